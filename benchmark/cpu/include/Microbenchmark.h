@@ -0,0 +1,109 @@
+/** \file microbenchmark.h */
+#pragma once
+
+#include <json.hpp>
+
+#include <chrono>
+#include <cstdint>
+#include <functional>
+#include <random>
+#include <string>
+#include <vector>
+
+/** \class BenchmarkState
+*	Handed to a benchmark, which sets up its inputs and then loops while keepRunning returns true. Only the loop is
+*	timed, minus any paused sections. The generator is reseeded before every call so inputs never depend on which
+*	benchmarks ran before.
+*/
+class BenchmarkState
+{
+public:
+	BenchmarkState(uint64_t iterations, int64_t arg, uint32_t seed) : m_iterations(iterations), m_remaining(iterations), m_arg(arg), m_rng(seed) {} //!< Constructor
+
+	inline bool keepRunning()
+	{
+		if (m_remaining == m_iterations && !m_running) resumeTiming();
+		if (m_remaining > 0)
+		{
+			m_remaining--;
+			return true;
+		}
+		pauseTiming();
+		return false;
+	} //!< Whether to run another iteration, starts the clock on the first call and stops it on the last
+
+	inline void pauseTiming()
+	{
+		if (!m_running) return;
+		m_elapsed += std::chrono::steady_clock::now() - m_start;
+		m_running = false;
+	} //!< Stop counting time, for per iteration setup
+
+	inline void resumeTiming()
+	{
+		if (m_running) return;
+		m_start = std::chrono::steady_clock::now();
+		m_running = true;
+	} //!< Count time again
+
+	inline void setItemsProcessed(uint64_t items) { m_items = items; } //!< Items handled across every iteration, reported per second
+	inline void setLabel(const std::string& label) { m_label = label; } //!< Note added to the report, such as the input used
+	inline int64_t arg() const { return m_arg; } //!< Size argument the benchmark was registered with
+	inline uint64_t iterations() const { return m_iterations; } //!< Iterations this call runs
+	inline std::mt19937& rng() { return m_rng; } //!< Fixed seed generator for inputs
+	inline double elapsedSeconds() const { return std::chrono::duration<double>(m_elapsed).count(); } //!< Time counted so far
+	inline uint64_t itemsProcessed() const { return m_items; } //!< Items set by the benchmark
+	inline const std::string& label() const { return m_label; } //!< Label set by the benchmark
+	inline void skip(const std::string& reason) { m_skipped = reason; m_remaining = 0; } //!< Give up, such as when an input file is missing
+	inline const std::string& skipped() const { return m_skipped; } //!< Why the benchmark gave up, empty if it ran
+	inline void fail(const std::string& reason) { m_failed = reason; m_remaining = 0; } //!< Report a wrong result, the run exits with 1
+	inline const std::string& failed() const { return m_failed; } //!< Why the benchmark failed, empty if it passed
+private:
+	uint64_t m_iterations; //!< Iterations to run
+	uint64_t m_remaining; //!< Iterations left
+	int64_t m_arg; //!< Size argument
+	std::mt19937 m_rng; //!< Input generator
+	std::chrono::steady_clock::time_point m_start; //!< When the clock last started
+	std::chrono::steady_clock::duration m_elapsed{ 0 }; //!< Time counted
+	bool m_running = false; //!< Whether the clock is running
+	uint64_t m_items = 0; //!< Items processed
+	std::string m_label; //!< Report note
+	std::string m_skipped; //!< Reason for giving up
+	std::string m_failed; //!< Reason for failing
+};
+
+using BenchmarkFunction = std::function<void(BenchmarkState&)>;
+
+/** \struct MicrobenchmarkSettings
+*	How every benchmark is run
+*/
+struct MicrobenchmarkSettings
+{
+	double minTime = 0.1; //!< Seconds a repetition must last, iterations double until it does
+	uint32_t repetitions = 5; //!< Timed repetitions, the report gives their median
+	uint32_t seed = 1337; //!< Seed of every benchmark's generator
+	std::string filter; //!< Only run benchmarks whose name contains this
+};
+
+/** \class Microbenchmark
+*	Registry and runner of the CPU benchmarks. Benchmarks register themselves at static init with EPHYRA_BENCHMARK,
+*	once per size argument.
+*/
+class Microbenchmark
+{
+public:
+	static bool add(const std::string& name, BenchmarkFunction function, std::vector<int64_t> args = {}); //!< Register a benchmark, run once per argument
+	static nlohmann::json run(const MicrobenchmarkSettings& settings); //!< Run every matching benchmark, returns the report with the number that failed
+	static bool compare(const nlohmann::json& report, const nlohmann::json& baseline, double threshold); //!< Print each result against the baseline, false if any is slower than its threshold allows
+};
+
+void doNotOptimize(const void* pointer); //!< Make the compiler treat the pointed to value as read, defined out of line so it cannot see through it
+
+template<typename T>
+inline void doNotOptimize(const T& value) { doNotOptimize(static_cast<const void*>(&value)); } //!< Keep a result from being optimized away
+
+#define EPHYRA_BENCHMARK_CONCAT_INNER(a, b) a##b
+#define EPHYRA_BENCHMARK_CONCAT(a, b) EPHYRA_BENCHMARK_CONCAT_INNER(a, b)
+
+//! Register a function taking a BenchmarkState&, optionally with the size arguments to run it with
+#define EPHYRA_BENCHMARK(function, ...) static const bool EPHYRA_BENCHMARK_CONCAT(s_registered_, function) = Microbenchmark::add(#function, function, { __VA_ARGS__ })
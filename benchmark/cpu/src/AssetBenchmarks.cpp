@@ -0,0 +1,299 @@
+/** \file assetBenchmarks.cpp
+*	Animation sampling and compression, asset lookup and scene saving and loading. The loader headers define functions that are not
+*	inline, so everything including them lives in this one file.
+*/
+#include "Microbenchmark.h"
+#include "Core/Resources/Management/SceneManager.h"
+
+#include <algorithm>
+#include <filesystem>
+
+namespace
+{
+	constexpr const char* benchmarkScene = "_benchmark.eph"; //!< Scratch file under saves/, removed after each run
+
+	std::unique_ptr<aiNodeAnim> syntheticChannel(std::mt19937& rng, uint32_t keys)
+	{
+		std::uniform_real_distribution<float> value(-1.f, 1.f);
+		auto channel = std::make_unique<aiNodeAnim>();
+		channel->mNumPositionKeys = channel->mNumRotationKeys = channel->mNumScalingKeys = keys;
+		channel->mPositionKeys = new aiVectorKey[keys];
+		channel->mRotationKeys = new aiQuatKey[keys];
+		channel->mScalingKeys = new aiVectorKey[keys];
+
+		for (uint32_t k = 0; k < keys; k++)
+		{
+			aiQuaternion rotation(value(rng), value(rng), value(rng), value(rng));
+			channel->mPositionKeys[k] = aiVectorKey(k, aiVector3D(value(rng), value(rng), value(rng)));
+			channel->mRotationKeys[k] = aiQuatKey(k, rotation.Normalize());
+			channel->mScalingKeys[k] = aiVectorKey(k, aiVector3D(1.f + 0.1f * value(rng)));
+		}
+		return channel;
+	}
+
+	// Pose of one channel as the bone update builds it
+	glm::mat4 sample(float time, const aiNodeAnim* channel)
+	{
+		glm::mat4 translation = glm::translate(glm::mat4(1.f), Engine::Loader::interpolatePosition(time, channel));
+		glm::mat4 rotation = glm::mat4_cast(Engine::Loader::interpolateRotation(time, channel));
+		glm::mat4 scale = glm::scale(glm::mat4(1.f), Engine::Loader::interpolateScaling(time, channel));
+		return translation * rotation * scale;
+	}
+
+	// Mech.fbx read once with Assimp alone, null if it cannot be read or has no animation
+	const aiScene* sandboxMech()
+	{
+		static Assimp::Importer importer;
+		static bool loaded = false;
+		if (!loaded)
+		{
+			loaded = true;
+			importer.ReadFile("./assets/models/Mech/Mech.fbx", 0);
+		}
+		const aiScene* scene = importer.GetScene();
+		return scene && scene->mNumAnimations > 0 ? scene : nullptr;
+	}
+
+	// Entities with every component the scene format stores apart from meshes, whose loading needs a GL context
+	void buildScene(entt::registry& registry, std::mt19937& rng, int64_t entities)
+	{
+		std::uniform_real_distribution<float> value(-50.f, 50.f);
+		entt::entity previous = entt::null;
+		for (int64_t i = 0; i < entities; i++)
+		{
+			auto entity = registry.create();
+			registry.emplace<Engine::TransformComponent>(entity, glm::vec3(value(rng), value(rng), value(rng)), glm::vec3(value(rng) * 0.01f), glm::vec3(1.f));
+			registry.emplace<Engine::TagComponent>(entity, "Entity" + std::to_string(i), i % 8 == 0 ? Engine::TagType::Light : Engine::TagType::Render3D);
+			registry.emplace<Engine::StateComponent>(entity, true);
+			if (i % 8 == 0) registry.emplace<Engine::EmmissiveComponent>(entity, glm::vec3(1.f, 0.5f, 0.2f), glm::vec3(0.f, 2.f, 0.f));
+			if (i % 4 == 0) registry.emplace<Engine::StaticComponent>(entity, true);
+			if (i % 16 == 0) registry.emplace<Engine::OccluderComponent>(entity, true);
+
+			// Chains of eight, each entity parented to the one before
+			registry.emplace<Engine::HierarchyComponent>(entity, entity, i % 8 == 0 ? entt::null : previous);
+			previous = entity;
+		}
+	}
+
+	// A fresh resource manager for the run, its registry is cleared while the manager can still be reached
+	struct SceneFixture
+	{
+		std::shared_ptr<Engine::ResourceManager> resources = Engine::ResourceManager::getInstance();
+		std::shared_ptr<Engine::SceneManager> scenes = Engine::SceneManager::getInstance();
+
+		SceneFixture() { resources->m_registry.on_destroy<Engine::HierarchyComponent>().connect<&Engine::onHierarchyDestroyed>(); }
+		~SceneFixture() { resources->m_registry.clear(); }
+	};
+}
+
+static void animationSampleSynthetic(BenchmarkState& state)
+{
+	uint32_t keys = static_cast<uint32_t>(state.arg());
+	auto channel = syntheticChannel(state.rng(), keys);
+
+	std::uniform_real_distribution<float> time(0.f, static_cast<float>(keys - 1));
+	std::vector<float> times(64);
+	for (auto& t : times) t = time(state.rng());
+
+	glm::mat4 pose(0.f);
+	while (state.keepRunning())
+	{
+		for (float t : times) pose += sample(t, channel.get());
+		doNotOptimize(pose);
+	}
+
+	state.setItemsProcessed(state.iterations() * times.size());
+}
+EPHYRA_BENCHMARK(animationSampleSynthetic, 2, 16, 256, 4096);
+
+static void animationSampleMech(BenchmarkState& state)
+{
+	const aiScene* scene = sandboxMech();
+	if (!scene) return state.skip("./assets/models/Mech/Mech.fbx not found or not animated");
+
+	// Every channel looked up by name then sampled, as the bone update does for each node
+	const aiAnimation* animation = scene->mAnimations[0];
+	std::uniform_real_distribution<float> time(0.f, static_cast<float>(animation->mDuration));
+	std::vector<float> times(16);
+	for (auto& t : times) t = time(state.rng());
+
+	std::vector<std::string> names;
+	for (uint32_t i = 0; i < animation->mNumChannels; i++)
+		names.emplace_back(animation->mChannels[i]->mNodeName.data);
+
+	glm::mat4 pose(0.f);
+	while (state.keepRunning())
+	{
+		for (float t : times)
+			for (auto& name : names)
+				if (const aiNodeAnim* channel = Engine::Loader::findNodeAnim(animation, name))
+					pose += sample(t, channel);
+		doNotOptimize(pose);
+	}
+
+	state.setItemsProcessed(state.iterations() * times.size() * names.size());
+	state.setLabel(std::to_string(names.size()) + " channels");
+}
+EPHYRA_BENCHMARK(animationSampleMech);
+
+static void animationCompressMech(BenchmarkState& state)
+{
+	const aiScene* scene = sandboxMech();
+	if (!scene) return state.skip("./assets/models/Mech/Mech.fbx not found or not animated");
+
+	// Cooked with the settings the loader uses, a clip over its error bound would be rejected there
+	Engine::AnimationCompressionSettings settings;
+	const aiAnimation* animation = scene->mAnimations[0];
+	std::shared_ptr<Engine::CompressedClip> clip;
+
+	while (state.keepRunning())
+	{
+		clip = Engine::CompressedClip::compress(animation, settings);
+		doNotOptimize(clip.get());
+	}
+
+	if (!clip)
+		return state.fail("compression returned no clip");
+
+	float extent = 0.f;
+	float maxError = clip->measureMaxPositionalError(scene, animation, extent);
+	float allowedError = extent * settings.maxPositionalErrorRatio;
+	if (maxError > allowedError)
+		return state.fail("max joint error " + std::to_string(maxError) + " over the bound of " + std::to_string(allowedError));
+
+	state.setItemsProcessed(state.iterations() * clip->getTrackCount());
+	state.setLabel(std::to_string(clip->getSourceSize()) + " -> " + std::to_string(clip->getCompressedSize()) + " bytes, max joint error " + std::to_string(maxError));
+}
+EPHYRA_BENCHMARK(animationCompressMech);
+
+static void animationSampleCompressedMech(BenchmarkState& state)
+{
+	const aiScene* scene = sandboxMech();
+	if (!scene) return state.skip("./assets/models/Mech/Mech.fbx not found or not animated");
+
+	// The same poses as animationSampleMech, read from the cooked clip
+	auto clip = Engine::CompressedClip::compress(scene->mAnimations[0], Engine::AnimationCompressionSettings());
+	if (!clip) return state.fail("compression returned no clip");
+
+	std::uniform_real_distribution<float> time(0.f, clip->getDuration());
+	std::vector<float> times(16);
+	for (auto& t : times) t = time(state.rng());
+
+	glm::vec3 translation(0.f);
+	glm::quat rotation(1.f, 0.f, 0.f, 0.f);
+	glm::mat4 pose(0.f);
+	while (state.keepRunning())
+	{
+		for (float t : times)
+			for (uint32_t track = 0; track < clip->getTrackCount(); track++)
+			{
+				clip->sample(track, t, translation, rotation);
+				pose += glm::translate(glm::mat4(1.f), translation) * glm::mat4_cast(rotation);
+			}
+		doNotOptimize(pose);
+	}
+
+	state.setItemsProcessed(state.iterations() * times.size() * clip->getTrackCount());
+	state.setLabel(std::to_string(clip->getTrackCount()) + " tracks");
+}
+EPHYRA_BENCHMARK(animationSampleCompressedMech);
+
+static void resourceGetAsset(BenchmarkState& state)
+{
+	// Ids shaped like the loader's, mesh name then asset kind
+	auto resources = Engine::ResourceManager::getInstance();
+	size_t assetCount = resources->getAssetCount();
+	const char* kinds[] = { "Geometry", "Material", "Texture" };
+	std::vector<std::string> ids;
+	for (int64_t i = 0; i < state.arg(); i++)
+	{
+		ids.push_back("Model" + std::to_string(i / 24) + "_Mesh" + std::to_string(i % 8) + kinds[i % 3]);
+		resources->addAsset<int>(ids.back(), Engine::SceneAsset::Type::Geometry, std::make_shared<int>(static_cast<int>(i)));
+	}
+
+	// One lookup in eight misses, the rest hit anywhere in the list
+	std::uniform_int_distribution<size_t> pick(0, ids.size() - 1);
+	std::uniform_int_distribution<int> miss(0, 7);
+	std::vector<std::string> lookups(256);
+	for (auto& lookup : lookups)
+		lookup = miss(state.rng()) == 0 ? "Missing" + std::to_string(pick(state.rng())) : ids[pick(state.rng())];
+
+	uint64_t found = 0;
+	while (state.keepRunning())
+	{
+		for (auto& lookup : lookups)
+			found += resources->getAsset<int>(lookup) != nullptr;
+		doNotOptimize(found);
+	}
+
+	// The manager is a singleton, so later args and benchmarks must not see these ids
+	resources->truncateAssets(assetCount);
+	state.setItemsProcessed(state.iterations() * lookups.size());
+}
+EPHYRA_BENCHMARK(resourceGetAsset, 64, 512, 4096);
+
+static void sceneSave(BenchmarkState& state)
+{
+	if (!std::filesystem::is_directory("saves")) return state.skip("saves/ not found, run from the sandbox directory");
+
+	SceneFixture fixture;
+	buildScene(fixture.resources->m_registry, state.rng(), state.arg());
+
+	while (state.keepRunning())
+		fixture.scenes->saveScene(fixture.resources->m_registry, benchmarkScene);
+
+	std::filesystem::remove(std::filesystem::path("saves") / benchmarkScene);
+	state.setItemsProcessed(state.iterations() * state.arg());
+}
+EPHYRA_BENCHMARK(sceneSave, 64, 1024);
+
+static void sceneLoad(BenchmarkState& state)
+{
+	if (!std::filesystem::is_directory("saves")) return state.skip("saves/ not found, run from the sandbox directory");
+
+	SceneFixture fixture;
+	buildScene(fixture.resources->m_registry, state.rng(), state.arg());
+	fixture.scenes->saveScene(fixture.resources->m_registry, benchmarkScene);
+
+	while (state.keepRunning())
+		fixture.scenes->loadScene(fixture.resources->m_registry, benchmarkScene);
+
+	std::filesystem::remove(std::filesystem::path("saves") / benchmarkScene);
+	state.setItemsProcessed(state.iterations() * state.arg());
+}
+EPHYRA_BENCHMARK(sceneLoad, 64, 1024);
+
+static void sceneLoadSandbox(BenchmarkState& state)
+{
+	if (!std::filesystem::is_directory("saves")) return state.skip("saves/ not found, run from the sandbox directory");
+
+	// The sandbox's saved scenes without their meshes, loading those needs a GL context
+	std::vector<std::string> files;
+	size_t entities = 0;
+	for (auto& entry : std::filesystem::directory_iterator("saves"))
+	{
+		std::string name = entry.path().filename().string();
+		if (entry.path().extension() != ".eph" || name.rfind("_benchmark", 0) == 0) continue;
+
+		nlohmann::json scene;
+		std::ifstream(entry.path()) >> scene;
+		if (!scene.contains("entities")) continue;
+		for (auto& entity : scene["entities"]) entity.erase("MeshRendererComponent");
+		entities += scene["entities"].size();
+
+		files.push_back("_benchmark_" + name);
+		std::ofstream(std::filesystem::path("saves") / files.back()) << scene.dump(4);
+	}
+	std::sort(files.begin(), files.end());
+	if (files.empty()) return state.skip("no scenes in saves/");
+
+	SceneFixture fixture;
+	while (state.keepRunning())
+		for (auto& file : files)
+			fixture.scenes->loadScene(fixture.resources->m_registry, file);
+
+	for (auto& file : files) std::filesystem::remove(std::filesystem::path("saves") / file);
+	state.setItemsProcessed(state.iterations() * entities);
+	state.setLabel(std::to_string(files.size()) + " scenes");
+}
+EPHYRA_BENCHMARK(sceneLoadSandbox);
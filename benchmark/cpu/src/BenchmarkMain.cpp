@@ -0,0 +1,74 @@
+/** \file benchmarkMain.cpp
+*	CPU subsystem benchmarks, no GL context is made.
+*
+*	Usage: BenchmarkCPU [--filter name] [--min-time s] [--repetitions N] [--seed N] [--out path] [--baseline path]
+*	                    [--threshold fraction] [--assets dir]
+*	Benchmarks reading sandbox assets expect to run from the sandbox directory, or --assets pointing at it, and skip
+*	themselves otherwise. The exit code is 1 when a benchmark checking its own results fails, or with a baseline, when
+*	any median is slower than its threshold allows. The job system runs a worker per hardware thread, as in the engine,
+*	except while the job benchmarks restart it at each thread count from one up.
+*/
+#include "Microbenchmark.h"
+#include "Core/Systems/Utility/JobSystem.h"
+#include "Core/Systems/Utility/Log.h"
+
+#include <cstring>
+#include <filesystem>
+#include <fstream>
+#include <iostream>
+
+int main(int argc, char** argv)
+{
+	MicrobenchmarkSettings settings;
+	std::string outPath = "cpu_benchmark.json";
+	std::string baselinePath;
+	double threshold = 0.1;
+
+	for (int i = 1; i < argc; i++)
+	{
+		bool hasValue = i + 1 < argc;
+		if (!strcmp(argv[i], "--filter") && hasValue) settings.filter = argv[++i];
+		else if (!strcmp(argv[i], "--min-time") && hasValue) settings.minTime = std::stod(argv[++i]);
+		else if (!strcmp(argv[i], "--repetitions") && hasValue) settings.repetitions = static_cast<uint32_t>(std::stoul(argv[++i]));
+		else if (!strcmp(argv[i], "--seed") && hasValue) settings.seed = static_cast<uint32_t>(std::stoul(argv[++i]));
+		else if (!strcmp(argv[i], "--out") && hasValue) outPath = argv[++i];
+		else if (!strcmp(argv[i], "--baseline") && hasValue) baselinePath = argv[++i];
+		else if (!strcmp(argv[i], "--threshold") && hasValue) threshold = std::stod(argv[++i]);
+		else if (!strcmp(argv[i], "--assets") && hasValue) std::filesystem::current_path(argv[++i]);
+		else
+		{
+			std::cerr << "Unknown argument " << argv[i] << std::endl;
+			return 2;
+		}
+	}
+
+	std::shared_ptr<Engine::System> logSystem(new Engine::Log);
+	logSystem->start();
+	std::shared_ptr<Engine::System> jobSystem(new Engine::JobSystem);
+	jobSystem->start();
+
+	nlohmann::json report = Microbenchmark::run(settings);
+	jobSystem->stop();
+
+	std::ofstream out(outPath);
+	out << report.dump(2) << std::endl;
+
+	bool passed = report.value("failed", 0u) == 0;
+	if (!baselinePath.empty())
+	{
+		std::ifstream baselineFile(baselinePath);
+		if (!baselineFile.is_open())
+		{
+			Engine::Log::error("Cannot open baseline {0}", baselinePath);
+			logSystem->stop();
+			return 2;
+		}
+
+		nlohmann::json baseline;
+		baselineFile >> baseline;
+		passed = Microbenchmark::compare(report, baseline, threshold) && passed;
+	}
+
+	logSystem->stop();
+	return passed ? 0 : 1;
+}
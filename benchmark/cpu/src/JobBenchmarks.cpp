@@ -0,0 +1,132 @@
+/** \file jobBenchmarks.cpp
+*	Job system parallel for against the same loop on one thread, and chains of small dependent jobs, at every thread
+*	count from one to the hardware's
+*/
+#include "Microbenchmark.h"
+#include "Core/Systems/Utility/JobSystem.h"
+
+#include <algorithm>
+#include <atomic>
+#include <cmath>
+#include <cstdio>
+#include <thread>
+
+namespace
+{
+	constexpr uint32_t parallelItems = 1000000; //!< Items split by jobParallelFor
+	constexpr uint32_t dependentJobs = 20000; //!< Jobs spread over the batches of jobDependentBatches
+
+	// Enough math per item that the split, not memory bandwidth, decides the time
+	void work(std::vector<float>& values, uint32_t first, uint32_t last)
+	{
+		for (uint32_t i = first; i < last; i++)
+		{
+			float x = static_cast<float>(i) * 0.001f;
+			values[i] = std::sqrt(x) * std::sin(x) + std::cos(x * 0.5f);
+		}
+	}
+
+	uint32_t hardwareThreads()
+	{
+		return std::max(1u, std::thread::hardware_concurrency());
+	}
+
+	// Every count from one to the hardware's, each benchmark below runs once per count
+	std::vector<int64_t> threadCounts()
+	{
+		std::vector<int64_t> counts;
+		for (uint32_t threads = 1; threads <= hardwareThreads(); threads++)
+			counts.push_back(threads);
+		return counts;
+	}
+
+	/** \struct PoolSize
+	*	Restarts the job system with the benchmark's thread count, and with one per hardware thread again once it returns
+	*/
+	struct PoolSize
+	{
+		PoolSize(int64_t threads) { Engine::JobSystem::setThreadCount(static_cast<uint32_t>(threads)); }
+		~PoolSize() { Engine::JobSystem::setThreadCount(hardwareThreads()); }
+	};
+
+	// Thread count and the speedup over the latest one thread run, which the runner always does first
+	std::string scalingLabel(BenchmarkState& state, double& oneThreadSeconds)
+	{
+		double seconds = state.elapsedSeconds() / std::max<uint64_t>(state.iterations(), 1);
+		if (state.arg() == 1) oneThreadSeconds = seconds;
+
+		std::string label = std::to_string(Engine::JobSystem::getThreadCount()) + " threads";
+		if (oneThreadSeconds > 0.0 && seconds > 0.0)
+		{
+			char speedup[32];
+			std::snprintf(speedup, sizeof(speedup), ", %.2fx one thread", oneThreadSeconds / seconds);
+			label += speedup;
+		}
+		return label;
+	}
+}
+
+static void jobSerialFor(BenchmarkState& state)
+{
+	// Baseline for jobParallelFor, the same items on the calling thread alone
+	std::vector<float> values(static_cast<size_t>(state.arg()));
+
+	while (state.keepRunning())
+	{
+		work(values, 0, static_cast<uint32_t>(values.size()));
+		doNotOptimize(values.back());
+	}
+
+	state.setItemsProcessed(state.iterations() * values.size());
+}
+EPHYRA_BENCHMARK(jobSerialFor, 100000, 1000000);
+
+static void jobParallelFor(BenchmarkState& state)
+{
+	static double oneThreadSeconds = 0.0;
+	PoolSize pool(state.arg());
+	std::vector<float> values(parallelItems);
+
+	while (state.keepRunning())
+	{
+		Engine::JobSystem::parallelFor(static_cast<uint32_t>(values.size()), 4096, [&values](uint32_t first, uint32_t last) { work(values, first, last); });
+		doNotOptimize(values.back());
+	}
+
+	state.setItemsProcessed(state.iterations() * values.size());
+	state.setLabel(scalingLabel(state, oneThreadSeconds));
+}
+static const bool s_registeredParallelFor = Microbenchmark::add("jobParallelFor", jobParallelFor, threadCounts());
+
+static void jobDependentBatches(BenchmarkState& state)
+{
+	// Each batch of small jobs waits on the previous one, so this also measures the dependency hand over
+	static double oneThreadSeconds = 0.0;
+	PoolSize pool(state.arg());
+	const uint32_t batches = 10;
+	const uint32_t jobs = dependentJobs;
+	std::atomic<uint32_t> completed{ 0 };
+	uint32_t ran = jobs;
+
+	while (state.keepRunning())
+	{
+		completed = 0;
+		Engine::JobHandle previous;
+		for (uint32_t batch = 0; batch < batches; batch++)
+		{
+			Engine::JobHandle counter = std::make_shared<Engine::JobCounter>();
+			for (uint32_t i = batch * jobs / batches; i < (batch + 1) * jobs / batches; i++)
+				Engine::JobSystem::runAfter(previous, counter, [&completed]() { completed.fetch_add(1, std::memory_order_relaxed); });
+			previous = counter;
+		}
+		Engine::JobSystem::wait(previous);
+		if (completed != jobs) ran = completed;
+	}
+
+	if (ran != jobs)
+		return state.fail("ran " + std::to_string(ran) + " of " + std::to_string(jobs) + " jobs");
+
+	state.setItemsProcessed(state.iterations() * jobs);
+	state.setLabel(scalingLabel(state, oneThreadSeconds));
+}
+static const bool s_registeredDependentBatches = Microbenchmark::add("jobDependentBatches", jobDependentBatches, threadCounts());
@@ -0,0 +1,212 @@
+/** \file microbenchmark.cpp */
+#include "Microbenchmark.h"
+
+#include <algorithm>
+#include <cmath>
+#include <cstdio>
+#include <numeric>
+#include <unordered_map>
+
+namespace
+{
+	/** \struct RegisteredBenchmark
+	*	Benchmark as registered, before it is expanded per argument
+	*/
+	struct RegisteredBenchmark
+	{
+		std::string name; //!< Function name
+		BenchmarkFunction function; //!< Benchmark body
+		std::vector<int64_t> args; //!< Size arguments, empty to run once without one
+	};
+
+	std::vector<RegisteredBenchmark>& registry()
+	{
+		// Function local so registration from other translation units never sees it unconstructed
+		static std::vector<RegisteredBenchmark> benchmarks;
+		return benchmarks;
+	}
+
+	const char* buildConfiguration()
+	{
+#if defined(NG_DEBUG)
+		return "Debug";
+#elif defined(NG_RELEASE)
+		return "Release";
+#else
+		return "Unknown";
+#endif
+	}
+
+	volatile const void* s_sink = nullptr; //!< Written by doNotOptimize
+
+	constexpr uint64_t maxIterations = 1000000000; //!< Calibration stops growing here
+}
+
+void doNotOptimize(const void* pointer)
+{
+	s_sink = pointer;
+}
+
+bool Microbenchmark::add(const std::string& name, BenchmarkFunction function, std::vector<int64_t> args)
+{
+	registry().push_back({ name, std::move(function), std::move(args) });
+	return true;
+}
+
+nlohmann::json Microbenchmark::run(const MicrobenchmarkSettings& settings)
+{
+	nlohmann::json report;
+	report["build"] = buildConfiguration();
+	report["seed"] = settings.seed;
+	report["min_time"] = settings.minTime;
+	report["repetitions"] = settings.repetitions;
+	report["benchmarks"] = nlohmann::json::array();
+	uint32_t failures = 0;
+
+	for (auto& benchmark : registry())
+	{
+		std::vector<int64_t> args = benchmark.args.empty() ? std::vector<int64_t>{ 0 } : benchmark.args;
+		for (int64_t arg : args)
+		{
+			std::string name = benchmark.args.empty() ? benchmark.name : benchmark.name + "/" + std::to_string(arg);
+			if (!settings.filter.empty() && name.find(settings.filter) == std::string::npos) continue;
+
+			// Double the iterations, or jump straight to the estimate, until one call lasts the minimum time
+			uint64_t iterations = 1;
+			std::string skipped, failed;
+			while (true)
+			{
+				BenchmarkState state(iterations, arg, settings.seed);
+				benchmark.function(state);
+				if (!state.skipped().empty() || !state.failed().empty())
+				{
+					skipped = state.skipped();
+					failed = state.failed();
+					break;
+				}
+
+				double elapsed = state.elapsedSeconds();
+				if (elapsed >= settings.minTime || iterations >= maxIterations) break;
+
+				double estimate = elapsed > 0.0 ? iterations * settings.minTime * 1.4 / elapsed : iterations * 10.0;
+				iterations = std::min(maxIterations, std::max(iterations * 2, static_cast<uint64_t>(std::min(estimate, iterations * 10.0))));
+			}
+
+			nlohmann::json result;
+			result["name"] = name;
+			if (!skipped.empty())
+			{
+				result["skipped"] = skipped;
+				report["benchmarks"].push_back(result);
+				std::printf("%-48s skipped: %s\n", name.c_str(), skipped.c_str());
+				continue;
+			}
+			if (!failed.empty())
+			{
+				result["failed"] = failed;
+				report["benchmarks"].push_back(result);
+				std::printf("%-48s FAILED: %s\n", name.c_str(), failed.c_str());
+				failures++;
+				continue;
+			}
+
+			std::vector<double> nanoseconds;
+			std::vector<double> itemsPerSecond;
+			std::string label;
+			for (uint32_t r = 0; r < std::max(1u, settings.repetitions); r++)
+			{
+				BenchmarkState state(iterations, arg, settings.seed);
+				benchmark.function(state);
+				nanoseconds.push_back(state.elapsedSeconds() * 1e9 / iterations);
+				if (state.itemsProcessed() > 0 && state.elapsedSeconds() > 0.0)
+					itemsPerSecond.push_back(state.itemsProcessed() / state.elapsedSeconds());
+				label = state.label();
+				if (!state.failed().empty())
+				{
+					failed = state.failed();
+					break;
+				}
+			}
+
+			// Results can depend on timing, such as work split across threads, so every repetition is checked
+			if (!failed.empty())
+			{
+				result["failed"] = failed;
+				report["benchmarks"].push_back(result);
+				std::printf("%-48s FAILED: %s\n", name.c_str(), failed.c_str());
+				failures++;
+				continue;
+			}
+
+			std::vector<double> sorted = nanoseconds;
+			std::sort(sorted.begin(), sorted.end());
+			double mean = std::accumulate(sorted.begin(), sorted.end(), 0.0) / sorted.size();
+			double variance = 0.0;
+			for (double sample : sorted) variance += (sample - mean) * (sample - mean);
+			double median = sorted[sorted.size() / 2];
+
+			result["iterations"] = iterations;
+			result["ns_per_op"] = {
+				{ "median", median },
+				{ "mean", mean },
+				{ "min", sorted.front() },
+				{ "stddev", std::sqrt(variance / sorted.size()) }
+			};
+			if (!itemsPerSecond.empty())
+			{
+				std::sort(itemsPerSecond.begin(), itemsPerSecond.end());
+				result["items_per_second"] = itemsPerSecond[itemsPerSecond.size() / 2];
+			}
+			if (!label.empty()) result["label"] = label;
+			report["benchmarks"].push_back(result);
+
+			std::printf("%-48s %14.1f ns %12llu iterations %s\n", name.c_str(), median, static_cast<unsigned long long>(iterations), label.c_str());
+		}
+	}
+
+	report["failed"] = failures;
+	return report;
+}
+
+bool Microbenchmark::compare(const nlohmann::json& report, const nlohmann::json& baseline, double threshold)
+{
+	if (baseline.value("build", "") != report.value("build", ""))
+		std::printf("Warning: baseline is a %s build, this is a %s build\n", baseline.value("build", "Unknown").c_str(), report.value("build", "Unknown").c_str());
+
+	std::unordered_map<std::string, const nlohmann::json*> baselineResults;
+	if (baseline.contains("benchmarks"))
+		for (auto& result : baseline["benchmarks"])
+			baselineResults[result.value("name", "")] = &result;
+
+	bool passed = true;
+	std::printf("\n%-48s %14s %14s %9s %9s\n", "Benchmark", "Baseline ns", "Current ns", "Change", "Allowed");
+	for (auto& result : report["benchmarks"])
+	{
+		std::string name = result.value("name", "");
+		auto found = baselineResults.find(name);
+		if (!result.contains("ns_per_op") || found == baselineResults.end() || !found->second->contains("ns_per_op"))
+		{
+			std::printf("%-48s %14s\n", name.c_str(), result.contains("ns_per_op") ? "new" : result.contains("failed") ? "failed" : "skipped");
+			continue;
+		}
+
+		// A baseline entry can carry its own threshold, for benchmarks known to be noisier than the rest
+		const nlohmann::json& entry = *found->second;
+		double allowed = entry.value("threshold", threshold);
+		double before = entry["ns_per_op"]["median"].get<double>();
+		double after = result["ns_per_op"]["median"].get<double>();
+		double change = before > 0.0 ? after / before - 1.0 : 0.0;
+
+		const char* verdict = "";
+		if (change > allowed)
+		{
+			verdict = "REGRESSED";
+			passed = false;
+		}
+		else if (change < -allowed) verdict = "improved";
+
+		std::printf("%-48s %14.1f %14.1f %+8.1f%% %8.1f%% %s\n", name.c_str(), before, after, change * 100.0, allowed * 100.0, verdict);
+	}
+
+	return passed;
+}
@@ -0,0 +1,105 @@
+/** \file occlusionBenchmarks.cpp
+*	Software occlusion culling against a scene with known visibility
+*/
+#include "Microbenchmark.h"
+#include "Core/Resources/Utility/OcclusionCuller.h"
+
+#include <glm/gtc/matrix_transform.hpp>
+
+namespace
+{
+	/** \struct OcclusionCase
+	*	Box tested against the wall and whether it must be found visible
+	*/
+	struct OcclusionCase
+	{
+		const char* name; //!< Reported when the result is wrong
+		Engine::AABB bounds; //!< World space box
+		bool visible; //!< Expected result
+	};
+
+	// A 8x8 wall five units in front of the camera, looking down -z
+	const Engine::OccluderMesh& wall()
+	{
+		static Engine::OccluderMesh mesh;
+		if (mesh.positions.empty())
+		{
+			mesh.positions = { { -1.f, -1.f, 0.f }, { 1.f, -1.f, 0.f }, { 1.f, 1.f, 0.f }, { -1.f, 1.f, 0.f } };
+			mesh.indices = { 0, 1, 2, 0, 2, 3 };
+		}
+		return mesh;
+	}
+
+	const glm::mat4 wallModel = glm::translate(glm::mat4(1.f), glm::vec3(0.f, 0.f, -5.f)) * glm::scale(glm::mat4(1.f), glm::vec3(4.f, 4.f, 1.f));
+	const glm::mat4 viewProjection = glm::perspective(glm::radians(60.f), 2.f, 0.1f, 100.f) * glm::lookAt(glm::vec3(0.f), glm::vec3(0.f, 0.f, -1.f), glm::vec3(0.f, 1.f, 0.f));
+
+	const OcclusionCase cases[] = {
+		{ "Behind wall", Engine::AABB(glm::vec3(-1.f, -1.f, -11.f), glm::vec3(1.f, 1.f, -9.f)), false },
+		{ "Just behind wall", Engine::AABB(glm::vec3(-1.f, -1.f, -5.5f), glm::vec3(1.f, 1.f, -5.2f)), false },
+		{ "Far behind wall", Engine::AABB(glm::vec3(-3.f, -3.f, -23.f), glm::vec3(3.f, 3.f, -17.f)), false },
+		{ "In front of wall", Engine::AABB(glm::vec3(-0.5f, -0.5f, -3.5f), glm::vec3(0.5f, 0.5f, -2.5f)), true },
+		{ "Flush with wall", Engine::AABB(glm::vec3(-2.f, -2.f, -5.f), glm::vec3(2.f, 2.f, -5.f)), true },
+		{ "Beside wall", Engine::AABB(glm::vec3(11.f, -1.f, -11.f), glm::vec3(13.f, 1.f, -9.f)), true },
+		{ "Across wall edge", Engine::AABB(glm::vec3(7.f, -1.f, -11.f), glm::vec3(9.f, 1.f, -9.f)), true },
+		{ "Through near plane", Engine::AABB(glm::vec3(-1.f, -1.f, -1.f), glm::vec3(1.f, 1.f, 1.f)), true }
+	};
+}
+
+static void occlusionGoldenVisibility(BenchmarkState& state)
+{
+	// Run with one band and with several, the bands must agree with the single threaded result
+	Engine::OcclusionCuller culler;
+	culler.setThreadCount(static_cast<uint32_t>(state.arg()));
+	std::string wrong;
+
+	while (state.keepRunning())
+	{
+		culler.begin(viewProjection);
+		culler.addOccluder(wall(), wallModel);
+		culler.rasterize();
+
+		wrong.clear();
+		for (auto& test : cases)
+			if (culler.isVisible(test.bounds) != test.visible)
+				wrong += std::string(wrong.empty() ? "" : ", ") + test.name;
+		doNotOptimize(wrong);
+	}
+
+	if (!wrong.empty())
+		return state.fail("wrong visibility: " + wrong);
+
+	state.setItemsProcessed(state.iterations() * (sizeof(cases) / sizeof(cases[0])));
+}
+EPHYRA_BENCHMARK(occlusionGoldenVisibility, 1, 4);
+
+static void occlusionTestBoxes(BenchmarkState& state)
+{
+	// Boxes scattered behind and beside the wall, about half of them hidden
+	std::uniform_real_distribution<float> across(-12.f, 12.f);
+	std::uniform_real_distribution<float> depth(-40.f, -6.f);
+	std::vector<Engine::AABB> bounds(static_cast<size_t>(state.arg()));
+	for (auto& box : bounds)
+	{
+		glm::vec3 center(across(state.rng()), across(state.rng()) * 0.5f, depth(state.rng()));
+		box = Engine::AABB(center - glm::vec3(0.5f), center + glm::vec3(0.5f));
+	}
+
+	Engine::OcclusionCuller culler;
+	culler.begin(viewProjection);
+	culler.addOccluder(wall(), wallModel);
+	culler.rasterize();
+	std::vector<uint8_t> visible;
+
+	while (state.keepRunning())
+	{
+		culler.testVisibility(bounds, visible);
+		doNotOptimize(visible.back());
+	}
+
+	uint32_t hidden = 0;
+	for (auto v : visible)
+		if (!v) hidden++;
+	state.setItemsProcessed(state.iterations() * bounds.size());
+	state.setLabel(std::to_string(hidden) + " hidden");
+}
+EPHYRA_BENCHMARK(occlusionTestBoxes, 1000, 10000);
@@ -0,0 +1,167 @@
+/** \file spatialBenchmarks.cpp
+*	Dynamic BVH build, update and queries against testing every box
+*/
+#include "Microbenchmark.h"
+#include "Core/Resources/Utility/DynamicBVH.h"
+
+#include <glm/gtc/matrix_transform.hpp>
+
+#include <algorithm>
+#include <cmath>
+
+namespace
+{
+	/** \struct MovingBoxes
+	*	Random boxes wandering inside a cube sized so density stays similar whatever the count
+	*/
+	struct MovingBoxes
+	{
+		float worldSize; //!< Half the side of the cube boxes start in
+		std::vector<glm::vec3> centers; //!< Center per box
+		std::vector<glm::vec3> velocities; //!< Distance moved per step per box
+		std::vector<glm::vec3> halfExtents; //!< Half size per box
+
+		MovingBoxes(std::mt19937& rng, int64_t count) : worldSize(std::cbrt(static_cast<float>(count)) * 4.f), centers(count), velocities(count), halfExtents(count)
+		{
+			std::uniform_real_distribution<float> position(-worldSize, worldSize);
+			std::uniform_real_distribution<float> speed(-0.05f, 0.05f);
+			std::uniform_real_distribution<float> size(0.25f, 1.f);
+			for (int64_t i = 0; i < count; i++)
+			{
+				centers[i] = glm::vec3(position(rng), position(rng), position(rng));
+				velocities[i] = glm::vec3(speed(rng), speed(rng), speed(rng));
+				halfExtents[i] = glm::vec3(size(rng), size(rng), size(rng));
+			}
+		}
+
+		inline Engine::AABB bounds(size_t i) const { return Engine::AABB(centers[i] - halfExtents[i], centers[i] + halfExtents[i]); }
+
+		void build(Engine::DynamicBVH& tree, std::vector<Engine::DynamicBVH::Proxy>& proxies) const
+		{
+			proxies.resize(centers.size());
+			for (size_t i = 0; i < centers.size(); i++)
+				proxies[i] = tree.create(bounds(i), static_cast<uint32_t>(i));
+		}
+
+		// Camera orbiting the centre so every step sees a different slice of the scene
+		inline glm::vec3 eye(uint64_t step) const { float angle = step * 0.1f; return glm::vec3(std::cos(angle), 0.25f, std::sin(angle)) * worldSize; }
+
+		inline Engine::Frustum frustum(uint64_t step) const
+		{
+			glm::mat4 projection = glm::perspective(glm::radians(60.f), 16.f / 9.f, 0.1f, worldSize * 2.f);
+			return Engine::Frustum(projection * glm::lookAt(eye(step), glm::vec3(0.f), glm::vec3(0.f, 1.f, 0.f)));
+		}
+	};
+}
+
+static void bvhBuild(BenchmarkState& state)
+{
+	MovingBoxes boxes(state.rng(), state.arg());
+	std::vector<Engine::DynamicBVH::Proxy> proxies;
+	uint32_t height = 0;
+
+	while (state.keepRunning())
+	{
+		Engine::DynamicBVH tree;
+		boxes.build(tree, proxies);
+		height = tree.getHeight();
+		doNotOptimize(height);
+	}
+
+	state.setItemsProcessed(state.iterations() * proxies.size());
+	state.setLabel("height " + std::to_string(height));
+}
+EPHYRA_BENCHMARK(bvhBuild, 10000, 100000);
+
+static void bvhMove(BenchmarkState& state)
+{
+	// Every box moves every step, only those escaping their fat box are reinserted
+	MovingBoxes boxes(state.rng(), state.arg());
+	Engine::DynamicBVH tree;
+	std::vector<Engine::DynamicBVH::Proxy> proxies;
+	boxes.build(tree, proxies);
+	uint64_t reinserted = 0;
+
+	while (state.keepRunning())
+	{
+		for (size_t i = 0; i < proxies.size(); i++)
+		{
+			boxes.centers[i] += boxes.velocities[i];
+			if (tree.move(proxies[i], boxes.bounds(i), boxes.velocities[i])) reinserted++;
+		}
+		doNotOptimize(reinserted);
+	}
+
+	state.setItemsProcessed(state.iterations() * proxies.size());
+	state.setLabel(std::to_string(reinserted / std::max<uint64_t>(state.iterations(), 1)) + " reinserted per step, height " + std::to_string(tree.getHeight()));
+}
+EPHYRA_BENCHMARK(bvhMove, 10000, 100000);
+
+static void bvhQueryFrustum(BenchmarkState& state)
+{
+	MovingBoxes boxes(state.rng(), state.arg());
+	Engine::DynamicBVH tree;
+	std::vector<Engine::DynamicBVH::Proxy> proxies;
+	boxes.build(tree, proxies);
+	std::vector<uint32_t> visible;
+	visible.reserve(proxies.size());
+	uint64_t step = 0;
+
+	while (state.keepRunning())
+	{
+		Engine::Frustum frustum = boxes.frustum(step++);
+		visible.clear();
+		tree.queryFrustum(frustum, visible);
+		doNotOptimize(visible.size());
+	}
+
+	state.setItemsProcessed(state.iterations());
+	state.setLabel(std::to_string(visible.size()) + " visible");
+}
+EPHYRA_BENCHMARK(bvhQueryFrustum, 10000, 100000);
+
+static void bruteForceFrustum(BenchmarkState& state)
+{
+	// Baseline for bvhQueryFrustum, testing every box
+	MovingBoxes boxes(state.rng(), state.arg());
+	std::vector<Engine::AABB> bounds(boxes.centers.size());
+	for (size_t i = 0; i < bounds.size(); i++) bounds[i] = boxes.bounds(i);
+	std::vector<uint32_t> visible;
+	visible.reserve(bounds.size());
+	uint64_t step = 0;
+
+	while (state.keepRunning())
+	{
+		Engine::Frustum frustum = boxes.frustum(step++);
+		visible.clear();
+		for (uint32_t i = 0; i < bounds.size(); i++)
+			if (frustum.intersects(bounds[i])) visible.push_back(i);
+		doNotOptimize(visible.size());
+	}
+
+	state.setItemsProcessed(state.iterations());
+	state.setLabel(std::to_string(visible.size()) + " visible");
+}
+EPHYRA_BENCHMARK(bruteForceFrustum, 10000, 100000);
+
+static void bvhRaycast(BenchmarkState& state)
+{
+	MovingBoxes boxes(state.rng(), state.arg());
+	Engine::DynamicBVH tree;
+	std::vector<Engine::DynamicBVH::Proxy> proxies;
+	boxes.build(tree, proxies);
+	uint64_t step = 0, hits = 0;
+
+	while (state.keepRunning())
+	{
+		glm::vec3 eye = boxes.eye(step++);
+		uint32_t hitData = 0;
+		float hitDistance = 0.f;
+		if (tree.raycast(eye, glm::normalize(-eye), boxes.worldSize * 4.f, hitData, hitDistance)) hits++;
+		doNotOptimize(hitDistance);
+	}
+
+	state.setItemsProcessed(state.iterations());
+	state.setLabel(std::to_string(hits) + " hits");
+}
+EPHYRA_BENCHMARK(bvhRaycast, 10000, 100000);
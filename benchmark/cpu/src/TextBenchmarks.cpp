@@ -0,0 +1,122 @@
+/** \file textBenchmarks.cpp
+*	Renderer2D glyph layout, from synthetic metrics and from the sandbox font
+*/
+#include "Microbenchmark.h"
+#include "Core/Resources/Utility/TextureAtlas.h"
+#include "Core/Rendering/Renderer/Renderer2D.h"
+
+namespace
+{
+	constexpr unsigned char firstGlyph = 32; //!< First glyph Renderer2D loads
+	constexpr unsigned char lastGlyph = 126; //!< Last glyph Renderer2D loads
+	constexpr float charScale = 100.f / 25.f; //!< Default text size over the loaded size, as Renderer2D submits strings
+
+	// Renderer2D's font at its loaded size, read with FreeType alone. Empty when the assets cannot be reached
+	const std::vector<Engine::Renderer2D::GlyphMetrics>& sandboxFontMetrics()
+	{
+		static std::vector<Engine::Renderer2D::GlyphMetrics> metrics;
+		static bool loaded = false;
+		if (loaded) return metrics;
+		loaded = true;
+
+		FT_Library ft;
+		FT_Face face;
+		if (FT_Init_FreeType(&ft)) return metrics;
+
+		if (!FT_New_Face(ft, "./assets/fonts/BOOKOSB.TTF", 0, &face))
+		{
+			if (!FT_Set_Pixel_Sizes(face, 0, 25))
+			{
+				for (unsigned char ch = firstGlyph; ch <= lastGlyph; ch++)
+				{
+					Engine::Renderer2D::GlyphMetrics glyph{ glm::vec2(0.f), glm::vec2(0.f), 0.f };
+					if (!FT_Load_Char(face, ch, FT_LOAD_RENDER))
+					{
+						glyph.size = glm::vec2(face->glyph->bitmap.width, face->glyph->bitmap.rows);
+						glyph.bearing = glm::vec2(face->glyph->bitmap_left, -face->glyph->bitmap_top);
+						glyph.advance = static_cast<float>(face->glyph->advance.x >> 6);
+					}
+					metrics.push_back(glyph);
+				}
+			}
+			FT_Done_Face(face);
+		}
+		FT_Done_FreeType(ft);
+		return metrics;
+	}
+
+	std::vector<Engine::Renderer2D::GlyphMetrics> syntheticMetrics(std::mt19937& rng)
+	{
+		std::uniform_real_distribution<float> size(4.f, 25.f);
+		std::vector<Engine::Renderer2D::GlyphMetrics> metrics;
+		for (unsigned char ch = firstGlyph; ch <= lastGlyph; ch++)
+		{
+			glm::vec2 glyphSize(size(rng), size(rng));
+			metrics.push_back({ glyphSize, glm::vec2(1.f, -glyphSize.y), glyphSize.x + 2.f });
+		}
+		return metrics;
+	}
+
+	// Printable characters with the odd tab and newline, which have no glyph
+	std::string randomText(std::mt19937& rng, size_t length)
+	{
+		std::uniform_int_distribution<int> printable(firstGlyph, lastGlyph);
+		std::uniform_int_distribution<int> control(0, 63);
+		std::string text(length, ' ');
+		for (auto& ch : text)
+			ch = control(rng) == 0 ? '\t' : static_cast<char>(printable(rng));
+		return text;
+	}
+
+	void layout(BenchmarkState& state, const std::vector<Engine::Renderer2D::GlyphMetrics>& metrics)
+	{
+		std::string text = randomText(state.rng(), static_cast<size_t>(state.arg()));
+		std::vector<Engine::Renderer2D::GlyphQuad> quads;
+
+		while (state.keepRunning())
+		{
+			Engine::Renderer2D::layoutText(metrics, firstGlyph, text.c_str(), glm::vec2(10.f, 50.f), charScale, quads);
+			doNotOptimize(quads.data());
+		}
+
+		state.setItemsProcessed(state.iterations() * text.size());
+	}
+}
+
+static void textLayoutSynthetic(BenchmarkState& state)
+{
+	auto metrics = syntheticMetrics(state.rng());
+	layout(state, metrics);
+}
+EPHYRA_BENCHMARK(textLayoutSynthetic, 16, 256, 4096);
+
+static void textLayoutSandboxFont(BenchmarkState& state)
+{
+	auto& metrics = sandboxFontMetrics();
+	if (metrics.empty()) return state.skip("./assets/fonts/BOOKOSB.TTF not found");
+	layout(state, metrics);
+}
+EPHYRA_BENCHMARK(textLayoutSandboxFont, 16, 256, 4096);
+
+static void atlasPackSandboxGlyphs(BenchmarkState& state)
+{
+	// The glyphs Renderer2D packs at init, in the same order
+	auto& metrics = sandboxFontMetrics();
+	if (metrics.empty()) return state.skip("./assets/fonts/BOOKOSB.TTF not found");
+
+	std::vector<Engine::SimpleRect> spaces;
+	spaces.reserve(128);
+	Engine::SimpleRect placed;
+
+	while (state.keepRunning())
+	{
+		spaces.clear();
+		spaces.push_back({ 0, 0, 4096, 4096 });
+		for (auto& glyph : metrics)
+			Engine::TextureAtlas::pack(spaces, static_cast<uint32_t>(glyph.size.x), static_cast<uint32_t>(glyph.size.y), placed);
+		doNotOptimize(placed);
+	}
+
+	state.setItemsProcessed(state.iterations() * metrics.size());
+}
+EPHYRA_BENCHMARK(atlasPackSandboxGlyphs);
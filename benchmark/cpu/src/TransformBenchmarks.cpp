@@ -0,0 +1,165 @@
+/** \file transformBenchmarks.cpp
+*	TRS composition kernels and transform hierarchy updates
+*/
+#include "Microbenchmark.h"
+#include "Core/Resources/Utility/TransformHierarchy.h"
+#include "Core/Resources/Utility/TransformKernels.h"
+
+#include <glm/gtc/matrix_transform.hpp>
+
+#include <algorithm>
+#include <cmath>
+
+namespace
+{
+	/** \struct TRSInputs
+	*	Random transforms with non-uniform scale and the matrices glm composes from them
+	*/
+	struct TRSInputs
+	{
+		std::vector<glm::vec3> translations; //!< Translation per transform
+		std::vector<glm::quat> rotations; //!< Unit rotation per transform
+		std::vector<glm::vec3> scales; //!< Scale per transform
+		std::vector<glm::mat4> reference; //!< translate * mat4_cast * scale per transform
+
+		TRSInputs(std::mt19937& rng, int64_t count) : translations(count), rotations(count), scales(count), reference(count)
+		{
+			std::uniform_real_distribution<float> range(-1.f, 1.f);
+			for (int64_t i = 0; i < count; i++)
+			{
+				translations[i] = glm::vec3(range(rng), range(rng), range(rng)) * 100.f;
+				rotations[i] = glm::normalize(glm::quat(range(rng), range(rng), range(rng), range(rng)));
+				scales[i] = glm::vec3(1.5f) + glm::vec3(range(rng), range(rng), range(rng));
+				reference[i] = glm::translate(glm::mat4(1.f), translations[i]) * glm::mat4_cast(rotations[i]) * glm::scale(glm::mat4(1.f), scales[i]);
+			}
+		}
+	};
+
+	constexpr float maxKernelError = 1e-4f; //!< Largest element difference from glm a kernel may have
+
+	void composeKernel(BenchmarkState& state, Engine::TransformKernels::Path path)
+	{
+		if (!Engine::TransformKernels::isSupported(path))
+			return state.skip(std::string(Engine::TransformKernels::getPathName(path)) + " is not supported by this CPU");
+
+		TRSInputs inputs(state.rng(), state.arg());
+		std::vector<glm::mat4> out(inputs.reference.size());
+
+		while (state.keepRunning())
+		{
+			Engine::TransformKernels::composeTRS(path, inputs.translations.data(), inputs.rotations.data(), inputs.scales.data(), out.data(), static_cast<uint32_t>(out.size()));
+			doNotOptimize(out.back());
+		}
+
+		// A fast but wrong kernel fails the run rather than reporting a time
+		float error = 0.f;
+		for (size_t i = 0; i < out.size(); i++)
+			for (int c = 0; c < 4; c++)
+				for (int r = 0; r < 4; r++)
+					error = std::max(error, std::abs(out[i][c][r] - inputs.reference[i][c][r]));
+		if (error > maxKernelError)
+			return state.fail("max error " + std::to_string(error) + " against glm");
+
+		state.setItemsProcessed(state.iterations() * out.size());
+		state.setLabel("max error " + std::to_string(error));
+	}
+
+	// A root with every other node as its direct child, posed at random
+	Engine::TransformHierarchy::Handle buildFlat(Engine::TransformHierarchy& hierarchy, std::mt19937& rng, int64_t children, std::vector<Engine::TransformHierarchy::Handle>& nodes)
+	{
+		std::uniform_real_distribution<float> value(-1.f, 1.f);
+		Engine::TransformHierarchy::Handle root = hierarchy.create();
+		nodes.clear();
+		for (int64_t i = 0; i < children; i++)
+		{
+			auto node = hierarchy.create(root, static_cast<uint32_t>(i));
+			glm::quat rotation = glm::normalize(glm::quat(value(rng), value(rng), value(rng), value(rng)));
+			hierarchy.setLocal(node, glm::vec3(value(rng), value(rng), value(rng)) * 50.f, rotation, glm::vec3(1.f));
+			nodes.push_back(node);
+		}
+		hierarchy.update();
+		return root;
+	}
+}
+
+static void hierarchyMoveRoot(BenchmarkState& state)
+{
+	// Every child's world matrix depends on the root, so the whole tree is recomputed
+	Engine::TransformHierarchy hierarchy;
+	std::vector<Engine::TransformHierarchy::Handle> nodes;
+	auto root = buildFlat(hierarchy, state.rng(), state.arg(), nodes);
+
+	float x = 0.f;
+	while (state.keepRunning())
+	{
+		x += 0.01f;
+		hierarchy.setLocal(root, glm::vec3(x, 0.f, 0.f), glm::quat(1.f, 0.f, 0.f, 0.f), glm::vec3(1.f));
+		hierarchy.update();
+		doNotOptimize(hierarchy.getWorld(nodes.back()));
+	}
+
+	state.setItemsProcessed(state.iterations() * hierarchy.getSize());
+}
+EPHYRA_BENCHMARK(hierarchyMoveRoot, 1000, 10000);
+
+static void hierarchyMoveChild(BenchmarkState& state)
+{
+	// One leaf edited per update, only its own subtree is recomputed
+	Engine::TransformHierarchy hierarchy;
+	std::vector<Engine::TransformHierarchy::Handle> nodes;
+	buildFlat(hierarchy, state.rng(), state.arg(), nodes);
+
+	uint32_t next = 0;
+	while (state.keepRunning())
+	{
+		auto node = nodes[next++ % nodes.size()];
+		hierarchy.setLocal(node, glm::vec3(static_cast<float>(next), 0.f, 0.f), glm::quat(1.f, 0.f, 0.f, 0.f), glm::vec3(1.f));
+		hierarchy.update();
+		doNotOptimize(hierarchy.getWorld(node));
+	}
+
+	state.setItemsProcessed(state.iterations());
+}
+EPHYRA_BENCHMARK(hierarchyMoveChild, 1000, 10000);
+
+static void hierarchyUpdateIdle(BenchmarkState& state)
+{
+	// Nothing changed since the last update, the cost every frame pays while the scene holds still
+	Engine::TransformHierarchy hierarchy;
+	std::vector<Engine::TransformHierarchy::Handle> nodes;
+	buildFlat(hierarchy, state.rng(), state.arg(), nodes);
+
+	while (state.keepRunning())
+	{
+		hierarchy.update();
+		doNotOptimize(hierarchy.getUpdated().size());
+	}
+
+	state.setItemsProcessed(state.iterations());
+}
+EPHYRA_BENCHMARK(hierarchyUpdateIdle, 1000, 10000);
+
+static void trsComposeGlm(BenchmarkState& state)
+{
+	TRSInputs inputs(state.rng(), state.arg());
+	std::vector<glm::mat4> out(inputs.reference.size());
+
+	while (state.keepRunning())
+	{
+		for (size_t i = 0; i < out.size(); i++)
+			out[i] = glm::translate(glm::mat4(1.f), inputs.translations[i]) * glm::mat4_cast(inputs.rotations[i]) * glm::scale(glm::mat4(1.f), inputs.scales[i]);
+		doNotOptimize(out.back());
+	}
+
+	state.setItemsProcessed(state.iterations() * out.size());
+}
+EPHYRA_BENCHMARK(trsComposeGlm, 1000, 100000);
+
+static void trsComposeScalar(BenchmarkState& state) { composeKernel(state, Engine::TransformKernels::Path::Scalar); }
+EPHYRA_BENCHMARK(trsComposeScalar, 1000, 100000);
+
+static void trsComposeSSE4(BenchmarkState& state) { composeKernel(state, Engine::TransformKernels::Path::SSE4); }
+EPHYRA_BENCHMARK(trsComposeSSE4, 1000, 100000);
+
+static void trsComposeAVX2(BenchmarkState& state) { composeKernel(state, Engine::TransformKernels::Path::AVX2); }
+EPHYRA_BENCHMARK(trsComposeAVX2, 1000, 100000);
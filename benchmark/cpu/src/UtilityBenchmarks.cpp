@@ -0,0 +1,62 @@
+/** \file utilityBenchmarks.cpp
+*	Texture atlas packing and texture unit assignment
+*/
+#include "Microbenchmark.h"
+#include "Core/Resources/Utility/TextureAtlas.h"
+#include "Core/Resources/Utility/TextureUnitManager.h"
+
+#include <algorithm>
+
+static void atlasPack(BenchmarkState& state)
+{
+	// Glyph to icon sized rects, a 4096 atlas holds all of them
+	std::uniform_int_distribution<uint32_t> size(4, 64);
+	std::vector<std::pair<uint32_t, uint32_t>> rects(static_cast<size_t>(state.arg()));
+	for (auto& rect : rects) rect = { size(state.rng()), size(state.rng()) };
+
+	std::vector<Engine::SimpleRect> spaces;
+	spaces.reserve(128);
+	Engine::SimpleRect placed;
+	uint32_t packed = 0;
+
+	while (state.keepRunning())
+	{
+		spaces.clear();
+		spaces.push_back({ 0, 0, 4096, 4096 });
+		packed = 0;
+		for (auto& rect : rects)
+			packed += Engine::TextureAtlas::pack(spaces, rect.first, rect.second, placed);
+		doNotOptimize(placed);
+	}
+
+	state.setItemsProcessed(state.iterations() * rects.size());
+	state.setLabel(std::to_string(packed) + " packed");
+}
+EPHYRA_BENCHMARK(atlasPack, 64, 256, 1024);
+
+static void textureUnitGetUnit(BenchmarkState& state)
+{
+	// Requests spread over a number of distinct textures, cleared when full the way the renderers do
+	std::uniform_int_distribution<uint32_t> texture(1, static_cast<uint32_t>(state.arg()));
+	std::vector<uint32_t> requests(4096);
+	for (auto& id : requests) id = texture(state.rng());
+
+	Engine::TextureUnitManager units(32);
+	uint32_t unit = 0;
+	uint64_t binds = 0;
+
+	while (state.keepRunning())
+	{
+		units.clear();
+		for (uint32_t id : requests)
+		{
+			if (units.isFull()) units.clear();
+			if (!units.getUnit(id, unit)) binds++;
+		}
+		doNotOptimize(unit);
+	}
+
+	state.setItemsProcessed(state.iterations() * requests.size());
+	state.setLabel(std::to_string(binds / std::max<uint64_t>(1, state.iterations())) + " binds per pass");
+}
+EPHYRA_BENCHMARK(textureUnitGetUnit, 8, 32, 256);
@@ -0,0 +1,62 @@
+/** \file rendererBenchmark.h */
+#pragma once
+
+#include "Core/Rendering/Renderer/Renderer3D.h"
+
+#include <json.hpp>
+#include <string>
+#include <vector>
+
+/** \struct RendererScenario
+*	Synthetic scene submitted every frame
+*/
+struct RendererScenario
+{
+	std::string name; //!< Name in the report
+	uint32_t instances; //!< Meshes submitted per frame
+	uint32_t geometries; //!< Distinct meshes the instances cycle through
+	uint32_t materials; //!< Distinct materials the instances cycle through, five textures each
+	bool skinned; //!< Every instance is skinned by the compute pre-pass into its own copy each frame
+};
+
+/** \struct PhaseTimes
+*	CPU milliseconds of one phase over the measured frames
+*/
+struct PhaseTimes
+{
+	std::vector<float> samples; //!< One per measured frame
+
+	nlohmann::json summary() const; //!< Mean, median, 95th percentile, min and max
+};
+
+/** \class RendererBenchmark
+*	Drives Renderer3D with synthetic scenes against an offscreen context and reports CPU time per phase with the
+*	frame's render stats. The geometry and material pools are shared by every scenario, the renderer has no way to
+*	free arena space.
+*/
+class RendererBenchmark
+{
+public:
+	RendererBenchmark(uint32_t warmupFrames, uint32_t measuredFrames); //!< Constructor, needs a current context
+	nlohmann::json run(const RendererScenario& scenario); //!< Run one scenario, returns its report
+	static std::vector<RendererScenario> defaultScenarios(); //!< Scenarios run when none are given
+private:
+	constexpr static uint32_t maxGeometries = 64; //!< Static meshes in the pool
+	constexpr static uint32_t maxBonedGeometries = 4; //!< Meshes with bones in the pool
+	constexpr static uint32_t maxMaterials = 16; //!< Materials in the pool
+	constexpr static uint32_t boneCount = 4; //!< Bones animated per skinned instance
+
+	uint32_t m_warmupFrames; //!< Frames run before measuring
+	uint32_t m_measuredFrames; //!< Frames measured
+	std::shared_ptr<Engine::Shader> m_shader; //!< PBR shader every material uses
+	std::vector<Engine::Geometry> m_geometries; //!< Static mesh pool
+	std::vector<Engine::Geometry> m_bonedGeometries; //!< Mesh with bones pool, sources of the skinned copies
+	std::vector<std::shared_ptr<Engine::Material>> m_materials; //!< Material pool
+	std::vector<std::shared_ptr<Engine::Texture>> m_textures; //!< Textures of the materials
+	glm::mat4 m_view; //!< Camera view
+	glm::mat4 m_projection; //!< Camera projection
+	glm::vec3 m_viewPos; //!< Camera position
+	Engine::SceneWideUniforms m_uniforms; //!< Point at the camera members
+
+	Engine::Geometry createSphere(uint32_t segments, uint32_t rings, bool bones); //!< Upload a UV sphere, bones split it at the equator
+};
@@ -0,0 +1,245 @@
+/** \file replayMain.cpp
+*	Replays a render capture recorded in the editor against a hidden window and writes a JSON report, so changes to
+*	flushing and batching can be compared on the same frames.
+*
+*	Usage: RenderReplay capture.erc [--loops N] [--warmup N] [--out path] [--assets dir] [--shader path] [--egl]
+*	                               [--depth-prepass on|off] [--hiz on|off] [--meshlets on|off|cone]
+*	The renderer switches are left as Renderer3D starts unless given. Shaders are loaded from ./assets, run it from the
+*	sandbox directory or point --assets at it.
+*/
+#include <Glad/glad.h>
+#include <GLFW/glfw3.h>
+
+#include "Core/Rendering/API/Global/RenderStats.h"
+#include "Core/Rendering/Renderer/GPUTimer.h"
+#include "Core/Rendering/Renderer/RenderCapture.h"
+#include "Core/Systems/Utility/Log.h"
+#include "Core/Systems/Utility/Timer.h"
+#include "platform/GLFW/GLFWSystem.h"
+#include "platform/GLFW/GLFW_OpenGl_GC.h"
+
+#include <json.hpp>
+#include <algorithm>
+#include <cstring>
+#include <filesystem>
+#include <fstream>
+#include <iostream>
+#include <numeric>
+
+namespace
+{
+	// Mean, median, 95th percentile, min and max
+	nlohmann::json summary(std::vector<float> samples)
+	{
+		nlohmann::json result;
+		if (samples.empty()) return result;
+
+		std::sort(samples.begin(), samples.end());
+		result["mean"] = std::accumulate(samples.begin(), samples.end(), 0.0) / samples.size();
+		result["median"] = samples[samples.size() / 2];
+		result["p95"] = samples[std::min<size_t>(samples.size() - 1, samples.size() * 95 / 100)];
+		result["min"] = samples.front();
+		result["max"] = samples.back();
+		return result;
+	}
+
+	nlohmann::json frameStats(const Engine::RenderFrameStats& stats)
+	{
+		nlohmann::json result;
+		result["draw_calls"] = stats.drawCalls;
+		result["draw_commands"] = stats.drawCommands;
+		result["drawn_instances"] = stats.instances;
+		result["dispatches"] = stats.dispatches;
+		result["batch_flushes"] = stats.batchFlushes;
+		result["forced_flushes"] = stats.forcedFlushes;
+		result["program_binds"] = stats.programBinds;
+		result["texture_binds"] = stats.textureBinds;
+		result["buffer_uploads"] = stats.bufferUploads;
+		result["bytes_uploaded"] = stats.bytesUploaded;
+		return result;
+	}
+
+	// -1 when the switch is not given, 0 off, 1 on, 2 on with cone culling
+	bool parseSwitch(const char* value, int32_t& result, bool allowCone)
+	{
+		if (!strcmp(value, "off")) result = 0;
+		else if (!strcmp(value, "on")) result = 1;
+		else if (allowCone && !strcmp(value, "cone")) result = 2;
+		else return false;
+		return true;
+	}
+}
+
+int main(int argc, char** argv)
+{
+	std::string capturePath;
+	uint32_t loops = 10;
+	uint32_t warmup = 2;
+	std::string outPath = "replay.json";
+	std::string shaderPath = "./assets/shaders/PBRShader.glsl";
+	bool egl = false;
+	int32_t depthPrepass = -1;
+	int32_t hiZ = -1;
+	int32_t meshlets = -1;
+
+	for (int i = 1; i < argc; i++)
+	{
+		bool hasValue = i + 1 < argc;
+		bool valid = true;
+		if (!strcmp(argv[i], "--loops") && hasValue) loops = std::max(1u, static_cast<uint32_t>(std::stoul(argv[++i])));
+		else if (!strcmp(argv[i], "--warmup") && hasValue) warmup = static_cast<uint32_t>(std::stoul(argv[++i]));
+		else if (!strcmp(argv[i], "--out") && hasValue) outPath = argv[++i];
+		else if (!strcmp(argv[i], "--shader") && hasValue) shaderPath = argv[++i];
+		else if (!strcmp(argv[i], "--depth-prepass") && hasValue) valid = parseSwitch(argv[++i], depthPrepass, false);
+		else if (!strcmp(argv[i], "--hiz") && hasValue) valid = parseSwitch(argv[++i], hiZ, false);
+		else if (!strcmp(argv[i], "--meshlets") && hasValue) valid = parseSwitch(argv[++i], meshlets, true);
+		else if (!strcmp(argv[i], "--egl")) egl = true;
+		else if (!strcmp(argv[i], "--assets") && hasValue)
+		{
+			// The capture is named relative to where the tool was started
+			if (!capturePath.empty()) capturePath = std::filesystem::absolute(capturePath).string();
+			std::filesystem::current_path(argv[++i]);
+		}
+		else if (argv[i][0] != '-' && capturePath.empty()) capturePath = argv[i];
+		else valid = false;
+
+		if (!valid)
+		{
+			std::cerr << "Unknown argument " << argv[i] << std::endl;
+			return 2;
+		}
+	}
+
+	if (capturePath.empty())
+	{
+		std::cerr << "Usage: RenderReplay capture.erc [--loops N] [--warmup N] [--out path] [--assets dir] [--shader path] [--egl] [--depth-prepass on|off] [--hiz on|off] [--meshlets on|off|cone]" << std::endl;
+		return 2;
+	}
+
+	std::shared_ptr<Engine::System> logSystem(new Engine::Log);
+	logSystem->start();
+	std::shared_ptr<Engine::System> windowsSystem(new Engine::GLFWSystem);
+	windowsSystem->start();
+
+	// Never shown, the default framebuffer is still there for the renderer to draw into
+	glfwWindowHint(GLFW_VISIBLE, GLFW_FALSE);
+	glfwWindowHint(GLFW_CONTEXT_VERSION_MAJOR, 4);
+	glfwWindowHint(GLFW_CONTEXT_VERSION_MINOR, 5);
+	glfwWindowHint(GLFW_OPENGL_PROFILE, GLFW_OPENGL_CORE_PROFILE);
+	if (egl) glfwWindowHint(GLFW_CONTEXT_CREATION_API, GLFW_EGL_CONTEXT_API);
+
+	GLFWwindow* window = glfwCreateWindow(1280, 720, "Ephyra Render Replay", nullptr, nullptr);
+	if (!window)
+	{
+		Engine::Log::error("Cannot create an offscreen context");
+		windowsSystem->stop();
+		return 1;
+	}
+
+	int result = 0;
+	{
+		Engine::GLFW_OpenGL_GC context(window);
+		context.init();
+		glfwSwapInterval(0);
+
+		// Initialises Renderer2D as well
+		Engine::Renderer3D::init(262144, 262144, 262144);
+		if (depthPrepass >= 0) Engine::Renderer3D::setDepthPrepass(depthPrepass == 1);
+		if (hiZ >= 0) Engine::Renderer3D::setHiZ(hiZ == 1);
+		if (meshlets >= 0) Engine::Renderer3D::setMeshletCulling(meshlets > 0, meshlets == 2);
+
+		Engine::RenderReplay replay;
+		if (!replay.load(capturePath, shaderPath))
+		{
+			Engine::Log::error("No whole frames in {0}", capturePath);
+			result = 1;
+		}
+		else
+		{
+			uint32_t frames = replay.getFrameCount();
+			std::vector<std::vector<float>> frameTimes(frames);
+			std::vector<float> loopTimes;
+			std::vector<Engine::RenderFrameStats> lastStats(frames);
+
+			Engine::ChronoTimer frameTimer;
+			Engine::ChronoTimer loopTimer;
+			for (uint32_t loop = 0; loop < warmup + loops; loop++)
+			{
+				bool measured = loop >= warmup;
+				loopTimer.start();
+				for (uint32_t f = 0; f < frames; f++)
+				{
+					// Waits for the GPU so each frame starts from an idle queue, as the renderer benchmark does
+					frameTimer.start();
+					replay.replayFrame(f);
+					glFinish();
+					float frameTime = frameTimer.getElapsedTime();
+
+					Engine::RenderStats::endFrame();
+					if (!measured) continue;
+					frameTimes[f].push_back(frameTime * 1000.f);
+					lastStats[f] = Engine::RenderStats::getLastFrame();
+				}
+				if (measured) loopTimes.push_back(loopTimer.getElapsedTime() * 1000.f);
+			}
+
+			auto& captureStats = replay.getStats();
+			nlohmann::json report;
+			report["renderer"] = reinterpret_cast<const char*>(glGetString(GL_RENDERER));
+			report["version"] = reinterpret_cast<const char*>(glGetString(GL_VERSION));
+			report["capture"]["path"] = capturePath;
+			report["capture"]["frames"] = frames;
+			report["capture"]["calls"] = captureStats.calls;
+			report["capture"]["geometries"] = captureStats.geometries;
+			report["capture"]["materials"] = captureStats.materials;
+			report["capture"]["textures"] = captureStats.textures;
+			report["capture"]["bytes"] = captureStats.bytes;
+			report["settings"]["depth_prepass"] = Engine::Renderer3D::getDepthPrepass() ? "on" : "off";
+			report["settings"]["hiz"] = hiZ < 0 ? "default" : hiZ ? "on" : "off";
+			report["settings"]["meshlets"] = meshlets < 0 ? "default" : meshlets == 2 ? "cone" : meshlets ? "on" : "off";
+			report["warmup_loops"] = warmup;
+			report["measured_loops"] = loops;
+			report["loop_ms"] = summary(loopTimes);
+
+			// Each frame issues the same calls every loop, so its counters are taken from the last one
+			std::vector<float> allFrames;
+			Engine::RenderFrameStats totals;
+			report["frames"] = nlohmann::json::array();
+			for (uint32_t f = 0; f < frames; f++)
+			{
+				allFrames.insert(allFrames.end(), frameTimes[f].begin(), frameTimes[f].end());
+				auto& stats = lastStats[f];
+				totals.drawCalls += stats.drawCalls;
+				totals.drawCommands += stats.drawCommands;
+				totals.instances += stats.instances;
+				totals.dispatches += stats.dispatches;
+				totals.batchFlushes += stats.batchFlushes;
+				totals.forcedFlushes += stats.forcedFlushes;
+				totals.programBinds += stats.programBinds;
+				totals.textureBinds += stats.textureBinds;
+				totals.bufferUploads += stats.bufferUploads;
+				totals.bytesUploaded += stats.bytesUploaded;
+
+				nlohmann::json frame = frameStats(stats);
+				frame["cpu_ms"] = summary(frameTimes[f]);
+				report["frames"].push_back(frame);
+			}
+			report["frame_ms"] = summary(allFrames);
+			report["totals"] = frameStats(totals);
+			if (Engine::GPUTimer::isEnabled())
+				report["gpu_frame_ms"] = Engine::GPUTimer::getStats().frameTime * 1000.f;
+
+			Engine::Log::release("{0}: {1} frames, {2:.3f} ms per frame, {3} draw calls and {4} flushes per loop", capturePath, frames,
+				report["frame_ms"]["mean"].get<double>(), totals.drawCalls, totals.batchFlushes);
+
+			std::ofstream out(outPath);
+			out << report.dump(2) << std::endl;
+			std::cout << report.dump(2) << std::endl;
+		}
+	}
+
+	glfwDestroyWindow(window);
+	windowsSystem->stop();
+	logSystem->stop();
+	return result;
+}
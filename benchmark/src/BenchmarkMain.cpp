@@ -0,0 +1,93 @@
+/** \file benchmarkMain.cpp
+*	Headless Renderer3D benchmark. Runs synthetic scenes against a hidden window and writes a JSON report.
+*
+*	Usage: Benchmark [--frames N] [--warmup N] [--scenario name] [--out path] [--assets dir] [--egl]
+*	Shaders are loaded from ./assets, run it from the sandbox directory or point --assets at it. On a machine without
+*	a GPU, Mesa's llvmpipe under Xvfb gives a 4.5 core context.
+*/
+#include <Glad/glad.h>
+#include <GLFW/glfw3.h>
+
+#include "RendererBenchmark.h"
+#include "Core/Systems/Utility/Log.h"
+#include "platform/GLFW/GLFWSystem.h"
+#include "platform/GLFW/GLFW_OpenGl_GC.h"
+
+#include <cstring>
+#include <filesystem>
+#include <fstream>
+#include <iostream>
+
+int main(int argc, char** argv)
+{
+	uint32_t frames = 200;
+	uint32_t warmup = 20;
+	std::string filter;
+	std::string outPath = "renderer_benchmark.json";
+	bool egl = false;
+
+	for (int i = 1; i < argc; i++)
+	{
+		bool hasValue = i + 1 < argc;
+		if (!strcmp(argv[i], "--frames") && hasValue) frames = static_cast<uint32_t>(std::stoul(argv[++i]));
+		else if (!strcmp(argv[i], "--warmup") && hasValue) warmup = static_cast<uint32_t>(std::stoul(argv[++i]));
+		else if (!strcmp(argv[i], "--scenario") && hasValue) filter = argv[++i];
+		else if (!strcmp(argv[i], "--out") && hasValue) outPath = argv[++i];
+		else if (!strcmp(argv[i], "--assets") && hasValue) std::filesystem::current_path(argv[++i]);
+		else if (!strcmp(argv[i], "--egl")) egl = true;
+		else
+		{
+			std::cerr << "Unknown argument " << argv[i] << std::endl;
+			return 2;
+		}
+	}
+
+	std::shared_ptr<Engine::System> logSystem(new Engine::Log);
+	logSystem->start();
+	std::shared_ptr<Engine::System> windowsSystem(new Engine::GLFWSystem);
+	windowsSystem->start();
+
+	// Never shown, the default framebuffer is still there for the renderer to draw into
+	glfwWindowHint(GLFW_VISIBLE, GLFW_FALSE);
+	glfwWindowHint(GLFW_CONTEXT_VERSION_MAJOR, 4);
+	glfwWindowHint(GLFW_CONTEXT_VERSION_MINOR, 5);
+	glfwWindowHint(GLFW_OPENGL_PROFILE, GLFW_OPENGL_CORE_PROFILE);
+	if (egl) glfwWindowHint(GLFW_CONTEXT_CREATION_API, GLFW_EGL_CONTEXT_API);
+
+	GLFWwindow* window = glfwCreateWindow(1280, 720, "Ephyra Benchmark", nullptr, nullptr);
+	if (!window)
+	{
+		Engine::Log::error("Cannot create an offscreen context");
+		windowsSystem->stop();
+		return 1;
+	}
+
+	{
+		Engine::GLFW_OpenGL_GC context(window);
+		context.init();
+		glfwSwapInterval(0);
+
+		nlohmann::json report;
+		report["renderer"] = reinterpret_cast<const char*>(glGetString(GL_RENDERER));
+		report["version"] = reinterpret_cast<const char*>(glGetString(GL_VERSION));
+		report["warmup_frames"] = warmup;
+		report["measured_frames"] = frames;
+		report["scenarios"] = nlohmann::json::array();
+
+		RendererBenchmark benchmark(warmup, frames);
+		for (auto& scenario : RendererBenchmark::defaultScenarios())
+		{
+			if (!filter.empty() && scenario.name.find(filter) == std::string::npos) continue;
+			report["scenarios"].push_back(benchmark.run(scenario));
+		}
+
+		std::ofstream out(outPath);
+		out << report.dump(2) << std::endl;
+		std::cout << report.dump(2) << std::endl;
+	}
+
+	glfwDestroyWindow(window);
+	windowsSystem->stop();
+	logSystem->stop();
+	return 0;
+}
@@ -0,0 +1,242 @@
+/** \file rendererBenchmark.cpp */
+#include "RendererBenchmark.h"
+#include "Core/Rendering/API/Global/RenderStats.h"
+#include "Core/Rendering/Renderer/GPUTimer.h"
+#include "Core/Systems/Utility/Timer.h"
+
+#include <Glad/glad.h>
+#include <glm/gtc/matrix_transform.hpp>
+#include <glm/gtc/type_ptr.hpp>
+#include <algorithm>
+#include <numeric>
+
+nlohmann::json PhaseTimes::summary() const
+{
+	nlohmann::json result;
+	if (samples.empty()) return result;
+
+	std::vector<float> sorted = samples;
+	std::sort(sorted.begin(), sorted.end());
+	result["mean"] = std::accumulate(sorted.begin(), sorted.end(), 0.0) / sorted.size();
+	result["median"] = sorted[sorted.size() / 2];
+	result["p95"] = sorted[std::min<size_t>(sorted.size() - 1, sorted.size() * 95 / 100)];
+	result["min"] = sorted.front();
+	result["max"] = sorted.back();
+	return result;
+}
+
+RendererBenchmark::RendererBenchmark(uint32_t warmupFrames, uint32_t measuredFrames) : m_warmupFrames(warmupFrames), m_measuredFrames(std::max(1u, measuredFrames))
+{
+	Engine::Renderer3D::init(262144, 262144, 262144);
+
+	m_shader.reset(Engine::Shader::create("./assets/shaders/PBRShader.glsl"));
+	Engine::Renderer3D::initShader(m_shader);
+
+	// Sizes vary so every pool entry is a distinct mesh with its own draw command
+	for (uint32_t i = 0; i < maxGeometries; i++)
+		m_geometries.push_back(createSphere(12 + (i % 8) * 2, 8 + (i % 4) * 2, false));
+	for (uint32_t i = 0; i < maxBonedGeometries; i++)
+		m_bonedGeometries.push_back(createSphere(16, 12 + i * 2, true));
+
+	// Five small textures per material, enough materials run the 32 texture units out and force early flushes
+	for (uint32_t i = 0; i < maxMaterials; i++)
+	{
+		std::vector<std::shared_ptr<Engine::Texture>> textures;
+		for (uint32_t t = 0; t < 5; t++)
+		{
+			unsigned char pixels[4 * 4 * 4];
+			for (uint32_t p = 0; p < 16; p++)
+			{
+				pixels[p * 4 + 0] = static_cast<unsigned char>(40 + i * 13);
+				pixels[p * 4 + 1] = static_cast<unsigned char>(60 + t * 37);
+				pixels[p * 4 + 2] = static_cast<unsigned char>(p * 16);
+				pixels[p * 4 + 3] = 255;
+			}
+			textures.emplace_back(Engine::Texture::create(4, 4, 4, pixels));
+			m_textures.push_back(textures.back());
+		}
+		m_materials.push_back(std::make_shared<Engine::Material>(m_shader, textures, glm::vec4(1.f), true));
+	}
+
+	m_viewPos = glm::vec3(0.f, 40.f, 120.f);
+	m_view = glm::lookAt(m_viewPos, glm::vec3(0.f), glm::vec3(0.f, 1.f, 0.f));
+	m_projection = glm::perspective(glm::radians(60.f), 16.f / 9.f, 0.1f, 1000.f);
+	m_uniforms["u_projection"] = std::pair<Engine::ShaderDataType, void*>(Engine::ShaderDataType::Mat4, static_cast<void*>(glm::value_ptr(m_projection)));
+	m_uniforms["u_view"] = std::pair<Engine::ShaderDataType, void*>(Engine::ShaderDataType::Mat4, static_cast<void*>(glm::value_ptr(m_view)));
+	m_uniforms["u_viewPos"] = std::pair<Engine::ShaderDataType, void*>(Engine::ShaderDataType::Float3, static_cast<void*>(glm::value_ptr(m_viewPos)));
+
+	Engine::RendererCommon::lightPos.assign(64, glm::vec3(0.f));
+	Engine::RendererCommon::lightColour.assign(64, glm::vec3(0.f));
+	Engine::RendererCommon::lightPos[0] = glm::vec3(0.f, 100.f, 100.f);
+	Engine::RendererCommon::lightColour[0] = glm::vec3(1.f);
+
+	glEnable(GL_DEPTH_TEST);
+}
+
+Engine::Geometry RendererBenchmark::createSphere(uint32_t segments, uint32_t rings, bool bones)
+{
+	std::vector<Engine::Renderer3DVertex> vertices;
+	std::vector<uint32_t> indices;
+
+	for (uint32_t ring = 0; ring <= rings; ring++)
+	{
+		float phi = glm::pi<float>() * ring / rings;
+		for (uint32_t segment = 0; segment <= segments; segment++)
+		{
+			float theta = glm::two_pi<float>() * segment / segments;
+			glm::vec3 normal(std::sin(phi) * std::cos(theta), std::cos(phi), std::sin(phi) * std::sin(theta));
+			glm::vec4 boneIndices(normal.y > 0.f ? 1.f : 0.f, 0.f, 0.f, 0.f);
+			glm::vec4 boneWeights = bones ? glm::vec4(1.f, 0.f, 0.f, 0.f) : glm::vec4(0.f);
+			vertices.emplace_back(normal, normal, glm::vec2(static_cast<float>(segment) / segments, static_cast<float>(ring) / rings), boneIndices, boneWeights);
+		}
+	}
+
+	for (uint32_t ring = 0; ring < rings; ring++)
+	{
+		for (uint32_t segment = 0; segment < segments; segment++)
+		{
+			uint32_t a = ring * (segments + 1) + segment;
+			uint32_t b = a + segments + 1;
+			indices.insert(indices.end(), { a, b, a + 1, a + 1, b, b + 1 });
+		}
+	}
+
+	Engine::Geometry geometry;
+	if (!Engine::Renderer3D::addGeometry(vertices, indices, geometry))
+		Engine::Log::error("Benchmark geometry does not fit the renderer's arena");
+	return geometry;
+}
+
+nlohmann::json RendererBenchmark::run(const RendererScenario& scenario)
+{
+	uint32_t geometries = std::max(1u, std::min(scenario.geometries, scenario.skinned ? maxBonedGeometries : maxGeometries));
+	uint32_t materials = std::max(1u, std::min(scenario.materials, maxMaterials));
+	auto& pool = scenario.skinned ? m_bonedGeometries : m_geometries;
+
+	// Instances on a square grid in front of the camera, all inside the frustum
+	uint32_t side = static_cast<uint32_t>(std::ceil(std::sqrt(static_cast<float>(std::max(1u, scenario.instances)))));
+	float spacing = 200.f / side;
+	std::vector<glm::mat4> models(scenario.instances);
+	for (uint32_t i = 0; i < scenario.instances; i++)
+	{
+		glm::vec3 position((i % side) * spacing - 100.f, 0.f, (i / side) * spacing - 100.f);
+		models[i] = glm::scale(glm::translate(glm::mat4(1.f), position), glm::vec3(spacing * 0.4f));
+	}
+
+	// A skinned instance owns its copy in the arena, which cannot be freed, so the copies only grow across scenarios
+	std::vector<Engine::Geometry> skinnedCopies;
+	uint32_t instances = scenario.instances;
+	if (scenario.skinned)
+	{
+		for (uint32_t i = 0; i < scenario.instances; i++)
+		{
+			Engine::Geometry copy;
+			if (!Engine::Renderer3D::addSkinnedGeometry(pool[i % geometries], copy))
+			{
+				Engine::Log::error("Only {0} of {1} skinned copies fit the renderer's arena", i, scenario.instances);
+				break;
+			}
+			skinnedCopies.push_back(copy);
+		}
+		instances = static_cast<uint32_t>(skinnedCopies.size());
+	}
+
+	PhaseTimes begin, skin, submit, end, finish, frame;
+	std::vector<glm::mat4> bones(boneCount);
+	Engine::ChronoTimer frameTimer, phaseTimer;
+
+	for (uint32_t f = 0; f < m_warmupFrames + m_measuredFrames; f++)
+	{
+		bool measured = f >= m_warmupFrames;
+		frameTimer.start();
+
+		phaseTimer.start();
+		Engine::Renderer3D::begin(m_uniforms);
+		float beginTime = phaseTimer.getElapsedTime();
+
+		phaseTimer.start();
+		if (scenario.skinned)
+		{
+			for (uint32_t i = 0; i < instances; i++)
+			{
+				bones[0] = glm::mat4(1.f);
+				bones[1] = glm::rotate(glm::mat4(1.f), 0.05f * f + 0.1f * i, glm::vec3(0.f, 1.f, 0.f));
+				Engine::Renderer3D::skin(pool[i % geometries], skinnedCopies[i], bones.data(), boneCount);
+			}
+		}
+		float skinTime = phaseTimer.getElapsedTime();
+
+		phaseTimer.start();
+		for (uint32_t i = 0; i < instances; i++)
+		{
+			auto& geometry = scenario.skinned ? skinnedCopies[i] : pool[i % geometries];
+			Engine::Renderer3D::submit(geometry, m_materials[(i / geometries) % materials], models[i]);
+		}
+		float submitTime = phaseTimer.getElapsedTime();
+
+		phaseTimer.start();
+		Engine::Renderer3D::end();
+		float endTime = phaseTimer.getElapsedTime();
+
+		// Waits for the GPU so the next frame starts from an idle queue and the CPU phases are not skewed by back pressure
+		phaseTimer.start();
+		glFinish();
+		float finishTime = phaseTimer.getElapsedTime();
+		float frameTime = frameTimer.getElapsedTime();
+
+		Engine::RenderStats::endFrame();
+
+		if (!measured) continue;
+		begin.samples.push_back(beginTime * 1000.f);
+		skin.samples.push_back(skinTime * 1000.f);
+		submit.samples.push_back(submitTime * 1000.f);
+		end.samples.push_back(endTime * 1000.f);
+		finish.samples.push_back(finishTime * 1000.f);
+		frame.samples.push_back(frameTime * 1000.f);
+	}
+
+	// Every frame submits the same work, the last one stands for all of them
+	auto& stats = Engine::RenderStats::getLastFrame();
+
+	nlohmann::json report;
+	report["name"] = scenario.name;
+	report["instances"] = instances;
+	report["geometries"] = geometries;
+	report["materials"] = materials;
+	report["skinned"] = scenario.skinned;
+	report["cpu_ms"]["begin"] = begin.summary();
+	report["cpu_ms"]["skin"] = skin.summary();
+	report["cpu_ms"]["submit"] = submit.summary();
+	report["cpu_ms"]["end"] = end.summary();
+	report["cpu_ms"]["gpu_wait"] = finish.summary();
+	report["cpu_ms"]["frame"] = frame.summary();
+	report["stats"]["draw_calls"] = stats.drawCalls;
+	report["stats"]["draw_commands"] = stats.drawCommands;
+	report["stats"]["drawn_instances"] = stats.instances;
+	report["stats"]["dispatches"] = stats.dispatches;
+	report["stats"]["batch_flushes"] = stats.batchFlushes;
+	report["stats"]["forced_flushes"] = stats.forcedFlushes;
+	report["stats"]["program_binds"] = stats.programBinds;
+	report["stats"]["texture_binds"] = stats.textureBinds;
+	report["stats"]["buffer_uploads"] = stats.bufferUploads;
+	report["stats"]["bytes_uploaded"] = stats.bytesUploaded;
+	if (Engine::GPUTimer::isEnabled())
+		report["gpu_frame_ms"] = Engine::GPUTimer::getStats().frameTime * 1000.f;
+
+	Engine::Log::release("{0}: submit {1:.3f} ms, end {2:.3f} ms, {3} draw calls", scenario.name, report["cpu_ms"]["submit"]["mean"].get<double>(), report["cpu_ms"]["end"]["mean"].get<double>(), stats.drawCalls);
+	return report;
+}
+
+std::vector<RendererScenario> RendererBenchmark::defaultScenarios()
+{
+	return {
+		{ "static_1k_1geo_1mat", 1000, 1, 1, false },
+		{ "static_10k_1geo_1mat", 10000, 1, 1, false },
+		{ "static_10k_16geo_1mat", 10000, 16, 1, false },
+		{ "static_10k_16geo_4mat", 10000, 16, 4, false },
+		{ "static_10k_64geo_16mat", 10000, 64, 16, false },
+		{ "static_50k_64geo_4mat", 50000, 64, 4, false },
+		{ "skinned_64_4geo_4mat", 64, 4, 4, true },
+		{ "skinned_256_4geo_4mat", 256, 4, 4, true }
+	};
+}
@@ -2,6 +2,8 @@
 
 #include "Core/Initialization/Application.h"
 #include "Core/Initialization/Window.h"
+#include "Core/Systems/Utility/JobSystem.h"
+#include "Core/Systems/Utility/Profiler.h"
 #include "Core/Systems/Utility/Log.h"
 #include "Core/Systems/Utility/Timer.h"
 #include "Core/Systems/Events/Events.h"
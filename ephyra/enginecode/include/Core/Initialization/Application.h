@@ -7,7 +7,11 @@
 #include "Core/Initialization/Window.h"
 #include "Core/Resources/Utility/CameraFPS.h"
 #include "Core/Resources/Utility/LayerStack.h"
+#include "Core/Systems/Utility/FixedTimestep.h"
+#include "Core/Systems/Utility/FramePacer.h"
+#include "Core/Systems/Utility/JobSystem.h"
 #include "Core/Systems/Utility/Log.h"
+#include "Core/Systems/Utility/Profiler.h"
 #include "Core/Systems/Utility/Timer.h"
 #include "Core/Systems/Events/Event.h"
 #include "Core/Systems/Events/EventHandler.h"
@@ -23,6 +27,7 @@ namespace Engine {
      * \brief Fundemental class of the engine. A singleton which runs the game loop infinitely.
      * 
      * The Application class is a fundamental class of the engine. It is a singleton class that runs the game loop infinitely. It provides various functionalities for the engine.
+     * Started with --headless the window is created hidden and without vsync, for runs on machines nobody is watching.
      */
 	class Application
 	{
@@ -30,6 +35,7 @@ namespace Engine {
 		Application(); //!< Constructor
 
 		std::shared_ptr<Log> m_logSystem;
+		std::shared_ptr<JobSystem> m_jobSystem;
 		std::shared_ptr<Timer> m_timer;
 
 		std::shared_ptr<System> m_windowsSystem;
@@ -39,6 +45,20 @@ namespace Engine {
 		std::shared_ptr<LayerStack> m_layerStack;
 
 		float deltaTime;
+
+		/** \struct PipelineStats
+		*	Seconds spent in each stage of the last frame
+		*/
+		struct PipelineStats
+		{
+			float simulation = 0.f; //!< Simulation and extraction of the pipelined layers
+			float render = 0.f; //!< Rendering of the pipelined layers
+			float other = 0.f; //!< Layers that are not pipelined, syncing and draining main thread jobs
+			float frame = 0.f; //!< Whole loop iteration including the buffer swap
+		};
+		PipelineStats m_pipelineStats; //!< Timings of the last frame
+		FixedTimestep m_fixedTimestep; //!< Turns frame time into simulation ticks
+		FramePacer m_framePacer; //!< Holds frames to a target rate
 		
 
 		EventHandler m_handler;
@@ -152,14 +172,37 @@ namespace Engine {
 
 	private:
 		static Application* s_instance; //!< Singleton instance of the application
+		static std::vector<std::string> s_arguments; //!< Command line without the program name
 		bool m_running = true; //!< Is the application running?
+		int m_exitCode = 0; //!< Returned from main once the loop ends
+		float m_fixedDelta = 0.f; //!< Seconds every frame steps by, 0 to measure them
 		bool m_focus = true;
+		bool m_pipelined = false; //!< Simulate the next frame on a worker while the current one renders
+		bool m_primed = false; //!< Whether the pipelined layers hold an extracted frame to render
+
+		void runFixedUpdates(); //!< Run every tick the frame's time covers on every layer
+		void runSequential(); //!< Update every layer in order
+		void runPipelined(); //!< Simulate frame N+1 alongside rendering frame N
 
 	public:
 		virtual ~Application(); //!< Deconstructor
 		inline static Application& getInstance() { return *s_instance; } //!< Instance getter from singleton pattern
 		inline static std::shared_ptr<Window> getWindow() { return s_instance->m_window; }
 		void run(); //!< Main loop
+		inline void setPipelined(bool pipelined) { m_pipelined = pipelined; } //!< Overlap simulation and rendering, adds a frame of latency
+		inline bool isPipelined() const { return m_pipelined; } //!< Whether simulation and rendering overlap
+		inline const PipelineStats& getPipelineStats() const { return m_pipelineStats; } //!< Stage timings of the last frame
+		inline FixedTimestep& getFixedTimestep() { return m_fixedTimestep; } //!< Tick rate, budget and the interpolation fraction of the current frame
+		inline FramePacer& getFramePacer() { return m_framePacer; } //!< Frame rate limit
+		inline void setFixedDelta(float delta) { m_fixedDelta = delta > 0.f ? delta : 0.f; } //!< Step every frame by this many seconds rather than the time it took, 0 to measure
+		inline float getFixedDelta() const { return m_fixedDelta; } //!< Seconds every frame steps by, 0 when measured
+		inline void close(int exitCode = 0) { m_running = false; m_exitCode = exitCode; } //!< Leave the loop once this frame is done
+		inline int getExitCode() const { return m_exitCode; } //!< Code main returns
+
+		inline static void setCommandLine(int argc, char** argv) { s_arguments.assign(argv + 1, argv + argc); } //!< Called by main before the application is created
+		inline static const std::vector<std::string>& getCommandLine() { return s_arguments; } //!< Arguments without the program name
+		static bool hasArgument(const std::string& name); //!< Whether a flag was given
+		static std::string getArgument(const std::string& name, const std::string& fallback = ""); //!< Value after a flag, the fallback if it was not given
 	};
 
 	// To be defined in users code
@@ -16,13 +16,15 @@ extern Engine::Application* Engine::startApplication();
  * \brief The main function of the application.
  * \param argc The number of command-line arguments.
  * \param argv An array of command-line arguments.
- * \return The exit code of the application.
+ * \return The exit code the application closed with.
  */
 int main(int argc, char** argv)
 {
+	Engine::Application::setCommandLine(argc, argv);
 	auto application = Engine::startApplication();
 	application->run();
+	int exitCode = application->getExitCode();
 	delete application;
 
-	return 0;
+	return exitCode;
 }
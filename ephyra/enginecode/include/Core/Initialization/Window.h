@@ -12,6 +12,7 @@ namespace Engine
 		uint32_t m_width, m_height;
 		bool m_isFullscreen;
 		bool m_isVSync;
+		bool m_isHidden = false; //!< Create the window without showing it, it can still be drawn to
 		glm::vec2 m_position;
 		WindowProperties(char * title = "Ephyra Animation Engine", uint32_t width = 1024, uint32_t height = 800, bool fullscreen = false) : m_title(title), m_width(width), m_height(height), m_isFullscreen(fullscreen) {}
 	};
@@ -0,0 +1,66 @@
+/** \file renderStats.h */
+#pragma once
+
+#include <array>
+#include <cstdint>
+
+namespace Engine
+{
+	/** \struct RenderFrameStats
+	*	What one frame asked of the GL
+	*/
+	struct RenderFrameStats
+	{
+		uint32_t drawCalls = 0; //!< Draw calls, a multi draw counts once
+		uint32_t drawCommands = 0; //!< Draws performed, one per command of a multi draw
+		uint32_t instances = 0; //!< Instances drawn across every draw
+		uint32_t dispatches = 0; //!< Compute dispatches
+		uint32_t batchFlushes = 0; //!< Batches flushed by the 2D and 3D renderers
+		uint32_t forcedFlushes = 0; //!< Of those, flushed early because every texture unit was taken
+		uint32_t programBinds = 0; //!< Shader programs made current
+		uint32_t textureBinds = 0; //!< Textures bound to a unit
+		uint32_t bufferUploads = 0; //!< Buffer and texture writes
+		uint64_t bytesUploaded = 0; //!< Bytes written by those uploads
+	};
+
+	/** \class RenderStats
+	*	Counts the GL work of each frame from the renderers and the GL wrappers. Counting is only done on the thread owning
+	*	the context, and the application closes each frame after presenting it, keeping a history of finished frames.
+	*/
+	class RenderStats
+	{
+	public:
+		constexpr static uint32_t historySize = 240; //!< Finished frames kept
+
+		inline static void draw(uint32_t commands = 1, uint32_t instances = 1) { s_current.drawCalls++; s_current.drawCommands += commands; s_current.instances += instances; } //!< Count a draw call
+		inline static void dispatch() { s_current.dispatches++; } //!< Count a compute dispatch
+		inline static void batchFlush() { s_current.batchFlushes++; } //!< Count a batch flush
+		inline static void forcedFlush() { s_current.forcedFlushes++; } //!< Count a flush made early because every texture unit was taken, the flush counts itself as well
+		inline static void programBind() { s_current.programBinds++; } //!< Count a program made current
+		inline static void textureBind() { s_current.textureBinds++; } //!< Count a texture bound to a unit
+		inline static void upload(uint64_t bytes) { s_current.bufferUploads++; s_current.bytesUploaded += bytes; } //!< Count a write to a buffer or texture
+
+		inline static void endFrame()
+		{
+			s_history[s_historyNext] = s_current;
+			s_historyNext = (s_historyNext + 1) % historySize;
+			if (s_historyCount < historySize) s_historyCount++;
+			s_current = RenderFrameStats();
+		} //!< Finish the frame, called by the application once it is presented
+
+		inline static const RenderFrameStats& getCurrent() { return s_current; } //!< Counters of the frame so far
+		inline static const RenderFrameStats& getLastFrame() { return getHistory(0); } //!< Counters of the latest finished frame
+		inline static uint32_t getHistoryCount() { return s_historyCount; } //!< Finished frames held, up to the history size
+		inline static const RenderFrameStats& getHistory(uint32_t framesAgo)
+		{
+			static const RenderFrameStats none;
+			if (framesAgo >= s_historyCount) return none;
+			return s_history[(s_historyNext + historySize - 1 - framesAgo) % historySize];
+		} //!< Counters of a finished frame, 0 being the latest, zeros past the history
+	private:
+		inline static RenderFrameStats s_current; //!< Frame being counted
+		inline static std::array<RenderFrameStats, historySize> s_history; //!< Ring of finished frames
+		inline static uint32_t s_historyNext = 0; //!< Slot the next finished frame goes in
+		inline static uint32_t s_historyCount = 0; //!< Finished frames held
+	};
+}
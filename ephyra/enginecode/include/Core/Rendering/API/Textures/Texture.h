@@ -31,6 +31,7 @@ namespace Engine
 
 		static Texture* create(const char* filepath);
 		static Texture* create(uint32_t width, uint32_t height, uint32_t channels, unsigned char* data);
+		static Texture* createFloat(uint32_t width, uint32_t height, uint32_t channels, float* data); //!< Unfiltered float texture, read with texelFetch
 
 	protected:
 		std::string m_filepath;
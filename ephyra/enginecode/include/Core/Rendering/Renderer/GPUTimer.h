@@ -0,0 +1,62 @@
+/** \file gpuTimer.h */
+#pragma once
+
+#include <cstdint>
+#include <vector>
+
+namespace Engine
+{
+	/** \struct GPUTimerResult
+	*	GPU time of one zone of a finished frame
+	*/
+	struct GPUTimerResult
+	{
+		const char* name; //!< Zone name
+		float time; //!< Seconds between the GPU reaching the start and the end of the zone
+		uint32_t depth; //!< Zones it is nested in
+	};
+
+	/** \struct GPUTimerStats
+	*	State of the frames in flight
+	*/
+	struct GPUTimerStats
+	{
+		float frameTime = 0.f; //!< GPU seconds of the latest finished frame
+		uint32_t latency = 0; //!< Frames between issuing the latest finished frame and reading it
+		uint32_t dropped = 0; //!< Frames whose queries were reused before their results arrived
+		uint32_t queries = 0; //!< Query objects pooled
+	};
+
+	/** \class GPUTimer
+	*	Times zones of a frame on the GPU with timestamp queries. Each frame takes its queries from its own pool of a ring,
+	*	and a frame's results are only read once the GPU reports them available, a few frames later, so reading never
+	*	waits on the GPU. Timestamps are used rather than elapsed time queries, which cannot nest.
+	*/
+	class GPUTimer
+	{
+	public:
+		constexpr static uint32_t frameLatency = 4; //!< Frames of queries in flight before a frame's pool is reused
+
+		static void init(); //!< Check timestamp queries are usable, with a current context
+		static void setEnabled(bool enabled); //!< Time frames or not
+		static bool isEnabled(); //!< Whether frames are timed
+		static void beginFrame(); //!< Collect finished frames and open a frame zone
+		static void endFrame(); //!< Close the frame zone and any left open
+		static void begin(const char* name); //!< Open a zone inside the frame, name must outlive the frame's results
+		static void end(); //!< Close the innermost open zone
+		static const std::vector<GPUTimerResult>& getResults(); //!< Zones of the latest finished frame in the order they opened
+		static const GPUTimerStats& getStats(); //!< State of the frames in flight
+	};
+
+	/** \class GPUTimerScope
+	*	Zone timed on the GPU from construction to destruction
+	*/
+	class GPUTimerScope
+	{
+	public:
+		GPUTimerScope(const char* name) { GPUTimer::begin(name); } //!< Constructor, opens the zone
+		~GPUTimerScope() { GPUTimer::end(); } //!< Destructor, closes the zone
+		GPUTimerScope(const GPUTimerScope&) = delete;
+		GPUTimerScope& operator=(const GPUTimerScope&) = delete;
+	};
+}
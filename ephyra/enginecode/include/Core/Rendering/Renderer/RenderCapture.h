@@ -0,0 +1,157 @@
+/** \file renderCapture.h */
+#pragma once
+
+#include "Core/Rendering/Renderer/Renderer2D.h"
+#include "Core/Rendering/Renderer/Renderer3D.h"
+
+#include <array>
+#include <cstdint>
+#include <string>
+#include <unordered_map>
+#include <vector>
+
+namespace Engine
+{
+	/** \struct RenderCaptureStats
+	*	What a capture holds
+	*/
+	struct RenderCaptureStats
+	{
+		uint32_t frames = 0; //!< Whole frames recorded
+		uint32_t geometries = 0; //!< Meshes written
+		uint32_t materials = 0; //!< Materials written
+		uint32_t textures = 0; //!< Textures written
+		uint32_t calls = 0; //!< Renderer calls recorded
+		uint64_t bytes = 0; //!< Size of the stream
+	};
+
+	/** \class RenderCapture
+	*	Records the calls the renderers receive into a binary stream for RenderReplay to issue again without the editor.
+	*	A mesh is read back from the arenas and written the first time a frame draws it, materials and textures are written
+	*	as handles carrying what a stand-in needs. Recording starts at the next frame boundary and only keeps whole frames.
+	*	Visible retained instances are recorded as ordinary submits. Skinning dispatches and crowds are not recorded, a
+	*	skinned copy replays in the pose it was first drawn in.
+	*/
+	class RenderCapture
+	{
+	public:
+		constexpr static uint32_t magic = 0x50435245; //!< "ERCP"
+		constexpr static uint32_t version = 1; //!< Bumped whenever the stream layout changes
+
+		/** \enum Op
+		*	Tag before each record of the stream
+		*/
+		enum class Op : uint8_t
+		{
+			Geometry = 1, //!< Handle, counts, then vertices, indices and meshlets
+			Texture, //!< Handle, width, height and channels
+			Material, //!< Handle, flags, tint, shader handle and texture handles
+			Lights, //!< Light positions and colours, written when they change
+			Begin3D = 16, //!< Projection, view and view position
+			Submit3D, //!< Geometry handle, material handle and the top three rows of the model matrix
+			End3D, //!< Whether post effects ran and which
+			Begin2D = 32, //!< Projection and view
+			Submit2D, //!< Quad translation and scale, texture handle, UVs and tint
+			End2D, //!< End of the 2D scene
+			FrameEnd = 48 //!< Frame boundary
+		};
+
+		static bool begin(const std::string& filepath, uint32_t frames); //!< Record the next frames to a file, false if a capture is running or the file cannot be opened
+		static void stop(); //!< Finish early, a frame in progress is dropped
+		static bool isCapturing(); //!< Whether waiting to start or recording
+		static const RenderCaptureStats& getStats(); //!< Contents of the running or latest capture
+		static void endFrame(); //!< Frame boundary, called by the application once it is presented
+
+		static void recordBegin3D(const SceneWideUniforms& sceneWideUniforms); //!< Called by Renderer3D::begin
+		static void recordSubmit3D(const Geometry& geometry, const std::shared_ptr<Material>& material, const glm::mat4& model); //!< Called by Renderer3D::submit and for each visible slot by Renderer3D::drawRetained
+		static void recordEnd3D(const bool* enabledEffects); //!< Called by Renderer3D::end, effects null without post processing
+		static void recordRemoveGeometry(const Geometry& geometry); //!< Called by Renderer3D when a mesh is released, a mesh later given its id is written again
+		static void recordBegin2D(const SceneWideUniforms& sceneWideUniforms); //!< Called by Renderer2D::begin
+		static void recordSubmit2D(const glm::vec3& translate, const glm::vec3& scale, const SubTexture& texture, const glm::vec4& tint); //!< Called by Renderer2D::submit for every quad and glyph
+		static void recordEnd2D(); //!< Called by Renderer2D::end
+	};
+
+	/** \class RenderReplay
+	*	Loads a capture and issues its frames to the renderers. Meshes are uploaded again, textures are replaced by blank
+	*	ones of the same size, and every captured shader by its own instance of the replay shader, so program and texture
+	*	binds match the capture while pixels do not.
+	*/
+	class RenderReplay
+	{
+	public:
+		bool load(const std::string& filepath, const std::string& shaderFilepath); //!< Read a capture and create its resources, needs both renderers initialised
+		void replayFrame(uint32_t frame); //!< Issue one frame's calls
+		inline uint32_t getFrameCount() const { return static_cast<uint32_t>(m_frames.size()); } //!< Whole frames in the capture
+		inline const RenderCaptureStats& getStats() const { return m_stats; } //!< Contents of the capture
+	private:
+		/** \struct Call
+		*	Renderer call of a frame, decoded at load so replaying does no parsing
+		*/
+		struct Call
+		{
+			RenderCapture::Op op; //!< Which call
+			uint32_t index; //!< Into the list holding the call's arguments
+		};
+
+		/** \struct Camera3D
+		*	Arguments of a 3D begin
+		*/
+		struct Camera3D
+		{
+			glm::mat4 projection; //!< Projection
+			glm::mat4 view; //!< View
+			glm::vec3 viewPos; //!< Camera position
+		};
+
+		/** \struct Camera2D
+		*	Arguments of a 2D begin
+		*/
+		struct Camera2D
+		{
+			glm::mat4 projection; //!< Projection
+			glm::mat4 view; //!< View
+		};
+
+		/** \struct Lights
+		*	Light state set before a 3D begin
+		*/
+		struct Lights
+		{
+			std::vector<glm::vec3> positions; //!< RendererCommon::lightPos
+			std::vector<glm::vec3> colours; //!< RendererCommon::lightColour
+		};
+
+		/** \struct Submit2D
+		*	Arguments of a 2D submit
+		*/
+		struct Submit2D
+		{
+			Quad quad; //!< Quad drawn
+			SubTexture texture; //!< Stand-in texture and the captured UVs
+			glm::vec4 tint; //!< Tint
+		};
+
+		std::vector<Call> m_calls; //!< Every recorded call
+		std::vector<uint32_t> m_frames; //!< Index in m_calls one past each frame's last call
+		std::vector<Camera3D> m_cameras3D; //!< Arguments of 3D begins
+		std::vector<Camera2D> m_cameras2D; //!< Arguments of 2D begins
+		std::vector<Lights> m_lights; //!< Light changes
+		std::vector<BatchQueueEntry> m_submits3D; //!< Arguments of 3D submits
+		std::vector<Submit2D> m_submits2D; //!< Arguments of 2D submits
+		std::vector<std::array<bool, 16>> m_effects; //!< Post effects of 3D ends that ran them
+
+		std::string m_shaderFilepath; //!< Shader every captured shader is replaced by
+		std::unordered_map<uint32_t, Geometry> m_geometries; //!< Uploaded meshes by captured handle
+		std::unordered_map<uint32_t, std::shared_ptr<Texture>> m_textures; //!< Stand-in textures by captured handle
+		std::unordered_map<uint32_t, std::shared_ptr<Shader>> m_shaders; //!< Stand-in shaders by captured handle
+		std::unordered_map<uint32_t, std::shared_ptr<Material>> m_materials; //!< Materials by captured handle
+
+		glm::mat4 m_projection; //!< Camera the uniforms point at
+		glm::mat4 m_view; //!< Camera the uniforms point at
+		glm::vec3 m_viewPos; //!< Camera the uniforms point at
+		SceneWideUniforms m_uniforms; //!< Scene wide uniforms of both renderers
+		RenderCaptureStats m_stats; //!< Contents of the capture
+
+		std::shared_ptr<Shader> getShader(uint32_t handle); //!< Stand-in for a captured shader
+	};
+}
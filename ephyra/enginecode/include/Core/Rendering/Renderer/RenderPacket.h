@@ -0,0 +1,100 @@
+/** \file renderPacket.h */
+#pragma once
+
+#include "Core/Rendering/Renderer/Renderer3D.h"
+#include "Core/Resources/Utility/Bounds.h"
+
+#include <glm/gtc/type_ptr.hpp>
+
+#include <cstdint>
+#include <memory>
+#include <vector>
+
+namespace Engine
+{
+	/** \struct RenderPacketItem
+	*	One mesh to draw and a copy of the pose it is drawn in
+	*/
+	struct RenderPacketItem
+	{
+		constexpr static uint32_t noBounds = 0xFFFFFFFF; //!< Item is never depth tested
+
+		std::shared_ptr<Geometry> geometry; //!< Mesh as loaded
+		std::shared_ptr<Geometry> skinned; //!< Skinned copy drawn instead when set
+		std::shared_ptr<Material> material; //!< Material it is drawn with
+		glm::mat4 model = glm::mat4(1.f); //!< Model to world transform
+		uint32_t firstBone = 0; //!< First matrix of the pose in the packet's bones
+		uint32_t boneCount = 0; //!< Matrices in the pose, 0 for meshes without bones
+		uint32_t pose = 0; //!< Version of the pose in the bones, a skinned copy already holding it is not skinned again, 0 always skins
+		uint32_t bounds = noBounds; //!< Entry in the packet's bounds tested against the depth pyramid
+	};
+
+	/** \struct RenderPacketCrowd
+	*	One mesh of a crowd to draw
+	*/
+	struct RenderPacketCrowd
+	{
+		std::shared_ptr<VertexAnimation> animation; //!< Baked clip
+		Crowd crowd; //!< Instance range
+		std::shared_ptr<Material> material; //!< Material it is drawn with
+	};
+
+	/** \class RenderPacket
+	*	Everything the renderer needs from the scene for one frame, copied out so the scene can move on while it is drawn.
+	*	Meshes are held by shared pointer so a mesh removed from the scene stays alive until the frame drawing it is done.
+	*/
+	class RenderPacket
+	{
+	public:
+		RenderPacket()
+		{
+			uniforms["u_projection"] = std::pair<ShaderDataType, void*>(ShaderDataType::Mat4, static_cast<void*>(glm::value_ptr(projection)));
+			uniforms["u_view"] = std::pair<ShaderDataType, void*>(ShaderDataType::Mat4, static_cast<void*>(glm::value_ptr(view)));
+			uniforms["u_viewPos"] = std::pair<ShaderDataType, void*>(ShaderDataType::Float3, static_cast<void*>(glm::value_ptr(viewPos)));
+		} //!< Constructor, points the uniforms at this packet's camera
+		RenderPacket(const RenderPacket&) = delete;
+		RenderPacket& operator=(const RenderPacket&) = delete;
+
+		void clear()
+		{
+			lightPositions.clear();
+			lightColours.clear();
+			items.clear();
+			bones.clear();
+			crowds.clear();
+			bounds.clear();
+			boundsKeys.clear();
+			hiZ = false;
+		} //!< Empty for a new frame, keeping the capacity
+
+		glm::mat4 view = glm::mat4(1.f); //!< Camera view
+		glm::mat4 projection = glm::mat4(1.f); //!< Camera projection
+		glm::vec3 viewPos = glm::vec3(0.f); //!< Camera position
+		SceneWideUniforms uniforms; //!< Camera uniforms, pointing into this packet
+		float time = 0.f; //!< Animation time key of the frame
+
+		std::vector<glm::vec3> lightPositions; //!< World position per light
+		std::vector<glm::vec3> lightColours; //!< Colour per light
+		std::vector<RenderPacketItem> items; //!< Meshes drawn one by one
+		std::vector<glm::mat4> bones; //!< Pose matrices of every item
+		std::vector<RenderPacketCrowd> crowds; //!< Crowd meshes
+		std::vector<AABB> bounds; //!< World bounds tested against the depth pyramid
+		std::vector<uint32_t> boundsKeys; //!< Entity per bounds, depth pyramid results come back a frame later matched by it
+		std::vector<uint8_t> boundsVisible; //!< Depth pyramid result per bounds, filled when drawn
+		bool hiZ = false; //!< Test the items against the depth pyramid when drawing, set when extraction could not
+	};
+
+	/** \class RenderPacketBuffer
+	*	Two packets, the back one is filled by extraction while the front one is drawn, swapped once both are done
+	*/
+	class RenderPacketBuffer
+	{
+	public:
+		inline RenderPacket& getBack() { return m_packets[m_front ^ 1]; } //!< Packet being filled
+		inline RenderPacket& getFront() { return m_packets[m_front]; } //!< Packet being drawn
+		inline void swap() { m_front ^= 1; } //!< Hand the filled packet to the renderer
+	private:
+		RenderPacket m_packets[2]; //!< Front and back
+		uint32_t m_front = 0; //!< Index of the packet being drawn
+	};
+}
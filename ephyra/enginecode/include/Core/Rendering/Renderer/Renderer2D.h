@@ -48,6 +48,19 @@ namespace Engine
 	class Renderer2D
 	{
 	public:
+		struct GlyphMetrics
+		{
+			glm::vec2 size; //!< Bitmap size in pixels
+			glm::vec2 bearing; //!< Offset from the pen to the bitmap's top left
+			float advance; //!< Pen advance in pixels
+		};
+
+		struct GlyphQuad
+		{
+			Quad quad; //!< Where the glyph is drawn
+			uint32_t glyph; //!< Index into the glyph table
+		};
+
 		static void init(); //!< Init Internal Data
 		static void begin(const SceneWideUniforms& swu); //!< Begin Scene
 		static void submit(const Quad& quad, const glm::vec4& tint); //!< Render tinted quad
@@ -64,14 +77,10 @@ namespace Engine
 
 		static void end();
 		static void flush();
+
+		static Quad layoutGlyph(const GlyphMetrics& glyph, const glm::vec2& position, float charScale); //!< Quad of a glyph with the pen at position, no GL work
+		static void layoutText(const std::vector<GlyphMetrics>& glyphs, unsigned char firstGlyph, const char* str, const glm::vec2& position, float charScale, std::vector<GlyphQuad>& quads); //!< Quads of every printable character of a string, no GL work
 	private:
-		struct GlyphData
-		{
-			glm::vec2 size;
-			glm::vec2 bearing;
-			float advance;
-			SubTexture subTexture;
-		};
 
 		struct InternalData
 		{
@@ -90,7 +99,9 @@ namespace Engine
 			int32_t charSize;
 			unsigned char firstGlyph = 32;
 			unsigned char lastGlyph = 126;
-			std::vector<GlyphData> glyphData;
+			std::vector<GlyphMetrics> glyphMetrics;
+			std::vector<SubTexture> glyphTextures;
+			std::vector<GlyphQuad> textQuads;
 			TextureAtlas glyphAtlas;
 		};
 
@@ -5,11 +5,14 @@
 #include "Core/Rendering/API/Buffers/IndirectBuffer.h"
 #include "Core/Rendering/Renderer/Renderer2D.h"
 #include "Core/Rendering/API/Global/RendererCommon.h"
+#include "Core/Resources/Utility/Bounds.h"
+#include "Core/Resources/Utility/Meshlets.h"
 
 #include <vector>
 #include <ft2build.h>
 #include <freetype/freetype.h>
 #include <memory>
+#include <unordered_map>
 
 
 namespace Engine
@@ -86,10 +89,74 @@ namespace Engine
 		uint32_t indexCount;
 		uint32_t firstVertex;
 		uint32_t firstIndex;
+		bool hasBones = false; //!< Any vertex carries bone weights, skinned in the vertex shader so it cannot take the depth prepass
+		uint32_t firstMeshlet = 0; //!< First cluster in the renderer's meshlet list
+		uint32_t meshletCount = 0; //!< Clusters, 0 if the mesh is always drawn whole
 		std::string Filepath;
 		void addFilepath(std::string filepath) { Filepath = filepath; };
 	};
 
+	/** \struct VertexAnimation
+	*	Clip baked into position and normal textures, one texel per vertex per frame
+	*/
+	struct VertexAnimation
+	{
+		Geometry geometry; //!< Source mesh, provides the index range and UVs
+		std::shared_ptr<Texture> positions; //!< Skinned positions, RGBA32F
+		std::shared_ptr<Texture> normals; //!< Skinned normals, RGBA32F
+		uint32_t frameCount = 0; //!< Number of baked frames, the clip loops from the last back to the first
+		float framesPerSecond = 30.f; //!< Rate the clip was sampled at
+
+		constexpr static uint32_t textureWidth = 2048; //!< Texels per row, frames wrap across rows
+	};
+
+	/** \struct Crowd
+	*	Range of retained instances drawn with a vertex animation
+	*/
+	struct Crowd
+	{
+		uint32_t firstInstance = 0; //!< First instance in the crowd instance buffers
+		uint32_t instanceCount = 0; //!< Number of instances
+	};
+
+	/** \struct RetainedStats
+	*	Work done by the retained instance path, per frame apart from the totals
+	*/
+	struct RetainedStats
+	{
+		uint32_t instances = 0; //!< Live retained slots
+		uint32_t visible = 0; //!< Slots currently drawn
+		uint32_t draws = 0; //!< Multi draws issued this frame, one per material
+		uint32_t patchedInstances = 0; //!< Instance transforms and tints uploaded this frame
+		uint32_t patchedCommands = 0; //!< Draw commands uploaded this frame for visibility changes
+		uint32_t rebuilds = 0; //!< Times the draw commands were rebuilt for membership changes, in total
+
+		void reset() { draws = 0; patchedInstances = 0; patchedCommands = 0; } //!< Clear the per frame counters
+	};
+
+	/** \struct AffineInstance
+	*	Per instance model matrix without its constant bottom row, the top three rows of the matrix in 48 bytes
+	*/
+	struct AffineInstance
+	{
+		glm::vec4 rows[3]; //!< Rows of the 3x4 affine transform
+
+		static AffineInstance encode(const glm::mat4& model); //!< Drop the (0,0,0,1) row
+		glm::mat4 decode() const; //!< Restore the (0,0,0,1) row
+	};
+
+	/** \struct RigidInstance
+	*	Per instance transform of a prop with only rotation, translation and uniform scale, 32 bytes
+	*/
+	struct RigidInstance
+	{
+		glm::vec4 rotation; //!< Unit quaternion as (x, y, z, w)
+		glm::vec3 position; //!< Translation
+		float scale; //!< Uniform scale
+
+		static bool encode(const glm::mat4& model, RigidInstance& instance); //!< False if the matrix has shear, non-uniform scale or a reflection
+	};
+
 	struct Light
 	{
 		glm::vec3 lightPos;
@@ -117,17 +184,108 @@ namespace Engine
 		static void flush(); //!< Flush All Draw Queues
 
 		static void initShader(std::shared_ptr<Shader> shader); //!< Attach Shader To The Current Render Context
-		static bool addGeometry(std::vector<Renderer3DVertex> vertices, std::vector<uint32_t> indices, Geometry& VAO);
+		static bool addGeometry(std::vector<Renderer3DVertex> vertices, std::vector<uint32_t> indices, Geometry& VAO, const std::vector<Meshlet>& meshlets = std::vector<Meshlet>()); //!< Upload a mesh, with clusters indexing into its already reordered indices
+		static void readGeometry(const Geometry& geometry, std::vector<Renderer3DVertex>& vertices, std::vector<uint32_t>& indices, std::vector<Meshlet>& meshlets); //!< Read a mesh back from the arenas, waits for the GPU
+		static void clearIndices(uint32_t firstIndex, uint32_t indexCount); //!< Overwrite part of the index arena with degenerate triangles so it draws nothing
+		static void removeGeometry(const Geometry& geometry); //!< Release a mesh's arena ranges and command slot, reused once the frames that may still draw it have ended
+		static bool addSkinnedGeometry(const Geometry& source, Geometry& skinned); //!< Reserve arena space for a skinned copy of a mesh
+		static void removeSkinnedGeometry(const Geometry& skinned); //!< Release a skinned copy, the index range it shares stays with the source
+		static void skin(const Geometry& source, const Geometry& skinned, glm::mat4* boneMatrices, uint32_t boneCount, uint32_t pose = 0); //!< Skin a mesh into its reserved copy with the compute pre-pass, skipped when the copy already holds this pose version, 0 always skins
+		static bool addCrowd(const std::vector<glm::mat4>& models, const std::vector<glm::vec2>& playback, Crowd& crowd); //!< Upload a crowd's instances once, playback is (time offset, rate) per instance
+		static void submitCrowd(const VertexAnimation& animation, const Crowd& crowd, const std::shared_ptr<Material>& material, float time); //!< Draw every instance of a crowd in one call
+		static void removeCrowd(const Crowd& crowd); //!< Release a crowd's instance range, reused once the frames that may still draw it have ended
+		static bool addRetained(const Geometry& geometry, const std::shared_ptr<Material>& material, const glm::mat4& model, uint32_t& slot); //!< Give a mesh a persistent instance slot, hidden until made visible
+		static void removeRetained(uint32_t slot); //!< Free a slot, the draw commands are rebuilt at the next draw
+		static void setRetainedTransform(uint32_t slot, const glm::mat4& model); //!< Patch a slot's transform
+		static void setRetainedMaterial(uint32_t slot, const std::shared_ptr<Material>& material); //!< Patch a slot's tint, a different material also rebuilds the draw commands
+		static void setRetainedVisible(uint32_t slot, bool visible); //!< Patch a slot's draw command to draw it or not
+		static void drawRetained(); //!< Draw every visible retained slot, one multi draw per material, without the depth prepass, Hi-Z or meshlet culling
+		static inline const RetainedStats& getRetainedStats() { return s_data->retainedStats; } //!< Counters from the current frame so far
+
+		static void setDepthPrepass(bool enabled); //!< Lay down depth with a position only pass, then shade only the visible surface of each pixel
+		static inline bool getDepthPrepass() { return s_data->depthPrepass; } //!< Whether the depth prepass is on
+		static void setHiZ(bool enabled); //!< Build a max depth pyramid from each frame's depth buffer
+		static bool testHiZ(const std::vector<AABB>& bounds, const std::vector<uint32_t>& keys, std::vector<uint8_t>& visible); //!< Queue world boxes against the previous frame's depth pyramid and apply the results queued by the last call, matched by key, 1 where visible, false if there are no results yet
+		static uint64_t getFragmentInvocations(bool depthPrepass); //!< Fragment shader invocations of the latest measured frame with or without the prepass, 0 until measured
+		static void setMeshletCulling(bool enabled, bool coneCulling); //!< Draw only the clusters of a mesh inside the frustum and, with cone culling, facing the camera
+		static inline const MeshletStats& getMeshletStats() { return s_data->meshletStats; } //!< Counters from the current frame so far
 	private:
+		static void drawImmediate(const Geometry& geometry, const std::shared_ptr<Material>& material, const glm::mat4& model); //!< Draw one piece of geometry with its material uniforms
 		static void flushBatch();
-		static void flushBatchCommands(std::shared_ptr<Shader>& shader, uint32_t instanceCount);
+		static void flushBatchCommands(std::shared_ptr<Shader>& shader, uint32_t instanceCount, bool rigid);
+		static void flushDepthPrepass(); //!< Prepass then equal depth shading of everything queued without bones
+		static void drawDepthPrepass(const std::vector<const BatchQueueEntry*>& entries); //!< Draw entries depth only in multi draws of at most the batch capacity
+		static bool appendClusterCommands(const Geometry& geometry, const glm::mat4& model, uint32_t instance, std::vector<DrawElementsIndirectCommand>& commands, bool recordStats = true); //!< Append a command per run of visible clusters, false if the geometry is drawn whole
+		static void beginMainPass(); //!< Start counting fragment shader invocations
+		static void endMainPass(); //!< Stop counting and build the depth pyramid
+		static void buildHiZ(); //!< Reduce the depth buffer into the pyramid
+		static void rebuildRetained(); //!< Order live slots by material and write a command per slot
+
+		/** \struct ArenaRange
+		*	Run of unused elements in one of the arenas
+		*/
+		struct ArenaRange
+		{
+			uint32_t first = 0; //!< First element
+			uint32_t count = 0; //!< Elements in the run
+		};
+
+		/** \struct RemovedGeometry
+		*	Released mesh waiting for the frames that may still draw it to end
+		*/
+		struct RemovedGeometry
+		{
+			Geometry geometry; //!< Ranges to release
+			bool ownsIndices = true; //!< False for a skinned copy sharing its source's indices and clusters
+			uint32_t frame = 0; //!< Frame it was removed in
+		};
+
+		/** \struct RemovedCrowd
+		*	Released crowd waiting for the frames that may still draw it to end
+		*/
+		struct RemovedCrowd
+		{
+			Crowd crowd; //!< Instance range to release
+			uint32_t frame = 0; //!< Frame it was removed in
+		};
+
+		static bool allocateRange(std::vector<ArenaRange>& freeRanges, uint32_t& end, uint32_t capacity, uint32_t count, uint32_t& first); //!< First fit from the released ranges, else from the end of the arena
+		static void releaseRange(std::vector<ArenaRange>& freeRanges, uint32_t& end, uint32_t first, uint32_t count); //!< Merge a range back in, moving the end down when it is the last
+		static uint32_t allocateCommand(); //!< Reuse a released command slot or append one
+		static void reclaimGeometry(); //!< Release the ranges of geometry and crowds no frame in flight can still draw
+
+		/** \struct RetainedSlot
+		*	Mesh drawn from a persistent instance slot
+		*/
+		struct RetainedSlot
+		{
+			Geometry geometry; //!< Mesh drawn
+			std::shared_ptr<Material> material; //!< Material drawn with, null while the slot is free
+			uint32_t command = 0; //!< Index of the slot's command since the last rebuild
+			bool visible = false; //!< Whether its command draws an instance
+		};
+
+		/** \struct RetainedDraw
+		*	Run of commands sharing a material
+		*/
+		struct RetainedDraw
+		{
+			std::shared_ptr<Material> material; //!< Material of every command in the run
+			uint32_t firstCommand = 0; //!< First command of the run
+			uint32_t commandCount = 0; //!< Commands in the run
+		};
 
 		struct InternalData
 		{	
 			std::shared_ptr<UniformBuffer> cameraUBO; //!< View and Proj Mats
 			std::shared_ptr<UniformBuffer> lightsUBO; //!< Scenewide Lighting Variables
 			std::shared_ptr<VertexArray> VAO; //!< All Static Meshes
+			std::shared_ptr<VertexArray> rigidVAO; //!< All Static Meshes With Rigid Instance Transforms
 			std::shared_ptr<IndirectBuffer> commands; //!< Command Buffer
+			std::shared_ptr<VertexArray> crowdVAO; //!< Static Meshes With Retained Crowd Instances
+			std::shared_ptr<Shader> skinningShader; //!< Compute Skinning Pre-Pass
+			bool skinningPending = false; //!< Skinned Vertices Written Since The Last Draw
+			std::vector<uint32_t> skinnedPoses; //!< Pose Version Each Skinned Copy Holds, By Command Slot, 0 For None
 			std::vector<BatchQueueEntry> batchQueue; //!< Queue Waiting To Be Drawn In Batches
 			std::vector<DrawElementsIndirectCommand> batchCommands; //!< Queue Of Commands Waiting To Be Called For Batches
 
@@ -136,8 +294,19 @@ namespace Engine
 			uint32_t indexCapacity = 0;
 			uint32_t nextVertex = 0;
 			uint32_t nextIndex = 0;
+			std::vector<ArenaRange> freeVertices; //!< Vertex Ranges Released For Reuse
+			std::vector<ArenaRange> freeIndices; //!< Index Ranges Released For Reuse
+			std::vector<ArenaRange> freeMeshlets; //!< Cluster Ranges Released For Reuse
+			std::vector<uint32_t> freeCommands; //!< Batch Command Slots Released For Reuse
+			std::vector<RemovedGeometry> removedGeometry; //!< Removed But Possibly Still In A Frame Being Drawn
+			uint32_t frame = 0; //!< Frames Begun
+			uint32_t crowdCapacity = 0;
+			uint32_t nextCrowdInstance = 0;
+			std::vector<ArenaRange> freeCrowdInstances; //!< Crowd Instance Ranges Released For Reuse
+			std::vector<RemovedCrowd> removedCrowds; //!< Removed But Possibly Still In A Frame Being Drawn
 
-			std::vector<glm::mat4> modelInstanceData;
+			std::vector<AffineInstance> affineInstanceData;
+			std::vector<RigidInstance> rigidInstanceData;
 			std::vector<uint32_t> tintInstanceData;
 			std::vector<uint32_t> normalInstanceData;
 			std::vector<uint32_t> albedoInstanceData;
@@ -145,6 +314,61 @@ namespace Engine
 			std::vector<uint32_t> roughnessInstanceData;
 			std::vector<uint32_t> aoInstanceData;
 
+			bool depthPrepass = false; //!< Position only depth pass before shading
+			std::shared_ptr<Shader> depthShader; //!< Position Only Depth Pass
+			std::shared_ptr<VertexArray> depthVAO; //!< Vertex Positions And Affine Transforms
+			std::shared_ptr<IndirectBuffer> depthCommands; //!< Command Buffer For The Depth Pass
+			std::vector<BatchQueueEntry> immediateQueue; //!< Immediate Submits Held Back Until The Depth Pass Has Run
+			std::vector<BatchQueueEntry> deferredBatch; //!< Batched Submits Held Back Until The Depth Pass Has Run
+			std::vector<DrawElementsIndirectCommand> depthCommandData;
+			std::vector<AffineInstance> depthInstanceData;
+
+			bool hiZ = false; //!< Build the depth pyramid each frame
+			bool hiZValid = false; //!< A pyramid has been built since it was enabled
+			std::shared_ptr<Shader> hiZShader; //!< Compute Depth Pyramid Reduction
+			std::shared_ptr<Shader> hiZCullShader; //!< Compute Box Test Against The Pyramid
+			std::shared_ptr<Texture> hiZTexture; //!< R32F Farthest Depth, One Mip Per Level
+			uint32_t hiZLevels = 0;
+			uint32_t hiZBoundsBuffers[2] = { 0, 0 }; //!< Box Corners Uploaded For Testing, Alternated Each Test
+			uint32_t hiZVisibleBuffers[2] = { 0, 0 }; //!< One Result Per Box, Read Back By The Next Test
+			uint32_t hiZCapacity[2] = { 0, 0 }; //!< Boxes Each Pair Of Test Buffers Can Hold
+			void* hiZFences[2] = { nullptr, nullptr }; //!< GLsync Signalled Once A Test's Results Are Written
+			std::vector<uint32_t> hiZKeys[2]; //!< Key Per Box Of Each Queued Test
+			uint32_t hiZSlot = 0; //!< Buffers The Next Test Is Queued In
+			std::vector<uint32_t> hiZReadback; //!< Results Copied Back From The GPU
+			std::unordered_map<uint32_t, uint8_t> hiZResults; //!< Latest Result By Key
+			glm::mat4 viewProjection = glm::mat4(1.f); //!< Camera Of The Current Frame
+			glm::mat4 hiZViewProjection = glm::mat4(1.f); //!< Camera The Pyramid Was Rendered With
+
+			bool pipelineStatistics = false; //!< Fragment invocation queries are supported
+			bool mainPassActive = false;
+			uint32_t invocationQueries[2] = { 0, 0 }; //!< Alternated Each Frame So Results Are Read A Frame Late
+			bool invocationQueryIssued[2] = { false, false };
+			bool invocationQueryPrepass[2] = { false, false }; //!< Whether The Frame Measured Used The Prepass
+			uint32_t invocationQueryIndex = 0;
+			uint64_t fragmentInvocations[2] = { 0, 0 }; //!< Latest Result Without And With The Prepass
+
+			bool meshletCulling = true; //!< Cull clusters of meshes that have them
+			bool meshletConeCulling = false; //!< Also cull clusters facing away from the camera, off by default as faces are not back face culled and open meshes would lose their inside
+			std::vector<Meshlet> meshlets; //!< Clusters Of Every Mesh, Ranges Given By Geometry
+			std::shared_ptr<IndirectBuffer> clusterCommands; //!< Command Buffer For Immediate Clustered Draws
+			std::vector<DrawElementsIndirectCommand> clusterCommandData; //!< Visible Cluster Commands Waiting To Be Drawn
+			glm::vec3 viewPosition = glm::vec3(0.f); //!< Camera Position Of The Current Frame
+			MeshletStats meshletStats;
+
+			std::shared_ptr<VertexArray> retainedVAO; //!< Static Meshes With Persistent Instance Slots
+			std::shared_ptr<IndirectBuffer> retainedCommands; //!< A Command Per Live Slot, Grouped By Material
+			uint32_t retainedCapacity = 0;
+			std::vector<RetainedSlot> retainedSlots;
+			std::vector<uint32_t> retainedFree; //!< Slots Released For Reuse
+			std::vector<AffineInstance> retainedModels; //!< CPU Copy Of The Instance Transforms
+			std::vector<uint32_t> retainedTints; //!< CPU Copy Of The Instance Tints
+			std::vector<DrawElementsIndirectCommand> retainedCommandData; //!< CPU Copy Of The Commands
+			std::vector<RetainedDraw> retainedDraws;
+			bool retainedRebuild = false; //!< Membership Or Materials Changed Since The Commands Were Built
+			uint32_t retainedDirtyInstances[2] = { UINT32_MAX, 0 }; //!< Range Of Slots To Upload, First And One Past The Last
+			uint32_t retainedDirtyCommands[2] = { UINT32_MAX, 0 }; //!< Range Of Commands To Upload, First And One Past The Last
+			RetainedStats retainedStats;
 		};
 
 		static std::shared_ptr<InternalData> s_data; //!< Data Internal To Renderer
@@ -45,6 +45,56 @@ namespace Engine
 		operator const glm::mat4& () const { return Transform; }
 	};
 
+	// TransformComponent holds the local transform, Transform is overwritten with the world matrix by the hierarchy update
+	struct HierarchyComponent
+	{
+		Engine::TransformHierarchy::Handle Node = Engine::TransformHierarchy::invalid;
+		entt::entity Parent = entt::null;
+
+		HierarchyComponent() = default;
+		HierarchyComponent(const HierarchyComponent&) = default;
+		HierarchyComponent(entt::entity entity, entt::entity parent)
+		{
+			std::shared_ptr<ResourceManager> resources;
+			resources = ResourceManager::getInstance();
+			auto& registry = resources->m_registry;
+
+			Engine::TransformHierarchy::Handle parentNode = Engine::TransformHierarchy::invalid;
+			if (parent != entt::null && registry.all_of<HierarchyComponent>(parent))
+			{
+				parentNode = registry.get<HierarchyComponent>(parent).Node;
+				Parent = parent;
+			}
+
+			Node = resources->transformHierarchy.create(parentNode, entt::to_integral(entity));
+			if (registry.all_of<TransformComponent>(entity))
+			{
+				auto& local = registry.get<TransformComponent>(entity);
+				resources->transformHierarchy.setLocal(Node, local.Translation, local.Rotation, local.Scale);
+			}
+		}
+	};
+
+	// Children of a removed node move up to its parent
+	static void onHierarchyDestroyed(entt::registry& registry, entt::entity entity)
+	{
+		std::shared_ptr<ResourceManager> resources;
+		resources = ResourceManager::getInstance();
+		auto& hierarchy = resources->transformHierarchy;
+		auto& removed = registry.get<HierarchyComponent>(entity);
+
+		if (!hierarchy.isValid(removed.Node)) return;
+
+		for (auto child : hierarchy.getChildren(removed.Node))
+		{
+			auto childEntity = entt::entity(hierarchy.getUserData(child));
+			if (registry.valid(childEntity) && registry.all_of<HierarchyComponent>(childEntity))
+				registry.get<HierarchyComponent>(childEntity).Parent = removed.Parent;
+		}
+
+		hierarchy.destroy(removed.Node);
+	}
+
 	struct MeshRendererComponent
 	{
 		std::vector<std::shared_ptr<Engine::Material>> Material;
@@ -69,6 +119,292 @@ namespace Engine
 		}
 	};
 
+	// Everything drawing and animating a mesh needs, resolved once so the per frame loops do no string lookups
+	struct RenderProxyComponent
+	{
+		std::vector<std::shared_ptr<Engine::Geometry>> Geometry; // Mesh handles, shared with the MeshRendererComponent
+		std::vector<std::shared_ptr<Engine::Material>> Material; // Material per mesh
+		std::vector<const std::vector<BoneInfo>*> Skeleton; // Bones per mesh in boneInfoList, null for meshes without bones
+		const aiScene* Scene = nullptr; // Loaded scene, its root node drives bone evaluation
+		std::string LoaderID; // Key into the loader maps, passed by reference where a lookup is unavoidable
+		Engine::AABB Bounds; // Bind pose model space bounds
+		std::shared_ptr<Engine::AnimatedBounds> AnimatedBounds; // Model space bounds per clip time range, null for static models
+		std::shared_ptr<Engine::OccluderMesh> Occluder; // CPU triangles, null for animated models
+		bool Animated = false; // Posed every frame
+
+		RenderProxyComponent() = default;
+		RenderProxyComponent(const RenderProxyComponent&) = default;
+		RenderProxyComponent(const MeshRendererComponent& mesh) : Geometry(mesh.Geometry), Material(mesh.Material)
+		{
+			std::shared_ptr<ResourceManager> resources;
+			resources = ResourceManager::getInstance();
+
+			auto ids = resources->FPToIDs.find(mesh.LoaderPath);
+			if (ids == resources->FPToIDs.end() || ids->second.empty()) return;
+			LoaderID = ids->second[0];
+
+			auto scene = sceneMapping.find(LoaderID);
+			if (scene != sceneMapping.end())
+			{
+				Scene = scene->second;
+				Animated = Scene->HasAnimations();
+			}
+
+			auto& meshNames = resources->IDToMeshNames[LoaderID];
+			for (int i = 0; i < Geometry.size(); i++)
+			{
+				auto bones = i < meshNames.size() ? boneInfoList.find(meshNames[i]) : boneInfoList.end();
+				Skeleton.push_back(bones != boneInfoList.end() ? &bones->second : nullptr);
+			}
+
+			auto bounds = resources->MeshBounds.find(LoaderID);
+			if (bounds != resources->MeshBounds.end()) Bounds = bounds->second;
+			auto animatedBounds = resources->AnimationBounds.find(LoaderID);
+			if (animatedBounds != resources->AnimationBounds.end()) AnimatedBounds = animatedBounds->second;
+			auto occluder = resources->OccluderMeshes.find(LoaderID);
+			if (occluder != resources->OccluderMeshes.end()) Occluder = occluder->second;
+		}
+
+		inline Engine::AABB getBounds(float time) const { return AnimatedBounds ? AnimatedBounds->query(time) : Bounds; } // Model space bounds at a clip time
+	};
+
+	static void onMeshRendererChanged(entt::registry& registry, entt::entity entity)
+	{
+		registry.emplace_or_replace<RenderProxyComponent>(entity, registry.get<MeshRendererComponent>(entity));
+	}
+
+	struct RetainedComponent
+	{
+		std::vector<uint32_t> Slots; // Persistent instance slot per mesh, empty if the renderer had no room
+		std::vector<uint32_t> Geometry; // Geometry id per slot, a different mesh list recreates the slots
+		std::vector<uint8_t> Visible; // Visibility last given to each slot
+
+		RetainedComponent() = default;
+		RetainedComponent(const RetainedComponent&) = default;
+		RetainedComponent(const MeshRendererComponent& mesh, const glm::mat4& transform)
+		{
+			for (int i = 0; i < mesh.Geometry.size() && i < mesh.Material.size(); i++)
+			{
+				uint32_t slot;
+				if (!mesh.Geometry[i] || !Engine::Renderer3D::addRetained(*mesh.Geometry[i], mesh.Material[i], transform, slot))
+				{
+					Log::error("Cannot retain {0}, retained instance buffer is full", mesh.LoaderPath);
+					for (auto added : Slots)
+						Engine::Renderer3D::removeRetained(added);
+					Slots.clear();
+					Geometry.clear();
+					break;
+				}
+				Slots.push_back(slot);
+				Geometry.push_back(mesh.Geometry[i]->id);
+			}
+			Visible.assign(Slots.size(), 0);
+		}
+
+		bool matches(const MeshRendererComponent& mesh) const
+		{
+			if (mesh.Geometry.size() != Geometry.size()) return false;
+			for (int i = 0; i < Geometry.size(); i++)
+				if (!mesh.Geometry[i] || mesh.Geometry[i]->id != Geometry[i]) return false;
+			return true;
+		}
+	};
+
+	// Created, moved, restyled or shown entities are queued and their retained slots patched once per update
+	static void onRetainedChanged(entt::registry& registry, entt::entity entity)
+	{
+		std::shared_ptr<ResourceManager> resources;
+		resources = ResourceManager::getInstance();
+		resources->retainedChanged.push_back(entity);
+	}
+
+	static void onMeshRendererDestroyed(entt::registry& registry, entt::entity entity)
+	{
+		registry.remove<RetainedComponent>(entity);
+		registry.remove<RenderProxyComponent>(entity);
+	}
+
+	static void onRetainedDestroyed(entt::registry& registry, entt::entity entity)
+	{
+		for (auto slot : registry.get<RetainedComponent>(entity).Slots)
+			Engine::Renderer3D::removeRetained(slot);
+	}
+
+	struct SkinnedMeshComponent
+	{
+		std::vector<std::shared_ptr<Engine::Geometry>> Geometry; // GPU skinned copy per mesh, null for meshes without bones
+
+		SkinnedMeshComponent() = default;
+		SkinnedMeshComponent(const SkinnedMeshComponent&) = default;
+		SkinnedMeshComponent(const MeshRendererComponent& mesh)
+		{
+			std::shared_ptr<ResourceManager> resources;
+			resources = ResourceManager::getInstance();
+			auto& meshNames = resources->IDToMeshNames[resources->FPToIDs[mesh.LoaderPath][0]];
+			for (int i = 0; i < mesh.Geometry.size(); i++)
+			{
+				std::shared_ptr<Engine::Geometry> skinned;
+				if (i < meshNames.size() && boneInfoList.find(meshNames[i]) != boneInfoList.end())
+				{
+					skinned = std::make_shared<Engine::Geometry>();
+					if (!Engine::Renderer3D::addSkinnedGeometry(*mesh.Geometry[i], *skinned)) skinned.reset();
+				}
+				Geometry.push_back(skinned);
+			}
+		}
+	};
+
+	// Skinned copies go back to the arena with their entity
+	static void onSkinnedMeshDestroyed(entt::registry& registry, entt::entity entity)
+	{
+		for (auto& skinned : registry.get<SkinnedMeshComponent>(entity).Geometry)
+			if (skinned) Engine::Renderer3D::removeSkinnedGeometry(*skinned);
+	}
+
+	struct AnimationLODComponent
+	{
+		uint32_t Level = 0; // Current LOD, AnimationLOD::offscreenLevel when outside the view
+		uint32_t Phase = 0; // Frame offset staggering evaluations across characters
+		uint32_t FramesSinceUpdate = 0; // Frames since the pose was last evaluated
+		std::vector<std::vector<glm::mat4>> PreviousPose; // Palette per mesh from the evaluation before last
+		std::vector<std::vector<glm::mat4>> CurrentPose; // Palette per mesh from the last evaluation
+		std::vector<std::vector<glm::mat4>> Pose; // Interpolated palette per mesh to draw this frame
+		float PreviousTime = -1.f; // Time key of the evaluation before last
+		float CurrentTime = -1.f; // Time key of the last evaluation
+		bool Reduced = false; // Whether the last evaluation skipped the minor joints
+		glm::vec3 PoseKey = glm::vec3(-1.f); // Times and blend Pose was made from
+		uint32_t PoseVersion = 0; // Bumped whenever Pose changes, skinned copies are only skinned again for a new version
+
+		AnimationLODComponent() = default;
+		AnimationLODComponent(const AnimationLODComponent&) = default;
+		AnimationLODComponent(uint32_t phase) : Phase(phase) {}
+	};
+
+	struct SpatialComponent
+	{
+		Engine::DynamicBVH::Proxy Proxy = Engine::DynamicBVH::null; // Leaf in the spatial index
+		uint32_t VisibleFrame = 0; // Last frame the proxy was inside the view frustum
+
+		SpatialComponent() = default;
+		SpatialComponent(const SpatialComponent&) = default;
+		SpatialComponent(entt::entity entity, const Engine::AABB& bounds)
+		{
+			std::shared_ptr<ResourceManager> resources;
+			resources = ResourceManager::getInstance();
+			Proxy = resources->spatialIndex.create(bounds, entt::to_integral(entity));
+		}
+	};
+
+	struct OccluderComponent
+	{
+		bool Occluder = true; // Drawn into the occlusion depth buffer, needs a static MeshRendererComponent
+
+		OccluderComponent() = default;
+		OccluderComponent(const OccluderComponent&) = default;
+		OccluderComponent(bool occluder) : Occluder(occluder) {}
+
+		operator bool& () { return Occluder; }
+	};
+
+	struct StaticComponent
+	{
+		bool Static = true; // Never moves, merged into the static batches at the next rebuild
+		bool Merged = false; // Some of its meshes are currently drawn by a batch
+		glm::mat4 MergedTransform = glm::mat4(1.f); // World transform baked into the batches, any change unmerges it
+
+		StaticComponent() = default;
+		StaticComponent(const StaticComponent&) = default;
+		StaticComponent(bool isStatic) : Static(isStatic) {}
+
+		operator bool& () { return Static; }
+	};
+
+	// Removed or edited entities are taken back out of their batches
+	static void onStaticDestroyed(entt::registry& registry, entt::entity entity)
+	{
+		std::shared_ptr<ResourceManager> resources;
+		resources = ResourceManager::getInstance();
+		if (registry.get<StaticComponent>(entity).Merged && resources->staticBatcher.unmerge(entt::to_integral(entity)))
+			resources->retainedChanged.push_back(entity);
+	}
+
+	static void onSpatialDestroyed(entt::registry& registry, entt::entity entity)
+	{
+		std::shared_ptr<ResourceManager> resources;
+		resources = ResourceManager::getInstance();
+		resources->spatialIndex.destroy(registry.get<SpatialComponent>(entity).Proxy);
+	}
+
+	struct CrowdComponent
+	{
+		std::vector<std::shared_ptr<Engine::Material>> Material;
+		std::vector<std::shared_ptr<Engine::VertexAnimation>> Animation; // Baked clip per mesh
+		Engine::Crowd Crowd; // Retained instance range
+
+		std::string LoaderPath;
+		uint32_t Count = 0; // Instances, laid out in rows from the entity's transform when spawned by count
+		float Spacing = 2.f; // Distance between neighbouring instances in the entity's local space
+
+		CrowdComponent() = default;
+		CrowdComponent(const CrowdComponent&) = default;
+		CrowdComponent(std::string filepath, std::string ID, const std::vector<glm::mat4>& models, const std::vector<glm::vec2>& playback)
+		{
+			if (!load(filepath, ID)) return;
+
+			Count = models.size();
+			if (!Engine::Renderer3D::addCrowd(models, playback, Crowd))
+				Log::error("Cannot add crowd of {0} instances for {1}, crowd buffer is full", models.size(), ID);
+		}
+		CrowdComponent(std::string filepath, std::string ID, const glm::mat4& origin, uint32_t count, float spacing) : Count(count), Spacing(spacing)
+		{
+			if (!load(filepath, ID) || Animation.empty()) return;
+
+			// Square rows centred on the origin, each instance starting at its own point of the clip at a slightly different rate
+			float duration = Animation[0]->frameCount / Animation[0]->framesPerSecond;
+			uint32_t columns = std::max(1u, (uint32_t)std::ceil(std::sqrt((float)count)));
+			std::vector<glm::mat4> models;
+			std::vector<glm::vec2> playback;
+			for (uint32_t i = 0; i < count; i++)
+			{
+				glm::vec3 offset(((i % columns) - (columns - 1) * 0.5f) * spacing, 0.f, ((i / columns) - (columns - 1) * 0.5f) * spacing);
+				models.push_back(origin * glm::translate(glm::mat4(1.f), offset));
+				playback.push_back({ glm::fract(i * 0.618034f) * duration, 0.9f + 0.2f * glm::fract(i * 0.754878f) });
+			}
+
+			if (!Engine::Renderer3D::addCrowd(models, playback, Crowd))
+				Log::error("Cannot add crowd of {0} instances for {1}, crowd buffer is full", count, ID);
+		}
+
+	private:
+		bool load(const std::string& filepath, const std::string& ID)
+		{
+			std::shared_ptr<ResourceManager> resources;
+			resources = ResourceManager::getInstance();
+			Engine::Loader::ASSIMPLoad(filepath, ID);
+			LoaderPath = filepath;
+
+			auto ids = resources->FPToIDs.find(filepath);
+			if (ids == resources->FPToIDs.end() || ids->second.empty()) return false;
+			std::string& loadedID = ids->second[0];
+			if (resources->VertexAnimations.find(loadedID) == resources->VertexAnimations.end())
+				if (!Engine::Loader::ASSIMPBakeVertexAnimation(loadedID)) return false;
+
+			for (int i = 0; i < resources->IDToMeshNames[loadedID].size(); i++)
+			{
+				std::string tempID = resources->IDToMeshNames[loadedID][i];
+				Material.push_back(resources->getAsset<Engine::Material>(tempID + "Material"));
+				Animation.push_back(resources->VertexAnimations[loadedID][i]);
+			}
+			return true;
+		}
+	};
+
+	// Crowd instance ranges go back to the renderer with their entity
+	static void onCrowdDestroyed(entt::registry& registry, entt::entity entity)
+	{
+		Engine::Renderer3D::removeCrowd(registry.get<CrowdComponent>(entity).Crowd);
+	}
+
 	struct SpriteRendererComponent
 	{
 		std::shared_ptr<Engine::Quad> Quad;
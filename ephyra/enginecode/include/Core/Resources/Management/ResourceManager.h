@@ -4,6 +4,15 @@
 
 #include "Core/Rendering/API/Global/RenderCommands.h"
 #include "Core/Rendering/API/Global/RendererCommon.h"
+#include "Core/Rendering/Renderer/Renderer3D.h"
+#include "Core/Resources/Utility/AnimatedBounds.h"
+#include "Core/Resources/Utility/AnimationCompression.h"
+#include "Core/Resources/Utility/AnimationLOD.h"
+#include "Core/Resources/Utility/DynamicBVH.h"
+#include "Core/Resources/Utility/OcclusionCuller.h"
+#include "Core/Resources/Utility/StaticBatcher.h"
+#include "Core/Resources/Utility/TransformHierarchy.h"
+#include "Core/Systems/Events/InputPath.h"
 
 #include <memory>
 #include <string>
@@ -79,11 +88,23 @@ namespace Engine
             return loadedAssets;
         }
 
+        size_t getAssetCount() const {
+            return loadedAssets.size();
+        }
+
+        // Drops every asset added after the first count, for callers that add temporary assets
+        void truncateAssets(size_t count) {
+            if (count < loadedAssets.size()) {
+                loadedAssets.erase(loadedAssets.begin() + count, loadedAssets.end());
+            }
+        }
+
         // Global Functionality
         
             // Window Management
         std::shared_ptr<Engine::Window> m_window; /**< Current Window Pointer Passed from SceneManager */
         std::shared_ptr<Engine::InputPoller> m_poller; /**< Current Input Poller Pointer Passed from SceneManager */
+        Engine::InputPath inputPath; /**< Camera Input And Timeline Recorded Or Played Back Each Tick */
 
             // Render Commands
         std::shared_ptr<Engine::RenderCommand> clearCommand; /**< The clear render command. */
@@ -111,8 +132,18 @@ namespace Engine
 
         std::unordered_map<std::string, std::vector<std::string>> FPToIDs;
         std::unordered_map<std::string, std::vector<std::string>> IDToMeshNames;
+        std::unordered_map<std::string, Engine::AABB> MeshBounds; /**< Bind Pose Model Space Bounds Keyed By Loader ID */
+        std::unordered_map<std::string, std::shared_ptr<Engine::OccluderMesh>> OccluderMeshes; /**< CPU Triangles Of Static Models Keyed By Loader ID */
         uint32_t fileCount = 0;
 
+            // Animation
+        std::unordered_map<std::string, std::shared_ptr<Engine::CompressedClip>> AnimationClips; /**< Cooked Clips Keyed By Loader ID */
+        Engine::AnimationCompressionSettings animationCompression; /**< Settings Used When Cooking Clips On Load */
+        std::unordered_map<std::string, std::shared_ptr<Engine::AnimatedBounds>> AnimationBounds; /**< Model Space Bounds Per Clip Time Range Keyed By Loader ID */
+        std::unordered_map<std::string, std::vector<std::shared_ptr<Engine::VertexAnimation>>> VertexAnimations; /**< Baked Clips Keyed By Loader ID, One Per Mesh */
+        Engine::AnimationLODSettings animationLOD; /**< Update Rates And Joint Reduction For Distant Characters */
+        Engine::AnimationLODStats animationLODStats; /**< Counters From The Last Animation Update */
+
         // GUI Layer
         bool isGuiActive = true;
         bool eDOF = false;
@@ -120,6 +151,15 @@ namespace Engine
         bool eBloom = true;
         bool eVignette = false;
         bool eToneMapping = true;
+        bool eGPUSkinning = true;
+        bool eFrustumCulling = true;
+        bool eOcclusionCulling = true;
+        bool eDepthPrepass = false;
+        bool eHiZCulling = false;
+        bool eMeshletCulling = true;
+        bool eMeshletConeCulling = false;
+        bool eStaticBatching = true;
+        bool eRetainedInstances = false;
 
         bool eViewport = true;
         bool eTextureViewer = false;
@@ -127,6 +167,7 @@ namespace Engine
         bool eAssets= true;
         bool eKeyframe = true;
         bool eHints = true;
+        bool eRenderStats = false;
 
         bool eIntroMessage = true;
 
@@ -140,6 +181,12 @@ namespace Engine
 
         // Registry
         entt::registry m_registry;
+        Engine::TransformHierarchy transformHierarchy; /**< Parent Child Transforms For Entities With A HierarchyComponent */
+        Engine::DynamicBVH spatialIndex; /**< World Bounds Of Rendered Entities, For Culling And Picking */
+        Engine::OcclusionCuller occlusionCuller; /**< CPU Depth Buffer Of Entities With An OccluderComponent */
+        Engine::StaticBatcher staticBatcher; /**< Merged Geometry Of Entities With A StaticComponent */
+        bool staticBatchesDirty = false; /**< Rebuild The Static Batches During The Next Update */
+        std::vector<entt::entity> retainedChanged; /**< Entities Whose Retained Instance Slots Need Patching, Filled By Registry Signals */
 
     private:
 
@@ -89,6 +89,40 @@ namespace Engine
                     };
                 }
 
+                // OccluderComponent
+                if (registry.all_of<OccluderComponent>(entityID)) {
+                    auto& entity = registry.get<OccluderComponent>(entityID);
+                    entityJson["OccluderComponent"] = {
+                        {"Occluder", {entity.Occluder}}
+                    };
+                }
+
+                // StaticComponent
+                if (registry.all_of<StaticComponent>(entityID)) {
+                    auto& entity = registry.get<StaticComponent>(entityID);
+                    entityJson["StaticComponent"] = {
+                        {"Static", {entity.Static}}
+                    };
+                }
+
+                // CrowdComponent
+                if (registry.all_of<CrowdComponent>(entityID)) {
+                    auto& entity = registry.get<CrowdComponent>(entityID);
+                    entityJson["CrowdComponent"] = {
+                        {"FilePath", {entity.LoaderPath}},
+                        {"Count", {entity.Count}},
+                        {"Spacing", {entity.Spacing}}
+                    };
+                }
+
+                // HierarchyComponent
+                if (registry.all_of<HierarchyComponent>(entityID)) {
+                    auto& entity = registry.get<HierarchyComponent>(entityID);
+                    entityJson["HierarchyComponent"] = {
+                        {"Parent", {entity.Parent == entt::null ? -1 : (int64_t)entt::to_integral(entity.Parent)}}
+                    };
+                }
+
                 scene["entities"].push_back(entityJson);
             };
 
@@ -97,6 +131,7 @@ namespace Engine
         }
 
         void loadScene(entt::registry& registry, const std::string& filepath) {
+            EPHYRA_PROFILE_SCOPE("Load Scene");
 
             nlohmann::json scene;
             std::ifstream file("saves/" + filepath);
@@ -163,7 +198,53 @@ namespace Engine
                         registry.emplace<TagComponent>(entity, tagComp["Tag"][0], (Engine::TagType)tagComp["Type"][0]);
                     }
 
+                    // OccluderComponent
+                    if (entityJson.contains("OccluderComponent")) {
+                        auto& occluderComp = entityJson["OccluderComponent"];
+                        registry.emplace<OccluderComponent>(entity, occluderComp["Occluder"][0].get<bool>());
+                    }
+
+                    // StaticComponent
+                    if (entityJson.contains("StaticComponent")) {
+                        auto& staticComp = entityJson["StaticComponent"];
+                        registry.emplace<StaticComponent>(entity, staticComp["Static"][0].get<bool>());
+                    }
+
+                    // CrowdComponent, laid out again from the entity's transform
+                    if (entityJson.contains("CrowdComponent")) {
+                        auto& crowdComp = entityJson["CrowdComponent"];
+                        std::string path = crowdComp["FilePath"][0];
+                        size_t start = path.rfind('/') + 1;
+                        std::string ID = path.substr(start, path.find('.', start) - start);
+                        glm::mat4 origin = registry.all_of<TransformComponent>(entity) ? registry.get<TransformComponent>(entity).Transform : glm::mat4(1.f);
+                        registry.emplace<CrowdComponent>(entity, path, ID, origin, crowdComp["Count"][0].get<uint32_t>(), crowdComp["Spacing"][0].get<float>());
+                    }
+
                 }
+
+                // HierarchyComponent, attached once every entity exists so parents are added before their children
+                std::unordered_map<uint32_t, int64_t> parents;
+                for (auto& entityJson : scene["entities"])
+                    if (entityJson.contains("HierarchyComponent"))
+                        parents[entityJson["id"].get<uint32_t>()] = entityJson["HierarchyComponent"]["Parent"][0].get<int64_t>();
+
+                std::function<void(uint32_t)> attach = [&](uint32_t id) {
+                    auto entity = entt::entity(id);
+                    if (registry.all_of<HierarchyComponent>(entity)) return;
+
+                    entt::entity parent = entt::null;
+                    if (parents[id] >= 0 && parents.find((uint32_t)parents[id]) != parents.end()) {
+                        attach((uint32_t)parents[id]);
+                        parent = entt::entity((uint32_t)parents[id]);
+                    }
+                    registry.emplace<HierarchyComponent>(entity, entity, parent);
+                };
+
+                for (auto& parent : parents)
+                    attach(parent.first);
+
+                // Merged once the hierarchy has placed every entity
+                gResources->staticBatchesDirty = true;
             }
         }
 
@@ -0,0 +1,44 @@
+/** \file animatedBounds.h */
+#pragma once
+
+#include "Core/Resources/Utility/Bounds.h"
+
+#include <cstdint>
+#include <vector>
+
+namespace Engine
+{
+	struct Renderer3DVertex;
+
+	/** \class AnimatedBounds
+	*	Bounding boxes of a skinned model over fixed time ranges of a clip, built at import and queried in constant time
+	*/
+	class AnimatedBounds
+	{
+	public:
+		AnimatedBounds() = default;
+		AnimatedBounds(float duration, float rangeSeconds); //!< Empty ranges covering a clip of a duration in seconds
+
+		void addSample(float seconds, const AABB& box); //!< Grow the ranges touching a sampled time
+		AABB query(float seconds) const; //!< Bounds of the range holding a time, the clip loops
+		AABB queryRange(float start, float end) const; //!< Bounds covering every range between two times
+
+		inline const AABB& getClipBounds() const { return m_clipBounds; } //!< Bounds over the whole clip
+		inline float getDuration() const { return m_duration; } //!< Clip duration in seconds
+		inline float getRangeSeconds() const { return m_rangeSeconds; } //!< Seconds covered by each range
+		inline uint32_t getRangeCount() const { return static_cast<uint32_t>(m_ranges.size()); } //!< Number of ranges
+
+		static AABB skinBounds(const Renderer3DVertex* vertices, uint32_t vertexCount, const glm::mat4* palette, uint32_t paletteSize); //!< Skin vertices with a bone palette and return their bounds, SSE when available
+
+		constexpr static float defaultRangeSeconds = 0.25f; //!< Range length used at import
+		constexpr static float defaultSampleRate = 30.f; //!< Poses sampled per second at import
+
+	private:
+		uint32_t rangeIndex(float seconds) const; //!< Range holding a time after looping
+
+		float m_duration = 0.f; //!< Clip duration in seconds
+		float m_rangeSeconds = defaultRangeSeconds; //!< Seconds covered by each range
+		std::vector<AABB> m_ranges; //!< Bounds per range
+		AABB m_clipBounds; //!< Union of every range
+	};
+}
@@ -0,0 +1,87 @@
+/** \file animationCompression.h */
+#pragma once
+
+#include <glm/glm.hpp>
+#include <glm/gtc/quaternion.hpp>
+
+#include <cstdint>
+#include <memory>
+#include <string>
+#include <unordered_map>
+#include <vector>
+
+struct aiAnimation;
+struct aiScene;
+
+namespace Engine
+{
+	/** \struct JointTolerance
+	*	Maximum error allowed when dropping keys from a single joint's curves
+	*/
+	struct JointTolerance
+	{
+		float translation = 0.01f; //!< Maximum translation error in model units
+		float rotation = 0.0005f; //!< Maximum rotation error in radians
+	};
+
+	/** \struct AnimationCompressionSettings
+	*	Settings used when cooking an aiAnimation into a CompressedClip
+	*/
+	struct AnimationCompressionSettings
+	{
+		JointTolerance defaultTolerance; //!< Tolerance used by joints without an override
+		std::unordered_map<std::string, JointTolerance> jointTolerances; //!< Per joint overrides, keyed by node name
+		float maxPositionalErrorRatio = 0.002f; //!< Largest joint position error accepted, as a fraction of the skeleton's extent, the diagonal of its animated joints' box in its largest frame
+		bool releaseSourceKeys = true; //!< Free the aiNodeAnim key arrays once the clip has been validated
+	};
+
+	struct QuantizedQuat { uint16_t m_data[3]; }; //!< Smallest three quaternion, 15 bits per component, largest index in the top bits
+	struct QuantizedVec3 { uint16_t m_data[3]; }; //!< Range quantized vector, 16 bits per component
+
+	/** \struct CompressedTrack
+	*	Reduced and quantized curves for a single node
+	*/
+	struct CompressedTrack
+	{
+		std::vector<uint16_t> rotationFrames; //!< Frame index of each rotation key
+		std::vector<QuantizedQuat> rotationKeys; //!< Quantized rotation keys
+		std::vector<uint16_t> translationFrames; //!< Frame index of each translation key
+		std::vector<QuantizedVec3> translationKeys; //!< Quantized translation keys
+		glm::vec3 translationMin = glm::vec3(0.f); //!< Minimum of the translation range
+		glm::vec3 translationExtent = glm::vec3(0.f); //!< Size of the translation range
+	};
+
+	/** \class CompressedClip
+	*	Cooked animation clip resampled onto a fixed frame grid, with error bounded key reduction
+	*/
+	class CompressedClip
+	{
+	public:
+		static std::shared_ptr<CompressedClip> compress(const aiAnimation* animation, const AnimationCompressionSettings& settings); //!< Cook a clip from an assimp animation
+
+		void sample(uint32_t track, float ticks, glm::vec3& translation, glm::quat& rotation) const; //!< Decompress a track at a time in ticks
+		int32_t findTrack(const std::string& nodeName) const; //!< Track index for a node, -1 if the node is not animated
+
+		float measureMaxPositionalError(const aiScene* scene, const aiAnimation* animation, float& skeletonExtent) const; //!< Largest joint position difference against the source keys over every frame, with the largest per frame diagonal of the animated joints
+		static void releaseSourceKeys(aiAnimation* animation); //!< Free the source key arrays of an animation
+
+		inline float getDuration() const { return m_duration; } //!< Duration in ticks
+		inline float getTicksPerSecond() const { return m_ticksPerSecond; } //!< Ticks per second
+		inline float getFrameStep() const { return m_frameStep; } //!< Ticks between resampled frames
+		inline uint32_t getFrameCount() const { return m_frameCount; } //!< Number of resampled frames
+		inline uint32_t getTrackCount() const { return static_cast<uint32_t>(m_tracks.size()); } //!< Number of animated nodes
+		inline const std::string& getTrackName(uint32_t track) const { return m_trackNames[track]; } //!< Node name of a track
+		inline size_t getSourceSize() const { return m_sourceSize; } //!< Bytes used by the source key arrays
+		size_t getCompressedSize() const; //!< Bytes used by the compressed keys
+
+	private:
+		float m_duration = 0.f; //!< Duration in ticks
+		float m_ticksPerSecond = 25.f; //!< Ticks per second
+		float m_frameStep = 1.f; //!< Ticks per resampled frame
+		uint32_t m_frameCount = 0; //!< Number of resampled frames
+		size_t m_sourceSize = 0; //!< Bytes used by the source key arrays
+		std::vector<CompressedTrack> m_tracks; //!< Track per animated node
+		std::vector<std::string> m_trackNames; //!< Node name per track
+		std::unordered_map<std::string, uint32_t> m_trackLookup; //!< Node name to track index
+	};
+}
@@ -0,0 +1,60 @@
+/** \file animationLOD.h */
+#pragma once
+
+#include "Core/Resources/Utility/Bounds.h"
+
+#include <glm/glm.hpp>
+
+#include <cstdint>
+#include <string>
+#include <vector>
+
+namespace Engine
+{
+	/** \struct AnimationLODSettings
+	*	Screen size thresholds and update rates used to reduce the cost of animating distant characters
+	*/
+	struct AnimationLODSettings
+	{
+		bool enabled = true; //!< When off every character is evaluated in full every frame
+		float screenSizes[3] = { 0.3f, 0.12f, 0.04f }; //!< Screen height fraction below which LOD 1, 2 and 3 start
+		uint32_t updateIntervals[4] = { 1, 2, 4, 8 }; //!< Frames between pose evaluations for LOD 0 to 3
+		uint32_t offscreenInterval = 16; //!< Frames between pose evaluations for characters outside the view
+		float minorJointScreenSize = 0.12f; //!< Screen height fraction below which minor joints hold their bind pose
+		std::vector<std::string> minorJointTokens = { "finger", "thumb", "index", "middle", "ring", "pinky", "toe", "eye", "jaw" }; //!< Joint name fragments treated as minor, case insensitive
+		float boundingRadius = 1.f; //!< Character radius in model units for models without animated bounds, scaled by the entity transform
+	};
+
+	/** \struct AnimationLODStats
+	*	Per frame counters for the animation LOD pass
+	*/
+	struct AnimationLODStats
+	{
+		uint32_t levelCounts[5] = { 0, 0, 0, 0, 0 }; //!< Characters at LOD 0 to 3, then off screen
+		uint32_t evaluated = 0; //!< Poses evaluated this frame
+		uint32_t skipped = 0; //!< Poses interpolated instead of evaluated this frame
+		uint32_t reducedJoints = 0; //!< Evaluations that skipped minor joints
+		float evaluationTime = 0.f; //!< Seconds spent evaluating poses this frame
+		float fullEvaluationTime = 0.f; //!< Running average cost of a full evaluation in seconds
+		float savedTime = 0.f; //!< Estimated seconds saved against evaluating every character in full
+
+		void reset() //!< Clear the per frame counters, the running average is kept
+		{
+			for (auto& count : levelCounts) count = 0;
+			evaluated = 0;
+			skipped = 0;
+			reducedJoints = 0;
+			evaluationTime = 0.f;
+			savedTime = 0.f;
+		}
+	};
+
+	namespace AnimationLOD
+	{
+		constexpr uint32_t offscreenLevel = 4; //!< Level reported for characters outside the view
+
+		uint32_t selectLevel(const AnimationLODSettings& settings, const glm::mat4& viewProjection, const glm::mat4& model, float& screenSize, const AABB* localBounds = nullptr); //!< Pick a level from the projected size of a character, bounds replace the settings radius when given
+		uint32_t updateInterval(const AnimationLODSettings& settings, uint32_t level); //!< Frames between evaluations at a level
+		bool isMinorJoint(const AnimationLODSettings& settings, const std::string& jointName); //!< Whether a joint name matches a minor joint token
+	}
+}
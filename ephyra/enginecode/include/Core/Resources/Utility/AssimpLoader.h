@@ -1,7 +1,9 @@
 #pragma once
 
 #include "Core/Resources/Utility/AssimpHelperFunctions.h"
+#include "Core/Systems/Utility/Profiler.h"
 #include <glm/gtx/integer.hpp>
+#include <set>
 
 namespace Engine {
 	namespace Loader
@@ -41,14 +43,52 @@ namespace Engine {
 		std::map<std::string, unsigned int> boneMapping;
 		unsigned int numBones = 0;
 
-		static void updateBoneTransforms(float timeInSeconds, const aiNode* pNode, const glm::mat4& parentTransform, std::string ID) {
+		static std::map<std::string, std::vector<Renderer3DVertex>> s_bindPoses; // Bind pose vertices of animated meshes, released once the model's bounds are computed
+		static std::map<std::string, std::set<std::string>> s_minorJoints; // Minor joints and their descendants per loader ID
+
+		static void collectMinorJoints(const aiNode* pNode, bool minor, std::set<std::string>& joints)
+		{
+			std::string nodeName(pNode->mName.data);
+			minor = minor || AnimationLOD::isMinorJoint(gResources->animationLOD, nodeName);
+			if (minor) joints.insert(nodeName);
+
+			for (unsigned int i = 0; i < pNode->mNumChildren; i++)
+				collectMinorJoints(pNode->mChildren[i], minor, joints);
+		}
+
+		static const std::set<std::string>& getMinorJoints(const std::string& ID)
+		{
+			auto joints = s_minorJoints.find(ID);
+			if (joints == s_minorJoints.end())
+			{
+				joints = s_minorJoints.emplace(ID, std::set<std::string>()).first;
+				collectMinorJoints(sceneMapping[ID]->mRootNode, false, joints->second);
+			}
+			return joints->second;
+		}
+
+		static void updateBoneTransforms(float timeInSeconds, const aiNode* pNode, const glm::mat4& parentTransform, const std::string& ID, const std::set<std::string>* skippedJoints = nullptr) {
 			std::string nodeName(pNode->mName.data);
 			glm::mat4 nodeTransformation = AssimpToGLMMatrix(pNode->mTransformation);
 
 			const aiAnimation* animation = sceneMapping[ID]->mAnimations[0];  // Assuming using the first animation
-			const aiNodeAnim* nodeAnim = findNodeAnim(animation, nodeName);
 
-			if (nodeAnim) {
+			auto clip = gResources->AnimationClips.find(ID);
+			if (skippedJoints && skippedJoints->count(nodeName)) {
+				// Reduced joint, hold the bind pose relative to its parent
+			}
+			else if (clip != gResources->AnimationClips.end()) {
+				// Cooked clip, sample the compressed curves instead of the aiNodeAnim keys
+				int32_t track = clip->second->findTrack(nodeName);
+				if (track >= 0) {
+					glm::vec3 translationVec;
+					glm::quat rotationQuat;
+					float ticks = glm::mod(timeInSeconds * clip->second->getTicksPerSecond(), clip->second->getDuration());
+					clip->second->sample(track, ticks, translationVec, rotationQuat);
+					nodeTransformation *= glm::translate(glm::mat4(1.0f), translationVec) * glm::mat4(rotationQuat);
+				}
+			}
+			else if (const aiNodeAnim* nodeAnim = findNodeAnim(animation, nodeName)) {
 
 				/*auto& p = rbc.m_body->getTransform().getPosition();
 				tc.Translation = glm::vec3(p.x, p.y, p.z);
@@ -90,7 +130,7 @@ namespace Engine {
 			}
 
 			for (unsigned int i = 0; i < pNode->mNumChildren; i++) {
-				updateBoneTransforms(timeInSeconds, pNode->mChildren[i], globalTransformation, ID);
+				updateBoneTransforms(timeInSeconds, pNode->mChildren[i], globalTransformation, ID, skippedJoints);
 			}
 
 		}
@@ -307,7 +347,36 @@ namespace Engine {
 
 			Engine::Geometry tmpGeo;
 
-			Renderer3D::addGeometry(tmpMesh.vertices, tmpMesh.indices, tmpGeo);
+			// Large static meshes are split into clusters so off screen and back facing parts are skipped when drawn
+			std::vector<Meshlet> meshlets;
+			if (!hasBones && tmpMesh.indices.size() % 3 == 0 && tmpMesh.indices.size() / 3 > Meshlets::maxTriangles)
+			{
+				std::vector<glm::vec3> positions;
+				positions.reserve(tmpMesh.vertices.size());
+				for (auto& vertex : tmpMesh.vertices)
+					positions.push_back(vertex.m_pos);
+				Meshlets::build(positions, tmpMesh.indices, meshlets);
+				Log::info("{0}: {1} triangles in {2} meshlets", mesh->mName.C_Str(), tmpMesh.indices.size() / 3, meshlets.size());
+			}
+
+			Renderer3D::addGeometry(tmpMesh.vertices, tmpMesh.indices, tmpGeo, meshlets);
+			auto& meshBounds = gResources->MeshBounds[ID];
+			for (auto& vertex : tmpMesh.vertices)
+				meshBounds.expand(vertex.m_pos);
+
+			// Static meshes keep their triangles on the CPU in case the model is marked as an occluder
+			if (!scene->HasAnimations())
+			{
+				auto& occluder = gResources->OccluderMeshes[ID];
+				if (!occluder) occluder = std::make_shared<OccluderMesh>();
+				uint32_t baseVertex = occluder->positions.size();
+				for (auto& vertex : tmpMesh.vertices)
+					occluder->positions.push_back(vertex.m_pos);
+				for (auto index : tmpMesh.indices)
+					occluder->indices.push_back(baseVertex + index);
+			}
+			if (scene->HasAnimations())
+				s_bindPoses[mesh->mName.C_Str()] = tmpMesh.vertices;
 			std::string name = mesh->mName.C_Str();
 			gResources->addAsset(name + ("Geometry"), Engine::SceneAsset::Type::Geometry, std::make_shared<Geometry>(tmpGeo));
 
@@ -358,8 +427,187 @@ namespace Engine {
 			}
 		}
 
+		static void ASSIMPCookAnimation(const std::string& id)
+		{
+			const aiScene* scene = sceneMapping[id];
+			aiAnimation* animation = scene->mAnimations[0];  // Assuming using the first animation
+
+			auto clip = CompressedClip::compress(animation, gResources->animationCompression);
+			if (!clip) return;
+
+			// Validate against the source keys before they are released
+			float extent = 0.f;
+			float maxError = clip->measureMaxPositionalError(scene, animation, extent);
+			float allowedError = extent * gResources->animationCompression.maxPositionalErrorRatio;
+
+			if (maxError > allowedError)
+			{
+				Log::error("Animation compression for {0} exceeded its error bound ({1} > {2}), keeping source keys", id, maxError, allowedError);
+				return;
+			}
+
+			Log::info("Animation {0} compressed: {1} -> {2} bytes, max joint error {3}", id, clip->getSourceSize(), clip->getCompressedSize(), maxError);
+			gResources->AnimationClips[id] = clip;
+
+			if (gResources->animationCompression.releaseSourceKeys)
+				CompressedClip::releaseSourceKeys(animation);
+		}
+
+		static void ASSIMPComputeAnimatedBounds(const std::string& id)
+		{
+			const aiAnimation* animation = sceneMapping[id]->mAnimations[0];  // Assuming using the first animation
+			float duration = (float)(animation->mDuration / animation->mTicksPerSecond);
+			auto clip = gResources->AnimationClips.find(id);
+			if (clip != gResources->AnimationClips.end())
+				duration = clip->second->getDuration() / clip->second->getTicksPerSecond();
+
+			auto bounds = std::make_shared<AnimatedBounds>(duration, AnimatedBounds::defaultRangeSeconds);
+			uint32_t frameCount = std::max(1u, (uint32_t)std::ceil(duration * AnimatedBounds::defaultSampleRate));
+			auto& meshNames = gResources->IDToMeshNames[id];
+
+			// Frames on both ends are included so every range sees its boundary poses
+			std::vector<glm::mat4> palette;
+			for (uint32_t f = 0; f <= frameCount; f++)
+			{
+				float seconds = std::min(f / AnimatedBounds::defaultSampleRate, duration);
+				updateBoneTransforms(seconds, sceneMapping[id]->mRootNode, glm::mat4(1.f), id);
+
+				AABB frameBounds;
+				for (auto& meshName : meshNames)
+				{
+					auto source = s_bindPoses.find(meshName);
+					if (source == s_bindPoses.end()) continue;
+
+					palette.clear();
+					if (boneInfoList.find(meshName) != boneInfoList.end())
+						for (auto& bone : boneInfoList[meshName])
+							palette.push_back(bone.finalTransformation);
+
+					frameBounds.expand(AnimatedBounds::skinBounds(source->second.data(), source->second.size(), palette.data(), std::min<uint32_t>(palette.size(), 100)));
+				}
+
+				bounds->addSample(seconds, frameBounds);
+			}
+
+			gResources->AnimationBounds[id] = bounds;
+			Log::info("Animated bounds for {0}: {1} ranges of {2}s", id, bounds->getRangeCount(), bounds->getRangeSeconds());
+
+			// Baking reads the bind pose back from the arena, so nothing is kept for models never made into a crowd
+			for (auto& meshName : meshNames)
+				s_bindPoses.erase(meshName);
+		}
+
+		static bool ASSIMPBakeVertexAnimation(const std::string& id, float framesPerSecond = 30.f)
+		{
+			gResources = Engine::ResourceManager::getInstance();
+
+			if (sceneMapping.find(id) == sceneMapping.end() || !sceneMapping[id]->HasAnimations())
+			{
+				Log::error("Cannot bake vertex animation for {0}, no animation loaded", id);
+				return false;
+			}
+
+			const aiAnimation* animation = sceneMapping[id]->mAnimations[0];  // Assuming using the first animation
+			float duration = (float)(animation->mDuration / animation->mTicksPerSecond);
+			auto clip = gResources->AnimationClips.find(id);
+			if (clip != gResources->AnimationClips.end())
+				duration = clip->second->getDuration() / clip->second->getTicksPerSecond();
+
+			uint32_t frameCount = std::max(1u, (uint32_t)std::ceil(duration * framesPerSecond));
+			uint32_t width = VertexAnimation::textureWidth;
+
+			auto& meshNames = gResources->IDToMeshNames[id];
+			std::vector<std::shared_ptr<VertexAnimation>> baked(meshNames.size());
+			std::vector<std::vector<Renderer3DVertex>> bindPoses(meshNames.size());
+			std::vector<std::vector<float>> positions(meshNames.size());
+			std::vector<std::vector<float>> normals(meshNames.size());
+
+			for (int m = 0; m < meshNames.size(); m++)
+			{
+				auto geometry = gResources->getAsset<Geometry>(meshNames[m] + "Geometry");
+				if (!geometry)
+				{
+					Log::error("Cannot bake vertex animation for {0}, mesh {1} was not uploaded", id, meshNames[m]);
+					return false;
+				}
+
+				std::vector<uint32_t> indices;
+				std::vector<Meshlet> meshlets;
+				Renderer3D::readGeometry(*geometry, bindPoses[m], indices, meshlets);
+
+				uint32_t vertexCount = bindPoses[m].size();
+				uint32_t rows = (frameCount * vertexCount + width - 1) / width;
+				if (rows > 16384)
+				{
+					Log::error("Cannot bake vertex animation for {0}, {1} frames of {2} vertices exceed the texture size", id, frameCount, vertexCount);
+					return false;
+				}
+
+				baked[m] = std::make_shared<VertexAnimation>();
+				baked[m]->geometry = *geometry;
+				baked[m]->frameCount = frameCount;
+				baked[m]->framesPerSecond = framesPerSecond;
+
+				positions[m].resize(rows * width * 4, 0.f);
+				normals[m].resize(rows * width * 4, 0.f);
+			}
+
+			// Pose every frame through the same path as the live animation, then skin as the PBR vertex shader does
+			for (uint32_t f = 0; f < frameCount; f++)
+			{
+				updateBoneTransforms(f / framesPerSecond, sceneMapping[id]->mRootNode, glm::mat4(1.f), id);
+
+				for (int m = 0; m < meshNames.size(); m++)
+				{
+					auto& vertices = bindPoses[m];
+					auto& bones = boneInfoList[meshNames[m]];
+
+					for (uint32_t v = 0; v < vertices.size(); v++)
+					{
+						auto& vertex = vertices[v];
+						glm::mat4 boneTransform(0.f);
+						for (int k = 0; k < 4; k++)
+						{
+							uint32_t bone = (uint32_t)vertex.boneIndices[k];
+							if (bone < bones.size() && bone < 100)
+								boneTransform += bones[bone].finalTransformation * vertex.boneWeights[k];
+						}
+
+						glm::vec3 position = vertex.m_pos;
+						glm::vec3 normal = vertex.m_normal;
+						if (boneTransform != glm::mat4(0.f))
+						{
+							position = glm::vec3(boneTransform * glm::vec4(position, 1.f));
+							normal = glm::normalize(glm::mat3(boneTransform) * normal);
+						}
+
+						size_t texel = ((size_t)f * vertices.size() + v) * 4;
+						positions[m][texel + 0] = position.x;
+						positions[m][texel + 1] = position.y;
+						positions[m][texel + 2] = position.z;
+						positions[m][texel + 3] = 1.f;
+						normals[m][texel + 0] = normal.x;
+						normals[m][texel + 1] = normal.y;
+						normals[m][texel + 2] = normal.z;
+					}
+				}
+			}
+
+			for (int m = 0; m < meshNames.size(); m++)
+			{
+				uint32_t rows = positions[m].size() / (width * 4);
+				baked[m]->positions.reset(Texture::createFloat(width, rows, 4, positions[m].data()));
+				baked[m]->normals.reset(Texture::createFloat(width, rows, 4, normals[m].data()));
+			}
+
+			gResources->VertexAnimations[id] = baked;
+			Log::info("Baked vertex animation for {0}: {1} frames at {2} fps", id, frameCount, framesPerSecond);
+			return true;
+		}
+
 		static void ASSIMPLoad(const std::string& filepath, std::string id, std::shared_ptr<Shader> shader = nullptr)
 		{
+			EPHYRA_PROFILE_SCOPE("Load Model");
 			gResources = Engine::ResourceManager::getInstance();
 
 			if (gResources->FPToIDs.find(filepath) != gResources->FPToIDs.end())
@@ -402,6 +650,12 @@ namespace Engine {
 			}
 
 			ASSIMPProcessNode(sceneMapping[id]->mRootNode, sceneMapping[id], id, filepath);
+
+			if (sceneMapping[id]->HasAnimations())
+			{
+				ASSIMPCookAnimation(id);
+				ASSIMPComputeAnimatedBounds(id);
+			}
 			
 
 		}
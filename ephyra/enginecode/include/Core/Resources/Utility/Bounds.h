@@ -0,0 +1,120 @@
+/** \file bounds.h */
+#pragma once
+
+#include <glm/glm.hpp>
+
+#include <algorithm>
+#include <cfloat>
+#include <cmath>
+
+namespace Engine
+{
+	/** \struct AABB
+	*	Axis aligned bounding box, starts empty and grows as points are added
+	*/
+	struct AABB
+	{
+		glm::vec3 min = glm::vec3(FLT_MAX); //!< Minimum corner
+		glm::vec3 max = glm::vec3(-FLT_MAX); //!< Maximum corner
+
+		AABB() = default;
+		AABB(const glm::vec3& minimum, const glm::vec3& maximum) : min(minimum), max(maximum) {}
+
+		inline bool isValid() const { return min.x <= max.x && min.y <= max.y && min.z <= max.z; } //!< False until something has been added
+		inline glm::vec3 getCenter() const { return (min + max) * 0.5f; } //!< Centre of the box
+		inline glm::vec3 getHalfExtent() const { return (max - min) * 0.5f; } //!< Half the size of the box on each axis
+		inline float getRadius() const { return glm::length(getHalfExtent()); } //!< Radius of the enclosing sphere
+
+		inline void expand(const glm::vec3& point) { min = glm::min(min, point); max = glm::max(max, point); } //!< Grow to contain a point
+		inline void expand(const AABB& box) { if (box.isValid()) { min = glm::min(min, box.min); max = glm::max(max, box.max); } } //!< Grow to contain a box
+
+		//! Box containing this box after a transform, exact for the transformed corners
+		AABB transformed(const glm::mat4& transform) const
+		{
+			if (!isValid()) return *this;
+
+			glm::vec3 center = glm::vec3(transform * glm::vec4(getCenter(), 1.f));
+			glm::vec3 half = getHalfExtent();
+			glm::vec3 extent(0.f);
+			for (int i = 0; i < 3; i++)
+				for (int j = 0; j < 3; j++)
+					extent[i] += std::abs(transform[j][i]) * half[j];
+
+			return AABB(center - extent, center + extent);
+		}
+
+		inline bool contains(const AABB& box) const { return min.x <= box.min.x && min.y <= box.min.y && min.z <= box.min.z && max.x >= box.max.x && max.y >= box.max.y && max.z >= box.max.z; } //!< Whether a box lies entirely inside
+		inline float getSurfaceArea() const { glm::vec3 d = max - min; return 2.f * (d.x * d.y + d.y * d.z + d.z * d.x); } //!< Surface area, the insertion cost of a tree node
+
+		//! Distance along a ray to where it enters the box, false if it misses within the range, takes 1 / direction
+		inline bool intersectRay(const glm::vec3& origin, const glm::vec3& inverseDirection, float maxDistance, float& entry) const
+		{
+			glm::vec3 t0 = (min - origin) * inverseDirection;
+			glm::vec3 t1 = (max - origin) * inverseDirection;
+			glm::vec3 tNear = glm::min(t0, t1);
+			glm::vec3 tFar = glm::max(t0, t1);
+
+			entry = std::max(std::max(tNear.x, tNear.y), std::max(tNear.z, 0.f));
+			float exit = std::min(std::min(tFar.x, tFar.y), std::min(tFar.z, maxDistance));
+			return entry <= exit;
+		}
+
+		//! Whether a sphere touches the box
+		inline bool intersectSphere(const glm::vec3& center, float radius) const
+		{
+			glm::vec3 closest = glm::clamp(center, min, max);
+			glm::vec3 delta = center - closest;
+			return glm::dot(delta, delta) <= radius * radius;
+		}
+	};
+
+	/** \struct Frustum
+	*	Six inward facing planes taken from a view projection matrix
+	*/
+	struct Frustum
+	{
+		enum class Result { Outside = 0, Intersect, Inside }; //!< Classification of a box against every plane
+
+		glm::vec4 planes[6]; //!< Left, right, bottom, top, near, far as (normal, distance)
+
+		Frustum() = default;
+		//! Extract the planes from the rows of a view projection matrix
+		explicit Frustum(const glm::mat4& viewProjection)
+		{
+			glm::vec4 rows[4];
+			for (int i = 0; i < 4; i++)
+				rows[i] = glm::vec4(viewProjection[0][i], viewProjection[1][i], viewProjection[2][i], viewProjection[3][i]);
+
+			planes[0] = rows[3] + rows[0];
+			planes[1] = rows[3] - rows[0];
+			planes[2] = rows[3] + rows[1];
+			planes[3] = rows[3] - rows[1];
+			planes[4] = rows[3] + rows[2];
+			planes[5] = rows[3] - rows[2];
+
+			for (auto& plane : planes)
+				plane /= glm::length(glm::vec3(plane));
+		}
+
+		//! Whether a box is outside, crossing or fully inside the frustum
+		Result classify(const AABB& box) const
+		{
+			glm::vec3 center = box.getCenter();
+			glm::vec3 extent = box.getHalfExtent();
+
+			Result result = Result::Inside;
+			for (auto& plane : planes)
+			{
+				glm::vec3 normal = glm::vec3(plane);
+				float distance = glm::dot(normal, center) + plane.w;
+				float radius = glm::dot(glm::abs(normal), extent);
+
+				if (distance < -radius) return Result::Outside;
+				if (distance < radius) result = Result::Intersect;
+			}
+			return result;
+		}
+
+		inline bool intersects(const AABB& box) const { return classify(box) != Result::Outside; } //!< Whether any part of a box is inside
+	};
+}
@@ -0,0 +1,69 @@
+/** \file dynamicBVH.h */
+#pragma once
+
+#include "Core/Resources/Utility/Bounds.h"
+
+#include <cstdint>
+#include <vector>
+
+namespace Engine
+{
+	/** \class DynamicBVH
+	*	Bounding volume tree over moving objects. Leaves hold a fattened box so small movements need no tree changes,
+	*	leaves that escape are removed and reinserted at the cheapest position by surface area and the tree is kept balanced by rotations.
+	*/
+	class DynamicBVH
+	{
+	public:
+		using Proxy = int32_t;
+		constexpr static Proxy null = -1; //!< Null proxy and null node
+
+		Proxy create(const AABB& bounds, uint32_t userData); //!< Insert an object, the proxy stays valid until destroyed
+		void destroy(Proxy proxy); //!< Remove an object
+		bool move(Proxy proxy, const AABB& bounds, const glm::vec3& displacement = glm::vec3(0.f)); //!< Update an object's bounds, true if it had to be reinserted
+		void clear(); //!< Remove every object
+
+		void queryFrustum(const Frustum& frustum, std::vector<uint32_t>& userData) const; //!< Append the user data of every object in a frustum
+		void querySphere(const glm::vec3& center, float radius, std::vector<uint32_t>& userData) const; //!< Append the user data of every object touching a sphere
+		bool raycast(const glm::vec3& origin, const glm::vec3& direction, float maxDistance, uint32_t& userData, float& distance) const; //!< Nearest object whose bounds the ray enters
+
+		inline bool isValid(Proxy proxy) const { return proxy >= 0 && proxy < static_cast<Proxy>(m_nodes.size()) && m_nodes[proxy].height == 0; } //!< Whether a proxy refers to a live object
+		inline uint32_t getUserData(Proxy proxy) const { return m_nodes[proxy].userData; } //!< Value attached at creation, such as an entity id
+		inline const AABB& getBounds(Proxy proxy) const { return m_nodes[proxy].bounds; } //!< Tight bounds as last set
+		inline const AABB& getFatBounds(Proxy proxy) const { return m_nodes[proxy].fat; } //!< Bounds stored in the tree
+		inline uint32_t getHeight() const { return m_root == null ? 0 : m_nodes[m_root].height; } //!< Levels below the root
+		inline uint32_t getProxyCount() const { return m_proxyCount; } //!< Number of live objects
+
+		inline void setMargin(float margin) { m_margin = margin; } //!< Distance boxes are fattened by on every side
+		inline float getMargin() const { return m_margin; } //!< Distance boxes are fattened by on every side
+	private:
+		/** \struct Node
+		*	Leaf holding an object or branch holding the union of its two children
+		*/
+		struct Node
+		{
+			AABB fat; //!< Fattened bounds for leaves, union of the children for branches
+			AABB bounds; //!< Tight bounds, leaves only
+			int32_t parent = null; //!< Parent node, next free node while unused
+			int32_t child1 = null; //!< First child, null for leaves
+			int32_t child2 = null; //!< Second child, null for leaves
+			int32_t height = -1; //!< 0 for leaves, -1 while unused
+			uint32_t userData = 0; //!< Value attached at creation
+
+			inline bool isLeaf() const { return child1 == null; }
+		};
+
+		int32_t allocateNode(); //!< Take a node from the free list, growing the pool if needed
+		void freeNode(int32_t node); //!< Return a node to the free list
+		void insertLeaf(int32_t leaf); //!< Attach a leaf next to the sibling that grows the tree's surface area the least
+		void removeLeaf(int32_t leaf); //!< Detach a leaf, its sibling takes its parent's place
+		int32_t balance(int32_t node); //!< Rotate a node's taller grandchild up if its children differ in height by more than one
+		void refit(int32_t node); //!< Recompute a branch's height and bounds from its children
+
+		std::vector<Node> m_nodes; //!< Node pool, proxies index into it
+		int32_t m_root = null; //!< Root node
+		int32_t m_freeList = null; //!< First unused node
+		uint32_t m_proxyCount = 0; //!< Number of live objects
+		float m_margin = 0.1f; //!< Distance boxes are fattened by on every side
+	};
+}
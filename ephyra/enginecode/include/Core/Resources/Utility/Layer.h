@@ -14,8 +14,14 @@ namespace Engine
         virtual void OnAttach() {}
         virtual void OnDetach() {}
         
+        virtual void OnFixedUpdate(float step) {} // Runs once per simulation tick on the main thread, before the frame's update
         virtual void OnUpdate(float timestep) {}
         virtual void OnRender() {}
+
+        // Pipelined layers split OnUpdate so the next frame can be simulated while the current one renders
+        virtual bool isPipelined() { return false; }
+        virtual void OnSimulate(float timestep) {} // Simulate and extract the next frame, may run on a worker thread
+        virtual void OnSync() {} // Main thread with nothing else running, hand the extracted frame to OnRender
         virtual bool OnKeyPress(Engine::KeyPressedEvent& e) { return false; }
         virtual bool OnMousePressed(Engine::MouseButtonPressedEvent& e) { return false; }
         virtual bool OnMouseMovedEvent(Engine::MouseMovedEvent& e) { return false; }
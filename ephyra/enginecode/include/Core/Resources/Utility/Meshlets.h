@@ -0,0 +1,50 @@
+/** \file meshlets.h */
+#pragma once
+
+#include "Core/Resources/Utility/Bounds.h"
+
+#include <cstdint>
+#include <vector>
+
+namespace Engine
+{
+	/** \struct Meshlet
+	*	Cluster of neighbouring triangles kept as a contiguous range of its mesh's index buffer
+	*/
+	struct Meshlet
+	{
+		glm::vec3 center = glm::vec3(0.f); //!< Bounding sphere centre, model space
+		float radius = 0.f; //!< Bounding sphere radius, model space
+		glm::vec3 coneAxis = glm::vec3(0.f); //!< Average facing of the triangles
+		float coneCutoff = 1.f; //!< Sine of the widest angle between a triangle's facing and the axis, 1 when the cluster can never be back facing
+		uint32_t firstIndex = 0; //!< First index relative to the mesh's first index
+		uint32_t triangleCount = 0; //!< Triangles in the cluster
+		uint32_t vertexCount = 0; //!< Unique vertices referenced by the cluster
+	};
+
+	/** \struct MeshletStats
+	*	Counters from the last frame's cluster culling
+	*/
+	struct MeshletStats
+	{
+		uint32_t tested = 0; //!< Clusters tested
+		uint32_t frustumCulled = 0; //!< Clusters outside the view frustum
+		uint32_t coneCulled = 0; //!< Clusters facing entirely away from the camera
+		uint32_t commands = 0; //!< Indirect commands emitted after merging neighbouring clusters
+		uint64_t trianglesDrawn = 0; //!< Triangles in visible clusters
+		uint64_t trianglesCulled = 0; //!< Triangles in culled clusters
+
+		void reset() { tested = 0; frustumCulled = 0; coneCulled = 0; commands = 0; trianglesDrawn = 0; trianglesCulled = 0; } //!< Clear for a new frame
+	};
+
+	namespace Meshlets
+	{
+		constexpr uint32_t maxVertices = 64; //!< Unique vertices per cluster
+		constexpr uint32_t maxTriangles = 124; //!< Triangles per cluster
+
+		enum class Result { Visible = 0, Outside, BackFacing }; //!< Outcome of testing a cluster
+
+		void build(const std::vector<glm::vec3>& positions, std::vector<uint32_t>& indices, std::vector<Meshlet>& meshlets); //!< Group a triangle list into clusters, reordering the indices so each cluster is contiguous
+		Result classify(const Meshlet& meshlet, const Frustum& frustum, const glm::vec3& camera, bool coneCulling); //!< Test a cluster against a frustum and camera position in the same space as the cluster
+	}
+}
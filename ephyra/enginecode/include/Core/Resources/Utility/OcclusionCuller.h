@@ -0,0 +1,92 @@
+/** \file occlusionCuller.h */
+#pragma once
+
+#include "Core/Resources/Utility/Bounds.h"
+
+#include <cstdint>
+#include <vector>
+
+namespace Engine
+{
+	/** \struct OccluderMesh
+	*	Model space triangles kept on the CPU for occlusion rasterization
+	*/
+	struct OccluderMesh
+	{
+		std::vector<glm::vec3> positions; //!< Vertex positions
+		std::vector<uint32_t> indices; //!< Triangle list into the positions
+	};
+
+	/** \struct OcclusionStats
+	*	Counters from the last culling pass
+	*/
+	struct OcclusionStats
+	{
+		uint32_t occluders = 0; //!< Occluder meshes added
+		uint32_t triangles = 0; //!< Occluder triangles reaching the rasterizer after clipping
+		uint32_t tested = 0; //!< Occludees tested
+		uint32_t culled = 0; //!< Occludees found hidden
+		float rasterTime = 0.f; //!< Seconds spent transforming, clipping and rasterizing occluders
+		float testTime = 0.f; //!< Seconds spent testing occludees
+
+		void reset() { occluders = 0; triangles = 0; tested = 0; culled = 0; rasterTime = 0.f; testTime = 0.f; } //!< Clear for a new pass
+	};
+
+	/** \class OcclusionCuller
+	*	Rasterizes occluder triangles into a small CPU depth buffer four pixels at a time, then tests occludee boxes
+	*	against the maximum depth of each 8x8 tile and, where a tile is inconclusive, against its pixels.
+	*	Rows are split into bands, each run as a job, so every band is rasterized and tested without sharing writes.
+	*/
+	class OcclusionCuller
+	{
+	public:
+		constexpr static uint32_t tileSize = 8; //!< Pixels per side of a hierarchical depth tile
+		constexpr static float depthBias = 1e-5f; //!< Depth an occluder must be in front of a box by to hide it, so an occluder never hides its own bounds
+
+		OcclusionCuller(uint32_t width = 256, uint32_t height = 128); //!< Depth buffer size, rounded up to whole tiles
+
+		void resize(uint32_t width, uint32_t height); //!< Change the depth buffer size, rounded up to whole tiles
+		void setThreadCount(uint32_t threads); //!< Bands run as jobs per pass, 0 picks from the job system's threads
+
+		void begin(const glm::mat4& viewProjection); //!< Start a pass with a camera, drops the previous occluders
+		void addOccluder(const OccluderMesh& mesh, const glm::mat4& model); //!< Queue a mesh to be drawn into the depth buffer
+		void rasterize(); //!< Draw every queued occluder and build the tile depths
+
+		bool isVisible(const AABB& bounds) const; //!< Whether any part of a world space box may be in front of the occluders
+		void testVisibility(const std::vector<AABB>& bounds, std::vector<uint8_t>& visible); //!< Test many boxes across the job system, 1 where visible
+
+		inline uint32_t getWidth() const { return m_width; } //!< Depth buffer width in pixels
+		inline uint32_t getHeight() const { return m_height; } //!< Depth buffer height in pixels
+		inline const std::vector<float>& getDepth() const { return m_depth; } //!< Depth per pixel, 0 near to 1 far, rows bottom up
+		inline const OcclusionStats& getStats() const { return m_stats; } //!< Counters from the last pass
+	private:
+		/** \struct Triangle
+		*	Screen space triangle after clipping, counter clockwise
+		*/
+		struct Triangle
+		{
+			glm::vec3 v[3]; //!< Pixel x, pixel y, depth
+		};
+
+		void setupTriangles(uint32_t first, uint32_t last, std::vector<Triangle>& triangles) const; //!< Transform, clip and project a range of queued occluders
+		void rasterizeBand(uint32_t firstRow, uint32_t lastRow); //!< Draw every triangle into a band of rows and build its tile depths
+		void rasterizeTriangle(const Triangle& triangle, uint32_t firstRow, uint32_t lastRow); //!< Draw one triangle into a band of rows
+		uint32_t getThreadCount() const; //!< Bands to use this pass
+
+		struct QueuedOccluder
+		{
+			const OccluderMesh* mesh; //!< Mesh to draw
+			glm::mat4 modelViewProjection; //!< Model to clip space
+		};
+
+		uint32_t m_width = 0; //!< Depth buffer width, a multiple of the tile size
+		uint32_t m_height = 0; //!< Depth buffer height, a multiple of the tile size
+		uint32_t m_threads = 0; //!< Requested bands, 0 for the job system's thread count
+		glm::mat4 m_viewProjection = glm::mat4(1.f); //!< Camera of the current pass
+		std::vector<float> m_depth; //!< Nearest occluder depth per pixel
+		std::vector<float> m_tileMax; //!< Farthest depth per tile
+		std::vector<QueuedOccluder> m_occluders; //!< Occluders added this pass
+		std::vector<std::vector<Triangle>> m_triangles; //!< Projected triangles, one list per setup job
+		OcclusionStats m_stats; //!< Counters from the last pass
+	};
+}
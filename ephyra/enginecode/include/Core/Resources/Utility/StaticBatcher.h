@@ -0,0 +1,98 @@
+/** \file staticBatcher.h */
+#pragma once
+
+#include "Core/Rendering/Renderer/Renderer3D.h"
+#include "Core/Resources/Utility/Bounds.h"
+
+#include <cstdint>
+#include <memory>
+#include <unordered_map>
+#include <vector>
+
+namespace Engine
+{
+	/** \struct StaticMeshData
+	*	Model space vertices and indices of a mesh read back from the arena so it can be merged into a batch
+	*/
+	struct StaticMeshData
+	{
+		Geometry geometry; //!< Arena ranges the data was read from
+		std::vector<Renderer3DVertex> vertices; //!< Vertices as uploaded
+		std::vector<uint32_t> indices; //!< Triangle list into the vertices, as uploaded
+	};
+
+	/** \struct StaticBatchStats
+	*	Counters from the last build and the unmerges since
+	*/
+	struct StaticBatchStats
+	{
+		uint32_t sources = 0; //!< Meshes added for the last build
+		uint32_t batches = 0; //!< Merged geometries created
+		uint32_t merged = 0; //!< Meshes drawn as part of a batch
+		uint32_t unmerged = 0; //!< Merged meshes removed from their batch since the build
+		uint32_t failed = 0; //!< Groups left unmerged because the arena was full
+
+		void reset() { sources = 0; batches = 0; merged = 0; unmerged = 0; failed = 0; } //!< Clear for a new build
+	};
+
+	/** \class StaticBatcher
+	*	Merges meshes that never move and share a material into one geometry per spatial cell. Each mesh is pre-transformed
+	*	into world space and appended to the arena, so a cell of scattered props becomes a single draw that is still frustum culled
+	*	by the cell's bounds. A mesh can be taken back out of its batch by turning its index range into degenerate triangles.
+	*/
+	class StaticBatcher
+	{
+	public:
+		/** \struct Batch
+		*	Merged geometry of every mesh in a cell with the same material, drawn with an identity model
+		*/
+		struct Batch
+		{
+			Geometry geometry; //!< World space vertices of every member
+			std::shared_ptr<Material> material; //!< Material shared by the members
+			AABB bounds; //!< World bounds of every member
+			uint32_t liveMembers = 0; //!< Members not yet unmerged, the batch is skipped at 0
+		};
+
+		void clear(); //!< Drop every source and release the batches' arena space
+		void add(const Geometry& geometry, const std::shared_ptr<Material>& material, const glm::mat4& model, uint32_t userData, uint32_t part); //!< Queue one mesh of an object, such as one part of an entity, meshes with bones are skipped
+		void build(); //!< Group the queued meshes and upload a batch for every group of two or more
+
+		bool unmerge(uint32_t userData); //!< Remove every part of an object from its batches, false if none were merged
+		bool isMerged(uint32_t userData, uint32_t part) const; //!< Whether a part of an object is drawn by a batch
+
+		inline const std::vector<Batch>& getBatches() const { return m_batches; } //!< Batches from the last build
+		inline const StaticBatchStats& getStats() const { return m_stats; } //!< Counters from the last build
+
+		inline void setCellSize(float size) { m_cellSize = size; } //!< World size of the grid cells batches are split by
+		inline float getCellSize() const { return m_cellSize; } //!< World size of the grid cells batches are split by
+	private:
+		/** \struct Source
+		*	Mesh queued for the next build and where it ended up
+		*/
+		struct Source
+		{
+			std::shared_ptr<StaticMeshData> mesh; //!< Model space data
+			std::shared_ptr<Material> material; //!< Material it is drawn with
+			glm::mat4 model; //!< Model to world transform
+			AABB bounds; //!< World bounds
+			uint32_t userData; //!< Owning object
+			uint32_t part; //!< Mesh index within the object
+			int32_t batch = -1; //!< Batch holding it, -1 while unmerged
+			uint32_t firstIndex = 0; //!< Start of its triangles in the arena index buffer
+			uint32_t indexCount = 0; //!< Indices of its triangles
+		};
+
+		uint32_t getMaterialKey(const std::shared_ptr<Material>& material); //!< Index of the first material drawing identically
+		std::shared_ptr<StaticMeshData> readMesh(const Geometry& geometry); //!< CPU copy of a mesh, read back from the arena the first time it is added
+		void releaseBatches(); //!< Hand every batch's geometry back to the renderer
+
+		std::vector<Source> m_sources; //!< Meshes of the last build
+		std::unordered_map<uint32_t, std::vector<uint32_t>> m_objects; //!< Sources of each object
+		std::vector<std::shared_ptr<Material>> m_materials; //!< Distinct materials seen this build
+		std::vector<Batch> m_batches; //!< Merged geometries
+		std::unordered_map<uint32_t, std::shared_ptr<StaticMeshData>> m_meshes; //!< Meshes read back so far by geometry id, kept across builds
+		StaticBatchStats m_stats; //!< Counters from the last build
+		float m_cellSize = 32.f; //!< World size of the grid cells
+	};
+}
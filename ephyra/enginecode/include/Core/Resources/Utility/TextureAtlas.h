@@ -16,6 +16,7 @@ namespace Engine
 		inline uint32_t getChannels() const { return m_baseTexture->getChannels(); }
 		inline std::shared_ptr<Texture> getBaseTexture() const { return m_baseTexture; };
 		inline uint32_t getID() const { return m_baseTexture->getID(); };
+		static bool pack(std::vector<SimpleRect>& spaces, uint32_t width, uint32_t height, SimpleRect& placed); //!< Place A Rect In The Free Spaces And Split What Is Left, No Texture Work
 	private:
 		std::vector<SimpleRect> m_spaces;
 		std::shared_ptr<Texture> m_baseTexture; //!< Texture Which Holds All Sub Textured Pixel Data
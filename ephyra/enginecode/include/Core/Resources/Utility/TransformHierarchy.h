@@ -0,0 +1,66 @@
+/** \file transformHierarchy.h */
+#pragma once
+
+#include <glm/glm.hpp>
+#include <glm/gtc/quaternion.hpp>
+
+#include <cstdint>
+#include <vector>
+
+namespace Engine
+{
+	/** \class TransformHierarchy
+	*	Parent child transforms stored as arrays in depth first order, so every subtree is a contiguous range and parents come before their children.
+	*	Changing a node only recomputes the world matrices of its own subtree on the next update.
+	*/
+	class TransformHierarchy
+	{
+	public:
+		using Handle = uint32_t;
+		constexpr static Handle invalid = 0xFFFFFFFF; //!< Null handle, also used for roots' parent
+
+		Handle create(Handle parent = invalid, uint32_t userData = 0); //!< Add a node with an identity local transform
+		void destroy(Handle node); //!< Remove a node, its children move to its parent and keep their local transforms
+		void setParent(Handle node, Handle parent); //!< Move a node and its subtree under a new parent
+		void setLocal(Handle node, const glm::vec3& translation, const glm::quat& rotation, const glm::vec3& scale); //!< Set a node's transform relative to its parent
+		void clear(); //!< Remove every node
+
+		void update(); //!< Recompute local and world matrices for every changed subtree
+		inline const std::vector<Handle>& getUpdated() const { return m_updated; } //!< Nodes whose world matrix was recomputed by the last update
+
+		inline bool isValid(Handle node) const { return node < m_handleToIndex.size() && m_handleToIndex[node] != invalid; } //!< Whether a handle refers to a live node
+		inline Handle getParent(Handle node) const { return m_parents[node]; } //!< Parent of a node, invalid for roots
+		inline const std::vector<Handle>& getChildren(Handle node) const { return m_children[node]; } //!< Direct children of a node
+		inline uint32_t getUserData(Handle node) const { return m_userData[m_handleToIndex[node]]; } //!< Value attached at creation, such as an entity id
+		inline const glm::mat4& getLocal(Handle node) const { return m_local[m_handleToIndex[node]]; } //!< Local matrix as of the last update
+		inline const glm::mat4& getWorld(Handle node) const { return m_world[m_handleToIndex[node]]; } //!< World matrix as of the last update
+		inline uint32_t getSize() const { return static_cast<uint32_t>(m_indexToHandle.size()); } //!< Number of live nodes
+
+	private:
+		void rebuildOrder(); //!< Re-sort the arrays depth first after a structural change
+		bool isDescendant(Handle node, Handle ancestor) const; //!< Whether a node sits below another
+
+		// Per handle, touched only by structural changes
+		std::vector<uint32_t> m_handleToIndex; //!< Array position of each handle, invalid when free
+		std::vector<Handle> m_parents; //!< Parent of each handle
+		std::vector<std::vector<Handle>> m_children; //!< Children of each handle
+		std::vector<Handle> m_roots; //!< Nodes without a parent
+		std::vector<Handle> m_freeHandles; //!< Handles available for reuse
+
+		// Per node in depth first order, touched by the update pass
+		std::vector<Handle> m_indexToHandle; //!< Handle at each position
+		std::vector<uint32_t> m_parentIndex; //!< Position of the parent, invalid for roots
+		std::vector<uint32_t> m_subtreeSize; //!< Nodes in the subtree including the node itself
+		std::vector<glm::vec3> m_translation; //!< Local translation
+		std::vector<glm::quat> m_rotation; //!< Local rotation
+		std::vector<glm::vec3> m_scale; //!< Local scale
+		std::vector<uint8_t> m_localDirty; //!< Local matrix needs recomposing
+		std::vector<glm::mat4> m_local; //!< Local matrix
+		std::vector<glm::mat4> m_world; //!< World matrix
+		std::vector<uint32_t> m_userData; //!< Value attached at creation
+
+		std::vector<Handle> m_dirty; //!< Nodes changed since the last update
+		std::vector<Handle> m_updated; //!< Nodes recomputed by the last update
+		bool m_orderDirty = false; //!< Arrays need re-sorting before the next update
+	};
+}
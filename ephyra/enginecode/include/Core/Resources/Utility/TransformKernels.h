@@ -0,0 +1,22 @@
+/** \file transformKernels.h */
+#pragma once
+
+#include <glm/glm.hpp>
+#include <glm/gtc/quaternion.hpp>
+
+#include <cstdint>
+
+namespace Engine
+{
+	namespace TransformKernels
+	{
+		enum class Path { Scalar = 0, SSE4, AVX2 }; //!< Kernel implementations, picked once from the CPU's features
+
+		bool isSupported(Path path); //!< Whether this CPU can run a path, detected once
+		Path getPath(); //!< Fastest path supported by this CPU
+		const char* getPathName(Path path); //!< Display name of a path
+
+		void composeTRS(const glm::vec3* translations, const glm::quat* rotations, const glm::vec3* scales, glm::mat4* out, uint32_t count); //!< Compose T * R * S for every transform with the fastest path
+		void composeTRS(Path path, const glm::vec3* translations, const glm::quat* rotations, const glm::vec3* scales, glm::mat4* out, uint32_t count); //!< Compose with a given path, falls back to scalar if unsupported
+	}
+}
@@ -0,0 +1,65 @@
+/** \file inputPath.h */
+#pragma once
+
+#include "Core/Systems/Events/InputPoller.h"
+
+#include <glm/glm.hpp>
+#include <cstdint>
+#include <string>
+#include <vector>
+
+namespace Engine
+{
+	/** \struct InputTick
+	*	What the camera and timeline saw at the start of one simulation tick
+	*/
+	struct InputTick
+	{
+		std::vector<uint16_t> keys; //!< Keys held
+		glm::vec2 mouseDelta = glm::vec2(0.f); //!< Mouse movement since the previous camera update
+		glm::vec2 scroll = glm::vec2(0.f); //!< Last scroll offset
+		bool buttons[2] = { false, false }; //!< Left and right mouse buttons
+		bool cameraActive = false; //!< Whether the camera took input, false while the editor GUI has focus
+		float timeKey = 0.f; //!< Timeline time
+	};
+
+	/** \class InputPath
+	*	Records the poller state, the camera focus and the timeline time once per tick, or writes a recording back in their
+	*	place. Ticks are fixed length, so playing a recording back moves the camera and animation through the same frames
+	*	whatever the frame rate, as long as the tick rate matches the one it was recorded at. The camera's own state is not
+	*	recorded, so a recording should start before the camera has moved from where the application starts it.
+	*/
+	class InputPath
+	{
+	public:
+		void startRecording(float step); //!< Drop what is held and record from the next tick
+		bool startPlayback(); //!< Play what is held from the start, false if nothing is
+		inline void stop() { m_mode = Mode::Idle; } //!< Stop recording or playing, what was recorded is kept
+
+		void tick(InputPoller& poller, bool& cameraActive, float& timeKey); //!< Record the tick or overwrite it from the recording, call before the camera updates
+
+		bool save(const std::string& filepath) const; //!< Write the recording as JSON
+		bool load(const std::string& filepath); //!< Read a recording, false if it cannot be read
+
+		inline bool isRecording() const { return m_mode == Mode::Recording; } //!< Whether ticks are being recorded
+		inline bool isPlaying() const { return m_mode == Mode::Playing; } //!< Whether ticks are being played back, false once the recording has run out
+		inline uint32_t getTickCount() const { return static_cast<uint32_t>(m_ticks.size()); } //!< Ticks held
+		inline uint32_t getPosition() const { return m_position; } //!< Ticks played so far
+		inline float getStep() const { return m_step; } //!< Seconds per tick it was recorded at
+	private:
+		/** \enum Mode
+		*	What each tick does
+		*/
+		enum class Mode
+		{
+			Idle = 0, //!< Nothing
+			Recording, //!< Append the tick
+			Playing //!< Overwrite the tick
+		};
+
+		Mode m_mode = Mode::Idle; //!< What each tick does
+		std::vector<InputTick> m_ticks; //!< Recording
+		uint32_t m_position = 0; //!< Next tick to play
+		float m_step = 1.f / 60.f; //!< Seconds per tick
+	};
+}
@@ -0,0 +1,83 @@
+/** \file fixedTimestep.h */
+#pragma once
+
+#include <glm/glm.hpp>
+#include <glm/gtc/quaternion.hpp>
+
+#include <algorithm>
+#include <cmath>
+#include <cstdint>
+
+namespace Engine
+{
+	/** \class FixedTimestep
+	*	Accumulates frame time and hands it out as whole ticks of a fixed length, so the simulation steps the same
+	*	however uneven the frames are. What is left over is the fraction of a tick rendering interpolates across.
+	*/
+	class FixedTimestep
+	{
+	public:
+		FixedTimestep(float tickRate = 60.f, uint32_t maxTicks = 5) { setTickRate(tickRate); setMaxTicks(maxTicks); } //!< Constructor
+
+		inline void setTickRate(float tickRate) { m_step = 1.f / std::max(tickRate, 1.f); } //!< Ticks per second
+		inline float getTickRate() const { return 1.f / m_step; } //!< Ticks per second
+		inline float getStep() const { return m_step; } //!< Seconds per tick
+		inline void setMaxTicks(uint32_t maxTicks) { m_maxTicks = std::max(1u, maxTicks); } //!< Most ticks run for one frame, the rest of a long frame is dropped
+		inline uint32_t getMaxTicks() const { return m_maxTicks; } //!< Most ticks run for one frame
+
+		uint32_t advance(float delta)
+		{
+			m_accumulator += std::max(delta, 0.f);
+			uint32_t ticks = static_cast<uint32_t>(m_accumulator / m_step);
+
+			// A frame longer than the tick budget would need more ticks next frame and so on, the simulation slows down instead
+			if (ticks > m_maxTicks)
+			{
+				m_droppedTicks += ticks - m_maxTicks;
+				ticks = m_maxTicks;
+				m_accumulator = std::fmod(m_accumulator, m_step) + ticks * m_step;
+			}
+
+			m_accumulator -= ticks * m_step;
+			m_alpha = std::min(1.f, m_accumulator / m_step);
+			m_ticks = ticks;
+			return ticks;
+		} //!< Add a frame's time, returns the ticks to run for it
+
+		inline void reset() { m_accumulator = 0.f; m_alpha = 0.f; m_ticks = 0; m_droppedTicks = 0; } //!< Drop the accumulated time
+
+		inline float getAlpha() const { return m_alpha; } //!< Fraction of a tick since the last one, 0 at the previous state and 1 at the latest
+		inline uint32_t getTicks() const { return m_ticks; } //!< Ticks run for the last frame
+		inline uint32_t getDroppedTicks() const { return m_droppedTicks; } //!< Ticks dropped since the reset by the tick budget
+
+		static glm::mat4 interpolate(const glm::mat4& previous, const glm::mat4& current, float alpha)
+		{
+			glm::vec3 scales[2];
+			glm::quat rotations[2];
+			const glm::mat4* transforms[2] = { &previous, &current };
+			for (int i = 0; i < 2; i++)
+			{
+				const glm::mat4& transform = *transforms[i];
+				scales[i] = glm::vec3(glm::length(glm::vec3(transform[0])), glm::length(glm::vec3(transform[1])), glm::length(glm::vec3(transform[2])));
+				glm::vec3 safeScale = glm::max(scales[i], glm::vec3(1e-8f));
+				glm::mat3 rotation(glm::vec3(transform[0]) / safeScale.x, glm::vec3(transform[1]) / safeScale.y, glm::vec3(transform[2]) / safeScale.z);
+				rotations[i] = glm::quat_cast(rotation);
+			}
+
+			glm::mat4 result = glm::mat4_cast(glm::slerp(rotations[0], rotations[1], alpha));
+			glm::vec3 scale = glm::mix(scales[0], scales[1], alpha);
+			result[0] *= scale.x;
+			result[1] *= scale.y;
+			result[2] *= scale.z;
+			result[3] = glm::vec4(glm::mix(glm::vec3(previous[3]), glm::vec3(current[3]), alpha), 1.f);
+			return result;
+		} //!< Blend two transforms without shear, translation and scale linearly and rotation along the shortest arc
+	private:
+		float m_step = 1.f / 60.f; //!< Seconds per tick
+		uint32_t m_maxTicks = 5; //!< Tick budget per frame
+		float m_accumulator = 0.f; //!< Time not yet simulated
+		float m_alpha = 0.f; //!< Accumulated time as a fraction of a tick
+		uint32_t m_ticks = 0; //!< Ticks run for the last frame
+		uint32_t m_droppedTicks = 0; //!< Ticks dropped since the reset
+	};
+}
@@ -0,0 +1,45 @@
+/** \file framePacer.h */
+#pragma once
+
+#include <chrono>
+#include <cstdint>
+
+namespace Engine
+{
+	/** \struct FramePacerStats
+	*	Time spent holding back the last frame
+	*/
+	struct FramePacerStats
+	{
+		float sleepTime = 0.f; //!< Seconds the thread slept
+		float spinTime = 0.f; //!< Seconds spent spinning up to the deadline
+		float lateTime = 0.f; //!< Seconds the frame ended past its deadline
+	};
+
+	/** \class FramePacer
+	*	Holds each frame to a target rate. Most of the wait is slept so the CPU is free, the last moment is spun
+	*	because a sleep can overshoot by a scheduler tick. On Windows the tick is shortened to 1 ms while a rate is set.
+	*/
+	class FramePacer
+	{
+	public:
+		~FramePacer(); //!< Restores the system timer resolution if pacing raised it
+
+		void setTargetRate(float rate); //!< Frames per second to hold to, 0 to not limit
+		inline float getTargetRate() const { return m_targetRate; } //!< Frames per second held to, 0 when not limiting
+		inline void setSpinTime(float seconds) { m_spinTime = seconds > 0.f ? seconds : 0.f; } //!< Part of each wait spun rather than slept
+		inline float getSpinTime() const { return m_spinTime; } //!< Part of each wait spun rather than slept
+
+		void wait(); //!< Block until a frame interval has passed since the previous wait
+		inline const FramePacerStats& getStats() const { return m_stats; } //!< Time spent in the last wait
+	private:
+		using Clock = std::chrono::steady_clock;
+
+		float m_targetRate = 0.f; //!< Frames per second, 0 when not limiting
+		float m_spinTime = 0.002f; //!< Seconds before the deadline to stop sleeping
+		Clock::time_point m_deadline; //!< When the previous frame was due
+		bool m_started = false; //!< Whether a deadline has been set
+		bool m_fineTimer = false; //!< Whether the system timer resolution is raised for the sleeps
+		FramePacerStats m_stats; //!< Time spent in the last wait
+	};
+}
@@ -0,0 +1,129 @@
+/** \file jobSystem.h */
+#pragma once
+
+#include "system.h"
+
+#include <algorithm>
+#include <atomic>
+#include <cstdint>
+#include <deque>
+#include <functional>
+#include <iterator>
+#include <memory>
+#include <mutex>
+#include <type_traits>
+#include <vector>
+
+namespace Engine
+{
+	/** \enum JobAffinity
+	*	Threads allowed to run a job
+	*/
+	enum class JobAffinity
+	{
+		Any = 0, //!< Any worker or a waiting thread
+		MainThread //!< Only the main thread, for work that touches the GL context
+	};
+
+	class JobCounter;
+
+	/** \struct Job
+	*	Function queued on the job system and the counter it reports to
+	*/
+	struct Job
+	{
+		std::function<void()> function; //!< Work to run
+		std::shared_ptr<JobCounter> counter; //!< Decremented once the work has run, may be empty
+		JobAffinity affinity = JobAffinity::Any; //!< Threads allowed to run it
+	};
+
+	/** \class JobCounter
+	*	Number of unfinished jobs in a group. Jobs can be made to wait on a counter, they are queued once it reaches zero
+	*/
+	class JobCounter
+	{
+	public:
+		inline bool isDone() const { return m_pending.load(std::memory_order_acquire) == 0; } //!< Whether every job in the group has run
+		inline uint32_t getPending() const { return m_pending.load(std::memory_order_acquire); } //!< Jobs still to run
+	private:
+		friend class JobSystem;
+
+		std::atomic<uint32_t> m_pending{ 0 }; //!< Jobs submitted and not yet finished
+		std::mutex m_mutex; //!< Guards the continuations
+		std::vector<Job> m_continuations; //!< Jobs waiting for this counter to reach zero
+	};
+
+	using JobHandle = std::shared_ptr<JobCounter>;
+
+	/** \class JobSystem
+	*	Work stealing thread pool. Every worker owns a deque, it pushes and pops its own jobs at the back while idle workers
+	*	steal from the front of the others. The main thread owns a deque too and helps run jobs whenever it waits.
+	*	Jobs with main thread affinity are never stolen, they run when the main thread waits or drains them each frame.
+	*/
+	class JobSystem : public System
+	{
+	public:
+		virtual void start(SystemSignal init = SystemSignal::None, ...) override; //!< Start a worker for every hardware thread but the main one
+		virtual void stop(SystemSignal close = SystemSignal::None, ...) override; //!< Finish the queued jobs and join the workers
+		static void setThreadCount(uint32_t threads); //!< Restart with threads - 1 workers, from the main thread of a started system, such as to measure scaling
+
+		static JobHandle run(std::function<void()> function, JobAffinity affinity = JobAffinity::Any); //!< Queue a job in a new group
+		static void run(const JobHandle& counter, std::function<void()> function, JobAffinity affinity = JobAffinity::Any); //!< Queue a job in an existing group
+		static void runAfter(const JobHandle& dependency, const JobHandle& counter, std::function<void()> function, JobAffinity affinity = JobAffinity::Any); //!< Queue a job once every job in another group has run
+		static void wait(const JobHandle& counter); //!< Run jobs on this thread until a group is done
+
+		static void drainMainThread(); //!< Run every job with main thread affinity, called once a frame by the application
+
+		template<typename Function>
+		static void parallelFor(uint32_t count, uint32_t grain, Function&& function); //!< Call function(first, last) over ranges of at most grain items and wait for them
+		template<typename Range, typename Function>
+		static void parallelForEach(const Range& range, uint32_t grain, Function&& function); //!< Call function(item) for every item of a range, such as an entt view or group, and wait
+
+		static uint32_t getWorkerCount(); //!< Worker threads, not counting the main thread
+		static uint32_t getThreadCount() { return getWorkerCount() + 1; } //!< Threads able to run jobs
+		static bool isMainThread(); //!< Whether the calling thread started the job system
+	private:
+		static void startWorkers(uint32_t count); //!< Spawn workers and their deques
+		static void stopWorkers(); //!< Run what is left and join the workers
+		static void schedule(Job&& job); //!< Push a job whose dependencies are met
+		static void finish(Job& job); //!< Report a job as run and release its counter's continuations
+		static bool tryRunJob(bool mainThread); //!< Run one job from this thread's deque, the main queue or a victim, false if none was found
+		static void workerLoop(uint32_t index); //!< Body of a worker thread
+	};
+
+	template<typename Function>
+	void JobSystem::parallelFor(uint32_t count, uint32_t grain, Function&& function)
+	{
+		if (count == 0) return;
+		grain = std::max(1u, grain);
+
+		// A single range, or nobody to share it with, is not worth queueing
+		if (count <= grain || getWorkerCount() == 0)
+		{
+			function(0u, count);
+			return;
+		}
+
+		// The caller runs the first range itself and then helps with the rest while it waits
+		JobHandle counter = std::make_shared<JobCounter>();
+		for (uint32_t first = grain; first < count; first += grain)
+		{
+			uint32_t last = std::min(count, first + grain);
+			run(counter, [&function, first, last]() { function(first, last); });
+		}
+		function(0u, std::min(count, grain));
+		wait(counter);
+	}
+
+	template<typename Range, typename Function>
+	void JobSystem::parallelForEach(const Range& range, uint32_t grain, Function&& function)
+	{
+		// Views are not random access, so take a snapshot of the items before splitting
+		using Item = typename std::decay<decltype(*std::begin(range))>::type;
+		std::vector<Item> items(std::begin(range), std::end(range));
+		parallelFor(static_cast<uint32_t>(items.size()), grain, [&items, &function](uint32_t first, uint32_t last) {
+			for (uint32_t i = first; i < last; i++)
+				function(items[i]);
+		});
+	}
+}
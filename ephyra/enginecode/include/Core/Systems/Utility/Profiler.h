@@ -0,0 +1,125 @@
+/** \file profiler.h */
+#pragma once
+
+#include <atomic>
+#include <chrono>
+#include <cstdint>
+#include <string>
+#include <vector>
+
+#if defined(_MSC_VER) && (defined(_M_X64) || defined(_M_IX86))
+#include <intrin.h>
+#define EPHYRA_PROFILER_TSC
+#elif defined(__x86_64__) || defined(__i386__)
+#include <x86intrin.h>
+#define EPHYRA_PROFILER_TSC
+#endif
+
+// Zones are compiled in for debug builds, release builds opt in by defining EPHYRA_PROFILE
+#if defined(NG_DEBUG) || defined(EPHYRA_PROFILE)
+#define EPHYRA_PROFILING
+#endif
+
+#define EPHYRA_PROFILE_CONCAT_INNER(a, b) a##b
+#define EPHYRA_PROFILE_CONCAT(a, b) EPHYRA_PROFILE_CONCAT_INNER(a, b)
+
+#ifdef EPHYRA_PROFILING
+#define EPHYRA_PROFILE_SCOPE(name) ::Engine::ProfileScope EPHYRA_PROFILE_CONCAT(profileScope, __LINE__)(name) //!< Time the rest of the scope, name must outlive the capture
+#define EPHYRA_PROFILE_FUNCTION() EPHYRA_PROFILE_SCOPE(__FUNCTION__) //!< Time the rest of the function
+#define EPHYRA_PROFILE_FRAME() ::Engine::Profiler::frame() //!< Mark the end of a frame
+#define EPHYRA_PROFILE_THREAD(name) ::Engine::Profiler::setThreadName(name) //!< Name the calling thread in exported traces
+#else
+#define EPHYRA_PROFILE_SCOPE(name) ((void)0)
+#define EPHYRA_PROFILE_FUNCTION() ((void)0)
+#define EPHYRA_PROFILE_FRAME() ((void)0)
+#define EPHYRA_PROFILE_THREAD(name) ((void)0)
+#endif
+
+namespace Engine
+{
+	/** \struct ProfileZoneTotal
+	*	Time spent in every zone sharing a name over a capture
+	*/
+	struct ProfileZoneTotal
+	{
+		std::string name; //!< Zone name
+		float time = 0.f; //!< Inclusive seconds across every thread
+		uint32_t count = 0; //!< Times the zone was entered
+	};
+
+	/** \struct ProfilerStats
+	*	Size of the last capture
+	*/
+	struct ProfilerStats
+	{
+		uint32_t frames = 0; //!< Frames captured
+		uint32_t events = 0; //!< Zones recorded
+		uint32_t dropped = 0; //!< Zones lost to full thread buffers
+		uint32_t threads = 0; //!< Threads that recorded a zone
+		float duration = 0.f; //!< Seconds from the first to the last frame marker
+	};
+
+	/** \class Profiler
+	*	Records timed zones into a buffer per thread. Only the owning thread writes a buffer and publishes how much of it
+	*	is filled with a release store, so recording takes no lock. Zones are only recorded while a capture of a number of
+	*	frames is running, outside one a zone costs a single relaxed load.
+	*/
+	class Profiler
+	{
+	public:
+		constexpr static uint32_t bufferCapacity = 1 << 16; //!< Zones per thread per capture
+
+		static void beginCapture(uint32_t frames); //!< Record every zone for a number of frames, from the next frame marker
+		static void frame(); //!< Mark the end of a frame, called once per loop by the application
+		static inline bool isCapturing() { return s_capturing.load(std::memory_order_relaxed); } //!< Whether zones are being recorded
+		static bool isCaptureReady(); //!< Whether a finished capture is held
+		static bool exportChromeTrace(const std::string& filepath); //!< Write the last capture as Chrome trace JSON, which Perfetto also opens
+		static void getZoneTotals(std::vector<ProfileZoneTotal>& totals); //!< Time per zone name over the last capture, slowest first
+		static const ProfilerStats& getStats(); //!< Size of the last capture
+		static void setThreadName(const char* name); //!< Name the calling thread in exported traces
+		static float measureOverhead(uint32_t zones = 50000); //!< Nanoseconds per recorded zone, discards any capture
+		static double getTicksPerSecond(); //!< Rate of now(), measured once by the first capture request and used for every track
+
+		static inline uint64_t now()
+		{
+#ifdef EPHYRA_PROFILER_TSC
+			return __rdtsc();
+#else
+			return static_cast<uint64_t>(std::chrono::steady_clock::now().time_since_epoch().count());
+#endif
+		} //!< Timestamp in profiler ticks
+		static void record(const char* name, uint64_t start, uint64_t end, uint32_t depth); //!< Store a finished zone in the calling thread's buffer
+		static void recordGpu(const char* name, uint64_t start, uint64_t end, uint32_t depth); //!< Store a zone timed on the GPU, already in profiler ticks, on its own track, main thread only
+	private:
+		static std::atomic<bool> s_capturing; //!< Whether zones are being recorded
+	};
+
+	/** \class ProfileScope
+	*	Zone timed from construction to destruction
+	*/
+	class ProfileScope
+	{
+	public:
+		inline ProfileScope(const char* name) : m_name(name), m_active(Profiler::isCapturing())
+		{
+			if (!m_active) return;
+			m_depth = s_depth++;
+			m_start = Profiler::now();
+		} //!< Constructor, starts the zone if a capture is running
+		inline ~ProfileScope()
+		{
+			if (!m_active) return;
+			Profiler::record(m_name, m_start, Profiler::now(), m_depth);
+			s_depth--;
+		} //!< Destructor, ends the zone
+		ProfileScope(const ProfileScope&) = delete;
+		ProfileScope& operator=(const ProfileScope&) = delete;
+	private:
+		const char* m_name; //!< Zone name
+		uint64_t m_start = 0; //!< Timestamp at construction
+		uint32_t m_depth = 0; //!< Zones open on this thread when it started
+		bool m_active; //!< Whether a capture was running at construction
+
+		static thread_local uint32_t s_depth; //!< Zones open on this thread
+	};
+}
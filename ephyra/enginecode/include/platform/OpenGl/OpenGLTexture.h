@@ -11,6 +11,7 @@ namespace Engine
 	public:
 		OpenGLTexture(const char* filepath);
 		OpenGLTexture(uint32_t width, uint32_t height, uint32_t channels, unsigned char* data);
+		OpenGLTexture(uint32_t width, uint32_t height, uint32_t channels, float* data);
 		virtual ~OpenGLTexture() override;
 		virtual void edit(uint32_t xOffset, uint32_t yOffset, uint32_t width, uint32_t height, unsigned char* data) override;
 		virtual void load(uint32_t unit) override;
@@ -2,12 +2,17 @@
 
 #include "Ephyra_pch.h"
 #include "Core/Initialization/Application.h"
+#include "Core/Rendering/API/Global/RenderStats.h"
+#include "Core/Rendering/Renderer/RenderCapture.h"
+
+#include <algorithm>
 
 namespace Engine 
 {
 
 		// Set static variables
 	Application* Application::s_instance = nullptr;
+	std::vector<std::string> Application::s_arguments;
 
 	Application::Application()
 	{
@@ -23,6 +28,11 @@ namespace Engine
 		m_logSystem.reset(new Log);
 		m_logSystem->start();
 
+		// Start job system, the constructing thread becomes the main thread
+		m_jobSystem.reset(new JobSystem);
+		m_jobSystem->start();
+		EPHYRA_PROFILE_THREAD("Main");
+
 		// reset timer
 		m_timer.reset(new ChronoTimer);
 		m_timer->start();
@@ -38,8 +48,11 @@ namespace Engine
 
 		// Define Window
 		WindowProperties props("Ephyra Animation Engine - Untitled.eph", SCR_WIDTH, SCR_HEIGHT, false); //!< Window Properties
+		bool headless = hasArgument("--headless");
+		props.m_isHidden = headless;
 
 		m_window.reset(Window::create(props));
+		if (headless) m_window->setVSync(false);
 
 		SCR_WIDTH = m_window->getWidthf();
 		SCR_HEIGHT = m_window->getHeightf();
@@ -78,6 +91,7 @@ namespace Engine
 
 	Application::~Application()
 	{
+		m_jobSystem->stop();
 		m_windowsSystem->stop();
 		m_logSystem->stop();
 
@@ -85,17 +99,148 @@ namespace Engine
 
 	void Application::run()
 	{
+		ChronoTimer frameTimer;
 		while (m_running)
 		{
-			deltaTime = m_timer->getElapsedTime();
+			EPHYRA_PROFILE_FRAME();
+			frameTimer.start();
+			deltaTime = m_fixedDelta > 0.f ? m_fixedDelta : m_timer->getElapsedTime();
 			m_timer->reset();
+
+			if (m_pipelined)
+				runPipelined();
+			else
+				runSequential();
+
+			// GL work queued from other threads runs before the frame is presented
+			JobSystem::drainMainThread();
+
+			{
+				EPHYRA_PROFILE_SCOPE("Window Update");
+				m_window->onUpdate(deltaTime);
+			}
+			RenderStats::endFrame();
+			RenderCapture::endFrame();
+
+			// Sleeps most of what is left of the frame when limiting, so the CPU idles rather than spinning without vsync
+			{
+				EPHYRA_PROFILE_SCOPE("Frame Pacing");
+				m_framePacer.wait();
+			}
+			m_pipelineStats.frame = frameTimer.getElapsedTime();
+		}
+	}
+
+	bool Application::hasArgument(const std::string& name)
+	{
+		return std::find(s_arguments.begin(), s_arguments.end(), name) != s_arguments.end();
+	}
+
+	std::string Application::getArgument(const std::string& name, const std::string& fallback)
+	{
+		auto argument = std::find(s_arguments.begin(), s_arguments.end(), name);
+		if (argument == s_arguments.end() || argument + 1 == s_arguments.end()) return fallback;
+		return *(argument + 1);
+	}
+
+	void Application::runFixedUpdates()
+	{
+		EPHYRA_PROFILE_FUNCTION();
+		uint32_t ticks = m_fixedTimestep.advance(deltaTime);
+		for (uint32_t tick = 0; tick < ticks; tick++)
 			for (auto layer = m_layerStack->begin(); layer != m_layerStack->end(); layer++)
-				(*layer)->OnUpdate(deltaTime);
+			{
+				EPHYRA_PROFILE_SCOPE((*layer)->GetName().c_str());
+				(*layer)->OnFixedUpdate(m_fixedTimestep.getStep());
+			}
+	}
+
+	void Application::runSequential()
+	{
+		EPHYRA_PROFILE_FUNCTION();
+		ChronoTimer stageTimer;
+		stageTimer.start();
+		m_primed = false;
+		runFixedUpdates();
+		for (auto layer = m_layerStack->begin(); layer != m_layerStack->end(); layer++)
+		{
+			EPHYRA_PROFILE_SCOPE((*layer)->GetName().c_str());
+			(*layer)->OnUpdate(deltaTime);
+		}
 
-			m_window->onUpdate(deltaTime);
+		m_pipelineStats.simulation = 0.f;
+		m_pipelineStats.render = 0.f;
+		m_pipelineStats.other = stageTimer.getElapsedTime();
+	}
 
+	void Application::runPipelined()
+	{
+		EPHYRA_PROFILE_FUNCTION();
+		ChronoTimer stageTimer;
 
+		// The first pipelined frame has nothing extracted yet, so it is simulated up front and this frame's step is spent
+		bool priming = !m_primed;
+		if (priming)
+		{
+			for (auto layer = m_layerStack->begin(); layer != m_layerStack->end(); layer++)
+			{
+				if (!(*layer)->isPipelined()) continue;
+				(*layer)->OnSimulate(deltaTime);
+				(*layer)->OnSync();
+			}
+			m_primed = true;
+		}
+
+		// Frame N+1 is simulated and extracted on a worker while frame N is drawn here from its packet
+		float simulationTime = 0.f;
+		float timestep = deltaTime;
+		JobHandle simulation;
+		if (!priming)
+		{
+			simulation = JobSystem::run([this, timestep, &simulationTime]() {
+				EPHYRA_PROFILE_SCOPE("Simulation");
+				ChronoTimer simulationTimer;
+				simulationTimer.start();
+				for (auto layer = m_layerStack->begin(); layer != m_layerStack->end(); layer++)
+					if ((*layer)->isPipelined())
+						(*layer)->OnSimulate(timestep);
+				simulationTime = simulationTimer.getElapsedTime();
+			});
+		}
+
+		stageTimer.start();
+		{
+			EPHYRA_PROFILE_SCOPE("Render");
+			for (auto layer = m_layerStack->begin(); layer != m_layerStack->end(); layer++)
+				if ((*layer)->isPipelined())
+					(*layer)->OnRender();
+		}
+		m_pipelineStats.render = stageTimer.getElapsedTime();
+
+		{
+			EPHYRA_PROFILE_SCOPE("Wait For Simulation");
+			JobSystem::wait(simulation);
+		}
+		m_pipelineStats.simulation = simulationTime;
+
+		// Both stages are done, ticks and layers that are not pipelined may touch the scene before it is handed over
+		stageTimer.start();
+		runFixedUpdates();
+		for (auto layer = m_layerStack->begin(); layer != m_layerStack->end(); layer++)
+		{
+			if ((*layer)->isPipelined()) continue;
+			EPHYRA_PROFILE_SCOPE((*layer)->GetName().c_str());
+			(*layer)->OnUpdate(deltaTime);
+		}
+
+		// Nothing new was extracted while priming, the packet just drawn is drawn again next frame
+		if (!priming)
+		{
+			for (auto layer = m_layerStack->begin(); layer != m_layerStack->end(); layer++)
+				if ((*layer)->isPipelined())
+					(*layer)->OnSync();
 		}
+		m_pipelineStats.other = stageTimer.getElapsedTime();
 	}
 
-}
+}
\ No newline at end of file
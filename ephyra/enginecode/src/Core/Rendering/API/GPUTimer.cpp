@@ -0,0 +1,201 @@
+/** \file gpuTimer.cpp */
+
+#include "Ephyra_pch.h"
+
+#include "Core/Rendering/Renderer/GPUTimer.h"
+#include "Core/Systems/Utility/Log.h"
+#include "Core/Systems/Utility/Profiler.h"
+
+#include <Glad/glad.h>
+#include <algorithm>
+
+namespace Engine
+{
+	namespace
+	{
+		/** \struct GPUZone
+		*	Zone of a frame in flight, as the queries stamping its ends
+		*/
+		struct GPUZone
+		{
+			const char* name; //!< Zone name
+			uint32_t depth; //!< Zones it is nested in
+			uint32_t beginQuery; //!< Index in the frame's pool stamped on opening
+			uint32_t endQuery; //!< Index in the frame's pool stamped on closing
+		};
+
+		/** \struct GPUFrame
+		*	Queries of one frame of the ring
+		*/
+		struct GPUFrame
+		{
+			std::vector<GLuint> queries; //!< Pool, grows to the most zones a frame has used
+			uint32_t used = 0; //!< Queries issued this frame
+			std::vector<GPUZone> zones; //!< Zones in the order they opened
+			uint64_t number = 0; //!< Frame number it was issued in
+			bool issued = false; //!< Whether results are owed
+			bool anchored = false; //!< Whether the clocks were sampled for the profiler
+			uint64_t cpuAnchor = 0; //!< Profiler ticks when the frame began
+			GLint64 gpuAnchor = 0; //!< GPU nanoseconds when the frame began
+		};
+
+		bool s_supported = false; //!< Whether timestamp queries count
+		bool s_enabled = true; //!< Whether frames are timed
+		bool s_frameActive = false; //!< Between beginFrame and endFrame
+		uint64_t s_frameNumber = 0; //!< Frames begun
+		GPUFrame s_frames[GPUTimer::frameLatency]; //!< Ring of frames in flight
+		std::vector<uint32_t> s_open; //!< Zones of the current frame still open, innermost last
+		std::vector<GPUTimerResult> s_results; //!< Zones of the latest finished frame
+		std::vector<GLuint64> s_timestamps; //!< Read back results, reused
+		GPUTimerStats s_stats; //!< State of the frames in flight
+
+		GPUFrame& currentFrame()
+		{
+			return s_frames[s_frameNumber % GPUTimer::frameLatency];
+		}
+
+		uint32_t stamp(GPUFrame& frame)
+		{
+			if (frame.used == frame.queries.size())
+			{
+				GLuint query = 0;
+				glGenQueries(1, &query);
+				frame.queries.push_back(query);
+				s_stats.queries++;
+			}
+			glQueryCounter(frame.queries[frame.used], GL_TIMESTAMP);
+			return frame.used++;
+		}
+
+		void collect(GPUFrame& frame)
+		{
+			s_timestamps.resize(frame.used);
+			for (uint32_t i = 0; i < frame.used; i++)
+				glGetQueryObjectui64v(frame.queries[i], GL_QUERY_RESULT, &s_timestamps[i]);
+
+			// Anchored at the frame's start, so drift between the clocks only builds up over one frame
+			bool toProfiler = frame.anchored && Profiler::isCapturing();
+			double ticksPerNanosecond = toProfiler ? Profiler::getTicksPerSecond() / 1000000000.0 : 0.0;
+
+			s_results.clear();
+			for (auto& zone : frame.zones)
+			{
+				GLuint64 start = s_timestamps[zone.beginQuery];
+				GLuint64 end = std::max(s_timestamps[zone.endQuery], start);
+				s_results.push_back({ zone.name, static_cast<float>((end - start) / 1000000000.0), zone.depth });
+
+				if (toProfiler)
+				{
+					double offset = static_cast<double>(static_cast<GLint64>(start) - frame.gpuAnchor) * ticksPerNanosecond;
+					uint64_t startTicks = frame.cpuAnchor + static_cast<uint64_t>(std::max(offset, 0.0));
+					uint64_t endTicks = startTicks + static_cast<uint64_t>((end - start) * ticksPerNanosecond);
+					Profiler::recordGpu(zone.name, startTicks, endTicks, zone.depth);
+				}
+			}
+
+			s_stats.frameTime = s_results.empty() ? 0.f : s_results.front().time;
+			s_stats.latency = static_cast<uint32_t>(s_frameNumber - frame.number);
+			frame.issued = false;
+		}
+	}
+
+	void GPUTimer::init()
+	{
+		GLint bits = 0;
+		glGetQueryiv(GL_TIMESTAMP, GL_QUERY_COUNTER_BITS, &bits);
+		s_supported = bits > 0;
+		if (!s_supported)
+			Log::warn("Timestamp queries unsupported, GPU passes will not be timed");
+	}
+
+	void GPUTimer::setEnabled(bool enabled)
+	{
+		if (s_frameActive) endFrame();
+		s_enabled = enabled;
+	}
+
+	bool GPUTimer::isEnabled()
+	{
+		return s_enabled && s_supported;
+	}
+
+	void GPUTimer::beginFrame()
+	{
+		if (!isEnabled() || s_frameActive) return;
+
+		// The GPU finishes frames in order, so collecting stops at the first frame not yet done
+		for (uint32_t i = 0; i < frameLatency; i++)
+		{
+			GPUFrame& frame = s_frames[(s_frameNumber + i) % frameLatency];
+			if (!frame.issued) continue;
+
+			GLuint available = 0;
+			glGetQueryObjectuiv(frame.queries[frame.used - 1], GL_QUERY_RESULT_AVAILABLE, &available);
+			if (!available) break;
+			collect(frame);
+		}
+
+		// Still owed after a full ring, its queries are reused rather than waited on
+		GPUFrame& frame = currentFrame();
+		if (frame.issued)
+		{
+			s_stats.dropped++;
+			frame.issued = false;
+		}
+
+		frame.used = 0;
+		frame.zones.clear();
+		frame.number = s_frameNumber;
+		frame.anchored = Profiler::isCapturing();
+		if (frame.anchored)
+		{
+			frame.cpuAnchor = Profiler::now();
+			glGetInteger64v(GL_TIMESTAMP, &frame.gpuAnchor);
+		}
+
+		s_frameActive = true;
+		s_open.clear();
+		begin("GPU Frame");
+	}
+
+	void GPUTimer::endFrame()
+	{
+		if (!s_frameActive) return;
+
+		while (!s_open.empty()) end();
+
+		GPUFrame& frame = currentFrame();
+		frame.issued = frame.used > 0;
+		s_frameActive = false;
+		s_frameNumber++;
+	}
+
+	void GPUTimer::begin(const char* name)
+	{
+		if (!s_frameActive) return;
+
+		GPUFrame& frame = currentFrame();
+		uint32_t query = stamp(frame);
+		s_open.push_back(static_cast<uint32_t>(frame.zones.size()));
+		frame.zones.push_back({ name, static_cast<uint32_t>(s_open.size() - 1), query, query });
+	}
+
+	void GPUTimer::end()
+	{
+		if (!s_frameActive || s_open.empty()) return;
+
+		GPUFrame& frame = currentFrame();
+		frame.zones[s_open.back()].endQuery = stamp(frame);
+		s_open.pop_back();
+	}
+
+	const std::vector<GPUTimerResult>& GPUTimer::getResults()
+	{
+		return s_results;
+	}
+
+	const GPUTimerStats& GPUTimer::getStats()
+	{
+		return s_stats;
+	}
+}
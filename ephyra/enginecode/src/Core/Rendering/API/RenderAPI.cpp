@@ -218,6 +218,28 @@ namespace Engine
 
 	}
 
+	Texture* Texture::createFloat(uint32_t width, uint32_t height, uint32_t channels, float* data)
+	{
+		switch (RenderAPI::getAPI())
+		{
+		case RenderAPI::API::None:
+			Log::error("No Render Api is Not Supported");
+			break;
+		case RenderAPI::API::OpenGL:
+			return new OpenGLTexture(width, height, channels, data);
+			break;
+		case RenderAPI::API::Direct3D:
+			Log::error("Direct3D is Not Supported");
+			break;
+		case RenderAPI::API::Vulkan:
+			Log::error("Vulkan is Not Supported");
+			break;
+		}
+
+		return nullptr;
+
+	}
+
 	UniformBuffer* UniformBuffer::create(const uniformBufferLayout& layout)
 	{
 		switch (RenderAPI::getAPI())
@@ -0,0 +1,560 @@
+/** \file renderCapture.cpp */
+
+#include "Ephyra_pch.h"
+
+#include "Core/Rendering/Renderer/RenderCapture.h"
+#include "Core/Systems/Utility/Log.h"
+
+#include <glm/gtc/type_ptr.hpp>
+#include <cstring>
+#include <fstream>
+#include <iterator>
+#include <unordered_set>
+
+namespace Engine
+{
+	namespace
+	{
+		/** \enum CaptureState
+		*	Where a capture is
+		*/
+		enum class CaptureState
+		{
+			Idle = 0, //!< Nothing to record
+			Armed, //!< Waiting for the next frame boundary
+			Recording //!< Recording whole frames
+		};
+
+		CaptureState s_state = CaptureState::Idle; //!< Where the capture is
+		uint32_t s_framesLeft = 0; //!< Frames still to record
+		std::ofstream s_file; //!< Capture file
+		std::vector<uint8_t> s_buffer; //!< Records of the frame in progress, written out at its end
+		std::unordered_set<uint32_t> s_geometries; //!< Meshes written
+		std::unordered_set<uint32_t> s_textures; //!< Textures written
+		std::unordered_map<const Material*, uint32_t> s_materialHandles; //!< Handles of materials written
+		std::vector<std::shared_ptr<Material>> s_materials; //!< Held so no address is reused for another material while recording
+		std::vector<glm::vec3> s_lightPos; //!< Lights last written
+		std::vector<glm::vec3> s_lightColour; //!< Lights last written
+		RenderCaptureStats s_stats; //!< Contents of the capture
+
+		template<typename T>
+		void write(const T& value)
+		{
+			const uint8_t* bytes = reinterpret_cast<const uint8_t*>(&value);
+			s_buffer.insert(s_buffer.end(), bytes, bytes + sizeof(T));
+		}
+
+		template<typename T>
+		void writeArray(const T* values, size_t count)
+		{
+			const uint8_t* bytes = reinterpret_cast<const uint8_t*>(values);
+			s_buffer.insert(s_buffer.end(), bytes, bytes + count * sizeof(T));
+		}
+
+		void writeOp(RenderCapture::Op op)
+		{
+			write(static_cast<uint8_t>(op));
+		}
+
+		void writeTexture(const std::shared_ptr<Texture>& texture)
+		{
+			if (!texture || !s_textures.insert(texture->getID()).second) return;
+
+			writeOp(RenderCapture::Op::Texture);
+			write(texture->getID());
+			write(texture->getWidth());
+			write(texture->getHeight());
+			write(texture->getChannels());
+			s_stats.textures++;
+		}
+
+		uint32_t writeMaterial(const std::shared_ptr<Material>& material)
+		{
+			auto found = s_materialHandles.find(material.get());
+			if (found != s_materialHandles.end()) return found->second;
+
+			auto textures = material->getTextures();
+			for (auto& texture : textures) writeTexture(texture);
+
+			uint32_t handle = static_cast<uint32_t>(s_materials.size());
+			s_materialHandles[material.get()] = handle;
+			s_materials.push_back(material);
+
+			uint32_t flags = 0;
+			for (uint32_t flag : { Material::flag_batched, Material::flag_texture, Material::flag_tint })
+				if (material->isFlagSet(flag)) flags |= flag;
+
+			writeOp(RenderCapture::Op::Material);
+			write(handle);
+			write(flags);
+			write(material->getTint());
+			write(material->getShader() ? material->getShader()->getID() : 0u);
+			write(static_cast<uint32_t>(textures.size()));
+			for (auto& texture : textures) write(texture ? texture->getID() : 0u);
+			s_stats.materials++;
+			return handle;
+		}
+
+		void writeGeometry(const Geometry& geometry)
+		{
+			if (!s_geometries.insert(geometry.id).second) return;
+
+			std::vector<Renderer3DVertex> vertices;
+			std::vector<uint32_t> indices;
+			std::vector<Meshlet> meshlets;
+			Renderer3D::readGeometry(geometry, vertices, indices, meshlets);
+
+			// A skinned copy keeps the source's weights but is drawn as a static mesh
+			if (!geometry.hasBones)
+				for (auto& vertex : vertices) vertex.boneWeights = glm::vec4(0.f);
+
+			writeOp(RenderCapture::Op::Geometry);
+			write(geometry.id);
+			write(static_cast<uint32_t>(vertices.size()));
+			write(static_cast<uint32_t>(indices.size()));
+			write(static_cast<uint32_t>(meshlets.size()));
+			writeArray(vertices.data(), vertices.size());
+			writeArray(indices.data(), indices.size());
+			writeArray(meshlets.data(), meshlets.size());
+			s_stats.geometries++;
+		}
+
+		void writeLights()
+		{
+			if (s_lightPos == RendererCommon::lightPos && s_lightColour == RendererCommon::lightColour) return;
+			s_lightPos = RendererCommon::lightPos;
+			s_lightColour = RendererCommon::lightColour;
+
+			writeOp(RenderCapture::Op::Lights);
+			write(static_cast<uint32_t>(s_lightPos.size()));
+			writeArray(s_lightPos.data(), s_lightPos.size());
+			write(static_cast<uint32_t>(s_lightColour.size()));
+			writeArray(s_lightColour.data(), s_lightColour.size());
+		}
+
+		void flushBuffer()
+		{
+			s_file.write(reinterpret_cast<const char*>(s_buffer.data()), s_buffer.size());
+			s_stats.bytes += s_buffer.size();
+			s_buffer.clear();
+		}
+
+		void finish()
+		{
+			s_file.close();
+			s_state = CaptureState::Idle;
+			s_buffer.clear();
+			s_geometries.clear();
+			s_textures.clear();
+			s_materialHandles.clear();
+			s_materials.clear();
+			Log::info("Render capture finished: {0} frames, {1} calls, {2} bytes", s_stats.frames, s_stats.calls, s_stats.bytes);
+		}
+
+		template<typename T>
+		bool read(const std::vector<uint8_t>& stream, size_t& offset, T& value)
+		{
+			if (offset + sizeof(T) > stream.size()) return false;
+			std::memcpy(&value, stream.data() + offset, sizeof(T));
+			offset += sizeof(T);
+			return true;
+		}
+
+		template<typename T>
+		bool readArray(const std::vector<uint8_t>& stream, size_t& offset, std::vector<T>& values, uint32_t count)
+		{
+			if (offset + static_cast<size_t>(count) * sizeof(T) > stream.size()) return false;
+			values.resize(count);
+			if (count > 0) std::memcpy(values.data(), stream.data() + offset, count * sizeof(T));
+			offset += count * sizeof(T);
+			return true;
+		}
+	}
+
+	bool RenderCapture::begin(const std::string& filepath, uint32_t frames)
+	{
+		if (s_state != CaptureState::Idle || frames == 0) return false;
+
+		s_file.open(filepath, std::ios::binary | std::ios::trunc);
+		if (!s_file.is_open())
+		{
+			Log::error("Cannot open render capture file {0}", filepath);
+			return false;
+		}
+
+		s_stats = RenderCaptureStats();
+		s_lightPos.clear();
+		s_lightColour.clear();
+
+		write(magic);
+		write(version);
+		write(static_cast<uint32_t>(sizeof(Renderer3DVertex)));
+		write(static_cast<uint32_t>(sizeof(Meshlet)));
+		flushBuffer();
+
+		s_framesLeft = frames;
+		s_state = CaptureState::Armed;
+		return true;
+	}
+
+	void RenderCapture::stop()
+	{
+		if (s_state != CaptureState::Idle) finish();
+	}
+
+	bool RenderCapture::isCapturing()
+	{
+		return s_state != CaptureState::Idle;
+	}
+
+	const RenderCaptureStats& RenderCapture::getStats()
+	{
+		return s_stats;
+	}
+
+	void RenderCapture::endFrame()
+	{
+		if (s_state == CaptureState::Armed)
+		{
+			s_state = CaptureState::Recording;
+			return;
+		}
+		if (s_state != CaptureState::Recording) return;
+
+		writeOp(Op::FrameEnd);
+		flushBuffer();
+		s_stats.frames++;
+		if (--s_framesLeft == 0) finish();
+	}
+
+	void RenderCapture::recordBegin3D(const SceneWideUniforms& sceneWideUniforms)
+	{
+		if (s_state != CaptureState::Recording) return;
+
+		writeLights();
+		writeOp(Op::Begin3D);
+		write(glm::make_mat4(static_cast<float*>(sceneWideUniforms.at("u_projection").second)));
+		write(glm::make_mat4(static_cast<float*>(sceneWideUniforms.at("u_view").second)));
+		write(glm::make_vec3(static_cast<float*>(sceneWideUniforms.at("u_viewPos").second)));
+		s_stats.calls++;
+	}
+
+	void RenderCapture::recordSubmit3D(const Geometry& geometry, const std::shared_ptr<Material>& material, const glm::mat4& model)
+	{
+		if (s_state != CaptureState::Recording) return;
+
+		writeGeometry(geometry);
+		uint32_t materialHandle = writeMaterial(material);
+
+		writeOp(Op::Submit3D);
+		write(geometry.id);
+		write(materialHandle);
+		write(AffineInstance::encode(model));
+		s_stats.calls++;
+	}
+
+	void RenderCapture::recordEnd3D(const bool* enabledEffects)
+	{
+		if (s_state != CaptureState::Recording) return;
+
+		uint16_t effects = 0;
+		if (enabledEffects)
+			for (uint32_t i = 0; i < 16; i++)
+				if (enabledEffects[i]) effects |= 1 << i;
+
+		writeOp(Op::End3D);
+		write(static_cast<uint8_t>(enabledEffects != nullptr));
+		write(effects);
+		s_stats.calls++;
+	}
+
+	void RenderCapture::recordRemoveGeometry(const Geometry& geometry)
+	{
+		s_geometries.erase(geometry.id);
+	}
+
+	void RenderCapture::recordBegin2D(const SceneWideUniforms& sceneWideUniforms)
+	{
+		if (s_state != CaptureState::Recording) return;
+
+		writeOp(Op::Begin2D);
+		write(glm::make_mat4(static_cast<float*>(sceneWideUniforms.at("u_projection").second)));
+		write(glm::make_mat4(static_cast<float*>(sceneWideUniforms.at("u_view").second)));
+		s_stats.calls++;
+	}
+
+	void RenderCapture::recordSubmit2D(const glm::vec3& translate, const glm::vec3& scale, const SubTexture& texture, const glm::vec4& tint)
+	{
+		if (s_state != CaptureState::Recording) return;
+
+		writeTexture(texture.getBaseTexture());
+
+		writeOp(Op::Submit2D);
+		write(translate);
+		write(scale);
+		write(texture.getBaseTexture()->getID());
+		write(texture.getUVStart());
+		write(texture.getUVEnd());
+		write(tint);
+		s_stats.calls++;
+	}
+
+	void RenderCapture::recordEnd2D()
+	{
+		if (s_state != CaptureState::Recording) return;
+
+		writeOp(Op::End2D);
+		s_stats.calls++;
+	}
+
+	bool RenderReplay::load(const std::string& filepath, const std::string& shaderFilepath)
+	{
+		std::ifstream file(filepath, std::ios::binary);
+		if (!file.is_open())
+		{
+			Log::error("Cannot open render capture {0}", filepath);
+			return false;
+		}
+		std::vector<uint8_t> stream((std::istreambuf_iterator<char>(file)), std::istreambuf_iterator<char>());
+
+		size_t offset = 0;
+		uint32_t fileMagic = 0, fileVersion = 0, vertexSize = 0, meshletSize = 0;
+		if (!read(stream, offset, fileMagic) || !read(stream, offset, fileVersion) || !read(stream, offset, vertexSize) || !read(stream, offset, meshletSize)
+			|| fileMagic != RenderCapture::magic || fileVersion != RenderCapture::version || vertexSize != sizeof(Renderer3DVertex) || meshletSize != sizeof(Meshlet))
+		{
+			Log::error("{0} is not a render capture of this version", filepath);
+			return false;
+		}
+
+		m_shaderFilepath = shaderFilepath;
+		m_uniforms["u_projection"] = std::pair<ShaderDataType, void*>(ShaderDataType::Mat4, static_cast<void*>(glm::value_ptr(m_projection)));
+		m_uniforms["u_view"] = std::pair<ShaderDataType, void*>(ShaderDataType::Mat4, static_cast<void*>(glm::value_ptr(m_view)));
+		m_uniforms["u_viewPos"] = std::pair<ShaderDataType, void*>(ShaderDataType::Float3, static_cast<void*>(glm::value_ptr(m_viewPos)));
+
+		// Definitions create their resource here, calls are decoded into argument lists so replaying does no parsing
+		bool valid = true;
+		uint32_t frameStart = 0;
+		while (valid && offset < stream.size())
+		{
+			uint8_t op = 0;
+			read(stream, offset, op);
+
+			switch (static_cast<RenderCapture::Op>(op))
+			{
+			case RenderCapture::Op::Geometry:
+			{
+				uint32_t handle = 0, vertexCount = 0, indexCount = 0, meshletCount = 0;
+				std::vector<Renderer3DVertex> vertices;
+				std::vector<uint32_t> indices;
+				std::vector<Meshlet> meshlets;
+				valid = read(stream, offset, handle) && read(stream, offset, vertexCount) && read(stream, offset, indexCount) && read(stream, offset, meshletCount)
+					&& readArray(stream, offset, vertices, vertexCount) && readArray(stream, offset, indices, indexCount) && readArray(stream, offset, meshlets, meshletCount);
+				if (!valid) break;
+
+				Geometry geometry;
+				if (!Renderer3D::addGeometry(vertices, indices, geometry, meshlets))
+				{
+					Log::error("Captured mesh {0} does not fit the renderer's arena", handle);
+					return false;
+				}
+				m_geometries[handle] = geometry;
+				m_stats.geometries++;
+				break;
+			}
+			case RenderCapture::Op::Texture:
+			{
+				uint32_t handle = 0, width = 0, height = 0, channels = 0;
+				valid = read(stream, offset, handle) && read(stream, offset, width) && read(stream, offset, height) && read(stream, offset, channels);
+				if (!valid) break;
+
+				m_textures[handle].reset(Texture::create(width, height, channels, nullptr));
+				m_stats.textures++;
+				break;
+			}
+			case RenderCapture::Op::Material:
+			{
+				uint32_t handle = 0, flags = 0, shader = 0, textureCount = 0;
+				glm::vec4 tint;
+				std::vector<uint32_t> textureHandles;
+				valid = read(stream, offset, handle) && read(stream, offset, flags) && read(stream, offset, tint) && read(stream, offset, shader)
+					&& read(stream, offset, textureCount) && readArray(stream, offset, textureHandles, textureCount);
+				if (!valid) break;
+
+				std::vector<std::shared_ptr<Texture>> textures;
+				for (uint32_t texture : textureHandles) textures.push_back(m_textures[texture]);
+
+				// The constructor setting the same flags the captured material had
+				bool batched = flags & Material::flag_batched;
+				bool textured = flags & Material::flag_texture;
+				bool tinted = flags & Material::flag_tint;
+				if (textured && tinted) m_materials[handle] = std::make_shared<Material>(getShader(shader), textures, tint, batched);
+				else if (textured) m_materials[handle] = std::make_shared<Material>(getShader(shader), textures, batched);
+				else if (tinted) m_materials[handle] = std::make_shared<Material>(getShader(shader), tint, batched);
+				else m_materials[handle] = std::make_shared<Material>(getShader(shader), batched);
+				m_stats.materials++;
+				break;
+			}
+			case RenderCapture::Op::Lights:
+			{
+				Lights lights;
+				uint32_t count = 0;
+				valid = read(stream, offset, count) && readArray(stream, offset, lights.positions, count)
+					&& read(stream, offset, count) && readArray(stream, offset, lights.colours, count);
+				if (!valid) break;
+
+				m_calls.push_back({ RenderCapture::Op::Lights, static_cast<uint32_t>(m_lights.size()) });
+				m_lights.push_back(std::move(lights));
+				break;
+			}
+			case RenderCapture::Op::Begin3D:
+			{
+				Camera3D camera;
+				valid = read(stream, offset, camera.projection) && read(stream, offset, camera.view) && read(stream, offset, camera.viewPos);
+				if (!valid) break;
+
+				m_calls.push_back({ RenderCapture::Op::Begin3D, static_cast<uint32_t>(m_cameras3D.size()) });
+				m_cameras3D.push_back(camera);
+				break;
+			}
+			case RenderCapture::Op::Submit3D:
+			{
+				uint32_t geometry = 0, material = 0;
+				AffineInstance rows;
+				valid = read(stream, offset, geometry) && read(stream, offset, material) && read(stream, offset, rows)
+					&& m_geometries.count(geometry) && m_materials.count(material);
+				if (!valid) break;
+
+				m_calls.push_back({ RenderCapture::Op::Submit3D, static_cast<uint32_t>(m_submits3D.size()) });
+				m_submits3D.push_back({ m_geometries[geometry], m_materials[material], rows.decode() });
+				break;
+			}
+			case RenderCapture::Op::End3D:
+			{
+				uint8_t hasEffects = 0;
+				uint16_t effects = 0;
+				valid = read(stream, offset, hasEffects) && read(stream, offset, effects);
+				if (!valid) break;
+
+				uint32_t index = 0xFFFFFFFF;
+				if (hasEffects)
+				{
+					index = static_cast<uint32_t>(m_effects.size());
+					m_effects.emplace_back();
+					for (uint32_t i = 0; i < 16; i++) m_effects.back()[i] = effects & (1 << i);
+				}
+				m_calls.push_back({ RenderCapture::Op::End3D, index });
+				break;
+			}
+			case RenderCapture::Op::Begin2D:
+			{
+				Camera2D camera;
+				valid = read(stream, offset, camera.projection) && read(stream, offset, camera.view);
+				if (!valid) break;
+
+				m_calls.push_back({ RenderCapture::Op::Begin2D, static_cast<uint32_t>(m_cameras2D.size()) });
+				m_cameras2D.push_back(camera);
+				break;
+			}
+			case RenderCapture::Op::Submit2D:
+			{
+				glm::vec3 translate, scale;
+				uint32_t texture = 0;
+				glm::vec2 uvStart, uvEnd;
+				glm::vec4 tint;
+				valid = read(stream, offset, translate) && read(stream, offset, scale) && read(stream, offset, texture)
+					&& read(stream, offset, uvStart) && read(stream, offset, uvEnd) && read(stream, offset, tint) && m_textures.count(texture);
+				if (!valid) break;
+
+				Submit2D submit;
+				submit.quad.setTranslate(translate);
+				submit.quad.setScale(scale);
+				submit.texture = SubTexture(m_textures[texture], uvStart, uvEnd);
+				submit.tint = tint;
+				m_calls.push_back({ RenderCapture::Op::Submit2D, static_cast<uint32_t>(m_submits2D.size()) });
+				m_submits2D.push_back(submit);
+				break;
+			}
+			case RenderCapture::Op::End2D:
+				m_calls.push_back({ RenderCapture::Op::End2D, 0 });
+				break;
+			case RenderCapture::Op::FrameEnd:
+				m_frames.push_back(static_cast<uint32_t>(m_calls.size()));
+				frameStart = static_cast<uint32_t>(m_calls.size());
+				break;
+			default:
+				valid = false;
+				break;
+			}
+		}
+
+		// A truncated or unknown record ends the capture, the frame it was in is dropped
+		if (!valid) Log::warn("Render capture {0} is damaged after {1} frames", filepath, m_frames.size());
+		m_calls.resize(frameStart);
+
+		m_stats.frames = static_cast<uint32_t>(m_frames.size());
+		m_stats.calls = static_cast<uint32_t>(m_calls.size());
+		m_stats.bytes = stream.size();
+		return !m_frames.empty();
+	}
+
+	void RenderReplay::replayFrame(uint32_t frame)
+	{
+		if (frame >= m_frames.size()) return;
+
+		uint32_t first = frame == 0 ? 0 : m_frames[frame - 1];
+		for (uint32_t i = first; i < m_frames[frame]; i++)
+		{
+			const Call& call = m_calls[i];
+			switch (call.op)
+			{
+			case RenderCapture::Op::Lights:
+				RendererCommon::lightPos = m_lights[call.index].positions;
+				RendererCommon::lightColour = m_lights[call.index].colours;
+				break;
+			case RenderCapture::Op::Begin3D:
+				m_projection = m_cameras3D[call.index].projection;
+				m_view = m_cameras3D[call.index].view;
+				m_viewPos = m_cameras3D[call.index].viewPos;
+				Renderer3D::begin(m_uniforms);
+				break;
+			case RenderCapture::Op::Submit3D:
+			{
+				auto& submit = m_submits3D[call.index];
+				Renderer3D::submit(submit.geometry, submit.material, submit.model);
+				break;
+			}
+			case RenderCapture::Op::End3D:
+				if (call.index == 0xFFFFFFFF) Renderer3D::end();
+				else Renderer3D::end(m_effects[call.index].data());
+				break;
+			case RenderCapture::Op::Begin2D:
+				m_projection = m_cameras2D[call.index].projection;
+				m_view = m_cameras2D[call.index].view;
+				Renderer2D::begin(m_uniforms);
+				break;
+			case RenderCapture::Op::Submit2D:
+			{
+				auto& submit = m_submits2D[call.index];
+				Renderer2D::submit(submit.quad, submit.texture, submit.tint);
+				break;
+			}
+			case RenderCapture::Op::End2D:
+				Renderer2D::end();
+				break;
+			default:
+				break;
+			}
+		}
+	}
+
+	std::shared_ptr<Shader> RenderReplay::getShader(uint32_t handle)
+	{
+		auto& shader = m_shaders[handle];
+		if (!shader)
+		{
+			shader.reset(Shader::create(m_shaderFilepath.c_str()));
+			Renderer3D::initShader(shader);
+		}
+		return shader;
+	}
+}
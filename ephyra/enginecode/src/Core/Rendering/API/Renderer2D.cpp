@@ -3,6 +3,8 @@
 #include "Ephyra_pch.h"
 
 #include "Core/Rendering/Renderer/Renderer2D.h"
+#include "Core/Rendering/API/Global/RenderStats.h"
+#include "Core/Rendering/Renderer/RenderCapture.h"
 
 #include <glm/gtc/matrix_transform.hpp>
 #include <numeric>
@@ -95,13 +97,8 @@ namespace Engine
 			Log::error("Error: FreeType Can't Set Font Size: {0}", s_data->charSize);
 
 		// Fill The Texture Atlas
-		s_data->glyphData.resize(s_data->lastGlyph - s_data->firstGlyph + 1);
-
-		std::sort(s_data->glyphData.begin(), s_data->glyphData.end(),
-			[](GlyphData& a, GlyphData& b)
-			{
-				return (a.size.x * a.size.y) > (b.size.x * b.size.y);
-			});
+		s_data->glyphMetrics.resize(s_data->lastGlyph - s_data->firstGlyph + 1);
+		s_data->glyphTextures.resize(s_data->glyphMetrics.size());
 
 		for (unsigned char ch = s_data->firstGlyph; ch <= s_data->lastGlyph; ch++)
 		{
@@ -110,7 +107,7 @@ namespace Engine
 			if (FT_Load_Char(s_data->fontFace, ch, FT_LOAD_RENDER)) Log::error("Error: Could Not Load Glyph For Char: {0}", ch);
 			else
 			{
-				GlyphData& gd = s_data->glyphData.at(ch - s_data->firstGlyph);
+				GlyphMetrics& gd = s_data->glyphMetrics.at(ch - s_data->firstGlyph);
 				// Get Glyph Data
 				gd.size = glm::vec2(s_data->fontFace->glyph->bitmap.width, s_data->fontFace->glyph->bitmap.rows);
 				gd.bearing = glm::vec2(s_data->fontFace->glyph->bitmap_left, -s_data->fontFace->glyph->bitmap_top);
@@ -125,7 +122,7 @@ namespace Engine
 
 				// Sort Glyph Texture
 				R2RGBA(glyphBuffer, s_data->fontFace->glyph->bitmap.buffer, gd.size.x, gd.size.y);
-				s_data->glyphAtlas.add(gd.size.x, gd.size.y, 4, glyphBuffer, gd.subTexture);
+				s_data->glyphAtlas.add(gd.size.x, gd.size.y, 4, glyphBuffer, s_data->glyphTextures.at(ch - s_data->firstGlyph));
 
 				free(glyphBuffer);
 			}
@@ -134,6 +131,7 @@ namespace Engine
 
 	void Renderer2D::begin(const SceneWideUniforms& swu)
 	{
+		RenderCapture::recordBegin2D(swu);
 		s_data->drawCount = 0;
 
 		// Bind the Shader
@@ -159,10 +157,12 @@ namespace Engine
 
 	void Renderer2D::submit(const Quad& quad, const SubTexture& texture, const glm::vec4& tint)
 	{
+		RenderCapture::recordSubmit2D(quad.m_translate, quad.m_scale, texture, tint);
 		if (s_data->drawCount + 4 > s_data->batchSize) flush();
 
 		uint32_t texUnit;
 		if (RendererCommon::m_textUM->isFull()) {
+			RenderStats::forcedFlush();
 			flush();
 			RendererCommon::m_textUM->clear();
 		}
@@ -215,38 +215,58 @@ namespace Engine
 
 		if (ch >= s_data->firstGlyph && ch <= s_data->lastGlyph)
 		{
-			GlyphData& gd = s_data->glyphData.at(ch - s_data->firstGlyph);
+			uint32_t glyph = ch - s_data->firstGlyph;
+			advance = s_data->glyphMetrics[glyph].advance * charScale;
+			submit(layoutGlyph(s_data->glyphMetrics[glyph], position, charScale), s_data->glyphTextures[glyph], tint);
+		}
+	}
 
-			advance = gd.advance * (charScale);
-			// Calculate the Quad for Glyph
-			glm::vec2 glyphHalfExtents((gd.size * glm::vec2((charScale), (charScale)) * 0.5f));
-			glm::vec2 glyphCentre = (position + gd.bearing * glm::vec2((charScale), (charScale)) + glyphHalfExtents);
-			Quad quad = Quad::createCentreHalfExtents(glyphCentre, glyphHalfExtents);
+	void Renderer2D::submit(const char* str, const glm::vec2& position, const glm::vec4& tint, uint32_t charSize)
+	{
+		layoutText(s_data->glyphMetrics, s_data->firstGlyph, str, position, (float)charSize / s_data->charSize, s_data->textQuads);
 
-			submit(quad, gd.subTexture, tint);
+		for (auto& glyphQuad : s_data->textQuads)
+			submit(glyphQuad.quad, s_data->glyphTextures[glyphQuad.glyph], tint);
+	}
 
-		}
+	Quad Renderer2D::layoutGlyph(const GlyphMetrics& glyph, const glm::vec2& position, float charScale)
+	{
+		// Calculate the Quad for Glyph
+		glm::vec2 glyphHalfExtents((glyph.size * glm::vec2(charScale, charScale) * 0.5f));
+		glm::vec2 glyphCentre = (position + glyph.bearing * glm::vec2(charScale, charScale) + glyphHalfExtents);
+		return Quad::createCentreHalfExtents(glyphCentre, glyphHalfExtents);
 	}
 
-	void Renderer2D::submit(const char* str, const glm::vec2& position, const glm::vec4& tint, uint32_t charSize)
+	void Renderer2D::layoutText(const std::vector<GlyphMetrics>& glyphs, unsigned char firstGlyph, const char* str, const glm::vec2& position, float charScale, std::vector<GlyphQuad>& quads)
 	{
-		uint32_t len = strlen(str);
-		float l_Advance = 0.f, x = position.x;
+		quads.clear();
+		if (glyphs.empty()) return;
 
-		for (int32_t i = 0; i < len; i++)
+		unsigned char lastGlyph = static_cast<unsigned char>(firstGlyph + glyphs.size() - 1);
+		float advance = 0.f, x = position.x;
+
+		// A character without a glyph moves the pen by the previous advance
+		for (const char* ch = str; *ch; ch++)
 		{
-			submit(str[i], { x, position.y }, l_Advance, tint, charSize);
-			x += l_Advance;
+			if (*ch >= firstGlyph && *ch <= lastGlyph)
+			{
+				uint32_t glyph = *ch - firstGlyph;
+				advance = glyphs[glyph].advance * charScale;
+				quads.push_back({ layoutGlyph(glyphs[glyph], { x, position.y }, charScale), glyph });
+			}
+			x += advance;
 		}
 	}
 
 	void Renderer2D::end()
 	{
+		RenderCapture::recordEnd2D();
 		if (s_data->drawCount > 0) flush();
 	}
 
 	void Renderer2D::flush()
 	{
+		RenderStats::batchFlush();
 		s_data->VAO->getVertexBuffer().at(0)->edit(s_data->vertices.data(), sizeof(Renderer2DVertex) * s_data->vertices.size(), 0);
 
 		s_data->VAO->bindIndexBuffer();
@@ -3,15 +3,25 @@
 #include "Ephyra_pch.h"
 
 #include "Core/Initialization/GlobalProperties.h"
+#include "Core/Rendering/API/Global/RenderStats.h"
+#include "Core/Rendering/Renderer/GPUTimer.h"
+#include "Core/Rendering/Renderer/RenderCapture.h"
 #include "Core/Rendering/Renderer/Renderer3D.h"
 #include "Core/Resources/Utility/GlobalAssimpData.h"
+#include "Core/Systems/Utility/Profiler.h"
 
 #include <Glad/glad.h>
 #include <glm/gtc/matrix_transform.hpp>
+#include <glm/gtc/quaternion.hpp>
 #include <glm/gtc/type_ptr.hpp>
 #include <numeric>
 #include <algorithm>
+#include <cstring>
 
+// Core in 4.6, ARB_pipeline_statistics_query before it
+#ifndef GL_FRAGMENT_SHADER_INVOCATIONS
+#define GL_FRAGMENT_SHADER_INVOCATIONS 0x82F4
+#endif
 
 namespace Engine
 {
@@ -19,6 +29,43 @@ namespace Engine
 
 	std::shared_ptr<Renderer3D::InternalData> Renderer3D::s_data = nullptr;
 
+	AffineInstance AffineInstance::encode(const glm::mat4& model)
+	{
+		AffineInstance instance;
+		for (int row = 0; row < 3; row++)
+			instance.rows[row] = glm::vec4(model[0][row], model[1][row], model[2][row], model[3][row]);
+		return instance;
+	}
+
+	glm::mat4 AffineInstance::decode() const
+	{
+		return glm::transpose(glm::mat4(rows[0], rows[1], rows[2], glm::vec4(0.f, 0.f, 0.f, 1.f)));
+	}
+
+	bool RigidInstance::encode(const glm::mat4& model, RigidInstance& instance)
+	{
+		glm::vec3 x = glm::vec3(model[0]);
+		glm::vec3 y = glm::vec3(model[1]);
+		glm::vec3 z = glm::vec3(model[2]);
+
+		float scale = glm::length(x);
+		if (scale <= 0.f) return false;
+
+		// Relative tolerances so large props are judged the same as small ones
+		const float tolerance = 1e-3f;
+		if (std::abs(glm::length(y) - scale) > tolerance * scale || std::abs(glm::length(z) - scale) > tolerance * scale) return false;
+
+		x /= scale; y /= scale; z /= scale;
+		if (std::abs(glm::dot(x, y)) > tolerance || std::abs(glm::dot(x, z)) > tolerance || std::abs(glm::dot(y, z)) > tolerance) return false;
+		if (glm::dot(glm::cross(x, y), z) < 0.f) return false;
+
+		glm::quat rotation = glm::normalize(glm::quat_cast(glm::mat3(x, y, z)));
+		instance.rotation = glm::vec4(rotation.x, rotation.y, rotation.z, rotation.w);
+		instance.position = glm::vec3(model[3]);
+		instance.scale = scale;
+		return true;
+	}
+
 	void Renderer3D::init(uint32_t vertexCapacity, uint32_t indexCapacity, uint32_t batchSize)
 	{
 
@@ -76,7 +123,8 @@ namespace Engine
 		s_data->indexCapacity = indexCapacity;
 
 		s_data->batchQueue.reserve(batchSize);
-		s_data->modelInstanceData.reserve(batchSize);
+		s_data->affineInstanceData.reserve(batchSize);
+		s_data->rigidInstanceData.reserve(batchSize);
 		s_data->tintInstanceData.reserve(batchSize);
 		s_data->batchCommands.reserve(batchSize);
 
@@ -91,9 +139,10 @@ namespace Engine
 		s_data->VAO->addVertexBuffer(VBO_Verts);
 		s_data->VAO->setIndexBuffer(IBO);
 
-		vertexBufferLayout modelLayout = { {ShaderDataType::Mat4, 1, false} };
+		// Instance transforms take three attribute slots in either encoding, the shader decodes them by InstanceEncoding
+		vertexBufferLayout modelLayout = { {ShaderDataType::Float4, 1, false}, {ShaderDataType::Float4, 1, false}, {ShaderDataType::Float4, 1, false} };
 		std::shared_ptr<VertexBuffer> VBO_Models;
-		VBO_Models.reset(VertexBuffer::create(nullptr, batchSize * sizeof(glm::mat4), modelLayout));
+		VBO_Models.reset(VertexBuffer::create(nullptr, batchSize * sizeof(AffineInstance), modelLayout));
 		s_data->VAO->addVertexBuffer(VBO_Models);
 
 		vertexBufferLayout tintLayout = { {ShaderDataType::Byte4, 1, true} };
@@ -126,7 +175,99 @@ namespace Engine
 		VBO_Normal.reset(VertexBuffer::create(nullptr, batchSize * sizeof(uint32_t), normalLayout));
 		s_data->VAO->addVertexBuffer(VBO_Normal);
 
+		// Same streams as the main VAO except the transforms, used when every instance in a batch is rigid
+		vertexBufferLayout rigidLayout = { {ShaderDataType::Float4, 1, false}, {ShaderDataType::Float3, 1, false}, {ShaderDataType::Float, 1, false} };
+		std::shared_ptr<VertexBuffer> VBO_Rigid;
+		VBO_Rigid.reset(VertexBuffer::create(nullptr, batchSize * sizeof(RigidInstance), rigidLayout));
+
+		s_data->rigidVAO.reset(VertexArray::create());
+		s_data->rigidVAO->addVertexBuffer(VBO_Verts);
+		s_data->rigidVAO->addVertexBuffer(VBO_Rigid);
+		s_data->rigidVAO->addVertexBuffer(VBO_Tints);
+		s_data->rigidVAO->addVertexBuffer(VBO_Albedo);
+		s_data->rigidVAO->addVertexBuffer(VBO_Metallic);
+		s_data->rigidVAO->addVertexBuffer(VBO_Roughness);
+		s_data->rigidVAO->addVertexBuffer(VBO_Ao);
+		s_data->rigidVAO->addVertexBuffer(VBO_Normal);
+		s_data->rigidVAO->setIndexBuffer(IBO);
+
 		s_data->commands.reset(IndirectBuffer::create(nullptr, batchSize));
+		s_data->clusterCommands.reset(IndirectBuffer::create(nullptr, batchSize));
+		s_data->clusterCommandData.reserve(batchSize);
+
+		// Crowds share the vertex arena, their instances are written once and stay resident
+		s_data->crowdCapacity = batchSize;
+		s_data->crowdVAO.reset(VertexArray::create());
+		s_data->crowdVAO->addVertexBuffer(VBO_Verts);
+		s_data->crowdVAO->setIndexBuffer(IBO);
+
+		std::shared_ptr<VertexBuffer> VBO_CrowdModels;
+		VBO_CrowdModels.reset(VertexBuffer::create(nullptr, batchSize * sizeof(AffineInstance), modelLayout));
+		s_data->crowdVAO->addVertexBuffer(VBO_CrowdModels);
+
+		vertexBufferLayout playbackLayout = { {ShaderDataType::Float4, 1, false} };
+		std::shared_ptr<VertexBuffer> VBO_CrowdPlayback;
+		VBO_CrowdPlayback.reset(VertexBuffer::create(nullptr, batchSize * sizeof(glm::vec4), playbackLayout));
+		s_data->crowdVAO->addVertexBuffer(VBO_CrowdPlayback);
+
+		// Retained slots keep their transform and tint resident, frames only upload what changed
+		s_data->retainedCapacity = batchSize;
+		s_data->retainedVAO.reset(VertexArray::create());
+		s_data->retainedVAO->addVertexBuffer(VBO_Verts);
+		s_data->retainedVAO->setIndexBuffer(IBO);
+
+		std::shared_ptr<VertexBuffer> VBO_RetainedModels;
+		VBO_RetainedModels.reset(VertexBuffer::create(nullptr, batchSize * sizeof(AffineInstance), modelLayout));
+		s_data->retainedVAO->addVertexBuffer(VBO_RetainedModels);
+
+		std::shared_ptr<VertexBuffer> VBO_RetainedTints;
+		VBO_RetainedTints.reset(VertexBuffer::create(nullptr, batchSize * sizeof(BYTE) * 4, tintLayout));
+		s_data->retainedVAO->addVertexBuffer(VBO_RetainedTints);
+
+		s_data->retainedCommands.reset(IndirectBuffer::create(nullptr, batchSize));
+
+		s_data->skinningShader.reset(Shader::create("./assets/shaders/skinning.glsl"));
+
+		// Depth prepass reads a tightly packed copy of the positions so it fetches 12 bytes per vertex instead of 64
+		vertexBufferLayout positionLayout = vertexBufferLayout({ ShaderDataType::Float3 });
+		std::shared_ptr<VertexBuffer> VBO_Positions;
+		VBO_Positions.reset(VertexBuffer::create(nullptr, sizeof(glm::vec3) * vertexCapacity, positionLayout));
+
+		std::shared_ptr<VertexBuffer> VBO_DepthModels;
+		VBO_DepthModels.reset(VertexBuffer::create(nullptr, batchSize * sizeof(AffineInstance), modelLayout));
+
+		s_data->depthVAO.reset(VertexArray::create());
+		s_data->depthVAO->addVertexBuffer(VBO_Positions);
+		s_data->depthVAO->addVertexBuffer(VBO_DepthModels);
+		s_data->depthVAO->setIndexBuffer(IBO);
+
+		s_data->depthCommands.reset(IndirectBuffer::create(nullptr, batchSize));
+		s_data->depthCommandData.reserve(batchSize);
+		s_data->depthInstanceData.reserve(batchSize);
+
+		s_data->hiZShader.reset(Shader::create("./assets/shaders/hiZ.glsl"));
+		s_data->hiZCullShader.reset(Shader::create("./assets/shaders/hiZCull.glsl"));
+
+		s_data->hiZTexture.reset(Texture::create(SCR_WIDTH, SCR_HEIGHT, 1, nullptr));
+		glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_MIN_FILTER, GL_NEAREST_MIPMAP_NEAREST);
+		glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_MAG_FILTER, GL_NEAREST);
+		s_data->hiZLevels = 1;
+		for (uint32_t size = std::max(SCR_WIDTH, SCR_HEIGHT); size > 1; size /= 2) s_data->hiZLevels++;
+
+		GLint major = 0, minor = 0, extensionCount = 0;
+		glGetIntegerv(GL_MAJOR_VERSION, &major);
+		glGetIntegerv(GL_MINOR_VERSION, &minor);
+		s_data->pipelineStatistics = major > 4 || (major == 4 && minor >= 6);
+		glGetIntegerv(GL_NUM_EXTENSIONS, &extensionCount);
+		for (GLint i = 0; i < extensionCount && !s_data->pipelineStatistics; i++)
+			s_data->pipelineStatistics = std::strcmp(reinterpret_cast<const char*>(glGetStringi(GL_EXTENSIONS, i)), "GL_ARB_pipeline_statistics_query") == 0;
+
+		if (s_data->pipelineStatistics)
+			glGenQueries(2, s_data->invocationQueries);
+		else
+			Log::warn("Pipeline statistics queries unsupported, fragment invocations will not be measured");
+
+		GPUTimer::init();
 
 		s_data->cameraUBO.reset(UniformBuffer::create(uniformBufferLayout({
 			{"u_projection", ShaderDataType::Mat4},
@@ -137,6 +278,9 @@ namespace Engine
 			{"u_viewPos", ShaderDataType::Float3},
 			})));
 
+		s_data->depthShader.reset(Shader::create("./assets/shaders/depthPrepass.glsl"));
+		s_data->cameraUBO->attachShaderBlock(s_data->depthShader, "b_camera");
+
 		Renderer2D::init();
 
 		RendererCommon::postProcessor = PostProcessing::create();
@@ -145,6 +289,10 @@ namespace Engine
 
 	void Renderer3D::begin(const SceneWideUniforms& sceneWideUniforms)
 	{
+		RenderCapture::recordBegin3D(sceneWideUniforms);
+
+		s_data->frame++;
+		if (!s_data->removedGeometry.empty() || !s_data->removedCrowds.empty()) reclaimGeometry();
 
 		RendererCommon::colorFBO->bind();
 		
@@ -156,93 +304,141 @@ namespace Engine
 
 		s_data->lightsUBO->bindUniformBuffer();
 		s_data->lightsUBO->uploadData("u_viewPos", sceneWideUniforms.at("u_viewPos").second);
+
+		s_data->viewProjection = glm::make_mat4(static_cast<float*>(sceneWideUniforms.at("u_projection").second)) * glm::make_mat4(static_cast<float*>(sceneWideUniforms.at("u_view").second));
+		s_data->viewPosition = glm::make_vec3(static_cast<float*>(sceneWideUniforms.at("u_viewPos").second));
+		s_data->meshletStats.reset();
+		s_data->retainedStats.reset();
+
+		GPUTimer::beginFrame();
+		GPUTimer::begin("Geometry");
+		beginMainPass();
 	}
 
 	void Renderer3D::submit(const Geometry& geometry, const std::shared_ptr<Material>& material, const glm::mat4& model)
 	{
+		RenderCapture::recordSubmit3D(geometry, material, model);
 
 		if (material->isFlagSet(Material::flag_batched))
 		{
-			if (s_data->batchQueue.size() == s_data->batchCapacity) flushBatch();
+			if (s_data->batchQueue.size() == s_data->batchCapacity)
+			{
+				if (s_data->depthPrepass) flush();
+				else flushBatch();
+			}
 
 			s_data->batchQueue.push_back({ geometry, material, model});
 		}
+		else if (s_data->depthPrepass && !geometry.hasBones)
+		{
+			// Held back so the depth pass covers it before it is shaded
+			s_data->immediateQueue.push_back({ geometry, material, model });
+			if (s_data->immediateQueue.size() == s_data->batchCapacity) flush();
+		}
 		else
 		{
-			// Bind Shader
-			auto& shader = material->getShader();
+			drawImmediate(geometry, material, model);
+		}
 
-			shader->useShader(s_data->VAO->getRenderID());
+	}
 
-			RendererCommon::colorFBO->bind();
+	void Renderer3D::drawImmediate(const Geometry& geometry, const std::shared_ptr<Material>& material, const glm::mat4& model)
+	{
+		s_data->clusterCommandData.clear();
+		bool clustered = appendClusterCommands(geometry, model, 0, s_data->clusterCommandData);
+		if (clustered && s_data->clusterCommandData.empty()) return;
 
-			uint32_t texUnit[5];
+		// Bind Shader
+		auto& shader = material->getShader();
 
-			std::vector<std::shared_ptr<Texture>> textures = material->getTextures();
-			for (int i = 0; i < textures.size(); i++)
-			{
-				RendererCommon::m_textUM->getUnit(textures[i]->getID(), texUnit[i]);
-				textures[i]->load(texUnit[i]);
-			}
+		shader->useShader(s_data->VAO->getRenderID());
 
-			for (int i = 0; i < 100; i++)
-			{
-				std::string name = "boneMatrices[" + std::to_string(i) + "]";
-				shader->uploadMat4(name.c_str(), boneManager.getBoneMatrices()[i]);
-			}
+		RendererCommon::colorFBO->bind();
 
-			shader->uploadIntArray("u_texData", RendererCommon::textureUnits->data(), 32);
+		uint32_t texUnit[5];
 
-			if (!RendererCommon::lightPos.empty())
-				shader->uploadFloat3Array("u_lightPos", RendererCommon::lightPos.data(), 64);
-			else
-			{
-				std::vector<glm::vec3> temp;
-				for (int i = 0; i < 16; i++)
-					temp.push_back({ 0.f, 0.f, 0.f });
-				shader->uploadFloat3Array("u_lightPos", temp.data(), 4);
-			}
+		std::vector<std::shared_ptr<Texture>> textures = material->getTextures();
+		for (int i = 0; i < textures.size(); i++)
+		{
+			RendererCommon::m_textUM->getUnit(textures[i]->getID(), texUnit[i]);
+			textures[i]->load(texUnit[i]);
+		}
 
-			if (!RendererCommon::lightColour.empty())
-				shader->uploadFloat3Array("u_lightColour", RendererCommon::lightColour.data(), 64);
-			else
-			{
-				std::vector<glm::vec3> temp;
-				for (int i = 0; i < 16; i++)
-					temp.push_back({ 0.f, 0.f, 0.f });
-				shader->uploadFloat3Array("u_lightColour", temp.data(), 64);
-			}
+		shader->uploadMat4Array("boneMatrices", boneManager.getBoneMatrices(), 100);
 
-			shader->uploadInt("ImmediateMode", 1);
+		shader->uploadIntArray("u_texData", RendererCommon::textureUnits->data(), 32);
 
-			shader->uploadInt("AlbedoTex", texUnit[0]);
-			shader->uploadInt("RoughnessTex", texUnit[1]);
-			shader->uploadInt("MetallicTex", texUnit[2]);
-			shader->uploadInt("AOTex", texUnit[3]);
-			shader->uploadInt("NormalTex", texUnit[4]);
+		if (!RendererCommon::lightPos.empty())
+			shader->uploadFloat3Array("u_lightPos", RendererCommon::lightPos.data(), 64);
+		else
+		{
+			std::vector<glm::vec3> temp;
+			for (int i = 0; i < 16; i++)
+				temp.push_back({ 0.f, 0.f, 0.f });
+			shader->uploadFloat3Array("u_lightPos", temp.data(), 4);
+		}
+
+		if (!RendererCommon::lightColour.empty())
+			shader->uploadFloat3Array("u_lightColour", RendererCommon::lightColour.data(), 64);
+		else
+		{
+			std::vector<glm::vec3> temp;
+			for (int i = 0; i < 16; i++)
+				temp.push_back({ 0.f, 0.f, 0.f });
+			shader->uploadFloat3Array("u_lightColour", temp.data(), 64);
+		}
 
-			// Apply Material Uniforms (per draw uniforms)
-			shader->uploadMat4("ModelMat", model);
+		shader->uploadInt("ImmediateMode", 1);
 
-			shader->uploadFloat4("TintCol", material->getTint());
+		shader->uploadInt("AlbedoTex", texUnit[0]);
+		shader->uploadInt("RoughnessTex", texUnit[1]);
+		shader->uploadInt("MetallicTex", texUnit[2]);
+		shader->uploadInt("AOTex", texUnit[3]);
+		shader->uploadInt("NormalTex", texUnit[4]);
 
-			s_data->VAO->bindIndexBuffer();
+		// Apply Material Uniforms (per draw uniforms)
+		shader->uploadMat4("ModelMat", model);
 
-			// Submit the draw call
-			glDrawElementsBaseVertex(GL_TRIANGLES, geometry.indexCount, GL_UNSIGNED_INT, (void*)(sizeof(uint32_t) * geometry.firstIndex), geometry.firstVertex);
+		shader->uploadFloat4("TintCol", material->getTint());
+
+		s_data->VAO->bindIndexBuffer();
+
+		if (s_data->skinningPending)
+		{
+			glMemoryBarrier(GL_VERTEX_ATTRIB_ARRAY_BARRIER_BIT);
+			s_data->skinningPending = false;
 		}
 
+		// Submit the draw call
+		if (clustered)
+		{
+			s_data->clusterCommands->edit(s_data->clusterCommandData.data(), s_data->clusterCommandData.size(), 0);
+			glMultiDrawElementsIndirect(GL_TRIANGLES, GL_UNSIGNED_INT, (GLvoid*)0, s_data->clusterCommandData.size(), 0);
+			RenderStats::draw(s_data->clusterCommandData.size(), s_data->clusterCommandData.size());
+			s_data->clusterCommandData.clear();
+		}
+		else
+		{
+			glDrawElementsBaseVertex(GL_TRIANGLES, geometry.indexCount, GL_UNSIGNED_INT, (void*)(sizeof(uint32_t) * geometry.firstIndex), geometry.firstVertex);
+			RenderStats::draw();
+		}
 	}
 
 	void Renderer3D::flush()
 	{
+		EPHYRA_PROFILE_FUNCTION();
 		RendererCommon::colorFBO->bind();
-		if (s_data->batchQueue.size() > 0) flushBatch();
+		if (s_data->depthPrepass) flushDepthPrepass();
+		else if (s_data->batchQueue.size() > 0) flushBatch();
 	}
 
 	void Renderer3D::end()
 	{
+		RenderCapture::recordEnd3D(nullptr);
 		flush();
+		GPUTimer::end();
+		endMainPass();
+		GPUTimer::endFrame();
 
 		//RendererCommon::colorFBO->unbind();
 
@@ -251,23 +447,51 @@ namespace Engine
 
 	void Renderer3D::end(bool enabledEffects[16])
 	{
+		EPHYRA_PROFILE_FUNCTION();
+		RenderCapture::recordEnd3D(enabledEffects);
 		flush();
+		GPUTimer::end();
+		endMainPass();
 
 		RendererCommon::frameCount++;
 
 		uint32_t texID = RendererCommon::colorFBOTexture->getID();
 		if (enabledEffects[0])
+		{
+			EPHYRA_PROFILE_SCOPE("DOF");
+			GPUTimerScope gpuScope("DOF");
 			texID = RendererCommon::postProcessor->ApplyDOFEffect(RendererCommon::depthFBOTexture->getID(), texID);
+		}
 		if (enabledEffects[1])
+		{
+			EPHYRA_PROFILE_SCOPE("Volumetric");
+			GPUTimerScope gpuScope("Volumetric");
 			texID = RendererCommon::postProcessor->ApplyVolumetricEffect(RendererCommon::depthFBOTexture->getID(), texID);
+		}
 		if (enabledEffects[2])
+		{
+			EPHYRA_PROFILE_SCOPE("Bloom");
+			GPUTimerScope gpuScope("Bloom");
 			texID = RendererCommon::postProcessor->ApplyBloomEffect(texID);
+		}
 		if (enabledEffects[3])
+		{
+			EPHYRA_PROFILE_SCOPE("Tone Mapping");
+			GPUTimerScope gpuScope("Tone Mapping");
 			texID = RendererCommon::postProcessor->ApplyToneMappingEffect(texID);
+		}
 		if (enabledEffects[4])
+		{
+			EPHYRA_PROFILE_SCOPE("Vignette");
+			GPUTimerScope gpuScope("Vignette");
 			texID = RendererCommon::postProcessor->ApplyVignetteEffect(texID);
+		}
 
-		RendererCommon::postProcessor->updateColorFBO(texID, RendererCommon::colorFBOTexture->getID());
+		{
+			GPUTimerScope gpuScope("Resolve");
+			RendererCommon::postProcessor->updateColorFBO(texID, RendererCommon::colorFBOTexture->getID());
+		}
+		GPUTimer::endFrame();
 	}
 
 	void Renderer3D::initShader(std::shared_ptr<Shader> shader)
@@ -276,36 +500,548 @@ namespace Engine
 		s_data->lightsUBO->attachShaderBlock(shader, "b_lights");
 	}
 
-	bool Renderer3D::addGeometry(std::vector<Renderer3DVertex> vertices, std::vector<uint32_t> indices, Geometry& geo)
+	bool Renderer3D::addGeometry(std::vector<Renderer3DVertex> vertices, std::vector<uint32_t> indices, Geometry& geo, const std::vector<Meshlet>& meshlets)
 	{
 		uint32_t vertexCount = vertices.size();
 		uint32_t indexCount = indices.size();
 
-		if (vertexCount + s_data->nextVertex > s_data->vertexCapacity) return false;
-		if (indexCount + s_data->nextIndex > s_data->indexCapacity) return false;
+		uint32_t firstVertex, firstIndex, firstMeshlet;
+		if (!allocateRange(s_data->freeVertices, s_data->nextVertex, s_data->vertexCapacity, vertexCount, firstVertex)) return false;
+		if (!allocateRange(s_data->freeIndices, s_data->nextIndex, s_data->indexCapacity, indexCount, firstIndex))
+		{
+			releaseRange(s_data->freeVertices, s_data->nextVertex, firstVertex, vertexCount);
+			return false;
+		}
+
+		uint32_t meshletEnd = s_data->meshlets.size();
+		allocateRange(s_data->freeMeshlets, meshletEnd, UINT32_MAX, meshlets.size(), firstMeshlet);
+		s_data->meshlets.resize(meshletEnd);
+		std::copy(meshlets.begin(), meshlets.end(), s_data->meshlets.begin() + firstMeshlet);
 
 		auto VBO = s_data->VAO->getVertexBuffer().at(0);
+		auto VBO_Positions = s_data->depthVAO->getVertexBuffer().at(0);
 		auto IBO = s_data->VAO->getIndexBuffer();
 
-		VBO->edit(vertices.data(), vertexCount * sizeof(Renderer3DVertex), s_data->nextVertex * sizeof(Renderer3DVertex));
-		IBO->edit(indices.data(), indexCount, s_data->nextIndex);
+		std::vector<glm::vec3> positions;
+		positions.reserve(vertexCount);
+		bool hasBones = false;
+		for (auto& vertex : vertices)
+		{
+			positions.push_back(vertex.m_pos);
+			if (vertex.boneWeights != glm::vec4(0.f)) hasBones = true;
+		}
+
+		VBO->edit(vertices.data(), vertexCount * sizeof(Renderer3DVertex), firstVertex * sizeof(Renderer3DVertex));
+		VBO_Positions->edit(positions.data(), vertexCount * sizeof(glm::vec3), firstVertex * sizeof(glm::vec3));
+		IBO->edit(indices.data(), indexCount, firstIndex);
 
-		geo.id = s_data->batchCommands.size();
-		geo.firstVertex = s_data->nextVertex;
-		geo.firstIndex = s_data->nextIndex;
+		geo.id = allocateCommand();
+		geo.firstVertex = firstVertex;
+		geo.firstIndex = firstIndex;
 		geo.vertexCount = vertexCount;
 		geo.indexCount = indexCount;
+		geo.hasBones = hasBones;
+		geo.firstMeshlet = firstMeshlet;
+		geo.meshletCount = meshlets.size();
 
-		s_data->nextVertex += vertexCount;
-		s_data->nextIndex += indexCount;
+		return true;
+
+	}
+
+	void Renderer3D::removeGeometry(const Geometry& geometry)
+	{
+		RenderCapture::recordRemoveGeometry(geometry);
+		s_data->removedGeometry.push_back({ geometry, true, s_data->frame });
+	}
+
+	void Renderer3D::readGeometry(const Geometry& geometry, std::vector<Renderer3DVertex>& vertices, std::vector<uint32_t>& indices, std::vector<Meshlet>& meshlets)
+	{
+		vertices.resize(geometry.vertexCount);
+		indices.resize(geometry.indexCount);
+		meshlets.assign(s_data->meshlets.begin() + geometry.firstMeshlet, s_data->meshlets.begin() + geometry.firstMeshlet + geometry.meshletCount);
+
+		// Skinned copies are written by the compute pass
+		glMemoryBarrier(GL_BUFFER_UPDATE_BARRIER_BIT);
+
+		glBindBuffer(GL_COPY_READ_BUFFER, s_data->VAO->getVertexBuffer().at(0)->getRenderID());
+		glGetBufferSubData(GL_COPY_READ_BUFFER, geometry.firstVertex * sizeof(Renderer3DVertex), geometry.vertexCount * sizeof(Renderer3DVertex), vertices.data());
+		glBindBuffer(GL_COPY_READ_BUFFER, s_data->VAO->getIndexBuffer()->getRenderID());
+		glGetBufferSubData(GL_COPY_READ_BUFFER, geometry.firstIndex * sizeof(uint32_t), geometry.indexCount * sizeof(uint32_t), indices.data());
+		glBindBuffer(GL_COPY_READ_BUFFER, 0);
+	}
+
+	void Renderer3D::clearIndices(uint32_t firstIndex, uint32_t indexCount)
+	{
+		if (indexCount == 0 || firstIndex + indexCount > s_data->nextIndex) return;
+
+		std::vector<uint32_t> zeros(indexCount, 0);
+		s_data->VAO->getIndexBuffer()->edit(zeros.data(), indexCount, firstIndex);
+	}
+
+	bool Renderer3D::addSkinnedGeometry(const Geometry& source, Geometry& skinned)
+	{
+		uint32_t firstVertex;
+		if (!allocateRange(s_data->freeVertices, s_data->nextVertex, s_data->vertexCapacity, source.vertexCount, firstVertex)) return false;
+
+		// The copy shares the source index range, only the base vertex differs
+		skinned = source;
+		skinned.id = allocateCommand();
+		skinned.firstVertex = firstVertex;
+		skinned.hasBones = false;
+
+		return true;
+	}
+
+	void Renderer3D::removeSkinnedGeometry(const Geometry& skinned)
+	{
+		if (skinned.id < s_data->skinnedPoses.size()) s_data->skinnedPoses[skinned.id] = 0;
+		RenderCapture::recordRemoveGeometry(skinned);
+		s_data->removedGeometry.push_back({ skinned, false, s_data->frame });
+	}
+
+	bool Renderer3D::allocateRange(std::vector<ArenaRange>& freeRanges, uint32_t& end, uint32_t capacity, uint32_t count, uint32_t& first)
+	{
+		first = end;
+		if (count == 0) return true;
+
+		for (auto range = freeRanges.begin(); range != freeRanges.end(); ++range)
+		{
+			if (range->count < count) continue;
+
+			first = range->first;
+			range->first += count;
+			range->count -= count;
+			if (range->count == 0) freeRanges.erase(range);
+			return true;
+		}
+
+		if (count > capacity - end) return false;
+		end += count;
+		return true;
+	}
+
+	void Renderer3D::releaseRange(std::vector<ArenaRange>& freeRanges, uint32_t& end, uint32_t first, uint32_t count)
+	{
+		if (count == 0) return;
+
+		// Kept sorted and merged so a run freed in pieces can hold a mesh as large as the run
+		auto next = std::lower_bound(freeRanges.begin(), freeRanges.end(), first, [](const ArenaRange& range, uint32_t value) { return range.first < value; });
+		next = freeRanges.insert(next, { first, count });
+		if (next + 1 != freeRanges.end() && next->first + next->count == (next + 1)->first)
+		{
+			next->count += (next + 1)->count;
+			freeRanges.erase(next + 1);
+		}
+		if (next != freeRanges.begin() && (next - 1)->first + (next - 1)->count == next->first)
+		{
+			(next - 1)->count += next->count;
+			next = freeRanges.erase(next) - 1;
+		}
+
+		if (next->first + next->count == end)
+		{
+			end = next->first;
+			freeRanges.erase(next);
+		}
+	}
+
+	uint32_t Renderer3D::allocateCommand()
+	{
+		if (!s_data->freeCommands.empty())
+		{
+			uint32_t command = s_data->freeCommands.back();
+			s_data->freeCommands.pop_back();
+			return command;
+		}
 
 		s_data->batchCommands.push_back({ 0,0,0,0,0 });
+		return s_data->batchCommands.size() - 1;
+	}
+
+	void Renderer3D::reclaimGeometry()
+	{
+		// A pipelined frame draws a packet extracted the frame before, so ranges wait out two frame boundaries
+		auto& removed = s_data->removedGeometry;
+		uint32_t kept = 0;
+		for (auto& entry : removed)
+		{
+			if (s_data->frame - entry.frame < 2)
+			{
+				removed[kept++] = entry;
+				continue;
+			}
+
+			auto& geometry = entry.geometry;
+			releaseRange(s_data->freeVertices, s_data->nextVertex, geometry.firstVertex, geometry.vertexCount);
+			if (entry.ownsIndices)
+			{
+				releaseRange(s_data->freeIndices, s_data->nextIndex, geometry.firstIndex, geometry.indexCount);
+
+				uint32_t meshletEnd = s_data->meshlets.size();
+				releaseRange(s_data->freeMeshlets, meshletEnd, geometry.firstMeshlet, geometry.meshletCount);
+				s_data->meshlets.resize(meshletEnd);
+			}
+			s_data->freeCommands.push_back(geometry.id);
+		}
+		removed.resize(kept);
+
+		auto& crowds = s_data->removedCrowds;
+		kept = 0;
+		for (auto& entry : crowds)
+		{
+			if (s_data->frame - entry.frame < 2)
+			{
+				crowds[kept++] = entry;
+				continue;
+			}
+
+			releaseRange(s_data->freeCrowdInstances, s_data->nextCrowdInstance, entry.crowd.firstInstance, entry.crowd.instanceCount);
+		}
+		crowds.resize(kept);
+	}
+
+	void Renderer3D::skin(const Geometry& source, const Geometry& skinned, glm::mat4* boneMatrices, uint32_t boneCount, uint32_t pose)
+	{
+		EPHYRA_PROFILE_FUNCTION();
+		// Recorded here rather than when the pose is extracted, a copy culled that frame keeps waiting for its pose
+		if (pose != 0)
+		{
+			if (skinned.id >= s_data->skinnedPoses.size()) s_data->skinnedPoses.resize(skinned.id + 1, 0);
+			if (s_data->skinnedPoses[skinned.id] == pose) return;
+			s_data->skinnedPoses[skinned.id] = pose;
+		}
+
+		auto& shader = s_data->skinningShader;
+		shader->useShader(s_data->VAO->getRenderID());
+
+		shader->uploadMat4Array("boneMatrices", boneMatrices, boneCount);
+		shader->uploadInt("sourceFirstVertex", source.firstVertex);
+		shader->uploadInt("skinnedFirstVertex", skinned.firstVertex);
+		shader->uploadInt("vertexCount", source.vertexCount);
+
+		glBindBufferBase(GL_SHADER_STORAGE_BUFFER, 0, s_data->VAO->getVertexBuffer().at(0)->getRenderID());
+		glBindBufferBase(GL_SHADER_STORAGE_BUFFER, 1, s_data->depthVAO->getVertexBuffer().at(0)->getRenderID());
+
+		glDispatchCompute((source.vertexCount + 63) / 64, 1, 1);
+		RenderStats::dispatch();
+
+		s_data->skinningPending = true;
+	}
+
+	bool Renderer3D::addCrowd(const std::vector<glm::mat4>& models, const std::vector<glm::vec2>& playback, Crowd& crowd)
+	{
+		uint32_t instanceCount = models.size();
+
+		if (playback.size() != instanceCount) return false;
+
+		uint32_t firstInstance;
+		if (!allocateRange(s_data->freeCrowdInstances, s_data->nextCrowdInstance, s_data->crowdCapacity, instanceCount, firstInstance)) return false;
+
+		std::vector<AffineInstance> modelData;
+		modelData.reserve(instanceCount);
+		for (auto& model : models)
+			modelData.push_back(AffineInstance::encode(model));
+
+		// Playback shares the tint attribute slot, padded to a vec4
+		std::vector<glm::vec4> playbackData;
+		playbackData.reserve(instanceCount);
+		for (auto& p : playback)
+			playbackData.push_back(glm::vec4(p.x, p.y, 0.f, 0.f));
+
+		auto VBO_Models = s_data->crowdVAO->getVertexBuffer().at(1);
+		auto VBO_Playback = s_data->crowdVAO->getVertexBuffer().at(2);
+
+		VBO_Models->edit(modelData.data(), sizeof(AffineInstance) * instanceCount, sizeof(AffineInstance) * firstInstance);
+		VBO_Playback->edit(playbackData.data(), sizeof(glm::vec4) * instanceCount, sizeof(glm::vec4) * firstInstance);
+
+		crowd.firstInstance = firstInstance;
+		crowd.instanceCount = instanceCount;
 		return true;
+	}
+
+	void Renderer3D::removeCrowd(const Crowd& crowd)
+	{
+		if (crowd.instanceCount == 0) return;
+		s_data->removedCrowds.push_back({ crowd, s_data->frame });
+	}
+
+	void Renderer3D::submitCrowd(const VertexAnimation& animation, const Crowd& crowd, const std::shared_ptr<Material>& material, float time)
+	{
+		if (crowd.instanceCount == 0) return;
+
+		auto& shader = material->getShader();
+		shader->useShader(s_data->crowdVAO->getRenderID());
+
+		RendererCommon::colorFBO->bind();
+
+		uint32_t texUnit[5];
+
+		std::vector<std::shared_ptr<Texture>> textures = material->getTextures();
+		for (int i = 0; i < textures.size(); i++)
+		{
+			RendererCommon::m_textUM->getUnit(textures[i]->getID(), texUnit[i]);
+			textures[i]->load(texUnit[i]);
+		}
+
+		uint32_t positionUnit, normalUnit;
+		RendererCommon::m_textUM->getUnit(animation.positions->getID(), positionUnit);
+		animation.positions->load(positionUnit);
+		RendererCommon::m_textUM->getUnit(animation.normals->getID(), normalUnit);
+		animation.normals->load(normalUnit);
+
+		shader->uploadIntArray("u_texData", RendererCommon::textureUnits->data(), 32);
+		shader->uploadFloat3Array("u_lightPos", RendererCommon::lightPos.data(), 64);
+		shader->uploadFloat3Array("u_lightColour", RendererCommon::lightColour.data(), 64);
+
+		shader->uploadInt("ImmediateMode", 0);
+		shader->uploadInt("InstanceEncoding", 0);
+		shader->uploadInt("VertexAnimation", 1);
+
+		shader->uploadInt("AlbedoTex", texUnit[0]);
+		shader->uploadInt("RoughnessTex", texUnit[1]);
+		shader->uploadInt("MetallicTex", texUnit[2]);
+		shader->uploadInt("AOTex", texUnit[3]);
+		shader->uploadInt("NormalTex", texUnit[4]);
+		shader->uploadFloat4("TintCol", material->isFlagSet(Material::flag_tint) ? material->getTint() : glm::vec4(1.f));
+
+		shader->uploadInt("VATPositions", positionUnit);
+		shader->uploadInt("VATNormals", normalUnit);
+		shader->uploadInt("VATBaseVertex", animation.geometry.firstVertex);
+		shader->uploadInt("VATVertexCount", animation.geometry.vertexCount);
+		shader->uploadInt("VATFrameCount", animation.frameCount);
+		shader->uploadInt("VATWidth", VertexAnimation::textureWidth);
+		shader->uploadFloat("VATFramesPerSecond", animation.framesPerSecond);
+		shader->uploadFloat("VATTime", time);
+
+		s_data->crowdVAO->bindIndexBuffer();
+
+		glDrawElementsInstancedBaseVertexBaseInstance(GL_TRIANGLES, animation.geometry.indexCount, GL_UNSIGNED_INT, (void*)(sizeof(uint32_t) * animation.geometry.firstIndex), crowd.instanceCount, animation.geometry.firstVertex, crowd.firstInstance);
+		RenderStats::draw(1, crowd.instanceCount);
+
+		shader->uploadInt("VertexAnimation", 0);
+	}
+
+	bool Renderer3D::addRetained(const Geometry& geometry, const std::shared_ptr<Material>& material, const glm::mat4& model, uint32_t& slot)
+	{
+		if (!material) return false;
+
+		if (!s_data->retainedFree.empty())
+		{
+			slot = s_data->retainedFree.back();
+			s_data->retainedFree.pop_back();
+		}
+		else
+		{
+			if (s_data->retainedSlots.size() == s_data->retainedCapacity) return false;
+
+			slot = s_data->retainedSlots.size();
+			s_data->retainedSlots.emplace_back();
+			s_data->retainedModels.emplace_back();
+			s_data->retainedTints.push_back(0);
+		}
+
+		auto& retained = s_data->retainedSlots[slot];
+		retained.geometry = geometry;
+		retained.material = material;
+		retained.visible = false;
+		s_data->retainedRebuild = true;
+		s_data->retainedStats.instances++;
+
+		s_data->retainedModels[slot] = AffineInstance::encode(model);
+		s_data->retainedTints[slot] = RendererCommon::pack(material->isFlagSet(Material::flag_tint) ? material->getTint() : glm::vec4(1.f));
+		s_data->retainedDirtyInstances[0] = std::min(s_data->retainedDirtyInstances[0], slot);
+		s_data->retainedDirtyInstances[1] = std::max(s_data->retainedDirtyInstances[1], slot + 1);
+		return true;
+	}
+
+	void Renderer3D::removeRetained(uint32_t slot)
+	{
+		if (slot >= s_data->retainedSlots.size() || !s_data->retainedSlots[slot].material) return;
+
+		auto& retained = s_data->retainedSlots[slot];
+		if (retained.visible) s_data->retainedStats.visible--;
+		retained.material.reset();
+		retained.visible = false;
+		s_data->retainedFree.push_back(slot);
+		s_data->retainedRebuild = true;
+		s_data->retainedStats.instances--;
+	}
+
+	void Renderer3D::setRetainedTransform(uint32_t slot, const glm::mat4& model)
+	{
+		if (slot >= s_data->retainedSlots.size() || !s_data->retainedSlots[slot].material) return;
+
+		s_data->retainedModels[slot] = AffineInstance::encode(model);
+		s_data->retainedDirtyInstances[0] = std::min(s_data->retainedDirtyInstances[0], slot);
+		s_data->retainedDirtyInstances[1] = std::max(s_data->retainedDirtyInstances[1], slot + 1);
+	}
+
+	void Renderer3D::setRetainedMaterial(uint32_t slot, const std::shared_ptr<Material>& material)
+	{
+		if (slot >= s_data->retainedSlots.size() || !s_data->retainedSlots[slot].material || !material) return;
+
+		auto& retained = s_data->retainedSlots[slot];
+		if (retained.material != material)
+		{
+			// Commands are grouped by material, moving between groups needs the order rebuilt
+			retained.material = material;
+			s_data->retainedRebuild = true;
+		}
+
+		uint32_t tint = RendererCommon::pack(material->isFlagSet(Material::flag_tint) ? material->getTint() : glm::vec4(1.f));
+		if (s_data->retainedTints[slot] == tint) return;
+
+		s_data->retainedTints[slot] = tint;
+		s_data->retainedDirtyInstances[0] = std::min(s_data->retainedDirtyInstances[0], slot);
+		s_data->retainedDirtyInstances[1] = std::max(s_data->retainedDirtyInstances[1], slot + 1);
+	}
 
+	void Renderer3D::setRetainedVisible(uint32_t slot, bool visible)
+	{
+		if (slot >= s_data->retainedSlots.size() || !s_data->retainedSlots[slot].material) return;
+
+		auto& retained = s_data->retainedSlots[slot];
+		if (retained.visible == visible) return;
+
+		retained.visible = visible;
+		if (visible) s_data->retainedStats.visible++;
+		else s_data->retainedStats.visible--;
+
+		// Written in place while the order holds, a pending rebuild rewrites every command anyway
+		if (s_data->retainedRebuild) return;
+
+		s_data->retainedCommandData[retained.command].instanceCount = visible ? 1 : 0;
+		s_data->retainedDirtyCommands[0] = std::min(s_data->retainedDirtyCommands[0], retained.command);
+		s_data->retainedDirtyCommands[1] = std::max(s_data->retainedDirtyCommands[1], retained.command + 1);
+	}
+
+	void Renderer3D::rebuildRetained()
+	{
+		std::vector<uint32_t> order;
+		order.reserve(s_data->retainedSlots.size());
+		for (uint32_t slot = 0; slot < s_data->retainedSlots.size(); slot++)
+			if (s_data->retainedSlots[slot].material) order.push_back(slot);
+
+		std::sort(order.begin(), order.end(), [](uint32_t a, uint32_t b) {
+			auto& slotA = s_data->retainedSlots[a];
+			auto& slotB = s_data->retainedSlots[b];
+			if (slotA.material != slotB.material) return slotA.material < slotB.material;
+			if (slotA.geometry.id != slotB.geometry.id) return slotA.geometry.id < slotB.geometry.id;
+			return a < b;
+		});
+
+		// The base instance of each command is its slot, so transforms never move when the order changes
+		s_data->retainedCommandData.clear();
+		s_data->retainedDraws.clear();
+		for (uint32_t slot : order)
+		{
+			auto& retained = s_data->retainedSlots[slot];
+			if (s_data->retainedDraws.empty() || s_data->retainedDraws.back().material != retained.material)
+				s_data->retainedDraws.push_back({ retained.material, static_cast<uint32_t>(s_data->retainedCommandData.size()), 0 });
+
+			retained.command = s_data->retainedCommandData.size();
+			s_data->retainedCommandData.push_back({ retained.geometry.indexCount, retained.visible ? 1u : 0u, retained.geometry.firstIndex, retained.geometry.firstVertex, slot });
+			s_data->retainedDraws.back().commandCount++;
+		}
+
+		s_data->retainedDirtyCommands[0] = 0;
+		s_data->retainedDirtyCommands[1] = s_data->retainedCommandData.size();
+		s_data->retainedRebuild = false;
+		s_data->retainedStats.rebuilds++;
+	}
+
+	void Renderer3D::drawRetained()
+	{
+		EPHYRA_PROFILE_FUNCTION();
+		GPUTimerScope gpuScope("Retained");
+		if (s_data->retainedRebuild) rebuildRetained();
+
+		auto& instances = s_data->retainedDirtyInstances;
+		if (instances[0] < instances[1])
+		{
+			uint32_t count = instances[1] - instances[0];
+			s_data->retainedVAO->getVertexBuffer().at(1)->edit(&s_data->retainedModels[instances[0]], sizeof(AffineInstance) * count, sizeof(AffineInstance) * instances[0]);
+			s_data->retainedVAO->getVertexBuffer().at(2)->edit(&s_data->retainedTints[instances[0]], sizeof(uint32_t) * count, sizeof(uint32_t) * instances[0]);
+			s_data->retainedStats.patchedInstances += count;
+			instances[0] = UINT32_MAX;
+			instances[1] = 0;
+		}
+
+		auto& commands = s_data->retainedDirtyCommands;
+		if (commands[0] < commands[1])
+		{
+			uint32_t count = commands[1] - commands[0];
+			s_data->retainedCommands->edit(&s_data->retainedCommandData[commands[0]], count, sizeof(DrawElementsIndirectCommand) * commands[0]);
+			s_data->retainedStats.patchedCommands += count;
+			commands[0] = UINT32_MAX;
+			commands[1] = 0;
+		}
+
+		if (s_data->retainedStats.visible == 0) return;
+
+		// Replay has no retained path, each visible slot is recorded as the submit it stands in for
+		if (RenderCapture::isCapturing())
+		{
+			for (uint32_t slot = 0; slot < s_data->retainedSlots.size(); slot++)
+			{
+				auto& retained = s_data->retainedSlots[slot];
+				if (retained.material && retained.visible)
+					RenderCapture::recordSubmit3D(retained.geometry, retained.material, s_data->retainedModels[slot].decode());
+			}
+		}
+
+		RendererCommon::colorFBO->bind();
+		s_data->retainedVAO->bindIndexBuffer();
+		glBindBuffer(GL_DRAW_INDIRECT_BUFFER, s_data->retainedCommands->getID());
+
+		if (s_data->skinningPending)
+		{
+			glMemoryBarrier(GL_VERTEX_ATTRIB_ARRAY_BARRIER_BIT);
+			s_data->skinningPending = false;
+		}
+
+		// The shader reads 64 lights, the layer may have set fewer
+		std::vector<glm::vec3> lightPos(64, glm::vec3(0.f)), lightColour(64, glm::vec3(0.f));
+		std::copy_n(RendererCommon::lightPos.begin(), std::min<size_t>(64, RendererCommon::lightPos.size()), lightPos.begin());
+		std::copy_n(RendererCommon::lightColour.begin(), std::min<size_t>(64, RendererCommon::lightColour.size()), lightColour.begin());
+
+		uint32_t texUnit[5];
+		for (auto& draw : s_data->retainedDraws)
+		{
+			auto& material = draw.material;
+			auto& shader = material->getShader();
+			shader->useShader(s_data->retainedVAO->getRenderID());
+
+			std::vector<std::shared_ptr<Texture>> textures = material->getTextures();
+			for (int i = 0; i < textures.size() && i < 5; i++)
+			{
+				RendererCommon::m_textUM->getUnit(textures[i]->getID(), texUnit[i]);
+				textures[i]->load(texUnit[i]);
+			}
+
+			shader->uploadIntArray("u_texData", RendererCommon::textureUnits->data(), 32);
+			shader->uploadFloat3Array("u_lightPos", lightPos.data(), 64);
+			shader->uploadFloat3Array("u_lightColour", lightColour.data(), 64);
+
+			// Textures come from uniforms as in immediate mode, transform and tint from the slot
+			shader->uploadInt("ImmediateMode", 2);
+			shader->uploadInt("InstanceEncoding", 0);
+
+			shader->uploadInt("AlbedoTex", texUnit[0]);
+			shader->uploadInt("RoughnessTex", texUnit[1]);
+			shader->uploadInt("MetallicTex", texUnit[2]);
+			shader->uploadInt("AOTex", texUnit[3]);
+			shader->uploadInt("NormalTex", texUnit[4]);
+
+			glMultiDrawElementsIndirect(GL_TRIANGLES, GL_UNSIGNED_INT, (GLvoid*)(sizeof(DrawElementsIndirectCommand) * draw.firstCommand), draw.commandCount, 0);
+			RenderStats::draw(draw.commandCount, draw.commandCount);
+			s_data->retainedStats.draws++;
+		}
 	}
 
 	void Renderer3D::flushBatch()
 	{
+		EPHYRA_PROFILE_FUNCTION();
 		//Sort Batch Queue by Shader then By geometryID
 		std::sort(s_data->batchQueue.begin(), s_data->batchQueue.end(),
 			[](BatchQueueEntry& a, BatchQueueEntry& b) {
@@ -317,39 +1053,90 @@ namespace Engine
 			}
 		);
 
+		// Rigid props drop to 32 bytes per instance, a single sheared or stretched instance keeps the batch on the affine stream.
+		// The depth prepass reads affine transforms, decoding a quaternion would not give bit identical depths for the equal test
+		auto& queue = s_data->batchQueue;
+		bool rigid = !s_data->depthPrepass;
+		for (uint32_t i = 0; rigid && i < queue.size(); i++)
+		{
+			RigidInstance instance;
+			rigid = RigidInstance::encode(queue[i].model, instance);
+		}
+
+		// Draws the instances gathered so far and starts the next range from instance 0
+		auto flushRange = [rigid](std::shared_ptr<Shader> shader, uint32_t instanceCount)
+		{
+			if (instanceCount > 0) flushBatchCommands(shader, instanceCount, rigid);
+
+			s_data->affineInstanceData.clear();
+			s_data->rigidInstanceData.clear();
+			s_data->tintInstanceData.clear();
+
+			s_data->albedoInstanceData.clear();
+			s_data->metallicInstanceData.clear();
+			s_data->roughnessInstanceData.clear();
+			s_data->aoInstanceData.clear();
+			s_data->normalInstanceData.clear();
+			s_data->clusterCommandData.clear();
+
+			for (auto& command : s_data->batchCommands)
+			{
+				command.instanceCount = 0;
+				command.drawCount = 0;
+			}
+		};
+
+		uint32_t commandSpace = s_data->batchCapacity - std::min<uint32_t>(s_data->batchCapacity, s_data->batchCommands.size());
 		uint32_t runningInstanceCount = 0;
 		uint32_t texUnit[5];
 
-		for (auto& bqe : s_data->batchQueue)
+		for (auto& bqe : queue)
 		{
+			// Binding this entry's textures would reuse units the gathered instances read
+			if (RendererCommon::m_textUM->isFull() && runningInstanceCount > 0)
+			{
+				RenderStats::forcedFlush();
+				flushRange(bqe.material->getShader(), runningInstanceCount);
+				runningInstanceCount = 0;
+			}
+
+			// Meshes with clusters emit a command per run of visible clusters against their instance slot, fully culled ones are dropped
+			uint32_t before = s_data->clusterCommandData.size();
+			bool clustered = bqe.geometry.meshletCount <= commandSpace - before && appendClusterCommands(bqe.geometry, bqe.model, runningInstanceCount, s_data->clusterCommandData);
+			if (clustered && s_data->clusterCommandData.size() == before) continue;
+
 			// Not Using Vertex Count of Geometry
 			auto& index = bqe.geometry.id;
 
-			if (s_data->batchCommands.at(index).drawCount == 0)
+			if (!clustered)
 			{
-				s_data->batchCommands.at(index).firstVertex = bqe.geometry.firstVertex;
-				s_data->batchCommands.at(index).firstIndex = bqe.geometry.firstIndex;
-				s_data->batchCommands.at(index).drawCount = bqe.geometry.indexCount;
-				s_data->batchCommands.at(index).firstInstance = runningInstanceCount;
-			}
+				if (s_data->batchCommands.at(index).drawCount == 0)
+				{
+					s_data->batchCommands.at(index).firstVertex = bqe.geometry.firstVertex;
+					s_data->batchCommands.at(index).firstIndex = bqe.geometry.firstIndex;
+					s_data->batchCommands.at(index).drawCount = bqe.geometry.indexCount;
+					s_data->batchCommands.at(index).firstInstance = runningInstanceCount;
+				}
 
-			// Increment Instance Counts
-			s_data->batchCommands.at(index).instanceCount++;
+				// Increment Instance Counts
+				s_data->batchCommands.at(index).instanceCount++;
+			}
 			runningInstanceCount++;
 
 			// Add Instanced Variables
-			s_data->modelInstanceData.push_back(bqe.model);
+			if (rigid)
+			{
+				RigidInstance instance;
+				RigidInstance::encode(bqe.model, instance);
+				s_data->rigidInstanceData.push_back(instance);
+			}
+			else
+				s_data->affineInstanceData.push_back(AffineInstance::encode(bqe.model));
 			if(bqe.material->isFlagSet(Material::flag_tint))
 				s_data->tintInstanceData.push_back(RendererCommon::pack(bqe.material->getTint()));
 			else
 				s_data->tintInstanceData.push_back(RendererCommon::pack(glm::vec4(1.f)));
 
-			if (RendererCommon::m_textUM->isFull())
-			{
-				flushBatchCommands(bqe.material->getShader(), runningInstanceCount);
-				runningInstanceCount = 0;
-			}
-
 			std::vector<std::shared_ptr<Texture>> textures = bqe.material->getTextures();
 			for (int i = 0; i < textures.size(); i++)
 			{
@@ -364,43 +1151,23 @@ namespace Engine
 			s_data->normalInstanceData.push_back(texUnit[4]);
 		}
 
-		if (runningInstanceCount > 0)
-		{
-			flushBatchCommands(s_data->batchQueue.back().material->getShader(), runningInstanceCount);
-			runningInstanceCount = 0;
-		}
-
-		s_data->batchQueue.clear();
-
-		s_data->modelInstanceData.clear();
-		s_data->tintInstanceData.clear();
-
-		s_data->albedoInstanceData.clear();
-		s_data->metallicInstanceData.clear();
-		s_data->roughnessInstanceData.clear();
-		s_data->aoInstanceData.clear();
-		s_data->normalInstanceData.clear();
-
-		for (auto& command : s_data->batchCommands)
-		{
-			command.instanceCount = 0;
-			command.drawCount = 0;
-		}
+		if (!queue.empty()) flushRange(queue.back().material->getShader(), runningInstanceCount);
+		queue.clear();
 	}
 
-	void Renderer3D::flushBatchCommands(std::shared_ptr<Shader>& shader, uint32_t instanceCount)
+	void Renderer3D::flushBatchCommands(std::shared_ptr<Shader>& shader, uint32_t instanceCount, bool rigid)
 	{
+		RenderStats::batchFlush();
+		auto& VAO = rigid ? s_data->rigidVAO : s_data->VAO;
+
 		// Use Shader
-		shader->useShader(s_data->VAO->getRenderID());
+		shader->useShader(VAO->getRenderID());
 
-		for (int i = 0; i < 100; i++)
-		{
-			std::string name = "boneMatrices[" + std::to_string(i) + "]";
-			shader->uploadMat4(name.c_str(), boneManager.getBoneMatrices()[i]);
-		}
+		shader->uploadMat4Array("boneMatrices", boneManager.getBoneMatrices(), 100);
 
 		// Upload Tex Units
 		shader->uploadInt("ImmediateMode", 0);
+		shader->uploadInt("InstanceEncoding", rigid ? 1 : 0);
 
 		shader->uploadIntArray("u_texData", RendererCommon::textureUnits->data(), 32);
 
@@ -425,7 +1192,7 @@ namespace Engine
 		}
 
 		// Upload Instance Data
-		auto VBO_Models = s_data->VAO->getVertexBuffer().at(1);
+		auto VBO_Models = VAO->getVertexBuffer().at(1);
 		auto VBO_Tints = s_data->VAO->getVertexBuffer().at(2);
 
 		auto VBO_Albedo = s_data->VAO->getVertexBuffer().at(3);
@@ -434,7 +1201,10 @@ namespace Engine
 		auto VBO_AO = s_data->VAO->getVertexBuffer().at(6);
 		auto VBO_Normal = s_data->VAO->getVertexBuffer().at(7);
 
-		VBO_Models->edit(s_data->modelInstanceData.data(), sizeof(glm::mat4) * instanceCount, 0);
+		if (rigid)
+			VBO_Models->edit(s_data->rigidInstanceData.data(), sizeof(RigidInstance) * instanceCount, 0);
+		else
+			VBO_Models->edit(s_data->affineInstanceData.data(), sizeof(AffineInstance) * instanceCount, 0);
 		VBO_Tints->edit(s_data->tintInstanceData.data(), sizeof(uint32_t) * instanceCount, 0);
 
 		VBO_Albedo->edit(s_data->albedoInstanceData.data(), sizeof(uint32_t) * instanceCount, 0);
@@ -443,11 +1213,361 @@ namespace Engine
 		VBO_AO->edit(s_data->aoInstanceData.data(), sizeof(uint32_t) * instanceCount, 0);
 		VBO_Normal->edit(s_data->normalInstanceData.data(), sizeof(uint32_t) * instanceCount, 0);
 
-		s_data->VAO->bindIndexBuffer();
+		VAO->bindIndexBuffer();
 
 		s_data->commands->edit(s_data->batchCommands.data(), s_data->batchCommands.size(), 0);
+		if (!s_data->clusterCommandData.empty())
+			s_data->commands->edit(s_data->clusterCommandData.data(), s_data->clusterCommandData.size(), s_data->batchCommands.size() * sizeof(DrawElementsIndirectCommand));
+
+		if (s_data->skinningPending)
+		{
+			glMemoryBarrier(GL_VERTEX_ATTRIB_ARRAY_BARRIER_BIT);
+			s_data->skinningPending = false;
+		}
 
-		glMultiDrawElementsIndirect(GL_TRIANGLES, GL_UNSIGNED_INT, (GLvoid*)0, s_data->batchCommands.size(), 0);
+		glMultiDrawElementsIndirect(GL_TRIANGLES, GL_UNSIGNED_INT, (GLvoid*)0, s_data->batchCommands.size() + s_data->clusterCommandData.size(), 0);
+		RenderStats::draw(s_data->batchCommands.size() + s_data->clusterCommandData.size(), instanceCount);
+	}
+
+	void Renderer3D::setDepthPrepass(bool enabled)
+	{
+		if (s_data->depthPrepass == enabled) return;
+
+		// Anything already queued is drawn under the mode it was submitted in
+		if (!s_data->batchQueue.empty() || !s_data->immediateQueue.empty()) flush();
+		s_data->depthPrepass = enabled;
+	}
+
+	void Renderer3D::flushDepthPrepass()
+	{
+		EPHYRA_PROFILE_FUNCTION();
+		// Boned geometry is skinned in the PBR vertex shader, it is shaded first with ordinary depth testing
+		auto& queue = s_data->batchQueue;
+		auto clean = std::stable_partition(queue.begin(), queue.end(), [](const BatchQueueEntry& entry) { return entry.geometry.hasBones; });
+		s_data->deferredBatch.assign(std::make_move_iterator(clean), std::make_move_iterator(queue.end()));
+		queue.erase(clean, queue.end());
+		if (!queue.empty()) flushBatch();
+
+		std::vector<const BatchQueueEntry*> entries;
+		entries.reserve(s_data->deferredBatch.size() + s_data->immediateQueue.size());
+		for (auto& entry : s_data->deferredBatch) entries.push_back(&entry);
+		for (auto& entry : s_data->immediateQueue) entries.push_back(&entry);
+		if (entries.empty()) return;
+
+		drawDepthPrepass(entries);
+
+		// Only the fragment matching the prepass depth survives, so each pixel is shaded once
+		glDepthFunc(GL_EQUAL);
+		glDepthMask(GL_FALSE);
+
+		queue.swap(s_data->deferredBatch);
+		if (!queue.empty()) flushBatch();
+		s_data->deferredBatch.clear();
+
+		for (auto& entry : s_data->immediateQueue)
+			drawImmediate(entry.geometry, entry.material, entry.model);
+		s_data->immediateQueue.clear();
+
+		glDepthMask(GL_TRUE);
+		glDepthFunc(GL_LESS);
+	}
+
+	void Renderer3D::drawDepthPrepass(const std::vector<const BatchQueueEntry*>& entries)
+	{
+		GPUTimerScope gpuScope("Depth Prepass");
+		auto& shader = s_data->depthShader;
+		shader->useShader(s_data->depthVAO->getRenderID());
+
+		auto VBO_Models = s_data->depthVAO->getVertexBuffer().at(1);
+		s_data->depthVAO->bindIndexBuffer();
+
+		if (s_data->skinningPending)
+		{
+			glMemoryBarrier(GL_VERTEX_ATTRIB_ARRAY_BARRIER_BIT);
+			s_data->skinningPending = false;
+		}
+
+		glColorMask(GL_FALSE, GL_FALSE, GL_FALSE, GL_FALSE);
+
+		auto drawChunk = [&VBO_Models]()
+		{
+			if (s_data->depthCommandData.empty()) return;
+
+			VBO_Models->edit(s_data->depthInstanceData.data(), sizeof(AffineInstance) * s_data->depthInstanceData.size(), 0);
+			s_data->depthCommands->edit(s_data->depthCommandData.data(), s_data->depthCommandData.size(), 0);
+
+			glMultiDrawElementsIndirect(GL_TRIANGLES, GL_UNSIGNED_INT, (GLvoid*)0, s_data->depthCommandData.size(), 0);
+			RenderStats::draw(s_data->depthCommandData.size(), s_data->depthInstanceData.size());
+
+			s_data->depthCommandData.clear();
+			s_data->depthInstanceData.clear();
+		};
+
+		// A command per entry, or per run of visible clusters, whose base instance selects the entry's transform
+		s_data->depthCommandData.clear();
+		s_data->depthInstanceData.clear();
+		for (auto* entry : entries)
+		{
+			if (s_data->depthCommandData.size() + std::max(1u, entry->geometry.meshletCount) > s_data->batchCapacity || s_data->depthInstanceData.size() == s_data->batchCapacity)
+				drawChunk();
+
+			uint32_t instance = s_data->depthInstanceData.size();
+			uint32_t before = s_data->depthCommandData.size();
+			if (!appendClusterCommands(entry->geometry, entry->model, instance, s_data->depthCommandData, false))
+				s_data->depthCommandData.push_back({ entry->geometry.indexCount, 1, entry->geometry.firstIndex, entry->geometry.firstVertex, instance });
+			if (s_data->depthCommandData.size() == before) continue;
+
+			s_data->depthInstanceData.push_back(AffineInstance::encode(entry->model));
+		}
+		drawChunk();
+
+		glColorMask(GL_TRUE, GL_TRUE, GL_TRUE, GL_TRUE);
+	}
+
+	bool Renderer3D::appendClusterCommands(const Geometry& geometry, const glm::mat4& model, uint32_t instance, std::vector<DrawElementsIndirectCommand>& commands, bool recordStats)
+	{
+		if (!s_data->meshletCulling || geometry.meshletCount == 0) return false;
+
+		// Test in model space, the planes of view projection * model are already in it and back facing is unchanged by the transform
+		Frustum frustum(s_data->viewProjection * model);
+		glm::vec3 camera = glm::vec3(glm::inverse(model) * glm::vec4(s_data->viewPosition, 1.f));
+
+		MeshletStats stats;
+		uint32_t first = commands.size();
+		for (uint32_t i = 0; i < geometry.meshletCount; i++)
+		{
+			auto& meshlet = s_data->meshlets[geometry.firstMeshlet + i];
+			stats.tested++;
+
+			Meshlets::Result result = Meshlets::classify(meshlet, frustum, camera, s_data->meshletConeCulling);
+			if (result != Meshlets::Result::Visible)
+			{
+				if (result == Meshlets::Result::Outside) stats.frustumCulled++;
+				else stats.coneCulled++;
+				stats.trianglesCulled += meshlet.triangleCount;
+				continue;
+			}
+			stats.trianglesDrawn += meshlet.triangleCount;
+
+			// Clusters are consecutive in the index buffer, so visible neighbours share one command
+			uint32_t firstIndex = geometry.firstIndex + meshlet.firstIndex;
+			if (commands.size() > first && commands.back().firstIndex + commands.back().drawCount == firstIndex)
+				commands.back().drawCount += meshlet.triangleCount * 3;
+			else
+			{
+				commands.push_back({ meshlet.triangleCount * 3, 1, firstIndex, geometry.firstVertex, instance });
+				stats.commands++;
+			}
+		}
+
+		if (recordStats)
+		{
+			auto& total = s_data->meshletStats;
+			total.tested += stats.tested;
+			total.frustumCulled += stats.frustumCulled;
+			total.coneCulled += stats.coneCulled;
+			total.commands += stats.commands;
+			total.trianglesDrawn += stats.trianglesDrawn;
+			total.trianglesCulled += stats.trianglesCulled;
+		}
+		return true;
+	}
+
+	void Renderer3D::setMeshletCulling(bool enabled, bool coneCulling)
+	{
+		s_data->meshletCulling = enabled;
+		s_data->meshletConeCulling = coneCulling;
+	}
+
+	void Renderer3D::beginMainPass()
+	{
+		if (!s_data->pipelineStatistics || s_data->mainPassActive) return;
+
+		uint32_t index = s_data->invocationQueryIndex;
+		uint32_t query = s_data->invocationQueries[index];
+
+		// Issued two frames ago, normally ready so reading it does not stall
+		if (s_data->invocationQueryIssued[index])
+		{
+			GLuint available = 0;
+			glGetQueryObjectuiv(query, GL_QUERY_RESULT_AVAILABLE, &available);
+			if (available)
+			{
+				GLuint64 invocations = 0;
+				glGetQueryObjectui64v(query, GL_QUERY_RESULT, &invocations);
+				s_data->fragmentInvocations[s_data->invocationQueryPrepass[index] ? 1 : 0] = invocations;
+			}
+		}
+
+		glBeginQuery(GL_FRAGMENT_SHADER_INVOCATIONS, query);
+		s_data->invocationQueryIssued[index] = true;
+		s_data->invocationQueryPrepass[index] = s_data->depthPrepass;
+		s_data->mainPassActive = true;
+	}
+
+	void Renderer3D::endMainPass()
+	{
+		if (s_data->mainPassActive)
+		{
+			glEndQuery(GL_FRAGMENT_SHADER_INVOCATIONS);
+			s_data->invocationQueryIndex ^= 1;
+			s_data->mainPassActive = false;
+		}
+
+		if (s_data->hiZ) buildHiZ();
+	}
+
+	uint64_t Renderer3D::getFragmentInvocations(bool depthPrepass)
+	{
+		return s_data->fragmentInvocations[depthPrepass ? 1 : 0];
+	}
+
+	void Renderer3D::setHiZ(bool enabled)
+	{
+		s_data->hiZ = enabled;
+		if (enabled) return;
+
+		// Queued tests are for boxes of the frame they were made in, never apply them after a pause
+		s_data->hiZValid = false;
+		for (auto& fence : s_data->hiZFences)
+		{
+			if (fence) glDeleteSync(static_cast<GLsync>(fence));
+			fence = nullptr;
+		}
+	}
+
+	void Renderer3D::buildHiZ()
+	{
+		EPHYRA_PROFILE_FUNCTION();
+		GPUTimerScope gpuScope("Hi-Z");
+		auto& shader = s_data->hiZShader;
+		glUseProgram(shader->getID());
+		RenderStats::programBind();
+
+		uint32_t depthUnit;
+		RendererCommon::m_textUM->getUnit(RendererCommon::depthFBOTexture->getID(), depthUnit);
+		RendererCommon::depthFBOTexture->load(depthUnit);
+		shader->uploadInt("depthTex", depthUnit);
+
+		// Level 0 copies the depth buffer, every level after keeps the farthest depth under each of its texels
+		uint32_t texID = s_data->hiZTexture->getID();
+		uint32_t width = s_data->hiZTexture->getWidth();
+		uint32_t height = s_data->hiZTexture->getHeight();
+		for (uint32_t level = 0; level < s_data->hiZLevels; level++)
+		{
+			shader->uploadInt("sourceIsDepth", level == 0 ? 1 : 0);
+
+			glBindImageTexture(0, texID, level, GL_FALSE, 0, GL_WRITE_ONLY, GL_R32F);
+			if (level > 0) glBindImageTexture(1, texID, level - 1, GL_FALSE, 0, GL_READ_ONLY, GL_R32F);
+
+			glDispatchCompute((width + 15) / 16, (height + 15) / 16, 1);
+			RenderStats::dispatch();
+
+			glMemoryBarrier(GL_SHADER_IMAGE_ACCESS_BARRIER_BIT);
+
+			width = std::max(1u, width / 2);
+			height = std::max(1u, height / 2);
+		}
+
+		glMemoryBarrier(GL_TEXTURE_FETCH_BARRIER_BIT);
+
+		s_data->hiZViewProjection = s_data->viewProjection;
+		s_data->hiZValid = true;
+	}
+
+	bool Renderer3D::testHiZ(const std::vector<AABB>& bounds, const std::vector<uint32_t>& keys, std::vector<uint8_t>& visible)
+	{
+		EPHYRA_PROFILE_FUNCTION();
+		visible.assign(bounds.size(), 1);
+		if (!s_data->hiZValid) return false;
+
+		// Results of the test queued last frame, skipped rather than waited for if the GPU has not finished it
+		uint32_t previous = s_data->hiZSlot ^ 1;
+		bool hasResults = false;
+		if (s_data->hiZFences[previous])
+		{
+			GLsync fence = static_cast<GLsync>(s_data->hiZFences[previous]);
+			GLenum status = glClientWaitSync(fence, GL_SYNC_FLUSH_COMMANDS_BIT, 0);
+			if (status == GL_ALREADY_SIGNALED || status == GL_CONDITION_SATISFIED)
+			{
+				auto& previousKeys = s_data->hiZKeys[previous];
+				s_data->hiZReadback.resize(previousKeys.size());
+				glBindBuffer(GL_SHADER_STORAGE_BUFFER, s_data->hiZVisibleBuffers[previous]);
+				glGetBufferSubData(GL_SHADER_STORAGE_BUFFER, 0, previousKeys.size() * sizeof(uint32_t), s_data->hiZReadback.data());
+
+				s_data->hiZResults.clear();
+				for (uint32_t i = 0; i < previousKeys.size(); i++)
+					s_data->hiZResults[previousKeys[i]] = s_data->hiZReadback[i] ? 1 : 0;
+				hasResults = true;
+			}
+			glDeleteSync(fence);
+			s_data->hiZFences[previous] = nullptr;
+		}
+
+		// Queue this frame's boxes, their results are read back by the next call
+		uint32_t slot = s_data->hiZSlot;
+		uint32_t count = bounds.size();
+		s_data->hiZKeys[slot] = keys;
+		s_data->hiZSlot ^= 1;
+		if (count > 0)
+		{
+			if (count > s_data->hiZCapacity[slot])
+			{
+				if (!s_data->hiZBoundsBuffers[slot]) glGenBuffers(1, &s_data->hiZBoundsBuffers[slot]);
+				if (!s_data->hiZVisibleBuffers[slot]) glGenBuffers(1, &s_data->hiZVisibleBuffers[slot]);
+
+				glBindBuffer(GL_SHADER_STORAGE_BUFFER, s_data->hiZBoundsBuffers[slot]);
+				glBufferData(GL_SHADER_STORAGE_BUFFER, count * 2 * sizeof(glm::vec4), nullptr, GL_DYNAMIC_DRAW);
+				glBindBuffer(GL_SHADER_STORAGE_BUFFER, s_data->hiZVisibleBuffers[slot]);
+				glBufferData(GL_SHADER_STORAGE_BUFFER, count * sizeof(uint32_t), nullptr, GL_DYNAMIC_READ);
+				s_data->hiZCapacity[slot] = count;
+			}
+
+			std::vector<glm::vec4> corners;
+			corners.reserve(count * 2);
+			for (auto& box : bounds)
+			{
+				corners.push_back(glm::vec4(box.min, 0.f));
+				corners.push_back(glm::vec4(box.max, 0.f));
+			}
+
+			glBindBuffer(GL_SHADER_STORAGE_BUFFER, s_data->hiZBoundsBuffers[slot]);
+			glBufferSubData(GL_SHADER_STORAGE_BUFFER, 0, count * 2 * sizeof(glm::vec4), corners.data());
+			RenderStats::upload(count * 2 * sizeof(glm::vec4));
+
+			auto& shader = s_data->hiZCullShader;
+			glUseProgram(shader->getID());
+			RenderStats::programBind();
+
+			uint32_t hiZUnit;
+			RendererCommon::m_textUM->getUnit(s_data->hiZTexture->getID(), hiZUnit);
+			s_data->hiZTexture->load(hiZUnit);
+
+			shader->uploadInt("hiZ", hiZUnit);
+			shader->uploadInt("levelCount", s_data->hiZLevels);
+			shader->uploadInt("boundsCount", count);
+			shader->uploadMat4("viewProjection", s_data->hiZViewProjection);
+
+			glBindBufferBase(GL_SHADER_STORAGE_BUFFER, 0, s_data->hiZBoundsBuffers[slot]);
+			glBindBufferBase(GL_SHADER_STORAGE_BUFFER, 1, s_data->hiZVisibleBuffers[slot]);
+
+			glDispatchCompute((count + 63) / 64, 1, 1);
+			RenderStats::dispatch();
+
+			glMemoryBarrier(GL_BUFFER_UPDATE_BARRIER_BIT);
+			s_data->hiZFences[slot] = glFenceSync(GL_SYNC_GPU_COMMANDS_COMPLETE, 0);
+		}
+
+		if (!hasResults) return false;
+
+		// Boxes not tested last frame have no result yet and stay visible
+		for (uint32_t i = 0; i < bounds.size(); i++)
+		{
+			auto result = s_data->hiZResults.find(keys[i]);
+			if (result != s_data->hiZResults.end() && !result->second)
+				visible[i] = 0;
+		}
+		return true;
 	}
 
 }
\ No newline at end of file
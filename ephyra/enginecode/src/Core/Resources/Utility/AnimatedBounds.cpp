@@ -0,0 +1,147 @@
+/** \file animatedBounds.cpp */
+
+#include "Ephyra_pch.h"
+
+#include "Core/Resources/Utility/AnimatedBounds.h"
+#include "Core/Rendering/Renderer/Renderer3D.h"
+
+#include <glm/gtc/type_ptr.hpp>
+
+#if defined(__SSE__) || defined(_M_X64) || (defined(_M_IX86_FP) && _M_IX86_FP >= 1)
+#define EPHYRA_BOUNDS_SSE
+#include <xmmintrin.h>
+#endif
+
+namespace Engine
+{
+	AnimatedBounds::AnimatedBounds(float duration, float rangeSeconds) : m_duration(duration), m_rangeSeconds(rangeSeconds)
+	{
+		uint32_t count = 1;
+		if (duration > 0.f && rangeSeconds > 0.f)
+			count = std::max(1u, static_cast<uint32_t>(std::ceil(duration / rangeSeconds)));
+		m_ranges.resize(count);
+	}
+
+	uint32_t AnimatedBounds::rangeIndex(float seconds) const
+	{
+		if (m_duration <= 0.f || m_rangeSeconds <= 0.f) return 0;
+
+		float wrapped = std::fmod(seconds, m_duration);
+		if (wrapped < 0.f) wrapped += m_duration;
+		return std::min(static_cast<uint32_t>(wrapped / m_rangeSeconds), getRangeCount() - 1);
+	}
+
+	void AnimatedBounds::addSample(float seconds, const AABB& box)
+	{
+		if (m_ranges.empty()) return;
+
+		uint32_t index = (m_rangeSeconds > 0.f) ? std::min(static_cast<uint32_t>(std::max(seconds, 0.f) / m_rangeSeconds), getRangeCount() - 1) : 0;
+		m_ranges[index].expand(box);
+
+		// A sample on a boundary belongs to both neighbouring ranges
+		if (index > 0 && std::abs(seconds - index * m_rangeSeconds) < 1e-4f)
+			m_ranges[index - 1].expand(box);
+
+		m_clipBounds.expand(box);
+	}
+
+	AABB AnimatedBounds::query(float seconds) const
+	{
+		if (m_ranges.empty()) return AABB();
+		return m_ranges[rangeIndex(seconds)];
+	}
+
+	AABB AnimatedBounds::queryRange(float start, float end) const
+	{
+		if (m_ranges.empty()) return AABB();
+		if (end - start >= m_duration) return m_clipBounds;
+
+		AABB box;
+		uint32_t first = rangeIndex(start);
+		uint32_t last = rangeIndex(end);
+		for (uint32_t i = first; ; i = (i + 1) % getRangeCount())
+		{
+			box.expand(m_ranges[i]);
+			if (i == last) break;
+		}
+		return box;
+	}
+
+	AABB AnimatedBounds::skinBounds(const Renderer3DVertex* vertices, uint32_t vertexCount, const glm::mat4* palette, uint32_t paletteSize)
+	{
+		AABB box;
+		if (vertexCount == 0) return box;
+
+#ifdef EPHYRA_BOUNDS_SSE
+		__m128 boxMin = _mm_set1_ps(FLT_MAX);
+		__m128 boxMax = _mm_set1_ps(-FLT_MAX);
+
+		for (uint32_t v = 0; v < vertexCount; v++)
+		{
+			const Renderer3DVertex& vertex = vertices[v];
+
+			// Blend the palette columns, same weighting as the PBR vertex shader
+			__m128 c0 = _mm_setzero_ps();
+			__m128 c1 = _mm_setzero_ps();
+			__m128 c2 = _mm_setzero_ps();
+			__m128 c3 = _mm_setzero_ps();
+			bool skinned = false;
+
+			for (int k = 0; k < 4; k++)
+			{
+				float weight = vertex.boneWeights[k];
+				uint32_t bone = static_cast<uint32_t>(vertex.boneIndices[k]);
+				if (weight == 0.f || bone >= paletteSize) continue;
+
+				const float* m = glm::value_ptr(palette[bone]);
+				__m128 w = _mm_set1_ps(weight);
+				c0 = _mm_add_ps(c0, _mm_mul_ps(_mm_loadu_ps(m + 0), w));
+				c1 = _mm_add_ps(c1, _mm_mul_ps(_mm_loadu_ps(m + 4), w));
+				c2 = _mm_add_ps(c2, _mm_mul_ps(_mm_loadu_ps(m + 8), w));
+				c3 = _mm_add_ps(c3, _mm_mul_ps(_mm_loadu_ps(m + 12), w));
+				skinned = true;
+			}
+
+			__m128 position;
+			if (skinned)
+			{
+				position = _mm_add_ps(
+					_mm_add_ps(_mm_mul_ps(c0, _mm_set1_ps(vertex.m_pos.x)), _mm_mul_ps(c1, _mm_set1_ps(vertex.m_pos.y))),
+					_mm_add_ps(_mm_mul_ps(c2, _mm_set1_ps(vertex.m_pos.z)), c3));
+			}
+			else
+				position = _mm_set_ps(1.f, vertex.m_pos.z, vertex.m_pos.y, vertex.m_pos.x);
+
+			boxMin = _mm_min_ps(boxMin, position);
+			boxMax = _mm_max_ps(boxMax, position);
+		}
+
+		alignas(16) float minOut[4];
+		alignas(16) float maxOut[4];
+		_mm_store_ps(minOut, boxMin);
+		_mm_store_ps(maxOut, boxMax);
+		box.min = glm::vec3(minOut[0], minOut[1], minOut[2]);
+		box.max = glm::vec3(maxOut[0], maxOut[1], maxOut[2]);
+#else
+		for (uint32_t v = 0; v < vertexCount; v++)
+		{
+			const Renderer3DVertex& vertex = vertices[v];
+
+			glm::mat4 boneTransform(0.f);
+			bool skinned = false;
+			for (int k = 0; k < 4; k++)
+			{
+				float weight = vertex.boneWeights[k];
+				uint32_t bone = static_cast<uint32_t>(vertex.boneIndices[k]);
+				if (weight == 0.f || bone >= paletteSize) continue;
+
+				boneTransform += palette[bone] * weight;
+				skinned = true;
+			}
+
+			box.expand(skinned ? glm::vec3(boneTransform * glm::vec4(vertex.m_pos, 1.f)) : vertex.m_pos);
+		}
+#endif
+		return box;
+	}
+}
@@ -0,0 +1,414 @@
+/** \file animationCompression.cpp */
+
+#include "Ephyra_pch.h"
+
+#include "Core/Resources/Utility/AnimationCompression.h"
+
+#include <assimp/scene.h>
+#include <glm/gtc/matrix_transform.hpp>
+
+#include <algorithm>
+#include <cmath>
+#include <limits>
+
+namespace Engine
+{
+	namespace
+	{
+		constexpr float s_quatRange = 0.70710678f; //!< Smallest three components lie in [-1/sqrt(2), 1/sqrt(2)]
+		constexpr uint32_t s_maxFrames = 0xFFFF; //!< Frame indices are stored as 16 bit
+
+		glm::mat4 toGLM(const aiMatrix4x4& m)
+		{
+			return glm::mat4(
+				m.a1, m.b1, m.c1, m.d1,
+				m.a2, m.b2, m.c2, m.d2,
+				m.a3, m.b3, m.c3, m.d3,
+				m.a4, m.b4, m.c4, m.d4
+			);
+		}
+
+		glm::vec3 sampleSourcePosition(const aiNodeAnim* channel, float ticks)
+		{
+			if (channel->mNumPositionKeys == 1 || ticks <= channel->mPositionKeys[0].mTime)
+				return glm::vec3(channel->mPositionKeys[0].mValue.x, channel->mPositionKeys[0].mValue.y, channel->mPositionKeys[0].mValue.z);
+
+			for (uint32_t i = 0; i < channel->mNumPositionKeys - 1; i++)
+			{
+				const aiVectorKey& a = channel->mPositionKeys[i];
+				const aiVectorKey& b = channel->mPositionKeys[i + 1];
+				if (ticks < b.mTime)
+				{
+					float factor = static_cast<float>((ticks - a.mTime) / (b.mTime - a.mTime));
+					aiVector3D v = a.mValue + factor * (b.mValue - a.mValue);
+					return glm::vec3(v.x, v.y, v.z);
+				}
+			}
+
+			const aiVector3D& last = channel->mPositionKeys[channel->mNumPositionKeys - 1].mValue;
+			return glm::vec3(last.x, last.y, last.z);
+		}
+
+		glm::quat sampleSourceRotation(const aiNodeAnim* channel, float ticks)
+		{
+			aiQuaternion result = channel->mRotationKeys[0].mValue;
+
+			if (channel->mNumRotationKeys > 1 && ticks > channel->mRotationKeys[0].mTime)
+			{
+				result = channel->mRotationKeys[channel->mNumRotationKeys - 1].mValue;
+				for (uint32_t i = 0; i < channel->mNumRotationKeys - 1; i++)
+				{
+					const aiQuatKey& a = channel->mRotationKeys[i];
+					const aiQuatKey& b = channel->mRotationKeys[i + 1];
+					if (ticks < b.mTime)
+					{
+						float factor = static_cast<float>((ticks - a.mTime) / (b.mTime - a.mTime));
+						aiQuaternion::Interpolate(result, a.mValue, b.mValue, factor);
+						break;
+					}
+				}
+			}
+
+			result = result.Normalize();
+			return glm::quat(result.w, result.x, result.y, result.z);
+		}
+
+		QuantizedQuat quantize(glm::quat q)
+		{
+			float c[4] = { q.x, q.y, q.z, q.w };
+
+			uint32_t largest = 0;
+			for (uint32_t i = 1; i < 4; i++)
+				if (std::fabs(c[i]) > std::fabs(c[largest])) largest = i;
+
+			// q and -q are the same rotation, so the dropped component is always made positive
+			float sign = c[largest] < 0.f ? -1.f : 1.f;
+
+			QuantizedQuat result;
+			uint32_t out = 0;
+			for (uint32_t i = 0; i < 4; i++)
+			{
+				if (i == largest) continue;
+				float normalised = glm::clamp((c[i] * sign / s_quatRange) * 0.5f + 0.5f, 0.f, 1.f);
+				result.m_data[out++] = static_cast<uint16_t>(std::lround(normalised * 32767.f));
+			}
+
+			result.m_data[0] |= static_cast<uint16_t>((largest & 1) << 15);
+			result.m_data[1] |= static_cast<uint16_t>(((largest >> 1) & 1) << 15);
+			return result;
+		}
+
+		glm::quat dequantize(const QuantizedQuat& q)
+		{
+			uint32_t largest = ((q.m_data[0] >> 15) & 1) | (((q.m_data[1] >> 15) & 1) << 1);
+
+			float c[4];
+			float sum = 0.f;
+			uint32_t in = 0;
+			for (uint32_t i = 0; i < 4; i++)
+			{
+				if (i == largest) continue;
+				float value = (static_cast<float>(q.m_data[in++] & 0x7FFF) / 32767.f * 2.f - 1.f) * s_quatRange;
+				c[i] = value;
+				sum += value * value;
+			}
+			c[largest] = std::sqrt(std::max(0.f, 1.f - sum));
+
+			return glm::quat(c[3], c[0], c[1], c[2]);
+		}
+
+		QuantizedVec3 quantize(const glm::vec3& v, const glm::vec3& min, const glm::vec3& extent)
+		{
+			QuantizedVec3 result;
+			for (uint32_t i = 0; i < 3; i++)
+			{
+				float normalised = extent[i] > 0.f ? glm::clamp((v[i] - min[i]) / extent[i], 0.f, 1.f) : 0.f;
+				result.m_data[i] = static_cast<uint16_t>(std::lround(normalised * 65535.f));
+			}
+			return result;
+		}
+
+		glm::vec3 dequantize(const QuantizedVec3& v, const glm::vec3& min, const glm::vec3& extent)
+		{
+			return min + extent * glm::vec3(v.m_data[0], v.m_data[1], v.m_data[2]) * (1.f / 65535.f);
+		}
+
+		glm::quat nlerp(const glm::quat& a, const glm::quat& b, float t)
+		{
+			glm::quat end = glm::dot(a, b) < 0.f ? -b : b;
+			return glm::normalize(a * (1.f - t) + end * t);
+		}
+
+		float angleBetween(const glm::quat& a, const glm::quat& b)
+		{
+			float d = glm::clamp(std::fabs(glm::dot(a, b)), 0.f, 1.f);
+			return 2.f * std::acos(d);
+		}
+
+		/** Greedily extends each segment while every skipped sample stays within tolerance of the interpolated curve */
+		template<typename Sample, typename Interpolate, typename Error>
+		std::vector<uint32_t> reduceKeys(const std::vector<Sample>& decoded, const std::vector<Sample>& source, float tolerance, Interpolate interpolate, Error error)
+		{
+			std::vector<uint32_t> keep;
+			uint32_t count = static_cast<uint32_t>(source.size());
+			keep.push_back(0);
+			if (count == 1) return keep;
+
+			bool constant = true;
+			for (uint32_t i = 1; i < count && constant; i++)
+				constant = error(decoded[0], source[i]) <= tolerance;
+			if (constant) return keep;
+
+			uint32_t anchor = 0;
+			for (uint32_t candidate = 2; candidate < count; candidate++)
+			{
+				bool fits = true;
+				for (uint32_t k = anchor + 1; k < candidate && fits; k++)
+				{
+					float t = static_cast<float>(k - anchor) / static_cast<float>(candidate - anchor);
+					fits = error(interpolate(decoded[anchor], decoded[candidate], t), source[k]) <= tolerance;
+				}
+
+				if (!fits)
+				{
+					anchor = candidate - 1;
+					keep.push_back(anchor);
+				}
+			}
+
+			keep.push_back(count - 1);
+			return keep;
+		}
+
+		uint32_t findKey(const std::vector<uint16_t>& frames, float frame, float& factor)
+		{
+			if (frames.size() == 1 || frame <= frames.front())
+			{
+				factor = 0.f;
+				return 0;
+			}
+			if (frame >= frames.back())
+			{
+				factor = 0.f;
+				return static_cast<uint32_t>(frames.size() - 1);
+			}
+
+			auto next = std::upper_bound(frames.begin(), frames.end(), static_cast<uint16_t>(frame));
+			uint32_t index = static_cast<uint32_t>(next - frames.begin()) - 1;
+			factor = (frame - frames[index]) / static_cast<float>(frames[index + 1] - frames[index]);
+			return index;
+		}
+
+		void accumulateError(const aiNode* node, const CompressedClip& clip, const std::unordered_map<std::string, const aiNodeAnim*>& channels, float ticks,
+			const glm::mat4& sourceParent, const glm::mat4& clipParent, float& maxError, glm::vec3& jointMin, glm::vec3& jointMax)
+		{
+			std::string name(node->mName.data);
+			glm::mat4 bind = toGLM(node->mTransformation);
+			glm::mat4 sourceLocal = bind;
+			glm::mat4 clipLocal = bind;
+
+			auto channel = channels.find(name);
+			int32_t track = clip.findTrack(name);
+			if (channel != channels.end() && track >= 0)
+			{
+				sourceLocal *= glm::translate(glm::mat4(1.f), sampleSourcePosition(channel->second, ticks)) * glm::mat4(sampleSourceRotation(channel->second, ticks));
+
+				glm::vec3 translation;
+				glm::quat rotation;
+				clip.sample(track, ticks, translation, rotation);
+				clipLocal *= glm::translate(glm::mat4(1.f), translation) * glm::mat4(rotation);
+			}
+
+			glm::mat4 sourceGlobal = sourceParent * sourceLocal;
+			glm::mat4 clipGlobal = clipParent * clipLocal;
+
+			glm::vec3 sourcePosition(sourceGlobal[3]);
+			maxError = std::max(maxError, glm::length(sourcePosition - glm::vec3(clipGlobal[3])));
+			if (channel != channels.end() && track >= 0)
+			{
+				jointMin = glm::min(jointMin, sourcePosition);
+				jointMax = glm::max(jointMax, sourcePosition);
+			}
+
+			for (uint32_t i = 0; i < node->mNumChildren; i++)
+				accumulateError(node->mChildren[i], clip, channels, ticks, sourceGlobal, clipGlobal, maxError, jointMin, jointMax);
+		}
+	}
+
+	std::shared_ptr<CompressedClip> CompressedClip::compress(const aiAnimation* animation, const AnimationCompressionSettings& settings)
+	{
+		if (!animation || animation->mNumChannels == 0) return nullptr;
+
+		std::shared_ptr<CompressedClip> clip = std::make_shared<CompressedClip>();
+		clip->m_duration = static_cast<float>(animation->mDuration);
+		clip->m_ticksPerSecond = animation->mTicksPerSecond != 0.0 ? static_cast<float>(animation->mTicksPerSecond) : 25.f;
+
+		// Resample at the density of the most detailed source curve
+		uint32_t maxKeys = 1;
+		for (uint32_t i = 0; i < animation->mNumChannels; i++)
+		{
+			const aiNodeAnim* channel = animation->mChannels[i];
+			maxKeys = std::max({ maxKeys, channel->mNumPositionKeys, channel->mNumRotationKeys });
+			clip->m_sourceSize += channel->mNumPositionKeys * sizeof(aiVectorKey) + channel->mNumRotationKeys * sizeof(aiQuatKey) + channel->mNumScalingKeys * sizeof(aiVectorKey);
+		}
+		maxKeys = std::min(maxKeys, s_maxFrames);
+
+		clip->m_frameStep = (maxKeys > 1 && clip->m_duration > 0.f) ? clip->m_duration / static_cast<float>(maxKeys - 1) : 1.f;
+		clip->m_frameCount = maxKeys;
+
+		clip->m_tracks.resize(animation->mNumChannels);
+		clip->m_trackNames.resize(animation->mNumChannels);
+
+		std::vector<glm::vec3> sourcePositions(clip->m_frameCount), decodedPositions(clip->m_frameCount);
+		std::vector<glm::quat> sourceRotations(clip->m_frameCount), decodedRotations(clip->m_frameCount);
+		std::vector<QuantizedVec3> packedPositions(clip->m_frameCount);
+		std::vector<QuantizedQuat> packedRotations(clip->m_frameCount);
+
+		for (uint32_t i = 0; i < animation->mNumChannels; i++)
+		{
+			const aiNodeAnim* channel = animation->mChannels[i];
+			CompressedTrack& track = clip->m_tracks[i];
+			std::string name(channel->mNodeName.data);
+			clip->m_trackNames[i] = name;
+			clip->m_trackLookup[name] = i;
+
+			JointTolerance tolerance = settings.defaultTolerance;
+			auto jointTolerance = settings.jointTolerances.find(name);
+			if (jointTolerance != settings.jointTolerances.end()) tolerance = jointTolerance->second;
+
+			glm::vec3 min(std::numeric_limits<float>::max());
+			glm::vec3 max(-std::numeric_limits<float>::max());
+
+			for (uint32_t f = 0; f < clip->m_frameCount; f++)
+			{
+				float ticks = static_cast<float>(f) * clip->m_frameStep;
+				sourcePositions[f] = channel->mNumPositionKeys > 0 ? sampleSourcePosition(channel, ticks) : glm::vec3(0.f);
+				sourceRotations[f] = channel->mNumRotationKeys > 0 ? sampleSourceRotation(channel, ticks) : glm::quat(1.f, 0.f, 0.f, 0.f);
+				min = glm::min(min, sourcePositions[f]);
+				max = glm::max(max, sourcePositions[f]);
+			}
+
+			track.translationMin = min;
+			track.translationExtent = max - min;
+
+			// Quantize first so key reduction measures the error of what is actually stored
+			for (uint32_t f = 0; f < clip->m_frameCount; f++)
+			{
+				packedPositions[f] = quantize(sourcePositions[f], track.translationMin, track.translationExtent);
+				decodedPositions[f] = dequantize(packedPositions[f], track.translationMin, track.translationExtent);
+				packedRotations[f] = quantize(sourceRotations[f]);
+				decodedRotations[f] = dequantize(packedRotations[f]);
+			}
+
+			std::vector<uint32_t> positionKeys = reduceKeys(decodedPositions, sourcePositions, tolerance.translation,
+				[](const glm::vec3& a, const glm::vec3& b, float t) { return glm::mix(a, b, t); },
+				[](const glm::vec3& a, const glm::vec3& b) { return glm::length(a - b); });
+
+			std::vector<uint32_t> rotationKeys = reduceKeys(decodedRotations, sourceRotations, tolerance.rotation,
+				[](const glm::quat& a, const glm::quat& b, float t) { return nlerp(a, b, t); },
+				[](const glm::quat& a, const glm::quat& b) { return angleBetween(a, b); });
+
+			track.translationFrames.reserve(positionKeys.size());
+			track.translationKeys.reserve(positionKeys.size());
+			for (uint32_t key : positionKeys)
+			{
+				track.translationFrames.push_back(static_cast<uint16_t>(key));
+				track.translationKeys.push_back(packedPositions[key]);
+			}
+
+			track.rotationFrames.reserve(rotationKeys.size());
+			track.rotationKeys.reserve(rotationKeys.size());
+			for (uint32_t key : rotationKeys)
+			{
+				track.rotationFrames.push_back(static_cast<uint16_t>(key));
+				track.rotationKeys.push_back(packedRotations[key]);
+			}
+		}
+
+		return clip;
+	}
+
+	void CompressedClip::sample(uint32_t track, float ticks, glm::vec3& translation, glm::quat& rotation) const
+	{
+		const CompressedTrack& data = m_tracks[track];
+		float frame = ticks / m_frameStep;
+		float factor;
+
+		uint32_t index = findKey(data.translationFrames, frame, factor);
+		translation = dequantize(data.translationKeys[index], data.translationMin, data.translationExtent);
+		if (factor > 0.f)
+			translation = glm::mix(translation, dequantize(data.translationKeys[index + 1], data.translationMin, data.translationExtent), factor);
+
+		index = findKey(data.rotationFrames, frame, factor);
+		rotation = dequantize(data.rotationKeys[index]);
+		if (factor > 0.f)
+			rotation = nlerp(rotation, dequantize(data.rotationKeys[index + 1]), factor);
+	}
+
+	int32_t CompressedClip::findTrack(const std::string& nodeName) const
+	{
+		auto it = m_trackLookup.find(nodeName);
+		if (it == m_trackLookup.end()) return -1;
+		return static_cast<int32_t>(it->second);
+	}
+
+	float CompressedClip::measureMaxPositionalError(const aiScene* scene, const aiAnimation* animation, float& skeletonExtent) const
+	{
+		std::unordered_map<std::string, const aiNodeAnim*> channels;
+		for (uint32_t i = 0; i < animation->mNumChannels; i++)
+		{
+			const aiNodeAnim* channel = animation->mChannels[i];
+			if (channel->mNumPositionKeys > 0 && channel->mNumRotationKeys > 0)
+				channels[channel->mNodeName.data] = channel;
+		}
+
+		float maxError = 0.f;
+		skeletonExtent = 0.f;
+
+		// Test every resampled frame and the midpoint between frames. The extent is the animated joints' box within a frame,
+		// so neither where the clip was authored nor how far it travels loosens the bound
+		for (uint32_t f = 0; f < m_frameCount * 2; f++)
+		{
+			float ticks = static_cast<float>(f) * 0.5f * m_frameStep;
+			glm::vec3 jointMin(std::numeric_limits<float>::max());
+			glm::vec3 jointMax(-std::numeric_limits<float>::max());
+			accumulateError(scene->mRootNode, *this, channels, ticks, glm::mat4(1.f), glm::mat4(1.f), maxError, jointMin, jointMax);
+			if (jointMin.x <= jointMax.x)
+				skeletonExtent = std::max(skeletonExtent, glm::length(jointMax - jointMin));
+		}
+
+		return maxError;
+	}
+
+	void CompressedClip::releaseSourceKeys(aiAnimation* animation)
+	{
+		for (uint32_t i = 0; i < animation->mNumChannels; i++)
+		{
+			aiNodeAnim* channel = animation->mChannels[i];
+
+			delete[] channel->mPositionKeys;
+			channel->mPositionKeys = nullptr;
+			channel->mNumPositionKeys = 0;
+
+			delete[] channel->mRotationKeys;
+			channel->mRotationKeys = nullptr;
+			channel->mNumRotationKeys = 0;
+
+			delete[] channel->mScalingKeys;
+			channel->mScalingKeys = nullptr;
+			channel->mNumScalingKeys = 0;
+		}
+	}
+
+	size_t CompressedClip::getCompressedSize() const
+	{
+		size_t size = 0;
+		for (auto& track : m_tracks)
+		{
+			size += track.translationFrames.size() * sizeof(uint16_t) + track.translationKeys.size() * sizeof(QuantizedVec3);
+			size += track.rotationFrames.size() * sizeof(uint16_t) + track.rotationKeys.size() * sizeof(QuantizedQuat);
+			size += sizeof(glm::vec3) * 2;
+		}
+		return size;
+	}
+}
@@ -0,0 +1,67 @@
+/** \file animationLOD.cpp */
+
+#include "Ephyra_pch.h"
+
+#include "Core/Resources/Utility/AnimationLOD.h"
+
+#include <algorithm>
+#include <cctype>
+#include <cmath>
+
+namespace Engine
+{
+	namespace AnimationLOD
+	{
+		uint32_t selectLevel(const AnimationLODSettings& settings, const glm::mat4& viewProjection, const glm::mat4& model, float& screenSize, const AABB* localBounds)
+		{
+			float scale = std::max(glm::length(glm::vec3(model[0])), std::max(glm::length(glm::vec3(model[1])), glm::length(glm::vec3(model[2]))));
+			float radius = settings.boundingRadius * scale;
+			glm::vec3 center = glm::vec3(model[3]);
+
+			if (localBounds && localBounds->isValid())
+			{
+				radius = localBounds->getRadius() * scale;
+				center = glm::vec3(model * glm::vec4(localBounds->getCenter(), 1.f));
+			}
+
+			glm::vec4 clip = viewProjection * glm::vec4(center, 1.f);
+
+			// Inside the bounding sphere counts as full screen
+			if (clip.w <= radius)
+			{
+				screenSize = 1.f;
+				return clip.w < -radius ? offscreenLevel : 0;
+			}
+
+			// Projected radius as a fraction of the screen height, the second row carries the vertical focal length scaled by a unit view axis
+			float focalLength = glm::length(glm::vec3(viewProjection[0][1], viewProjection[1][1], viewProjection[2][1]));
+			float ndcRadius = radius * focalLength / clip.w;
+			screenSize = ndcRadius;
+
+			glm::vec3 ndc = glm::vec3(clip) / clip.w;
+			if (std::abs(ndc.x) > 1.f + ndcRadius || std::abs(ndc.y) > 1.f + ndcRadius || ndc.z > 1.f)
+				return offscreenLevel;
+
+			uint32_t level = 0;
+			while (level < 3 && screenSize < settings.screenSizes[level]) level++;
+			return level;
+		}
+
+		uint32_t updateInterval(const AnimationLODSettings& settings, uint32_t level)
+		{
+			if (level >= offscreenLevel) return std::max(1u, settings.offscreenInterval);
+			return std::max(1u, settings.updateIntervals[level]);
+		}
+
+		bool isMinorJoint(const AnimationLODSettings& settings, const std::string& jointName)
+		{
+			std::string name = jointName;
+			std::transform(name.begin(), name.end(), name.begin(), [](unsigned char c) { return static_cast<char>(std::tolower(c)); });
+
+			for (auto& token : settings.minorJointTokens)
+				if (name.find(token) != std::string::npos) return true;
+
+			return false;
+		}
+	}
+}
@@ -0,0 +1,338 @@
+/** \file dynamicBVH.cpp */
+
+#include "Ephyra_pch.h"
+
+#include "Core/Resources/Utility/DynamicBVH.h"
+
+#include <algorithm>
+
+namespace Engine
+{
+	namespace
+	{
+		AABB combine(const AABB& a, const AABB& b)
+		{
+			AABB result = a;
+			result.expand(b);
+			return result;
+		}
+	}
+
+	DynamicBVH::Proxy DynamicBVH::create(const AABB& bounds, uint32_t userData)
+	{
+		int32_t leaf = allocateNode();
+		Node& node = m_nodes[leaf];
+		node.bounds = bounds;
+		node.fat = AABB(bounds.min - glm::vec3(m_margin), bounds.max + glm::vec3(m_margin));
+		node.userData = userData;
+		node.height = 0;
+
+		insertLeaf(leaf);
+		m_proxyCount++;
+		return leaf;
+	}
+
+	void DynamicBVH::destroy(Proxy proxy)
+	{
+		if (!isValid(proxy)) return;
+
+		removeLeaf(proxy);
+		freeNode(proxy);
+		m_proxyCount--;
+	}
+
+	bool DynamicBVH::move(Proxy proxy, const AABB& bounds, const glm::vec3& displacement)
+	{
+		if (!isValid(proxy)) return false;
+
+		Node& node = m_nodes[proxy];
+		node.bounds = bounds;
+		if (node.fat.contains(bounds)) return false;
+
+		// Stretch the new fat box along the motion so a steadily moving object escapes less often
+		AABB fat(bounds.min - glm::vec3(m_margin), bounds.max + glm::vec3(m_margin));
+		glm::vec3 predicted = displacement * 2.f;
+		fat.min += glm::min(predicted, glm::vec3(0.f));
+		fat.max += glm::max(predicted, glm::vec3(0.f));
+
+		removeLeaf(proxy);
+		m_nodes[proxy].fat = fat;
+		insertLeaf(proxy);
+		return true;
+	}
+
+	void DynamicBVH::clear()
+	{
+		m_nodes.clear();
+		m_root = null;
+		m_freeList = null;
+		m_proxyCount = 0;
+	}
+
+	void DynamicBVH::queryFrustum(const Frustum& frustum, std::vector<uint32_t>& userData) const
+	{
+		if (m_root == null) return;
+
+		// Subtrees entirely inside the frustum are collected without further plane tests
+		std::vector<std::pair<int32_t, bool>> stack;
+		stack.reserve(64);
+		stack.push_back({ m_root, false });
+		while (!stack.empty())
+		{
+			auto [index, inside] = stack.back();
+			stack.pop_back();
+			const Node& node = m_nodes[index];
+
+			if (!inside)
+			{
+				Frustum::Result result = frustum.classify(node.isLeaf() ? node.bounds : node.fat);
+				if (result == Frustum::Result::Outside) continue;
+				inside = result == Frustum::Result::Inside;
+			}
+
+			if (node.isLeaf())
+				userData.push_back(node.userData);
+			else
+			{
+				stack.push_back({ node.child1, inside });
+				stack.push_back({ node.child2, inside });
+			}
+		}
+	}
+
+	void DynamicBVH::querySphere(const glm::vec3& center, float radius, std::vector<uint32_t>& userData) const
+	{
+		if (m_root == null) return;
+
+		std::vector<int32_t> stack;
+		stack.reserve(64);
+		stack.push_back(m_root);
+		while (!stack.empty())
+		{
+			const Node& node = m_nodes[stack.back()];
+			stack.pop_back();
+
+			if (!(node.isLeaf() ? node.bounds : node.fat).intersectSphere(center, radius)) continue;
+
+			if (node.isLeaf())
+				userData.push_back(node.userData);
+			else
+			{
+				stack.push_back(node.child1);
+				stack.push_back(node.child2);
+			}
+		}
+	}
+
+	bool DynamicBVH::raycast(const glm::vec3& origin, const glm::vec3& direction, float maxDistance, uint32_t& userData, float& distance) const
+	{
+		if (m_root == null) return false;
+
+		glm::vec3 inverseDirection = 1.f / direction;
+		float nearest = maxDistance;
+		bool hit = false;
+
+		// Nearer child is visited first so the best hit so far prunes the farther one
+		std::vector<std::pair<int32_t, float>> stack;
+		stack.reserve(64);
+		float entry;
+		if (!m_nodes[m_root].fat.intersectRay(origin, inverseDirection, nearest, entry)) return false;
+		stack.push_back({ m_root, entry });
+
+		while (!stack.empty())
+		{
+			auto [index, nodeEntry] = stack.back();
+			stack.pop_back();
+			if (nodeEntry > nearest) continue;
+
+			const Node& node = m_nodes[index];
+			if (node.isLeaf())
+			{
+				if (node.bounds.intersectRay(origin, inverseDirection, nearest, entry))
+				{
+					nearest = entry;
+					userData = node.userData;
+					hit = true;
+				}
+				continue;
+			}
+
+			float entry1, entry2;
+			bool hit1 = m_nodes[node.child1].fat.intersectRay(origin, inverseDirection, nearest, entry1);
+			bool hit2 = m_nodes[node.child2].fat.intersectRay(origin, inverseDirection, nearest, entry2);
+
+			if (hit1 && hit2)
+			{
+				if (entry1 < entry2)
+				{
+					stack.push_back({ node.child2, entry2 });
+					stack.push_back({ node.child1, entry1 });
+				}
+				else
+				{
+					stack.push_back({ node.child1, entry1 });
+					stack.push_back({ node.child2, entry2 });
+				}
+			}
+			else if (hit1) stack.push_back({ node.child1, entry1 });
+			else if (hit2) stack.push_back({ node.child2, entry2 });
+		}
+
+		if (hit) distance = nearest;
+		return hit;
+	}
+
+	int32_t DynamicBVH::allocateNode()
+	{
+		if (m_freeList == null)
+		{
+			m_nodes.emplace_back();
+			return static_cast<int32_t>(m_nodes.size()) - 1;
+		}
+
+		int32_t node = m_freeList;
+		m_freeList = m_nodes[node].parent;
+		m_nodes[node] = Node();
+		return node;
+	}
+
+	void DynamicBVH::freeNode(int32_t node)
+	{
+		m_nodes[node] = Node();
+		m_nodes[node].parent = m_freeList;
+		m_freeList = node;
+	}
+
+	void DynamicBVH::insertLeaf(int32_t leaf)
+	{
+		if (m_root == null)
+		{
+			m_root = leaf;
+			m_nodes[leaf].parent = null;
+			return;
+		}
+
+		// Descend while pushing the leaf further down is cheaper than pairing it with the current node
+		AABB leafBounds = m_nodes[leaf].fat;
+		int32_t index = m_root;
+		while (!m_nodes[index].isLeaf())
+		{
+			const Node& node = m_nodes[index];
+			float area = node.fat.getSurfaceArea();
+			float combinedArea = combine(node.fat, leafBounds).getSurfaceArea();
+
+			float cost = 2.f * combinedArea;
+			float inheritance = 2.f * (combinedArea - area);
+
+			auto childCost = [&](int32_t child) {
+				const Node& c = m_nodes[child];
+				float grown = combine(leafBounds, c.fat).getSurfaceArea();
+				return (c.isLeaf() ? grown : grown - c.fat.getSurfaceArea()) + inheritance;
+			};
+			float cost1 = childCost(node.child1);
+			float cost2 = childCost(node.child2);
+
+			if (cost < cost1 && cost < cost2) break;
+			index = cost1 < cost2 ? node.child1 : node.child2;
+		}
+
+		int32_t sibling = index;
+		int32_t oldParent = m_nodes[sibling].parent;
+		int32_t newParent = allocateNode();
+
+		m_nodes[newParent].parent = oldParent;
+		m_nodes[newParent].fat = combine(leafBounds, m_nodes[sibling].fat);
+		m_nodes[newParent].height = m_nodes[sibling].height + 1;
+		m_nodes[newParent].child1 = sibling;
+		m_nodes[newParent].child2 = leaf;
+		m_nodes[sibling].parent = newParent;
+		m_nodes[leaf].parent = newParent;
+
+		if (oldParent == null) m_root = newParent;
+		else if (m_nodes[oldParent].child1 == sibling) m_nodes[oldParent].child1 = newParent;
+		else m_nodes[oldParent].child2 = newParent;
+
+		for (index = m_nodes[leaf].parent; index != null; index = m_nodes[index].parent)
+		{
+			index = balance(index);
+			refit(index);
+		}
+	}
+
+	void DynamicBVH::removeLeaf(int32_t leaf)
+	{
+		if (leaf == m_root)
+		{
+			m_root = null;
+			return;
+		}
+
+		int32_t parent = m_nodes[leaf].parent;
+		int32_t grandParent = m_nodes[parent].parent;
+		int32_t sibling = m_nodes[parent].child1 == leaf ? m_nodes[parent].child2 : m_nodes[parent].child1;
+
+		freeNode(parent);
+		m_nodes[sibling].parent = grandParent;
+		m_nodes[leaf].parent = null;
+
+		if (grandParent == null)
+		{
+			m_root = sibling;
+			return;
+		}
+
+		if (m_nodes[grandParent].child1 == parent) m_nodes[grandParent].child1 = sibling;
+		else m_nodes[grandParent].child2 = sibling;
+
+		for (int32_t index = grandParent; index != null; index = m_nodes[index].parent)
+		{
+			index = balance(index);
+			refit(index);
+		}
+	}
+
+	int32_t DynamicBVH::balance(int32_t a)
+	{
+		if (m_nodes[a].isLeaf() || m_nodes[a].height < 2) return a;
+
+		int32_t b = m_nodes[a].child1;
+		int32_t c = m_nodes[a].child2;
+		int32_t difference = m_nodes[c].height - m_nodes[b].height;
+		if (difference >= -1 && difference <= 1) return a;
+
+		// Promote the taller child, its shorter grandchild takes the promoted node's old slot under a
+		int32_t up = difference > 1 ? c : b;
+		int32_t f = m_nodes[up].child1;
+		int32_t g = m_nodes[up].child2;
+
+		m_nodes[up].child1 = a;
+		m_nodes[up].parent = m_nodes[a].parent;
+		m_nodes[a].parent = up;
+
+		int32_t upParent = m_nodes[up].parent;
+		if (upParent == null) m_root = up;
+		else if (m_nodes[upParent].child1 == a) m_nodes[upParent].child1 = up;
+		else m_nodes[upParent].child2 = up;
+
+		int32_t taller = m_nodes[f].height > m_nodes[g].height ? f : g;
+		int32_t shorter = taller == f ? g : f;
+
+		m_nodes[up].child2 = taller;
+		if (up == c) m_nodes[a].child2 = shorter;
+		else m_nodes[a].child1 = shorter;
+		m_nodes[shorter].parent = a;
+
+		refit(a);
+		refit(up);
+		return up;
+	}
+
+	void DynamicBVH::refit(int32_t index)
+	{
+		Node& node = m_nodes[index];
+		const Node& child1 = m_nodes[node.child1];
+		const Node& child2 = m_nodes[node.child2];
+		node.height = 1 + std::max(child1.height, child2.height);
+		node.fat = combine(child1.fat, child2.fat);
+	}
+}
@@ -0,0 +1,165 @@
+/** \file meshlets.cpp */
+
+#include "Ephyra_pch.h"
+
+#include "Core/Resources/Utility/Meshlets.h"
+
+#include <algorithm>
+#include <cmath>
+
+namespace Engine
+{
+	namespace Meshlets
+	{
+		namespace
+		{
+			//! Sphere, normal cone and counts for the triangles in output from the meshlet's first index
+			void computeBounds(Meshlet& meshlet, const std::vector<glm::vec3>& positions, const std::vector<uint32_t>& output, const std::vector<uint32_t>& vertices)
+			{
+				AABB box;
+				for (uint32_t vertex : vertices)
+					box.expand(positions[vertex]);
+
+				meshlet.center = box.getCenter();
+				meshlet.radius = 0.f;
+				for (uint32_t vertex : vertices)
+					meshlet.radius = std::max(meshlet.radius, glm::length(positions[vertex] - meshlet.center));
+
+				std::vector<glm::vec3> normals;
+				normals.reserve(meshlet.triangleCount);
+				glm::vec3 sum(0.f);
+				for (uint32_t i = 0; i < meshlet.triangleCount; i++)
+				{
+					const uint32_t* triangle = &output[meshlet.firstIndex + i * 3];
+					glm::vec3 normal = glm::cross(positions[triangle[1]] - positions[triangle[0]], positions[triangle[2]] - positions[triangle[0]]);
+					float length = glm::length(normal);
+					if (length <= 0.f) continue;
+
+					normals.push_back(normal / length);
+					sum += normals.back();
+				}
+
+				meshlet.vertexCount = static_cast<uint32_t>(vertices.size());
+				meshlet.coneAxis = glm::vec3(0.f);
+				meshlet.coneCutoff = 1.f;
+
+				float sumLength = glm::length(sum);
+				if (normals.empty() || sumLength <= 0.f) return;
+
+				meshlet.coneAxis = sum / sumLength;
+				float minimumDot = 1.f;
+				for (auto& normal : normals)
+					minimumDot = std::min(minimumDot, glm::dot(normal, meshlet.coneAxis));
+
+				// Cones wider than about 84 degrees almost never pass the test, leave them uncullable
+				if (minimumDot > 0.1f)
+					meshlet.coneCutoff = std::sqrt(1.f - minimumDot * minimumDot);
+			}
+		}
+
+		void build(const std::vector<glm::vec3>& positions, std::vector<uint32_t>& indices, std::vector<Meshlet>& meshlets)
+		{
+			meshlets.clear();
+
+			uint32_t vertexCount = static_cast<uint32_t>(positions.size());
+			uint32_t triangleCount = static_cast<uint32_t>(indices.size() / 3);
+			if (triangleCount == 0) return;
+
+			// Triangles using each vertex, packed so the triangles of vertex v are at offsets[v] to offsets[v + 1]
+			std::vector<uint32_t> offsets(vertexCount + 1, 0);
+			for (uint32_t i = 0; i < triangleCount * 3; i++)
+				offsets[indices[i] + 1]++;
+			for (uint32_t v = 0; v < vertexCount; v++)
+				offsets[v + 1] += offsets[v];
+
+			std::vector<uint32_t> adjacency(triangleCount * 3);
+			std::vector<uint32_t> cursor(offsets.begin(), offsets.end() - 1);
+			for (uint32_t i = 0; i < triangleCount * 3; i++)
+				adjacency[cursor[indices[i]]++] = i / 3;
+
+			std::vector<uint8_t> emitted(triangleCount, 0);
+			std::vector<uint32_t> owner(vertexCount, UINT32_MAX); // Cluster each vertex was last added to
+			std::vector<uint32_t> output;
+			output.reserve(triangleCount * 3);
+			std::vector<uint32_t> vertices, candidates;
+
+			uint32_t seed = 0;
+			while (true)
+			{
+				while (seed < triangleCount && emitted[seed]) seed++;
+				if (seed == triangleCount) break;
+
+				uint32_t id = static_cast<uint32_t>(meshlets.size());
+				Meshlet meshlet;
+				meshlet.firstIndex = static_cast<uint32_t>(output.size());
+				vertices.clear();
+				candidates.assign(1, seed);
+
+				// Grow from the seed, always taking the neighbour that adds the fewest new vertices
+				while (meshlet.triangleCount < maxTriangles)
+				{
+					int32_t best = -1;
+					uint32_t bestNew = 4;
+					for (uint32_t c = 0; c < candidates.size();)
+					{
+						uint32_t triangle = candidates[c];
+						if (emitted[triangle])
+						{
+							candidates[c] = candidates.back();
+							candidates.pop_back();
+							continue;
+						}
+
+						uint32_t added = 0;
+						for (uint32_t k = 0; k < 3; k++)
+							if (owner[indices[triangle * 3 + k]] != id) added++;
+						if (added < bestNew) { best = static_cast<int32_t>(c); bestNew = added; }
+						c++;
+					}
+
+					// Nothing connected is left or the best neighbour would overflow the vertex limit
+					if (best < 0 || vertices.size() + bestNew > maxVertices) break;
+
+					uint32_t triangle = candidates[best];
+					candidates[best] = candidates.back();
+					candidates.pop_back();
+
+					emitted[triangle] = 1;
+					meshlet.triangleCount++;
+					for (uint32_t k = 0; k < 3; k++)
+					{
+						uint32_t vertex = indices[triangle * 3 + k];
+						output.push_back(vertex);
+						if (owner[vertex] == id) continue;
+
+						owner[vertex] = id;
+						vertices.push_back(vertex);
+						for (uint32_t a = offsets[vertex]; a < offsets[vertex + 1]; a++)
+							if (!emitted[adjacency[a]]) candidates.push_back(adjacency[a]);
+					}
+				}
+
+				computeBounds(meshlet, positions, output, vertices);
+				meshlets.push_back(meshlet);
+			}
+
+			indices.swap(output);
+		}
+
+		Result classify(const Meshlet& meshlet, const Frustum& frustum, const glm::vec3& camera, bool coneCulling)
+		{
+			for (auto& plane : frustum.planes)
+				if (glm::dot(glm::vec3(plane), meshlet.center) + plane.w < -meshlet.radius) return Result::Outside;
+
+			if (!coneCulling || meshlet.coneCutoff >= 1.f) return Result::Visible;
+
+			// Every point of the sphere must see every triangle from behind, so the sphere widens the cone on both sides
+			glm::vec3 view = meshlet.center - camera;
+			float distance = glm::length(view);
+			if (glm::dot(view, meshlet.coneAxis) >= meshlet.coneCutoff * distance + meshlet.radius * (1.f + meshlet.coneCutoff))
+				return Result::BackFacing;
+
+			return Result::Visible;
+		}
+	}
+}
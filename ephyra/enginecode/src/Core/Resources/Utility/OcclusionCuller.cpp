@@ -0,0 +1,343 @@
+/** \file occlusionCuller.cpp */
+
+#include "Ephyra_pch.h"
+
+#include "Core/Resources/Utility/OcclusionCuller.h"
+#include "Core/Systems/Utility/JobSystem.h"
+#include "Core/Systems/Utility/Timer.h"
+
+#include <algorithm>
+#include <cmath>
+
+#if defined(__SSE2__) || defined(_M_X64) || (defined(_M_IX86_FP) && _M_IX86_FP >= 2)
+#define EPHYRA_OCCLUSION_SSE
+#include <emmintrin.h>
+#endif
+
+namespace Engine
+{
+	namespace
+	{
+		uint32_t roundToTiles(uint32_t size)
+		{
+			size = std::max(size, OcclusionCuller::tileSize);
+			return (size + OcclusionCuller::tileSize - 1) / OcclusionCuller::tileSize * OcclusionCuller::tileSize;
+		}
+
+		// Runs work(0 .. count - 1) as one job per index, index 0 on the calling thread
+		template<typename Work>
+		void runParallel(uint32_t count, Work&& work)
+		{
+			JobSystem::parallelFor(count, 1, [&work](uint32_t first, uint32_t last) {
+				for (uint32_t i = first; i < last; i++)
+					work(i);
+			});
+		}
+	}
+
+	OcclusionCuller::OcclusionCuller(uint32_t width, uint32_t height)
+	{
+		resize(width, height);
+	}
+
+	void OcclusionCuller::resize(uint32_t width, uint32_t height)
+	{
+		m_width = roundToTiles(width);
+		m_height = roundToTiles(height);
+		m_depth.assign(m_width * m_height, 1.f);
+		m_tileMax.assign((m_width / tileSize) * (m_height / tileSize), 1.f);
+	}
+
+	void OcclusionCuller::setThreadCount(uint32_t threads)
+	{
+		m_threads = threads;
+	}
+
+	uint32_t OcclusionCuller::getThreadCount() const
+	{
+		uint32_t threads = m_threads ? m_threads : JobSystem::getThreadCount();
+		return std::max(1u, std::min(std::min(threads, 8u), m_height / tileSize));
+	}
+
+	void OcclusionCuller::begin(const glm::mat4& viewProjection)
+	{
+		m_viewProjection = viewProjection;
+		m_occluders.clear();
+		m_stats.reset();
+	}
+
+	void OcclusionCuller::addOccluder(const OccluderMesh& mesh, const glm::mat4& model)
+	{
+		m_occluders.push_back({ &mesh, m_viewProjection * model });
+		m_stats.occluders++;
+	}
+
+	void OcclusionCuller::rasterize()
+	{
+		ChronoTimer timer;
+		timer.start();
+
+		uint32_t threads = getThreadCount();
+		uint32_t occluderCount = static_cast<uint32_t>(m_occluders.size());
+		m_triangles.resize(threads);
+
+		runParallel(threads, [&](uint32_t thread) {
+			m_triangles[thread].clear();
+			setupTriangles(occluderCount * thread / threads, occluderCount * (thread + 1) / threads, m_triangles[thread]);
+		});
+
+		// Bands are whole tile rows so each thread also owns the tiles it builds
+		uint32_t tileRows = m_height / tileSize;
+		runParallel(threads, [&](uint32_t thread) {
+			rasterizeBand(tileRows * thread / threads * tileSize, tileRows * (thread + 1) / threads * tileSize);
+		});
+
+		m_stats.triangles = 0;
+		for (auto& triangles : m_triangles)
+			m_stats.triangles += static_cast<uint32_t>(triangles.size());
+		m_stats.rasterTime += timer.getElapsedTime();
+	}
+
+	void OcclusionCuller::setupTriangles(uint32_t first, uint32_t last, std::vector<Triangle>& triangles) const
+	{
+		std::vector<glm::vec4> clip;
+		float width = static_cast<float>(m_width);
+		float height = static_cast<float>(m_height);
+
+		for (uint32_t o = first; o < last; o++)
+		{
+			auto& occluder = m_occluders[o];
+			auto& positions = occluder.mesh->positions;
+			auto& indices = occluder.mesh->indices;
+
+			clip.resize(positions.size());
+			for (size_t i = 0; i < positions.size(); i++)
+				clip[i] = occluder.modelViewProjection * glm::vec4(positions[i], 1.f);
+
+			for (size_t i = 0; i + 2 < indices.size(); i += 3)
+			{
+				const glm::vec4 corners[3] = { clip[indices[i]], clip[indices[i + 1]], clip[indices[i + 2]] };
+
+				// Skip triangles entirely beyond one side of the view volume
+				bool outside = false;
+				for (int axis = 0; axis < 2 && !outside; axis++)
+				{
+					outside = (corners[0][axis] > corners[0].w && corners[1][axis] > corners[1].w && corners[2][axis] > corners[2].w) ||
+						(corners[0][axis] < -corners[0].w && corners[1][axis] < -corners[1].w && corners[2][axis] < -corners[2].w);
+				}
+				if (outside) continue;
+
+				// Clip against the near plane, a triangle becomes at most a quad
+				glm::vec4 polygon[4];
+				uint32_t count = 0;
+				for (int v = 0; v < 3; v++)
+				{
+					const glm::vec4& a = corners[v];
+					const glm::vec4& b = corners[(v + 1) % 3];
+					float da = a.z + a.w;
+					float db = b.z + b.w;
+					if (da >= 0.f) polygon[count++] = a;
+					if ((da >= 0.f) != (db >= 0.f)) polygon[count++] = a + (b - a) * (da / (da - db));
+				}
+				if (count < 3) continue;
+
+				glm::vec3 screen[4];
+				for (uint32_t v = 0; v < count; v++)
+				{
+					glm::vec3 ndc = glm::vec3(polygon[v]) / polygon[v].w;
+					screen[v] = glm::vec3((ndc.x * 0.5f + 0.5f) * width, (ndc.y * 0.5f + 0.5f) * height, ndc.z * 0.5f + 0.5f);
+				}
+
+				for (uint32_t v = 1; v + 1 < count; v++)
+				{
+					Triangle triangle = { { screen[0], screen[v], screen[v + 1] } };
+					float area = (triangle.v[1].x - triangle.v[0].x) * (triangle.v[2].y - triangle.v[0].y) - (triangle.v[1].y - triangle.v[0].y) * (triangle.v[2].x - triangle.v[0].x);
+					if (std::abs(area) < 1e-6f) continue;
+
+					// Either winding occludes, a wall seen from behind still hides what is past it
+					if (area < 0.f) std::swap(triangle.v[1], triangle.v[2]);
+					triangles.push_back(triangle);
+				}
+			}
+		}
+	}
+
+	void OcclusionCuller::rasterizeBand(uint32_t firstRow, uint32_t lastRow)
+	{
+		if (firstRow >= lastRow) return;
+
+		std::fill(m_depth.begin() + firstRow * m_width, m_depth.begin() + lastRow * m_width, 1.f);
+
+		for (auto& triangles : m_triangles)
+			for (auto& triangle : triangles)
+				rasterizeTriangle(triangle, firstRow, lastRow);
+
+		uint32_t tilesX = m_width / tileSize;
+		for (uint32_t tileY = firstRow / tileSize; tileY < lastRow / tileSize; tileY++)
+		{
+			for (uint32_t tileX = 0; tileX < tilesX; tileX++)
+			{
+				const float* tile = &m_depth[tileY * tileSize * m_width + tileX * tileSize];
+#ifdef EPHYRA_OCCLUSION_SSE
+				__m128 farthest = _mm_setzero_ps();
+				for (uint32_t row = 0; row < tileSize; row++)
+				{
+					const float* pixels = tile + row * m_width;
+					farthest = _mm_max_ps(farthest, _mm_max_ps(_mm_loadu_ps(pixels), _mm_loadu_ps(pixels + 4)));
+				}
+				farthest = _mm_max_ps(farthest, _mm_shuffle_ps(farthest, farthest, _MM_SHUFFLE(1, 0, 3, 2)));
+				farthest = _mm_max_ps(farthest, _mm_shuffle_ps(farthest, farthest, _MM_SHUFFLE(2, 3, 0, 1)));
+				m_tileMax[tileY * tilesX + tileX] = _mm_cvtss_f32(farthest);
+#else
+				float farthest = 0.f;
+				for (uint32_t row = 0; row < tileSize; row++)
+					for (uint32_t column = 0; column < tileSize; column++)
+						farthest = std::max(farthest, tile[row * m_width + column]);
+				m_tileMax[tileY * tilesX + tileX] = farthest;
+#endif
+			}
+		}
+	}
+
+	void OcclusionCuller::rasterizeTriangle(const Triangle& triangle, uint32_t firstRow, uint32_t lastRow)
+	{
+		const glm::vec3& v0 = triangle.v[0];
+		const glm::vec3& v1 = triangle.v[1];
+		const glm::vec3& v2 = triangle.v[2];
+
+		int32_t minX = std::max(0, static_cast<int32_t>(std::floor(std::min(v0.x, std::min(v1.x, v2.x)))));
+		int32_t maxX = std::min(static_cast<int32_t>(m_width) - 1, static_cast<int32_t>(std::ceil(std::max(v0.x, std::max(v1.x, v2.x)))));
+		int32_t minY = std::max(static_cast<int32_t>(firstRow), static_cast<int32_t>(std::floor(std::min(v0.y, std::min(v1.y, v2.y)))));
+		int32_t maxY = std::min(static_cast<int32_t>(lastRow) - 1, static_cast<int32_t>(std::ceil(std::max(v0.y, std::max(v1.y, v2.y)))));
+		if (minX > maxX || minY > maxY) return;
+
+		// Edge functions are positive inside a counter clockwise triangle, each one weights the opposite vertex
+		float a0 = v1.y - v2.y, b0 = v2.x - v1.x, c0 = v1.x * v2.y - v1.y * v2.x;
+		float a1 = v2.y - v0.y, b1 = v0.x - v2.x, c1 = v2.x * v0.y - v2.y * v0.x;
+		float a2 = v0.y - v1.y, b2 = v1.x - v0.x, c2 = v0.x * v1.y - v0.y * v1.x;
+		float area = a2 * v2.x + b2 * v2.y + c2;
+		if (area <= 0.f) return;
+
+		// Depth is linear in screen space, so it is a plane over the pixels
+		float za = (a0 * v0.z + a1 * v1.z + a2 * v2.z) / area;
+		float zb = (b0 * v0.z + b1 * v1.z + b2 * v2.z) / area;
+		float zc = (c0 * v0.z + c1 * v1.z + c2 * v2.z) / area;
+
+		int32_t startX = minX & ~3;
+
+#ifdef EPHYRA_OCCLUSION_SSE
+		const __m128 offsets = _mm_setr_ps(0.5f, 1.5f, 2.5f, 3.5f);
+		const __m128 zero = _mm_setzero_ps();
+		const __m128 edgeA0 = _mm_set1_ps(a0), edgeA1 = _mm_set1_ps(a1), edgeA2 = _mm_set1_ps(a2), depthA = _mm_set1_ps(za);
+
+		for (int32_t y = minY; y <= maxY; y++)
+		{
+			float py = y + 0.5f;
+			__m128 row0 = _mm_set1_ps(b0 * py + c0);
+			__m128 row1 = _mm_set1_ps(b1 * py + c1);
+			__m128 row2 = _mm_set1_ps(b2 * py + c2);
+			__m128 rowZ = _mm_set1_ps(zb * py + zc);
+			float* depth = &m_depth[y * m_width];
+
+			for (int32_t x = startX; x <= maxX; x += 4)
+			{
+				__m128 px = _mm_add_ps(_mm_set1_ps(static_cast<float>(x)), offsets);
+				__m128 e0 = _mm_add_ps(_mm_mul_ps(edgeA0, px), row0);
+				__m128 e1 = _mm_add_ps(_mm_mul_ps(edgeA1, px), row1);
+				__m128 e2 = _mm_add_ps(_mm_mul_ps(edgeA2, px), row2);
+				__m128 inside = _mm_and_ps(_mm_cmpge_ps(e0, zero), _mm_and_ps(_mm_cmpge_ps(e1, zero), _mm_cmpge_ps(e2, zero)));
+				if (_mm_movemask_ps(inside) == 0) continue;
+
+				__m128 z = _mm_add_ps(_mm_mul_ps(depthA, px), rowZ);
+				__m128 previous = _mm_loadu_ps(depth + x);
+				__m128 nearest = _mm_min_ps(previous, z);
+				_mm_storeu_ps(depth + x, _mm_or_ps(_mm_and_ps(inside, nearest), _mm_andnot_ps(inside, previous)));
+			}
+		}
+#else
+		for (int32_t y = minY; y <= maxY; y++)
+		{
+			float py = y + 0.5f;
+			float* depth = &m_depth[y * m_width];
+			for (int32_t x = startX; x <= maxX; x++)
+			{
+				float px = x + 0.5f;
+				if (a0 * px + b0 * py + c0 < 0.f || a1 * px + b1 * py + c1 < 0.f || a2 * px + b2 * py + c2 < 0.f) continue;
+				depth[x] = std::min(depth[x], za * px + zb * py + zc);
+			}
+		}
+#endif
+	}
+
+	bool OcclusionCuller::isVisible(const AABB& bounds) const
+	{
+		if (!bounds.isValid()) return true;
+
+		float minX = FLT_MAX, minY = FLT_MAX, maxX = -FLT_MAX, maxY = -FLT_MAX, nearest = FLT_MAX;
+		for (int corner = 0; corner < 8; corner++)
+		{
+			glm::vec3 point((corner & 1) ? bounds.max.x : bounds.min.x, (corner & 2) ? bounds.max.y : bounds.min.y, (corner & 4) ? bounds.max.z : bounds.min.z);
+			glm::vec4 clip = m_viewProjection * glm::vec4(point, 1.f);
+
+			// Boxes crossing the near plane are too close to judge
+			if (clip.z < -clip.w || clip.w <= 0.f) return true;
+
+			glm::vec3 ndc = glm::vec3(clip) / clip.w;
+			float x = (ndc.x * 0.5f + 0.5f) * m_width;
+			float y = (ndc.y * 0.5f + 0.5f) * m_height;
+			minX = std::min(minX, x); maxX = std::max(maxX, x);
+			minY = std::min(minY, y); maxY = std::max(maxY, y);
+			nearest = std::min(nearest, ndc.z * 0.5f + 0.5f);
+		}
+
+		// Faces of an occluder lie on its own bounds, rounding in the rasterizer must not let them hide it
+		nearest -= depthBias;
+
+		int32_t x0 = std::max(0, static_cast<int32_t>(std::floor(minX)));
+		int32_t x1 = std::min(static_cast<int32_t>(m_width) - 1, static_cast<int32_t>(std::floor(maxX)));
+		int32_t y0 = std::max(0, static_cast<int32_t>(std::floor(minY)));
+		int32_t y1 = std::min(static_cast<int32_t>(m_height) - 1, static_cast<int32_t>(std::floor(maxY)));
+
+		// Off screen is for the frustum test to decide
+		if (x0 > x1 || y0 > y1) return true;
+
+		uint32_t tilesX = m_width / tileSize;
+		for (int32_t tileY = y0 / tileSize; tileY <= y1 / static_cast<int32_t>(tileSize); tileY++)
+		{
+			for (int32_t tileX = x0 / tileSize; tileX <= x1 / static_cast<int32_t>(tileSize); tileX++)
+			{
+				// Every pixel of the tile is nearer than the box
+				if (m_tileMax[tileY * tilesX + tileX] < nearest) continue;
+
+				int32_t rowEnd = std::min(y1, tileY * static_cast<int32_t>(tileSize) + static_cast<int32_t>(tileSize) - 1);
+				int32_t columnEnd = std::min(x1, tileX * static_cast<int32_t>(tileSize) + static_cast<int32_t>(tileSize) - 1);
+				for (int32_t y = std::max(y0, tileY * static_cast<int32_t>(tileSize)); y <= rowEnd; y++)
+					for (int32_t x = std::max(x0, tileX * static_cast<int32_t>(tileSize)); x <= columnEnd; x++)
+						if (m_depth[y * m_width + x] >= nearest) return true;
+			}
+		}
+
+		return false;
+	}
+
+	void OcclusionCuller::testVisibility(const std::vector<AABB>& bounds, std::vector<uint8_t>& visible)
+	{
+		ChronoTimer timer;
+		timer.start();
+
+		uint32_t count = static_cast<uint32_t>(bounds.size());
+		visible.resize(count);
+
+		// Small sets are not worth a thread each
+		uint32_t threads = std::min(getThreadCount(), std::max(1u, count / 256));
+		runParallel(threads, [&](uint32_t thread) {
+			for (uint32_t i = count * thread / threads; i < count * (thread + 1) / threads; i++)
+				visible[i] = isVisible(bounds[i]) ? 1 : 0;
+		});
+
+		m_stats.tested += count;
+		for (auto v : visible)
+			if (!v) m_stats.culled++;
+		m_stats.testTime += timer.getElapsedTime();
+	}
+}
@@ -0,0 +1,208 @@
+/** \file staticBatcher.cpp */
+
+#include "Ephyra_pch.h"
+
+#include "Core/Resources/Utility/StaticBatcher.h"
+#include "Core/Resources/Utility/Meshlets.h"
+#include "Core/Systems/Utility/Log.h"
+
+#include <cmath>
+#include <map>
+#include <tuple>
+
+namespace Engine
+{
+	void StaticBatcher::clear()
+	{
+		releaseBatches();
+		m_sources.clear();
+		m_objects.clear();
+		m_materials.clear();
+		m_stats.reset();
+	}
+
+	void StaticBatcher::releaseBatches()
+	{
+		for (auto& batch : m_batches)
+			Renderer3D::removeGeometry(batch.geometry);
+		m_batches.clear();
+	}
+
+	std::shared_ptr<StaticMeshData> StaticBatcher::readMesh(const Geometry& geometry)
+	{
+		// Ids are reused once a mesh is removed, a cached copy is only valid for the ranges it was read from
+		auto& mesh = m_meshes[geometry.id];
+		if (mesh && mesh->geometry.firstVertex == geometry.firstVertex && mesh->geometry.vertexCount == geometry.vertexCount &&
+			mesh->geometry.firstIndex == geometry.firstIndex && mesh->geometry.indexCount == geometry.indexCount)
+			return mesh;
+
+		std::vector<Meshlet> meshlets;
+		mesh = std::make_shared<StaticMeshData>();
+		mesh->geometry = geometry;
+		Renderer3D::readGeometry(geometry, mesh->vertices, mesh->indices, meshlets);
+		return mesh;
+	}
+
+	void StaticBatcher::add(const Geometry& geometry, const std::shared_ptr<Material>& material, const glm::mat4& model, uint32_t userData, uint32_t part)
+	{
+		// Meshes with bones are posed in the vertex shader, pre-transforming them would freeze the bind pose
+		if (!material || geometry.hasBones || geometry.indexCount == 0) return;
+
+		auto mesh = readMesh(geometry);
+
+		Source source;
+		source.mesh = mesh;
+		source.material = material;
+		source.model = model;
+		for (auto& vertex : mesh->vertices)
+			source.bounds.expand(glm::vec3(model * glm::vec4(vertex.m_pos, 1.f)));
+		source.userData = userData;
+		source.part = part;
+
+		m_objects[userData].push_back(static_cast<uint32_t>(m_sources.size()));
+		m_sources.push_back(source);
+	}
+
+	uint32_t StaticBatcher::getMaterialKey(const std::shared_ptr<Material>& material)
+	{
+		for (uint32_t i = 0; i < m_materials.size(); i++)
+		{
+			auto& other = m_materials[i];
+			if (other == material)
+				return i;
+
+			bool same = other->getShader() == material->getShader() && other->getTint() == material->getTint() && other->getTextures() == material->getTextures();
+			for (uint32_t flag : { Material::flag_batched, Material::flag_texture, Material::flag_tint })
+				same = same && other->isFlagSet(flag) == material->isFlagSet(flag);
+			if (same)
+				return i;
+		}
+
+		m_materials.push_back(material);
+		return static_cast<uint32_t>(m_materials.size() - 1);
+	}
+
+	void StaticBatcher::build()
+	{
+		releaseBatches();
+		m_materials.clear();
+		m_stats.reset();
+		m_stats.sources = static_cast<uint32_t>(m_sources.size());
+
+		// Group by material and by the grid cell holding each mesh's centre, so one batch never spans the whole level
+		std::map<std::tuple<uint32_t, int32_t, int32_t, int32_t>, std::vector<uint32_t>> groups;
+		for (uint32_t i = 0; i < m_sources.size(); i++)
+		{
+			auto& source = m_sources[i];
+			source.batch = -1;
+
+			glm::vec3 cell = glm::floor(source.bounds.getCenter() / m_cellSize);
+			groups[std::make_tuple(getMaterialKey(source.material), static_cast<int32_t>(cell.x), static_cast<int32_t>(cell.y), static_cast<int32_t>(cell.z))].push_back(i);
+		}
+
+		std::vector<Renderer3DVertex> vertices;
+		std::vector<uint32_t> indices;
+		std::vector<uint32_t> firstIndices;
+		std::vector<glm::vec3> positions;
+		std::vector<Meshlet> meshlets;
+
+		for (auto& group : groups)
+		{
+			auto& members = group.second;
+			if (members.size() < 2) continue;
+
+			vertices.clear();
+			indices.clear();
+			firstIndices.clear();
+
+			Batch batch;
+			batch.material = m_sources[members[0]].material;
+
+			for (uint32_t member : members)
+			{
+				auto& source = m_sources[member];
+				glm::mat3 normalMatrix = glm::transpose(glm::inverse(glm::mat3(source.model)));
+				uint32_t baseVertex = static_cast<uint32_t>(vertices.size());
+
+				for (auto& vertex : source.mesh->vertices)
+				{
+					glm::vec3 normal = normalMatrix * vertex.m_normal;
+					float length = glm::length(normal);
+					vertices.emplace_back(glm::vec3(source.model * glm::vec4(vertex.m_pos, 1.f)), length > 0.f ? normal / length : normal, vertex.m_uv, glm::vec4(0.f), glm::vec4(0.f));
+				}
+
+				firstIndices.push_back(static_cast<uint32_t>(indices.size()));
+				for (uint32_t index : source.mesh->indices)
+					indices.push_back(baseVertex + index);
+
+				batch.bounds.expand(source.bounds);
+			}
+
+			// Members share no vertices and clusters are seeded in triangle order, so each member's triangles stay in one contiguous range
+			meshlets.clear();
+			if (indices.size() % 3 == 0 && indices.size() / 3 > Meshlets::maxTriangles)
+			{
+				positions.clear();
+				positions.reserve(vertices.size());
+				for (auto& vertex : vertices)
+					positions.push_back(vertex.m_pos);
+				Meshlets::build(positions, indices, meshlets);
+			}
+
+			if (!Renderer3D::addGeometry(vertices, indices, batch.geometry, meshlets))
+			{
+				Log::error("Cannot merge {0} static meshes, {1} vertices and {2} indices do not fit in the arena", members.size(), vertices.size(), indices.size());
+				m_stats.failed++;
+				continue;
+			}
+
+			int32_t batchIndex = static_cast<int32_t>(m_batches.size());
+			for (uint32_t i = 0; i < members.size(); i++)
+			{
+				auto& source = m_sources[members[i]];
+				source.batch = batchIndex;
+				source.firstIndex = batch.geometry.firstIndex + firstIndices[i];
+				source.indexCount = static_cast<uint32_t>(source.mesh->indices.size());
+			}
+
+			batch.liveMembers = static_cast<uint32_t>(members.size());
+			m_stats.merged += batch.liveMembers;
+			m_batches.push_back(batch);
+		}
+
+		m_stats.batches = static_cast<uint32_t>(m_batches.size());
+		Log::info("Static batching: {0} meshes merged into {1} batches, {2} left separate", m_stats.merged, m_stats.batches, m_stats.sources - m_stats.merged);
+	}
+
+	bool StaticBatcher::unmerge(uint32_t userData)
+	{
+		auto object = m_objects.find(userData);
+		if (object == m_objects.end()) return false;
+
+		bool unmerged = false;
+		for (uint32_t index : object->second)
+		{
+			auto& source = m_sources[index];
+			if (source.batch < 0) continue;
+
+			// Zeroed indices are degenerate triangles, the batch keeps drawing the same ranges without the removed mesh
+			Renderer3D::clearIndices(source.firstIndex, source.indexCount);
+			m_batches[source.batch].liveMembers--;
+			source.batch = -1;
+			m_stats.unmerged++;
+			unmerged = true;
+		}
+		return unmerged;
+	}
+
+	bool StaticBatcher::isMerged(uint32_t userData, uint32_t part) const
+	{
+		auto object = m_objects.find(userData);
+		if (object == m_objects.end()) return false;
+
+		for (uint32_t index : object->second)
+			if (m_sources[index].part == part)
+				return m_sources[index].batch >= 0;
+		return false;
+	}
+}
@@ -32,27 +32,36 @@ namespace Engine
 	{
 		if (channels != getChannels()) return false;
 
-		for (auto iterator = m_spaces.begin(); iterator != m_spaces.end(); ++iterator)
+		SimpleRect space;
+		if (!pack(m_spaces, width, height, space)) return false;
+
+		// Texture Fits! Add Texture Data
+		m_baseTexture->edit(space.x, space.y, width, height, data);
+
+		// Set SubTexture Result
+		glm::vec2 UVStart( static_cast<float>(space.x) / m_baseTexture->getWidthf(), static_cast<float>(space.y) / m_baseTexture->getHeightf());
+		glm::vec2 UVEnd(static_cast<float>(space.x + width) / m_baseTexture->getWidthf(), static_cast<float>(space.y+height) / m_baseTexture->getHeightf());
+		result = SubTexture(m_baseTexture, UVStart, UVEnd);
+		return true;
+	}
+
+	bool TextureAtlas::pack(std::vector<SimpleRect>& spaces, uint32_t width, uint32_t height, SimpleRect& placed)
+	{
+		for (auto iterator = spaces.begin(); iterator != spaces.end(); ++iterator)
 		{
 			auto& space = *iterator;
 
 			// Does The Texture Fit This Space
 			if (width < space.w && height < space.h)
 			{
-				// Texture Fits! Add Texture Data
-				m_baseTexture->edit(space.x, space.y, width, height, data);
-
-				// Set SubTexture Result
-				glm::vec2 UVStart( static_cast<float>(space.x) / m_baseTexture->getWidthf(), static_cast<float>(space.y) / m_baseTexture->getHeightf());
-				glm::vec2 UVEnd(static_cast<float>(space.x + width) / m_baseTexture->getWidthf(), static_cast<float>(space.y+height) / m_baseTexture->getHeightf());
-				result = SubTexture(m_baseTexture, UVStart, UVEnd);
+				placed = { space.x, space.y, width, height };
 
 					// Sort Out Remaining Spaces
 
 				// Case 1: Texture Matches Space Size. Delete Space
 				if (width == space.w && height == space.h)
 				{
-					m_spaces.erase(iterator);
+					spaces.erase(iterator);
 					return true;
 				}
 
@@ -78,9 +87,9 @@ namespace Engine
 					SimpleRect newRect({ space.x, space.y + height, width, space.h - height });
 					space.x += width;
 					space.w -= width;
-					m_spaces.push_back(newRect);
+					spaces.push_back(newRect);
 
-					std::sort(m_spaces.begin(), m_spaces.end(), [](SimpleRect& a, SimpleRect& b) { return a.w < b.w; });
+					std::sort(spaces.begin(), spaces.end(), [](SimpleRect& a, SimpleRect& b) { return a.w < b.w; });
 					return true;
 				}
 
@@ -0,0 +1,279 @@
+/** \file transformHierarchy.cpp */
+
+#include "Ephyra_pch.h"
+
+#include "Core/Resources/Utility/TransformHierarchy.h"
+#include "Core/Resources/Utility/TransformKernels.h"
+#include "Core/Systems/Utility/Log.h"
+
+#include <algorithm>
+
+namespace Engine
+{
+	TransformHierarchy::Handle TransformHierarchy::create(Handle parent, uint32_t userData)
+	{
+		if (parent != invalid && !isValid(parent))
+		{
+			Log::error("Transform hierarchy parent {0} does not exist, node created as a root", parent);
+			parent = invalid;
+		}
+
+		Handle node;
+		if (!m_freeHandles.empty())
+		{
+			node = m_freeHandles.back();
+			m_freeHandles.pop_back();
+		}
+		else
+		{
+			node = static_cast<Handle>(m_handleToIndex.size());
+			m_handleToIndex.push_back(invalid);
+			m_parents.push_back(invalid);
+			m_children.emplace_back();
+		}
+
+		// Appended for now, rebuildOrder moves it next to its siblings before the next update
+		m_handleToIndex[node] = static_cast<uint32_t>(m_indexToHandle.size());
+		m_parents[node] = parent;
+		m_children[node].clear();
+		if (parent == invalid) m_roots.push_back(node);
+		else m_children[parent].push_back(node);
+
+		m_indexToHandle.push_back(node);
+		m_parentIndex.push_back(invalid);
+		m_subtreeSize.push_back(1);
+		m_translation.push_back(glm::vec3(0.f));
+		m_rotation.push_back(glm::quat(1.f, 0.f, 0.f, 0.f));
+		m_scale.push_back(glm::vec3(1.f));
+		m_localDirty.push_back(1);
+		m_local.push_back(glm::mat4(1.f));
+		m_world.push_back(glm::mat4(1.f));
+		m_userData.push_back(userData);
+
+		m_dirty.push_back(node);
+		m_orderDirty = true;
+		return node;
+	}
+
+	void TransformHierarchy::destroy(Handle node)
+	{
+		if (!isValid(node)) return;
+
+		Handle parent = m_parents[node];
+		auto& siblings = parent == invalid ? m_roots : m_children[parent];
+		siblings.erase(std::remove(siblings.begin(), siblings.end(), node), siblings.end());
+
+		for (Handle child : m_children[node])
+		{
+			m_parents[child] = parent;
+			siblings.push_back(child);
+			m_dirty.push_back(child);
+		}
+		m_children[node].clear();
+
+		// Swap the last position into the hole, rebuildOrder restores the depth first order
+		uint32_t index = m_handleToIndex[node];
+		uint32_t last = static_cast<uint32_t>(m_indexToHandle.size()) - 1;
+		if (index != last)
+		{
+			m_indexToHandle[index] = m_indexToHandle[last];
+			m_translation[index] = m_translation[last];
+			m_rotation[index] = m_rotation[last];
+			m_scale[index] = m_scale[last];
+			m_localDirty[index] = m_localDirty[last];
+			m_local[index] = m_local[last];
+			m_world[index] = m_world[last];
+			m_userData[index] = m_userData[last];
+			m_handleToIndex[m_indexToHandle[index]] = index;
+		}
+
+		m_indexToHandle.pop_back();
+		m_parentIndex.pop_back();
+		m_subtreeSize.pop_back();
+		m_translation.pop_back();
+		m_rotation.pop_back();
+		m_scale.pop_back();
+		m_localDirty.pop_back();
+		m_local.pop_back();
+		m_world.pop_back();
+		m_userData.pop_back();
+
+		m_handleToIndex[node] = invalid;
+		m_parents[node] = invalid;
+		m_freeHandles.push_back(node);
+
+		m_dirty.erase(std::remove(m_dirty.begin(), m_dirty.end(), node), m_dirty.end());
+		m_orderDirty = true;
+	}
+
+	void TransformHierarchy::setParent(Handle node, Handle parent)
+	{
+		if (!isValid(node) || m_parents[node] == parent) return;
+		if (parent != invalid && (!isValid(parent) || parent == node || isDescendant(parent, node)))
+		{
+			Log::error("Transform hierarchy cannot parent {0} to {1}", node, parent);
+			return;
+		}
+
+		Handle oldParent = m_parents[node];
+		auto& oldSiblings = oldParent == invalid ? m_roots : m_children[oldParent];
+		oldSiblings.erase(std::remove(oldSiblings.begin(), oldSiblings.end(), node), oldSiblings.end());
+
+		m_parents[node] = parent;
+		if (parent == invalid) m_roots.push_back(node);
+		else m_children[parent].push_back(node);
+
+		m_dirty.push_back(node);
+		m_orderDirty = true;
+	}
+
+	void TransformHierarchy::setLocal(Handle node, const glm::vec3& translation, const glm::quat& rotation, const glm::vec3& scale)
+	{
+		if (!isValid(node)) return;
+
+		uint32_t index = m_handleToIndex[node];
+		m_translation[index] = translation;
+		m_rotation[index] = rotation;
+		m_scale[index] = scale;
+
+		if (!m_localDirty[index])
+		{
+			m_localDirty[index] = 1;
+			m_dirty.push_back(node);
+		}
+	}
+
+	void TransformHierarchy::clear()
+	{
+		m_handleToIndex.clear();
+		m_parents.clear();
+		m_children.clear();
+		m_roots.clear();
+		m_freeHandles.clear();
+
+		m_indexToHandle.clear();
+		m_parentIndex.clear();
+		m_subtreeSize.clear();
+		m_translation.clear();
+		m_rotation.clear();
+		m_scale.clear();
+		m_localDirty.clear();
+		m_local.clear();
+		m_world.clear();
+		m_userData.clear();
+
+		m_dirty.clear();
+		m_updated.clear();
+		m_orderDirty = false;
+	}
+
+	void TransformHierarchy::update()
+	{
+		m_updated.clear();
+
+		if (m_orderDirty) rebuildOrder();
+		if (m_dirty.empty()) return;
+
+		// Positions of changed nodes, ascending so a subtree is visited before anything nested in it
+		std::vector<uint32_t> dirtyIndices;
+		dirtyIndices.reserve(m_dirty.size());
+		for (Handle node : m_dirty)
+			if (isValid(node)) dirtyIndices.push_back(m_handleToIndex[node]);
+		std::sort(dirtyIndices.begin(), dirtyIndices.end());
+		m_dirty.clear();
+
+		uint32_t coveredEnd = 0;
+		for (uint32_t first : dirtyIndices)
+		{
+			if (first < coveredEnd) continue;
+
+			uint32_t end = first + m_subtreeSize[first];
+
+			// Recompose changed locals in contiguous runs so the SIMD kernel sees whole batches
+			for (uint32_t i = first; i < end;)
+			{
+				if (!m_localDirty[i]) { i++; continue; }
+
+				uint32_t runEnd = i;
+				while (runEnd < end && m_localDirty[runEnd]) m_localDirty[runEnd++] = 0;
+				TransformKernels::composeTRS(&m_translation[i], &m_rotation[i], &m_scale[i], &m_local[i], runEnd - i);
+				i = runEnd;
+			}
+
+			for (uint32_t i = first; i < end; i++)
+			{
+				uint32_t parent = m_parentIndex[i];
+				m_world[i] = parent == invalid ? m_local[i] : m_world[parent] * m_local[i];
+				m_updated.push_back(m_indexToHandle[i]);
+			}
+
+			coveredEnd = end;
+		}
+	}
+
+	void TransformHierarchy::rebuildOrder()
+	{
+		uint32_t count = static_cast<uint32_t>(m_indexToHandle.size());
+
+		std::vector<Handle> order;
+		order.reserve(count);
+		std::vector<Handle> stack(m_roots.rbegin(), m_roots.rend());
+		while (!stack.empty())
+		{
+			Handle node = stack.back();
+			stack.pop_back();
+			order.push_back(node);
+			for (auto child = m_children[node].rbegin(); child != m_children[node].rend(); ++child)
+				stack.push_back(*child);
+		}
+
+		std::vector<glm::vec3> translation(count), scale(count);
+		std::vector<glm::quat> rotation(count);
+		std::vector<uint8_t> localDirty(count);
+		std::vector<glm::mat4> local(count), world(count);
+		std::vector<uint32_t> userData(count);
+
+		for (uint32_t i = 0; i < count; i++)
+		{
+			uint32_t old = m_handleToIndex[order[i]];
+			translation[i] = m_translation[old];
+			rotation[i] = m_rotation[old];
+			scale[i] = m_scale[old];
+			localDirty[i] = m_localDirty[old];
+			local[i] = m_local[old];
+			world[i] = m_world[old];
+			userData[i] = m_userData[old];
+		}
+
+		m_translation.swap(translation);
+		m_rotation.swap(rotation);
+		m_scale.swap(scale);
+		m_localDirty.swap(localDirty);
+		m_local.swap(local);
+		m_world.swap(world);
+		m_userData.swap(userData);
+		m_indexToHandle.swap(order);
+
+		for (uint32_t i = 0; i < count; i++)
+			m_handleToIndex[m_indexToHandle[i]] = i;
+
+		// Children follow their parent, so walking backwards accumulates subtree sizes in one pass
+		for (uint32_t i = 0; i < count; i++)
+		{
+			Handle parent = m_parents[m_indexToHandle[i]];
+			m_parentIndex[i] = parent == invalid ? invalid : m_handleToIndex[parent];
+			m_subtreeSize[i] = 1;
+		}
+		for (uint32_t i = count; i-- > 0;)
+			if (m_parentIndex[i] != invalid) m_subtreeSize[m_parentIndex[i]] += m_subtreeSize[i];
+
+		m_orderDirty = false;
+	}
+
+	bool TransformHierarchy::isDescendant(Handle node, Handle ancestor) const
+	{
+		for (Handle parent = m_parents[node]; parent != invalid; parent = m_parents[parent])
+			if (parent == ancestor) return true;
+		return false;
+	}
+}
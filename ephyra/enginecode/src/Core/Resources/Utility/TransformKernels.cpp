@@ -0,0 +1,243 @@
+/** \file transformKernels.cpp */
+
+#include "Ephyra_pch.h"
+
+#include "Core/Resources/Utility/TransformKernels.h"
+
+#if defined(_M_X64) || defined(__x86_64__) || defined(_M_IX86) || defined(__i386__)
+#define EPHYRA_KERNELS_X86
+#include <immintrin.h>
+#if defined(_MSC_VER)
+#include <intrin.h>
+#endif
+#endif
+
+// MSVC exposes every intrinsic unconditionally, GCC and Clang need the target named per function
+#if defined(EPHYRA_KERNELS_X86) && (defined(__GNUC__) || defined(__clang__))
+#define EPHYRA_TARGET_SSE4 __attribute__((target("sse4.1")))
+#define EPHYRA_TARGET_AVX2 __attribute__((target("avx2")))
+#else
+#define EPHYRA_TARGET_SSE4
+#define EPHYRA_TARGET_AVX2
+#endif
+
+namespace Engine
+{
+	namespace TransformKernels
+	{
+		namespace
+		{
+			void composeScalar(const glm::vec3* t, const glm::quat* r, const glm::vec3* s, glm::mat4* out, uint32_t count)
+			{
+				for (uint32_t i = 0; i < count; i++)
+				{
+					const glm::quat& q = r[i];
+					float xx = q.x * q.x, yy = q.y * q.y, zz = q.z * q.z;
+					float xy = q.x * q.y, xz = q.x * q.z, yz = q.y * q.z;
+					float wx = q.w * q.x, wy = q.w * q.y, wz = q.w * q.z;
+
+					glm::mat4& m = out[i];
+					m[0] = glm::vec4((1.f - 2.f * (yy + zz)) * s[i].x, 2.f * (xy + wz) * s[i].x, 2.f * (xz - wy) * s[i].x, 0.f);
+					m[1] = glm::vec4(2.f * (xy - wz) * s[i].y, (1.f - 2.f * (xx + zz)) * s[i].y, 2.f * (yz + wx) * s[i].y, 0.f);
+					m[2] = glm::vec4(2.f * (xz + wy) * s[i].z, 2.f * (yz - wx) * s[i].z, (1.f - 2.f * (xx + yy)) * s[i].z, 0.f);
+					m[3] = glm::vec4(t[i], 1.f);
+				}
+			}
+
+#ifdef EPHYRA_KERNELS_X86
+			// Four transforms per iteration, one per lane, transposed back into columns on store
+			EPHYRA_TARGET_SSE4 void composeSSE4(const glm::vec3* t, const glm::quat* r, const glm::vec3* s, glm::mat4* out, uint32_t count)
+			{
+				const __m128 one = _mm_set1_ps(1.f);
+				const __m128 two = _mm_set1_ps(2.f);
+				const __m128 zero = _mm_setzero_ps();
+
+				uint32_t i = 0;
+				for (; i + 4 <= count; i += 4)
+				{
+					__m128 qx = _mm_set_ps(r[i + 3].x, r[i + 2].x, r[i + 1].x, r[i].x);
+					__m128 qy = _mm_set_ps(r[i + 3].y, r[i + 2].y, r[i + 1].y, r[i].y);
+					__m128 qz = _mm_set_ps(r[i + 3].z, r[i + 2].z, r[i + 1].z, r[i].z);
+					__m128 qw = _mm_set_ps(r[i + 3].w, r[i + 2].w, r[i + 1].w, r[i].w);
+					__m128 sx = _mm_set_ps(s[i + 3].x, s[i + 2].x, s[i + 1].x, s[i].x);
+					__m128 sy = _mm_set_ps(s[i + 3].y, s[i + 2].y, s[i + 1].y, s[i].y);
+					__m128 sz = _mm_set_ps(s[i + 3].z, s[i + 2].z, s[i + 1].z, s[i].z);
+
+					__m128 xx = _mm_mul_ps(qx, qx), yy = _mm_mul_ps(qy, qy), zz = _mm_mul_ps(qz, qz);
+					__m128 xy = _mm_mul_ps(qx, qy), xz = _mm_mul_ps(qx, qz), yz = _mm_mul_ps(qy, qz);
+					__m128 wx = _mm_mul_ps(qw, qx), wy = _mm_mul_ps(qw, qy), wz = _mm_mul_ps(qw, qz);
+
+					__m128 m00 = _mm_mul_ps(_mm_sub_ps(one, _mm_mul_ps(two, _mm_add_ps(yy, zz))), sx);
+					__m128 m01 = _mm_mul_ps(_mm_mul_ps(two, _mm_add_ps(xy, wz)), sx);
+					__m128 m02 = _mm_mul_ps(_mm_mul_ps(two, _mm_sub_ps(xz, wy)), sx);
+					__m128 m10 = _mm_mul_ps(_mm_mul_ps(two, _mm_sub_ps(xy, wz)), sy);
+					__m128 m11 = _mm_mul_ps(_mm_sub_ps(one, _mm_mul_ps(two, _mm_add_ps(xx, zz))), sy);
+					__m128 m12 = _mm_mul_ps(_mm_mul_ps(two, _mm_add_ps(yz, wx)), sy);
+					__m128 m20 = _mm_mul_ps(_mm_mul_ps(two, _mm_add_ps(xz, wy)), sz);
+					__m128 m21 = _mm_mul_ps(_mm_mul_ps(two, _mm_sub_ps(yz, wx)), sz);
+					__m128 m22 = _mm_mul_ps(_mm_sub_ps(one, _mm_mul_ps(two, _mm_add_ps(xx, yy))), sz);
+
+					__m128 c0a = m00, c0b = m01, c0c = m02, c0d = zero;
+					__m128 c1a = m10, c1b = m11, c1c = m12, c1d = zero;
+					__m128 c2a = m20, c2b = m21, c2c = m22, c2d = zero;
+					_MM_TRANSPOSE4_PS(c0a, c0b, c0c, c0d);
+					_MM_TRANSPOSE4_PS(c1a, c1b, c1c, c1d);
+					_MM_TRANSPOSE4_PS(c2a, c2b, c2c, c2d);
+
+					__m128 col0[4] = { c0a, c0b, c0c, c0d };
+					__m128 col1[4] = { c1a, c1b, c1c, c1d };
+					__m128 col2[4] = { c2a, c2b, c2c, c2d };
+					for (uint32_t k = 0; k < 4; k++)
+					{
+						float* m = &out[i + k][0][0];
+						_mm_storeu_ps(m + 0, col0[k]);
+						_mm_storeu_ps(m + 4, col1[k]);
+						_mm_storeu_ps(m + 8, col2[k]);
+						_mm_storeu_ps(m + 12, _mm_set_ps(1.f, t[i + k].z, t[i + k].y, t[i + k].x));
+					}
+				}
+
+				composeScalar(t + i, r + i, s + i, out + i, count - i);
+			}
+
+			// Eight transforms per iteration, each 128 bit half transposed like the SSE4 path
+			EPHYRA_TARGET_AVX2 void composeAVX2(const glm::vec3* t, const glm::quat* r, const glm::vec3* s, glm::mat4* out, uint32_t count)
+			{
+				const __m256 one = _mm256_set1_ps(1.f);
+				const __m256 two = _mm256_set1_ps(2.f);
+
+				uint32_t i = 0;
+				for (; i + 8 <= count; i += 8)
+				{
+					__m256 qx = _mm256_set_ps(r[i + 7].x, r[i + 6].x, r[i + 5].x, r[i + 4].x, r[i + 3].x, r[i + 2].x, r[i + 1].x, r[i].x);
+					__m256 qy = _mm256_set_ps(r[i + 7].y, r[i + 6].y, r[i + 5].y, r[i + 4].y, r[i + 3].y, r[i + 2].y, r[i + 1].y, r[i].y);
+					__m256 qz = _mm256_set_ps(r[i + 7].z, r[i + 6].z, r[i + 5].z, r[i + 4].z, r[i + 3].z, r[i + 2].z, r[i + 1].z, r[i].z);
+					__m256 qw = _mm256_set_ps(r[i + 7].w, r[i + 6].w, r[i + 5].w, r[i + 4].w, r[i + 3].w, r[i + 2].w, r[i + 1].w, r[i].w);
+					__m256 sx = _mm256_set_ps(s[i + 7].x, s[i + 6].x, s[i + 5].x, s[i + 4].x, s[i + 3].x, s[i + 2].x, s[i + 1].x, s[i].x);
+					__m256 sy = _mm256_set_ps(s[i + 7].y, s[i + 6].y, s[i + 5].y, s[i + 4].y, s[i + 3].y, s[i + 2].y, s[i + 1].y, s[i].y);
+					__m256 sz = _mm256_set_ps(s[i + 7].z, s[i + 6].z, s[i + 5].z, s[i + 4].z, s[i + 3].z, s[i + 2].z, s[i + 1].z, s[i].z);
+
+					__m256 xx = _mm256_mul_ps(qx, qx), yy = _mm256_mul_ps(qy, qy), zz = _mm256_mul_ps(qz, qz);
+					__m256 xy = _mm256_mul_ps(qx, qy), xz = _mm256_mul_ps(qx, qz), yz = _mm256_mul_ps(qy, qz);
+					__m256 wx = _mm256_mul_ps(qw, qx), wy = _mm256_mul_ps(qw, qy), wz = _mm256_mul_ps(qw, qz);
+
+					__m256 m[9] = {
+						_mm256_mul_ps(_mm256_sub_ps(one, _mm256_mul_ps(two, _mm256_add_ps(yy, zz))), sx),
+						_mm256_mul_ps(_mm256_mul_ps(two, _mm256_add_ps(xy, wz)), sx),
+						_mm256_mul_ps(_mm256_mul_ps(two, _mm256_sub_ps(xz, wy)), sx),
+						_mm256_mul_ps(_mm256_mul_ps(two, _mm256_sub_ps(xy, wz)), sy),
+						_mm256_mul_ps(_mm256_sub_ps(one, _mm256_mul_ps(two, _mm256_add_ps(xx, zz))), sy),
+						_mm256_mul_ps(_mm256_mul_ps(two, _mm256_add_ps(yz, wx)), sy),
+						_mm256_mul_ps(_mm256_mul_ps(two, _mm256_add_ps(xz, wy)), sz),
+						_mm256_mul_ps(_mm256_mul_ps(two, _mm256_sub_ps(yz, wx)), sz),
+						_mm256_mul_ps(_mm256_sub_ps(one, _mm256_mul_ps(two, _mm256_add_ps(xx, yy))), sz)
+					};
+
+					for (uint32_t half = 0; half < 2; half++)
+					{
+						__m128 lanes[9];
+						for (uint32_t e = 0; e < 9; e++)
+							lanes[e] = half == 0 ? _mm256_castps256_ps128(m[e]) : _mm256_extractf128_ps(m[e], 1);
+
+						__m128 cols[3][4];
+						for (uint32_t c = 0; c < 3; c++)
+						{
+							cols[c][0] = lanes[c * 3 + 0];
+							cols[c][1] = lanes[c * 3 + 1];
+							cols[c][2] = lanes[c * 3 + 2];
+							cols[c][3] = _mm_setzero_ps();
+							_MM_TRANSPOSE4_PS(cols[c][0], cols[c][1], cols[c][2], cols[c][3]);
+						}
+
+						for (uint32_t k = 0; k < 4; k++)
+						{
+							uint32_t index = i + half * 4 + k;
+							float* mat = &out[index][0][0];
+							_mm_storeu_ps(mat + 0, cols[0][k]);
+							_mm_storeu_ps(mat + 4, cols[1][k]);
+							_mm_storeu_ps(mat + 8, cols[2][k]);
+							_mm_storeu_ps(mat + 12, _mm_set_ps(1.f, t[index].z, t[index].y, t[index].x));
+						}
+					}
+				}
+
+				composeScalar(t + i, r + i, s + i, out + i, count - i);
+			}
+
+			bool detectSupport(Path path)
+			{
+				if (path == Path::Scalar) return true;
+#if defined(_MSC_VER)
+				int info[4];
+				__cpuid(info, 0);
+				int maxLeaf = info[0];
+
+				__cpuid(info, 1);
+				bool sse41 = (info[2] & (1 << 19)) != 0;
+				if (path == Path::SSE4) return sse41;
+
+				// AVX2 also needs the OS to save the wide registers
+				bool osxsave = (info[2] & (1 << 27)) != 0;
+				bool avx = (info[2] & (1 << 28)) != 0;
+				if (maxLeaf < 7 || !osxsave || !avx) return false;
+				if ((_xgetbv(0) & 0x6) != 0x6) return false;
+
+				__cpuidex(info, 7, 0);
+				return (info[1] & (1 << 5)) != 0;
+#else
+				__builtin_cpu_init();
+				if (path == Path::SSE4) return __builtin_cpu_supports("sse4.1");
+				return __builtin_cpu_supports("avx2");
+#endif
+			}
+#else
+			bool detectSupport(Path path) { return path == Path::Scalar; }
+#endif
+		}
+
+		bool isSupported(Path path)
+		{
+			// CPUID is slow enough to show in every small batch, so the features are read once
+			static const bool s_supported[3] = { true, detectSupport(Path::SSE4), detectSupport(Path::AVX2) };
+			return s_supported[static_cast<int>(path)];
+		}
+
+		Path getPath()
+		{
+			static Path s_path = isSupported(Path::AVX2) ? Path::AVX2 : (isSupported(Path::SSE4) ? Path::SSE4 : Path::Scalar);
+			return s_path;
+		}
+
+		const char* getPathName(Path path)
+		{
+			switch (path)
+			{
+			case Path::AVX2: return "AVX2";
+			case Path::SSE4: return "SSE4";
+			default: return "Scalar";
+			}
+		}
+
+		void composeTRS(const glm::vec3* translations, const glm::quat* rotations, const glm::vec3* scales, glm::mat4* out, uint32_t count)
+		{
+			composeTRS(getPath(), translations, rotations, scales, out, count);
+		}
+
+		void composeTRS(Path path, const glm::vec3* translations, const glm::quat* rotations, const glm::vec3* scales, glm::mat4* out, uint32_t count)
+		{
+#ifdef EPHYRA_KERNELS_X86
+			if (path == Path::AVX2 && isSupported(Path::AVX2))
+			{
+				composeAVX2(translations, rotations, scales, out, count);
+				return;
+			}
+			if (path != Path::Scalar && isSupported(Path::SSE4))
+			{
+				composeSSE4(translations, rotations, scales, out, count);
+				return;
+			}
+#endif
+			composeScalar(translations, rotations, scales, out, count);
+		}
+	}
+}
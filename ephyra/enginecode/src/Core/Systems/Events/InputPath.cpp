@@ -0,0 +1,133 @@
+/** \file inputPath.cpp */
+#include "Ephyra_pch.h"
+#include "Core/Systems/Events/InputPath.h"
+#include "Core/Systems/Utility/Log.h"
+
+#include <json.hpp>
+#include <fstream>
+
+namespace Engine
+{
+	namespace
+	{
+		constexpr uint32_t keyCount = 350; //!< Keys the poller tracks
+		constexpr uint32_t version = 1; //!< Bumped whenever the file layout changes
+	}
+
+	void InputPath::startRecording(float step)
+	{
+		m_ticks.clear();
+		m_position = 0;
+		m_step = step;
+		m_mode = Mode::Recording;
+	}
+
+	bool InputPath::startPlayback()
+	{
+		if (m_ticks.empty()) return false;
+
+		m_position = 0;
+		m_mode = Mode::Playing;
+		return true;
+	}
+
+	void InputPath::tick(InputPoller& poller, bool& cameraActive, float& timeKey)
+	{
+		if (m_mode == Mode::Recording)
+		{
+			InputTick tick;
+			for (uint32_t key = 0; key < keyCount; key++)
+				if (poller.isKeyPressed(key)) tick.keys.push_back(static_cast<uint16_t>(key));
+			tick.mouseDelta = glm::vec2(poller.getMouseDeltaX(), poller.getMouseDeltaY());
+			tick.scroll = glm::vec2(poller.getMouseScrollX(), poller.getMouseScrollY());
+			tick.buttons[0] = poller.isLeftClicked();
+			tick.buttons[1] = poller.isRightClicked();
+			tick.cameraActive = cameraActive;
+			tick.timeKey = timeKey;
+			m_ticks.push_back(std::move(tick));
+		}
+		else if (m_mode == Mode::Playing)
+		{
+			// Live input is discarded for the rest of the recording
+			const InputTick& tick = m_ticks[m_position];
+			for (uint32_t key = 0; key < keyCount; key++)
+				poller.isKeyPressed(key) = false;
+			for (uint16_t key : tick.keys)
+				poller.isKeyPressed(key) = true;
+			poller.getMouseDeltaX() = tick.mouseDelta.x;
+			poller.getMouseDeltaY() = tick.mouseDelta.y;
+			poller.getMouseScrollX() = tick.scroll.x;
+			poller.getMouseScrollY() = tick.scroll.y;
+			poller.isLeftClicked() = tick.buttons[0];
+			poller.isRightClicked() = tick.buttons[1];
+			cameraActive = tick.cameraActive;
+			timeKey = tick.timeKey;
+
+			if (++m_position == m_ticks.size()) m_mode = Mode::Idle;
+		}
+	}
+
+	bool InputPath::save(const std::string& filepath) const
+	{
+		nlohmann::json path;
+		path["version"] = version;
+		path["step"] = m_step;
+		path["ticks"] = nlohmann::json::array();
+		for (auto& tick : m_ticks)
+		{
+			nlohmann::json tickJson;
+			tickJson["keys"] = tick.keys;
+			tickJson["mouse"] = { tick.mouseDelta.x, tick.mouseDelta.y };
+			tickJson["scroll"] = { tick.scroll.x, tick.scroll.y };
+			tickJson["buttons"] = { tick.buttons[0], tick.buttons[1] };
+			tickJson["camera"] = tick.cameraActive;
+			tickJson["time"] = tick.timeKey;
+			path["ticks"].push_back(tickJson);
+		}
+
+		std::ofstream file(filepath);
+		if (!file.is_open())
+		{
+			Log::error("Cannot write input path {0}", filepath);
+			return false;
+		}
+		file << path.dump();
+		return true;
+	}
+
+	bool InputPath::load(const std::string& filepath)
+	{
+		std::ifstream file(filepath);
+		if (!file.is_open())
+		{
+			Log::error("Cannot open input path {0}", filepath);
+			return false;
+		}
+
+		nlohmann::json path = nlohmann::json::parse(file, nullptr, false);
+		if (path.is_discarded() || path.value("version", 0u) != version || !path.contains("ticks"))
+		{
+			Log::error("{0} is not an input path of this version", filepath);
+			return false;
+		}
+
+		m_mode = Mode::Idle;
+		m_position = 0;
+		m_step = path.value("step", 1.f / 60.f);
+		m_ticks.clear();
+		for (auto& tickJson : path["ticks"])
+		{
+			InputTick tick;
+			for (auto& key : tickJson["keys"])
+				if (key.get<uint32_t>() < keyCount) tick.keys.push_back(key.get<uint16_t>());
+			tick.mouseDelta = glm::vec2(tickJson["mouse"][0].get<float>(), tickJson["mouse"][1].get<float>());
+			tick.scroll = glm::vec2(tickJson["scroll"][0].get<float>(), tickJson["scroll"][1].get<float>());
+			tick.buttons[0] = tickJson["buttons"][0].get<bool>();
+			tick.buttons[1] = tickJson["buttons"][1].get<bool>();
+			tick.cameraActive = tickJson["camera"].get<bool>();
+			tick.timeKey = tickJson["time"].get<float>();
+			m_ticks.push_back(std::move(tick));
+		}
+		return true;
+	}
+}
@@ -0,0 +1,81 @@
+/** \file framePacer.cpp */
+#include "Ephyra_pch.h"
+#include "Core/Systems/Utility/FramePacer.h"
+
+#include <thread>
+
+#ifdef NG_PLATFORM_WINDOWS
+#include <Windows.h>
+#include <timeapi.h>
+#pragma comment(lib, "winmm.lib")
+#endif
+
+namespace Engine
+{
+	FramePacer::~FramePacer()
+	{
+		setTargetRate(0.f);
+	}
+
+	void FramePacer::setTargetRate(float rate)
+	{
+		m_targetRate = rate > 0.f ? rate : 0.f;
+
+#ifdef NG_PLATFORM_WINDOWS
+		// Sleeps are rounded up to the scheduler tick, 15.6 ms by default, far past the spin margin. The finer tick costs
+		// power system wide, so it is only held while limiting
+		bool fine = m_targetRate > 0.f;
+		if (fine == m_fineTimer) return;
+
+		if (fine) timeBeginPeriod(1);
+		else timeEndPeriod(1);
+		m_fineTimer = fine;
+#endif
+	}
+
+	void FramePacer::wait()
+	{
+		m_stats = FramePacerStats();
+		Clock::time_point now = Clock::now();
+		if (m_targetRate <= 0.f)
+		{
+			m_started = false;
+			return;
+		}
+
+		auto interval = std::chrono::duration_cast<Clock::duration>(std::chrono::duration<float>(1.f / m_targetRate));
+		if (!m_started)
+		{
+			m_deadline = now;
+			m_started = true;
+		}
+		Clock::time_point deadline = m_deadline + interval;
+
+		if (now < deadline)
+		{
+			auto spin = std::chrono::duration_cast<Clock::duration>(std::chrono::duration<float>(m_spinTime));
+			if (deadline - now > spin)
+			{
+				std::this_thread::sleep_for(deadline - now - spin);
+				Clock::time_point slept = Clock::now();
+				m_stats.sleepTime = std::chrono::duration<float>(slept - now).count();
+				now = slept;
+			}
+
+			Clock::time_point spinStart = now;
+			while (now < deadline)
+			{
+				std::this_thread::yield();
+				now = Clock::now();
+			}
+			m_stats.spinTime = std::chrono::duration<float>(now - spinStart).count();
+			m_deadline = deadline;
+		}
+		else
+		{
+			// A frame that ran over starts the next interval from now, rather than rushing to catch up
+			m_stats.lateTime = std::chrono::duration<float>(now - deadline).count();
+			m_deadline = now;
+		}
+	}
+}
@@ -0,0 +1,297 @@
+/** \file jobSystem.cpp */
+#include "Ephyra_pch.h"
+#include "Core/Systems/Utility/JobSystem.h"
+#include "Core/Systems/Utility/Log.h"
+#include "Core/Systems/Utility/Profiler.h"
+
+#include <condition_variable>
+#include <thread>
+
+namespace Engine
+{
+	namespace
+	{
+		/** \struct JobQueue
+		*	Deque of jobs owned by one thread, other threads steal from its front
+		*/
+		struct JobQueue
+		{
+			std::mutex mutex; //!< Guards the jobs
+			std::deque<Job> jobs; //!< Queued jobs, newest at the back
+		};
+
+		std::vector<std::unique_ptr<JobQueue>> s_queues; //!< Index 0 belongs to the main thread, the rest to the workers
+		std::vector<std::thread> s_workers; //!< Worker threads
+		JobQueue s_mainQueue; //!< Jobs with main thread affinity
+		std::atomic<uint32_t> s_workerCount{ 0 }; //!< Workers running
+		std::atomic<uint32_t> s_queued{ 0 }; //!< Jobs waiting in the worker deques
+		std::atomic<uint32_t> s_nextQueue{ 0 }; //!< Round robin target for jobs pushed by threads owning no deque
+		std::atomic<bool> s_running{ false }; //!< Whether the workers should keep looking for jobs
+		std::mutex s_wakeMutex; //!< Paired with the wake condition
+		std::condition_variable s_wake; //!< Signalled when a job is queued or the workers are stopped
+		std::thread::id s_mainThread; //!< Thread that started the system
+
+		thread_local int32_t t_queue = -1; //!< Deque owned by this thread, -1 for none
+	}
+
+	void JobSystem::start(SystemSignal init, ...)
+	{
+		s_mainThread = std::this_thread::get_id();
+		t_queue = 0;
+
+		uint32_t hardware = std::thread::hardware_concurrency();
+		startWorkers(hardware > 1 ? hardware - 1 : 0);
+		Log::info("Job system started with {0} workers", getWorkerCount());
+	}
+
+	void JobSystem::stop(SystemSignal close, ...)
+	{
+		stopWorkers();
+		drainMainThread();
+		t_queue = -1;
+	}
+
+	void JobSystem::setThreadCount(uint32_t threads)
+	{
+		if (s_queues.empty() || !isMainThread())
+		{
+			Log::error("Job system thread count can only be set from the main thread once started");
+			return;
+		}
+
+		uint32_t workers = threads > 1 ? threads - 1 : 0;
+		if (workers == getWorkerCount()) return;
+
+		// Queued jobs run during the stop, so none are lost across the restart
+		stopWorkers();
+		startWorkers(workers);
+	}
+
+	void JobSystem::startWorkers(uint32_t count)
+	{
+		s_queues.clear();
+		for (uint32_t i = 0; i <= count; i++)
+			s_queues.emplace_back(new JobQueue);
+
+		s_running = true;
+		s_workerCount = count;
+		for (uint32_t i = 1; i <= count; i++)
+			s_workers.emplace_back(&JobSystem::workerLoop, i);
+	}
+
+	void JobSystem::stopWorkers()
+	{
+		s_running = false;
+		{
+			std::lock_guard<std::mutex> lock(s_wakeMutex);
+		}
+		s_wake.notify_all();
+
+		for (auto& worker : s_workers)
+			worker.join();
+		s_workers.clear();
+		s_workerCount = 0;
+
+		// Anything still queued runs here rather than being dropped
+		while (tryRunJob(false)) {}
+		s_queues.clear();
+	}
+
+	JobHandle JobSystem::run(std::function<void()> function, JobAffinity affinity)
+	{
+		JobHandle counter = std::make_shared<JobCounter>();
+		run(counter, std::move(function), affinity);
+		return counter;
+	}
+
+	void JobSystem::run(const JobHandle& counter, std::function<void()> function, JobAffinity affinity)
+	{
+		runAfter(nullptr, counter, std::move(function), affinity);
+	}
+
+	void JobSystem::runAfter(const JobHandle& dependency, const JobHandle& counter, std::function<void()> function, JobAffinity affinity)
+	{
+		Job job;
+		job.function = std::move(function);
+		job.counter = counter;
+		job.affinity = affinity;
+
+		// Counted on submission so waiting on the group also covers jobs still held back by a dependency
+		if (counter) counter->m_pending.fetch_add(1, std::memory_order_acq_rel);
+
+		if (dependency)
+		{
+			std::lock_guard<std::mutex> lock(dependency->m_mutex);
+			if (!dependency->isDone())
+			{
+				dependency->m_continuations.push_back(std::move(job));
+				return;
+			}
+		}
+		schedule(std::move(job));
+	}
+
+	void JobSystem::schedule(Job&& job)
+	{
+		if (job.affinity == JobAffinity::MainThread)
+		{
+			std::lock_guard<std::mutex> lock(s_mainQueue.mutex);
+			s_mainQueue.jobs.push_back(std::move(job));
+			return;
+		}
+
+		// Not started, run in place so callers behave the same either way
+		if (s_queues.empty())
+		{
+			{
+				EPHYRA_PROFILE_SCOPE("Job");
+				job.function();
+			}
+			finish(job);
+			return;
+		}
+
+		uint32_t queueCount = static_cast<uint32_t>(s_queues.size());
+		uint32_t index = t_queue >= 0 && static_cast<uint32_t>(t_queue) < queueCount ? static_cast<uint32_t>(t_queue) : s_nextQueue.fetch_add(1, std::memory_order_relaxed) % queueCount;
+		{
+			std::lock_guard<std::mutex> lock(s_queues[index]->mutex);
+			s_queues[index]->jobs.push_back(std::move(job));
+		}
+		s_queued.fetch_add(1, std::memory_order_release);
+
+		// Taking the lock orders this against a worker checking the count before it sleeps
+		{
+			std::lock_guard<std::mutex> lock(s_wakeMutex);
+		}
+		s_wake.notify_one();
+	}
+
+	void JobSystem::finish(Job& job)
+	{
+		if (!job.counter) return;
+		if (job.counter->m_pending.fetch_sub(1, std::memory_order_acq_rel) != 1) return;
+
+		std::vector<Job> continuations;
+		{
+			std::lock_guard<std::mutex> lock(job.counter->m_mutex);
+			continuations.swap(job.counter->m_continuations);
+		}
+		for (auto& continuation : continuations)
+			schedule(std::move(continuation));
+	}
+
+	bool JobSystem::tryRunJob(bool mainThread)
+	{
+		Job job;
+		bool found = false;
+
+		if (mainThread)
+		{
+			std::lock_guard<std::mutex> lock(s_mainQueue.mutex);
+			if (!s_mainQueue.jobs.empty())
+			{
+				job = std::move(s_mainQueue.jobs.front());
+				s_mainQueue.jobs.pop_front();
+				found = true;
+			}
+		}
+
+		uint32_t queueCount = static_cast<uint32_t>(s_queues.size());
+		int32_t own = t_queue >= 0 && static_cast<uint32_t>(t_queue) < queueCount ? t_queue : -1;
+
+		// Own jobs come off the back while they are still warm in cache
+		if (!found && own >= 0)
+		{
+			auto& queue = *s_queues[own];
+			std::lock_guard<std::mutex> lock(queue.mutex);
+			if (!queue.jobs.empty())
+			{
+				job = std::move(queue.jobs.back());
+				queue.jobs.pop_back();
+				found = true;
+			}
+		}
+
+		// Victims give up their oldest job, which tends to be the largest remaining piece of work
+		for (uint32_t i = 1; !found && i <= queueCount; i++)
+		{
+			uint32_t victim = static_cast<uint32_t>(own + static_cast<int32_t>(i)) % queueCount;
+			if (static_cast<int32_t>(victim) == own) continue;
+
+			auto& queue = *s_queues[victim];
+			std::lock_guard<std::mutex> lock(queue.mutex);
+			if (!queue.jobs.empty())
+			{
+				job = std::move(queue.jobs.front());
+				queue.jobs.pop_front();
+				found = true;
+			}
+		}
+
+		if (!found) return false;
+
+		if (job.affinity == JobAffinity::Any)
+			s_queued.fetch_sub(1, std::memory_order_acq_rel);
+
+		{
+			EPHYRA_PROFILE_SCOPE("Job");
+			job.function();
+		}
+		finish(job);
+		return true;
+	}
+
+	void JobSystem::workerLoop(uint32_t index)
+	{
+		t_queue = static_cast<int32_t>(index);
+		EPHYRA_PROFILE_THREAD(("Worker " + std::to_string(index)).c_str());
+
+		while (s_running)
+		{
+			if (tryRunJob(false)) continue;
+
+			std::unique_lock<std::mutex> lock(s_wakeMutex);
+			s_wake.wait(lock, []() { return s_queued.load(std::memory_order_acquire) > 0 || !s_running; });
+		}
+	}
+
+	void JobSystem::wait(const JobHandle& counter)
+	{
+		if (!counter) return;
+
+		bool mainThread = isMainThread();
+		while (!counter->isDone())
+		{
+			if (!tryRunJob(mainThread))
+				std::this_thread::yield();
+		}
+	}
+
+	void JobSystem::drainMainThread()
+	{
+		// Only the jobs queued so far, a job queueing another main thread job runs it next frame
+		std::deque<Job> jobs;
+		{
+			std::lock_guard<std::mutex> lock(s_mainQueue.mutex);
+			jobs.swap(s_mainQueue.jobs);
+		}
+		for (auto& job : jobs)
+		{
+			{
+				EPHYRA_PROFILE_SCOPE("Main Thread Job");
+				job.function();
+			}
+			finish(job);
+		}
+	}
+
+	uint32_t JobSystem::getWorkerCount()
+	{
+		return s_workerCount.load(std::memory_order_acquire);
+	}
+
+	bool JobSystem::isMainThread()
+	{
+		return std::this_thread::get_id() == s_mainThread;
+	}
+}
@@ -0,0 +1,351 @@
+/** \file profiler.cpp */
+#include "Ephyra_pch.h"
+#include "Core/Systems/Utility/Profiler.h"
+#include "Core/Systems/Utility/Log.h"
+
+#include <algorithm>
+#include <fstream>
+#include <mutex>
+#include <thread>
+#include <unordered_map>
+
+namespace Engine
+{
+	std::atomic<bool> Profiler::s_capturing{ false };
+	thread_local uint32_t ProfileScope::s_depth = 0;
+
+	namespace
+	{
+		/** \struct ProfileEvent
+		*	Finished zone
+		*/
+		struct ProfileEvent
+		{
+			const char* name; //!< Zone name
+			uint64_t start; //!< Timestamp entering the zone
+			uint64_t end; //!< Timestamp leaving the zone
+			uint32_t depth; //!< Zones it is nested in
+		};
+
+		/** \struct ThreadBuffer
+		*	Zones recorded by one thread, written only by that thread
+		*/
+		struct ThreadBuffer
+		{
+			std::vector<ProfileEvent> events; //!< Fixed size storage
+			std::atomic<uint32_t> count{ 0 }; //!< Events filled this capture, published with release
+			std::atomic<uint32_t> generation{ 0 }; //!< Capture the events belong to
+			std::atomic<bool> inUse{ true }; //!< Whether a live thread owns it
+			uint32_t index = 0; //!< Thread id in exported traces
+			std::string name; //!< Thread name in exported traces
+		};
+
+		/** \struct ThreadBufferHandle
+		*	Releases a thread's buffer for reuse when the thread exits
+		*/
+		struct ThreadBufferHandle
+		{
+			ThreadBuffer* buffer = nullptr; //!< Buffer owned by this thread
+			~ThreadBufferHandle() { if (buffer) buffer->inUse.store(false, std::memory_order_release); }
+		};
+
+		std::mutex s_buffersMutex; //!< Guards the buffer list, taken once per thread and when reading a capture
+		std::vector<std::unique_ptr<ThreadBuffer>> s_buffers; //!< Every buffer ever handed out
+		std::atomic<uint32_t> s_generation{ 0 }; //!< Current capture
+		std::atomic<uint32_t> s_dropped{ 0 }; //!< Zones lost to full buffers this capture
+
+		uint32_t s_pendingFrames = 0; //!< Frames requested for the next capture
+		uint32_t s_remainingFrames = 0; //!< Frames left in the running capture
+		bool s_ready = false; //!< Whether a finished capture is held
+		uint64_t s_startTicks = 0; //!< Timestamp of the first frame marker
+		uint64_t s_endTicks = 0; //!< Timestamp of the last frame marker
+		std::chrono::steady_clock::time_point s_startTime; //!< Clock time of the first frame marker
+		double s_ticksPerSecond = 0.0; //!< Rate of now(), calibrated by the first capture request and shared by the CPU and GPU tracks
+		std::vector<uint64_t> s_frameMarkers; //!< Timestamp of every frame marker in the capture
+		ProfilerStats s_stats; //!< Size of the last capture
+		ThreadBuffer* s_gpuBuffer = nullptr; //!< Track of GPU zones, filled by the main thread
+
+		thread_local ThreadBufferHandle t_buffer; //!< Buffer of the calling thread
+
+		ThreadBuffer* acquireBuffer()
+		{
+			std::lock_guard<std::mutex> lock(s_buffersMutex);
+
+			// Threads that exited leave their buffer behind, such as workers of a restarted job system
+			for (auto& buffer : s_buffers)
+			{
+				bool free = false;
+				if (buffer->inUse.compare_exchange_strong(free, true, std::memory_order_acq_rel))
+					return buffer.get();
+			}
+
+			s_buffers.emplace_back(new ThreadBuffer);
+			auto& buffer = *s_buffers.back();
+			buffer.events.resize(Profiler::bufferCapacity);
+			buffer.index = static_cast<uint32_t>(s_buffers.size() - 1);
+			buffer.name = "Thread " + std::to_string(buffer.index);
+			return &buffer;
+		}
+
+		ThreadBuffer& getBuffer()
+		{
+			if (!t_buffer.buffer) t_buffer.buffer = acquireBuffer();
+			return *t_buffer.buffer;
+		}
+
+		void store(ThreadBuffer& buffer, const char* name, uint64_t start, uint64_t end, uint32_t depth)
+		{
+			uint32_t generation = s_generation.load(std::memory_order_acquire);
+			if (buffer.generation.load(std::memory_order_relaxed) != generation)
+			{
+				buffer.count.store(0, std::memory_order_relaxed);
+				buffer.generation.store(generation, std::memory_order_release);
+			}
+
+			uint32_t index = buffer.count.load(std::memory_order_relaxed);
+			if (index >= Profiler::bufferCapacity)
+			{
+				s_dropped.fetch_add(1, std::memory_order_relaxed);
+				return;
+			}
+
+			buffer.events[index] = { name, start, end, depth };
+			buffer.count.store(index + 1, std::memory_order_release);
+		}
+
+		// Calls f(buffer, count) for every buffer holding events of the last capture, with the buffer list locked
+		template<typename Function>
+		void forEachCaptured(Function&& function)
+		{
+			uint32_t generation = s_generation.load(std::memory_order_acquire);
+			std::lock_guard<std::mutex> lock(s_buffersMutex);
+			for (auto& buffer : s_buffers)
+			{
+				if (buffer->generation.load(std::memory_order_acquire) != generation) continue;
+				uint32_t count = std::min(buffer->count.load(std::memory_order_acquire), Profiler::bufferCapacity);
+				if (count > 0) function(*buffer, count);
+			}
+		}
+
+		double toMicroseconds(uint64_t ticks)
+		{
+			return static_cast<double>(static_cast<int64_t>(ticks - s_startTicks)) * 1000000.0 / s_ticksPerSecond;
+		}
+
+		void writeString(std::ofstream& file, const char* text)
+		{
+			file << '"';
+			for (; *text; text++)
+			{
+				if (*text == '"' || *text == '\\') file << '\\';
+				file << *text;
+			}
+			file << '"';
+		}
+	}
+
+	void Profiler::beginCapture(uint32_t frames)
+	{
+		// Calibrated here, before any zone is recorded, so the GPU track never waits on it mid capture
+		getTicksPerSecond();
+		s_pendingFrames = std::max(1u, frames);
+	}
+
+	void Profiler::frame()
+	{
+		uint64_t ticks = now();
+
+		if (isCapturing())
+		{
+			s_frameMarkers.push_back(ticks);
+			if (--s_remainingFrames > 0) return;
+
+			s_capturing.store(false, std::memory_order_relaxed);
+			s_endTicks = ticks;
+			float seconds = std::chrono::duration<float>(std::chrono::steady_clock::now() - s_startTime).count();
+			s_ready = true;
+
+			s_stats = ProfilerStats();
+			s_stats.frames = static_cast<uint32_t>(s_frameMarkers.size() - 1);
+			s_stats.dropped = s_dropped.load(std::memory_order_relaxed);
+			s_stats.duration = seconds;
+			forEachCaptured([](ThreadBuffer& buffer, uint32_t count) {
+				s_stats.events += count;
+				s_stats.threads++;
+			});
+			Log::release("Profiler captured {0} frames, {1} zones on {2} threads, {3} dropped", s_stats.frames, s_stats.events, s_stats.threads, s_stats.dropped);
+			return;
+		}
+
+		if (s_pendingFrames == 0) return;
+
+		// Starting a new generation empties every thread's buffer the next time that thread records
+		s_generation.fetch_add(1, std::memory_order_acq_rel);
+		s_dropped = 0;
+		s_frameMarkers.clear();
+		s_frameMarkers.push_back(ticks);
+		s_startTicks = ticks;
+		s_startTime = std::chrono::steady_clock::now();
+		s_remainingFrames = s_pendingFrames;
+		s_pendingFrames = 0;
+		s_ready = false;
+		s_capturing.store(true, std::memory_order_relaxed);
+	}
+
+	void Profiler::record(const char* name, uint64_t start, uint64_t end, uint32_t depth)
+	{
+		// A zone still open when the capture ended is left out
+		if (!isCapturing()) return;
+
+		store(getBuffer(), name, start, end, depth);
+	}
+
+	void Profiler::recordGpu(const char* name, uint64_t start, uint64_t end, uint32_t depth)
+	{
+		if (!isCapturing()) return;
+
+		// Taken like a thread's buffer but never handed back, so it is not reused by a thread
+		if (!s_gpuBuffer)
+		{
+			s_gpuBuffer = acquireBuffer();
+			std::lock_guard<std::mutex> lock(s_buffersMutex);
+			s_gpuBuffer->name = "GPU";
+		}
+		store(*s_gpuBuffer, name, start, end, depth);
+	}
+
+	double Profiler::getTicksPerSecond()
+	{
+		if (s_ticksPerSecond > 0.0) return s_ticksPerSecond;
+
+#ifdef EPHYRA_PROFILER_TSC
+		// The time stamp counter runs at a constant rate on anything recent, it is timed against the clock once
+		auto startTime = std::chrono::steady_clock::now();
+		uint64_t startTicks = now();
+		std::this_thread::sleep_for(std::chrono::milliseconds(20));
+		uint64_t endTicks = now();
+		double seconds = std::chrono::duration<double>(std::chrono::steady_clock::now() - startTime).count();
+		s_ticksPerSecond = seconds > 0.0 ? static_cast<double>(endTicks - startTicks) / seconds : 1.0;
+#else
+		s_ticksPerSecond = static_cast<double>(std::chrono::steady_clock::period::den) / std::chrono::steady_clock::period::num;
+#endif
+		return s_ticksPerSecond;
+	}
+
+	bool Profiler::isCaptureReady()
+	{
+		return s_ready;
+	}
+
+	const ProfilerStats& Profiler::getStats()
+	{
+		return s_stats;
+	}
+
+	void Profiler::setThreadName(const char* name)
+	{
+		auto& buffer = getBuffer();
+		std::lock_guard<std::mutex> lock(s_buffersMutex);
+		buffer.name = name;
+	}
+
+	bool Profiler::exportChromeTrace(const std::string& filepath)
+	{
+		if (!s_ready)
+		{
+			Log::error("There is no finished profiler capture to export");
+			return false;
+		}
+
+		std::ofstream file(filepath);
+		if (!file)
+		{
+			Log::error("Cannot open {0} to write the profile", filepath);
+			return false;
+		}
+
+		file << "{\"traceEvents\":[\n";
+		bool first = true;
+		auto separate = [&]() { if (!first) file << ",\n"; first = false; };
+
+		forEachCaptured([&](ThreadBuffer& buffer, uint32_t count) {
+			separate();
+			file << "{\"name\":\"thread_name\",\"ph\":\"M\",\"pid\":1,\"tid\":" << buffer.index << ",\"args\":{\"name\":";
+			writeString(file, buffer.name.c_str());
+			file << "}}";
+
+			for (uint32_t i = 0; i < count; i++)
+			{
+				auto& event = buffer.events[i];
+				separate();
+				file << "{\"name\":";
+				writeString(file, event.name);
+				file << ",\"cat\":\"cpu\",\"ph\":\"X\",\"pid\":1,\"tid\":" << buffer.index << ",\"ts\":" << toMicroseconds(event.start) << ",\"dur\":" << toMicroseconds(event.end) - toMicroseconds(event.start) << ",\"args\":{\"depth\":" << event.depth << "}}";
+			}
+		});
+
+		for (uint32_t i = 0; i < s_frameMarkers.size(); i++)
+		{
+			separate();
+			file << "{\"name\":\"Frame " << i << "\",\"cat\":\"frame\",\"ph\":\"i\",\"s\":\"g\",\"pid\":1,\"tid\":0,\"ts\":" << toMicroseconds(s_frameMarkers[i]) << "}";
+		}
+
+		file << "\n],\"displayTimeUnit\":\"ms\"}\n";
+		Log::release("Profile of {0} frames written to {1}", s_stats.frames, filepath);
+		return true;
+	}
+
+	void Profiler::getZoneTotals(std::vector<ProfileZoneTotal>& totals)
+	{
+		totals.clear();
+		if (!s_ready) return;
+
+		// The same literal can live at different addresses in different translation units, so names are compared by value
+		std::unordered_map<std::string, ProfileZoneTotal> byName;
+		forEachCaptured([&](ThreadBuffer& buffer, uint32_t count) {
+			for (uint32_t i = 0; i < count; i++)
+			{
+				auto& event = buffer.events[i];
+				auto& total = byName[event.name];
+				total.time += static_cast<float>(static_cast<double>(event.end - event.start) / s_ticksPerSecond);
+				total.count++;
+			}
+		});
+
+		for (auto& entry : byName)
+		{
+			entry.second.name = entry.first;
+			totals.push_back(entry.second);
+		}
+		std::sort(totals.begin(), totals.end(), [](const ProfileZoneTotal& a, const ProfileZoneTotal& b) { return a.time > b.time; });
+	}
+
+	float Profiler::measureOverhead(uint32_t zones)
+	{
+		if (isCapturing() || s_pendingFrames > 0)
+		{
+			Log::error("Cannot measure the profiler overhead during a capture");
+			return 0.f;
+		}
+
+		// Runs as a capture of its own so every zone takes the recording path, then discards it
+		zones = std::min(std::max(1u, zones), bufferCapacity);
+		s_generation.fetch_add(1, std::memory_order_acq_rel);
+		s_capturing.store(true, std::memory_order_relaxed);
+
+		auto start = std::chrono::steady_clock::now();
+		for (uint32_t i = 0; i < zones; i++)
+		{
+			ProfileScope scope("Overhead");
+		}
+		float seconds = std::chrono::duration<float>(std::chrono::steady_clock::now() - start).count();
+
+		s_capturing.store(false, std::memory_order_relaxed);
+		s_generation.fetch_add(1, std::memory_order_acq_rel);
+		s_ready = false;
+
+		float nanoseconds = seconds * 1000000000.f / zones;
+		Log::release("Profiler overhead: {0} ns per zone over {1} zones", nanoseconds, zones);
+		return nanoseconds;
+	}
+}
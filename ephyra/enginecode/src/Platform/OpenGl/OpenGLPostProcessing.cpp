@@ -2,6 +2,7 @@
 #include "Platform/OpenGl/OpenGLPostProcessing.h"
 #include <Core/Initialization/GlobalProperties.h>
 #include "Core/Rendering/API/Global/RendererCommon.h"
+#include "Core/Rendering/API/Global/RenderStats.h"
 
 Engine::OpenGLPostProcessing::OpenGLPostProcessing()
 {
@@ -44,52 +45,62 @@ Engine::OpenGLPostProcessing::~OpenGLPostProcessing()
 uint32_t Engine::OpenGLPostProcessing::ApplyBloomEffect(uint32_t sceneTexture)
 {
     glUseProgram(ColorExtractShaderProgram->getID());
+    Engine::RenderStats::programBind();
 
     glBindImageTexture(0, sceneTexture, 0, GL_FALSE, 0, GL_READ_ONLY, GL_RGBA32F);
     glBindImageTexture(1, BrightColorTexture->getID(), 0, GL_FALSE, 0, GL_WRITE_ONLY, GL_RGBA32F);
 
     glDispatchCompute(ceil((float)SCR_WIDTH / 16), ceil((float)SCR_HEIGHT / 16), 1);
+    Engine::RenderStats::dispatch();
 
     glMemoryBarrier(GL_SHADER_IMAGE_ACCESS_BARRIER_BIT);
 
 
     glUseProgram(DownSampleShaderProgram->getID());
+    Engine::RenderStats::programBind();
 
     glBindImageTexture(1, BrightColorTexture->getID(), 0, GL_FALSE, 0, GL_READ_ONLY, GL_RGBA32F);
     glBindImageTexture(2, DownSampleTexture->getID(), 0, GL_FALSE, 0, GL_WRITE_ONLY, GL_RGBA32F);
 
     glDispatchCompute(ceil((float)SCR_WIDTH / 16), ceil((float)SCR_HEIGHT / 16), 1);
+    Engine::RenderStats::dispatch();
 
     glMemoryBarrier(GL_SHADER_IMAGE_ACCESS_BARRIER_BIT);
 
 
     glUseProgram(GaussianBlurHShaderProgram->getID());
+    Engine::RenderStats::programBind();
 
     glBindImageTexture(2, DownSampleTexture->getID(), 0, GL_FALSE, 0, GL_READ_ONLY, GL_RGBA32F);
     glBindImageTexture(3, BlurredTextureH->getID(), 0, GL_FALSE, 0, GL_WRITE_ONLY, GL_RGBA32F);
 
     glDispatchCompute(ceil((float)SCR_WIDTH / 16), ceil((float)SCR_HEIGHT / 16), 1);
+    Engine::RenderStats::dispatch();
 
     glMemoryBarrier(GL_SHADER_IMAGE_ACCESS_BARRIER_BIT);
 
 
     glUseProgram(GaussianBlurVShaderProgram->getID());
+    Engine::RenderStats::programBind();
 
     glBindImageTexture(3, BlurredTextureH->getID(), 0, GL_FALSE, 0, GL_READ_ONLY, GL_RGBA32F);
     glBindImageTexture(4, BlurredTextureV->getID(), 0, GL_FALSE, 0, GL_WRITE_ONLY, GL_RGBA32F);
 
     glDispatchCompute(ceil((float)SCR_WIDTH / 16), ceil((float)SCR_HEIGHT / 16), 1);
+    Engine::RenderStats::dispatch();
 
     glMemoryBarrier(GL_SHADER_IMAGE_ACCESS_BARRIER_BIT);
 
 
     glUseProgram(UpSampleCombineShaderProgram->getID());
+    Engine::RenderStats::programBind();
 
     glBindImageTexture(0, sceneTexture, 0, GL_FALSE, 0, GL_READ_ONLY, GL_RGBA32F);
     glBindImageTexture(4, BlurredTextureV->getID(), 0, GL_FALSE, 0, GL_READ_ONLY, GL_RGBA32F);
     glBindImageTexture(5, BloomColorTexture->getID(), 0, GL_FALSE, 0, GL_READ_ONLY, GL_RGBA32F);
 
     glDispatchCompute(ceil((float)SCR_WIDTH / 16), ceil((float)SCR_HEIGHT / 16), 1);
+    Engine::RenderStats::dispatch();
 
     glMemoryBarrier(GL_SHADER_IMAGE_ACCESS_BARRIER_BIT);
 
@@ -99,26 +110,31 @@ uint32_t Engine::OpenGLPostProcessing::ApplyBloomEffect(uint32_t sceneTexture)
 uint32_t Engine::OpenGLPostProcessing::ApplyDOFEffect(uint32_t depthTexture, uint32_t sceneTexture)
 {
     glUseProgram(GaussianBlurHShaderProgram->getID());
+    Engine::RenderStats::programBind();
 
     glBindImageTexture(2, sceneTexture, 0, GL_FALSE, 0, GL_READ_ONLY, GL_RGBA32F);
     glBindImageTexture(3, BlurredTextureH->getID(), 0, GL_FALSE, 0, GL_WRITE_ONLY, GL_RGBA32F);
 
     glDispatchCompute(ceil((float)SCR_WIDTH / 16), ceil((float)SCR_HEIGHT / 16), 1);
+    Engine::RenderStats::dispatch();
 
     glMemoryBarrier(GL_SHADER_IMAGE_ACCESS_BARRIER_BIT);
 
 
     glUseProgram(GaussianBlurVShaderProgram->getID());
+    Engine::RenderStats::programBind();
 
     glBindImageTexture(3, BlurredTextureH->getID(), 0, GL_FALSE, 0, GL_READ_ONLY, GL_RGBA32F);
     glBindImageTexture(4, BlurredTextureV->getID(), 0, GL_FALSE, 0, GL_WRITE_ONLY, GL_RGBA32F);
 
     glDispatchCompute(ceil((float)SCR_WIDTH / 16), ceil((float)SCR_HEIGHT / 16), 1);
+    Engine::RenderStats::dispatch();
 
     glMemoryBarrier(GL_SHADER_IMAGE_ACCESS_BARRIER_BIT);
     
 
     glUseProgram(DOFShaderProgram->getID());
+    Engine::RenderStats::programBind();
 
     glActiveTexture(GL_TEXTURE0 + 32);
     glBindTexture(GL_TEXTURE_2D, depthTexture);
@@ -131,6 +147,7 @@ uint32_t Engine::OpenGLPostProcessing::ApplyDOFEffect(uint32_t depthTexture, uin
     DOFShaderProgram->uploadInt("depthTexture", 32);
 
     glDispatchCompute(ceil((float)SCR_WIDTH / 16), ceil((float)SCR_HEIGHT / 16), 1);
+    Engine::RenderStats::dispatch();
 
     glMemoryBarrier(GL_SHADER_IMAGE_ACCESS_BARRIER_BIT);
 
@@ -140,11 +157,13 @@ uint32_t Engine::OpenGLPostProcessing::ApplyDOFEffect(uint32_t depthTexture, uin
 uint32_t Engine::OpenGLPostProcessing::ApplyToneMappingEffect(uint32_t sceneTexture)
 {
     glUseProgram(ToneMappingShaderProgram->getID());
+    Engine::RenderStats::programBind();
 
     glBindImageTexture(0, sceneTexture, 0, GL_FALSE, 0, GL_READ_ONLY, GL_RGBA32F);
     glBindImageTexture(1, ToneMappingColorTexture->getID(), 0, GL_FALSE, 0, GL_WRITE_ONLY, GL_RGBA32F);
 
     glDispatchCompute(ceil((float)SCR_WIDTH / 16), ceil((float)SCR_HEIGHT / 16), 1);
+    Engine::RenderStats::dispatch();
 
     glMemoryBarrier(GL_SHADER_IMAGE_ACCESS_BARRIER_BIT);
 
@@ -154,6 +173,7 @@ uint32_t Engine::OpenGLPostProcessing::ApplyToneMappingEffect(uint32_t sceneText
 uint32_t Engine::OpenGLPostProcessing::ApplyVignetteEffect(uint32_t sceneTexture)
 {
     glUseProgram(VignetteShaderProgram->getID());
+    Engine::RenderStats::programBind();
 
     glBindImageTexture(0, sceneTexture, 0, GL_FALSE, 0, GL_READ_ONLY, GL_RGBA32F);
     glBindImageTexture(1, VignetteColorTexture->getID(), 0, GL_FALSE, 0, GL_WRITE_ONLY, GL_RGBA32F);
@@ -161,6 +181,7 @@ uint32_t Engine::OpenGLPostProcessing::ApplyVignetteEffect(uint32_t sceneTexture
     VignetteShaderProgram->uploadFloat2("screenSize", glm::vec2((float)SCR_WIDTH, (float)SCR_HEIGHT));
 
     glDispatchCompute(ceil((float)SCR_WIDTH / 16), ceil((float)SCR_HEIGHT / 16), 1);
+    Engine::RenderStats::dispatch();
 
     glMemoryBarrier(GL_SHADER_IMAGE_ACCESS_BARRIER_BIT);
 
@@ -170,6 +191,7 @@ uint32_t Engine::OpenGLPostProcessing::ApplyVignetteEffect(uint32_t sceneTexture
 uint32_t Engine::OpenGLPostProcessing::ApplyVolumetricEffect(uint32_t depthTexture, uint32_t sceneTexture)
 {
     glUseProgram(VolumetricShaderProgram->getID());
+    Engine::RenderStats::programBind();
 
     glActiveTexture(GL_TEXTURE0 + 32);
     glBindTexture(GL_TEXTURE_2D, depthTexture);
@@ -180,6 +202,7 @@ uint32_t Engine::OpenGLPostProcessing::ApplyVolumetricEffect(uint32_t depthTextu
     VolumetricShaderProgram->uploadInt("depthTexture", 32);
 
     glDispatchCompute(ceil((float)SCR_WIDTH / 16), ceil((float)SCR_HEIGHT / 16), 1);
+    Engine::RenderStats::dispatch();
 
     glMemoryBarrier(GL_SHADER_IMAGE_ACCESS_BARRIER_BIT);
     glActiveTexture(GL_TEXTURE0);
@@ -190,11 +213,13 @@ uint32_t Engine::OpenGLPostProcessing::ApplyVolumetricEffect(uint32_t depthTextu
 void Engine::OpenGLPostProcessing::updateColorFBO(uint32_t processedTexture, uint32_t outputTexture)
 {
     glUseProgram(CleanUpShaderProgram->getID());
+    Engine::RenderStats::programBind();
 
     glBindImageTexture(0, processedTexture, 0, GL_FALSE, 0, GL_READ_ONLY, GL_RGBA32F);
     glBindImageTexture(1, outputTexture, 0, GL_FALSE, 0, GL_WRITE_ONLY, GL_RGBA32F);
 
     glDispatchCompute(ceil((float)SCR_WIDTH / 16), ceil((float)SCR_HEIGHT / 16), 1);
+    Engine::RenderStats::dispatch();
 
     glMemoryBarrier(GL_SHADER_IMAGE_ACCESS_BARRIER_BIT);
 }
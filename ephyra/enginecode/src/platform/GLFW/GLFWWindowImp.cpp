@@ -33,12 +33,13 @@ namespace Engine
 
 		const GLFWvidmode* mode = glfwGetVideoMode(primary);
 
-		glfwWindowHint(GLFW_REFRESH_RATE, mode->refreshRate);
+		if (mode) glfwWindowHint(GLFW_REFRESH_RATE, mode->refreshRate);
 
 		m_props.m_width = SCR_WIDTH;
 		m_props.m_height = SCR_HEIGHT;
 
 		glfwWindowHint(GLFW_DECORATED, GLFW_TRUE);
+		glfwWindowHint(GLFW_VISIBLE, m_props.m_isHidden ? GLFW_FALSE : GLFW_TRUE);
 
 		m_aspectRatio = static_cast<float>(ASPECT_RATIO.x / ASPECT_RATIO.y);
 
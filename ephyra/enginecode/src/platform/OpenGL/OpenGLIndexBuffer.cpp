@@ -3,6 +3,7 @@
 #include "Ephyra_pch.h"
 #include <glad/glad.h>
 #include "Platform/OpenGl/OpenGLIndexBuffer.h"
+#include "Core/Rendering/API/Global/RenderStats.h"
 
 namespace Engine
 {
@@ -22,6 +23,7 @@ namespace Engine
 	{
 		glBindBuffer(GL_ELEMENT_ARRAY_BUFFER, m_OpenGL_ID);
 		glBufferSubData(GL_ELEMENT_ARRAY_BUFFER, offsetIndex * sizeof(uint32_t), count * sizeof(uint32_t), indices);
+		RenderStats::upload(count * sizeof(uint32_t));
 	}
 
 }
\ No newline at end of file
@@ -2,6 +2,7 @@
 
 #include "Ephyra_pch.h"
 #include "Platform/OpenGl/OpenGLIndirectBuffer.h"
+#include "Core/Rendering/API/Global/RenderStats.h"
 #include <glad/glad.h>
 
 namespace Engine
@@ -16,7 +17,7 @@ namespace Engine
 		m_OpenGL_ID = NULL;
 		glGenBuffers(1, &m_OpenGL_ID);
 		glBindBuffer(GL_DRAW_INDIRECT_BUFFER, m_OpenGL_ID);
-		glBufferData(GL_DRAW_INDIRECT_BUFFER, count, commands, GL_DYNAMIC_DRAW);
+		glBufferData(GL_DRAW_INDIRECT_BUFFER, count * sizeof(DrawElementsIndirectCommand), commands, GL_DYNAMIC_DRAW);
 
 	}
 
@@ -30,6 +31,7 @@ namespace Engine
 
 		glBindBuffer(GL_DRAW_INDIRECT_BUFFER, m_OpenGL_ID);
 		glBufferSubData(GL_DRAW_INDIRECT_BUFFER, offset, count * sizeof(DrawElementsIndirectCommand), commands);
+		RenderStats::upload(count * sizeof(DrawElementsIndirectCommand));
 
 	}
 
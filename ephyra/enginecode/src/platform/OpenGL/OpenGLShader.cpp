@@ -6,6 +6,8 @@
 #include <glad/glad.h>
 #include <fstream>
 #include "Core/Systems/Utility/Log.h"
+#include "Core/Rendering/API/Global/RenderStats.h"
+#include "Core/Systems/Utility/Profiler.h"
 #include <string>
 #include <array>
 #include <glm/gtc/type_ptr.hpp>
@@ -14,6 +16,7 @@ namespace Engine
 {
 	OpenGLShader::OpenGLShader(const char* vertexFilepath, const char* fragmentFilepath)
 	{
+		EPHYRA_PROFILE_SCOPE("Load Shader");
 		std::string line, vertexSrc, fragmentSrc;
 
 		std::fstream handle(vertexFilepath, std::ios::in);
@@ -47,6 +50,7 @@ namespace Engine
 
 	OpenGLShader::OpenGLShader(const char* filepath)
 	{
+		EPHYRA_PROFILE_SCOPE("Load Shader");
 		enum Region { None = -1, Vertex = 0, Fragment, Geometry, TesselationControl, TesselationEvaluation, Compute };
 		bool v = false; bool f = false; bool g = false; bool tc = false; bool te = false; bool c = false;
 		std::string line;
@@ -219,16 +223,19 @@ namespace Engine
 	{
 		glUseProgram(m_OpenGL_ID);
 		glBindVertexArray(modelID);
+		RenderStats::programBind();
 	}
 
 	void OpenGLShader::drawObj(std::shared_ptr<VertexArray> modelVAO)
 	{
 		glDrawElements(GL_TRIANGLES, modelVAO->getDrawCount(), GL_UNSIGNED_INT, nullptr);
+		RenderStats::draw();
 	}
 
 	void OpenGLShader::drawQuads(std::shared_ptr<VertexArray> modelVAO, uint32_t drawCount)
 	{
 		glDrawElements(GL_QUADS, drawCount, GL_UNSIGNED_INT, nullptr);
+		RenderStats::draw();
 	}
 
 	void OpenGLShader::compileAndLink(const char* vertexShaderSrc, const char* fragmentShaderSrc)
@@ -4,7 +4,9 @@
 #include "Platform/OpenGl/OpenGLTexture.h"
 #include <glad/glad.h>
 #include "Core/Systems/Utility/Log.h"
+#include "Core/Systems/Utility/Profiler.h"
 #include "Core/Rendering/API/Global/RendererCommon.h"
+#include "Core/Rendering/API/Global/RenderStats.h"
 
 #define STB_IMAGE_IMPLEMENTATION
 #include "stb_image.h"
@@ -14,6 +16,7 @@ namespace Engine
 
 	OpenGLTexture::OpenGLTexture(const char* filepath)
 	{
+		EPHYRA_PROFILE_SCOPE("Load Texture");
 		m_filepath = filepath;
 
 		int width, height, channels;
@@ -32,6 +35,27 @@ namespace Engine
 		
 	}
 
+	OpenGLTexture::OpenGLTexture(uint32_t width, uint32_t height, uint32_t channels, float* data)
+	{
+		glGenTextures(1, &m_OpenGl_ID);
+		glBindTexture(GL_TEXTURE_2D, m_OpenGl_ID);
+
+		// Data textures are fetched per texel, no filtering or mips
+		glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_WRAP_S, GL_CLAMP_TO_EDGE);
+		glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_WRAP_T, GL_CLAMP_TO_EDGE);
+		glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_MIN_FILTER, GL_NEAREST);
+		glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_MAG_FILTER, GL_NEAREST);
+
+		if (channels == 1) glTexImage2D(GL_TEXTURE_2D, 0, GL_R32F, width, height, 0, GL_RED, GL_FLOAT, data);
+		else if (channels == 3) glTexImage2D(GL_TEXTURE_2D, 0, GL_RGB32F, width, height, 0, GL_RGB, GL_FLOAT, data);
+		else if (channels == 4) glTexImage2D(GL_TEXTURE_2D, 0, GL_RGBA32F, width, height, 0, GL_RGBA, GL_FLOAT, data);
+		else Log::error("Float textures need 1, 3 or 4 channels, got {0}", channels);
+
+		m_width = width;
+		m_height = height;
+		m_channels = channels;
+	}
+
 	OpenGLTexture::~OpenGLTexture()
 	{
 		glDeleteTextures(1, &m_OpenGl_ID);
@@ -43,9 +67,21 @@ namespace Engine
 		if (data)
 		{
 			if (m_channels == 0) glTexSubImage2D(GL_TEXTURE_2D, 0, GL_DEPTH_COMPONENT32F, width, height, 0, GL_DEPTH_COMPONENT, GL_FLOAT, data);
-			if (m_channels == 1) glTextureSubImage2D(m_OpenGl_ID, 0.f, xOffset, yOffset, width, height, GL_RED, GL_UNSIGNED_BYTE, data);
-			if (m_channels == 3) glTextureSubImage2D(m_OpenGl_ID, 0.f, xOffset, yOffset, width, height, GL_RGB, GL_UNSIGNED_BYTE, data);
-			else if (m_channels == 4) glTextureSubImage2D(m_OpenGl_ID, 0.f, xOffset, yOffset, width, height, GL_RGBA, GL_UNSIGNED_BYTE, data);
+			if (m_channels == 1)
+			{
+				glTextureSubImage2D(m_OpenGl_ID, 0.f, xOffset, yOffset, width, height, GL_RED, GL_UNSIGNED_BYTE, data);
+				RenderStats::upload(static_cast<uint64_t>(width) * height);
+			}
+			if (m_channels == 3)
+			{
+				glTextureSubImage2D(m_OpenGl_ID, 0.f, xOffset, yOffset, width, height, GL_RGB, GL_UNSIGNED_BYTE, data);
+				RenderStats::upload(static_cast<uint64_t>(width) * height * 3);
+			}
+			else if (m_channels == 4)
+			{
+				glTextureSubImage2D(m_OpenGl_ID, 0.f, xOffset, yOffset, width, height, GL_RGBA, GL_UNSIGNED_BYTE, data);
+				RenderStats::upload(static_cast<uint64_t>(width) * height * 4);
+			}
 		}
 	}
 
@@ -53,6 +89,7 @@ namespace Engine
 	{
 		glActiveTexture(GL_TEXTURE0 + unit);
 		glBindTexture(GL_TEXTURE_2D, m_OpenGl_ID);
+		RenderStats::textureBind();
 	}
 
 	void OpenGLTexture::init(uint32_t width, uint32_t height, uint32_t channels, unsigned char* data)
@@ -5,6 +5,7 @@
 #include "Platform/OpenGl/OpenGLUniformBuffer.h"
 #include <glad/glad.h>
 #include "Core/Systems/Utility/Log.h"
+#include "Core/Rendering/API/Global/RenderStats.h"
 
 namespace Engine {
 
@@ -46,6 +47,7 @@ namespace Engine {
 
 		auto& pair = m_uniformCache[uniformName];
 		glBufferSubData(GL_UNIFORM_BUFFER, pair.first, pair.second, data);
+		RenderStats::upload(pair.second);
 	}
 
 	void OpenGLUniformBuffer::bindUniformBuffer()
@@ -4,6 +4,7 @@
 
 #include <glad/glad.h>
 #include "Platform/OpenGl/OpenGLVertexBuffer.h"
+#include "Core/Rendering/API/Global/RenderStats.h"
 
 namespace Engine
 {
@@ -24,6 +25,7 @@ namespace Engine
 	{
 		glBindBuffer(GL_ARRAY_BUFFER, m_OpenGL_ID);
 		glBufferSubData(GL_ARRAY_BUFFER, offset, size, vertices);
+		RenderStats::upload(size);
 	}
 
 }
\ No newline at end of file
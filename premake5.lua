@@ -132,6 +132,175 @@ project "Sandbox"
 		runtime "Release"
 		optimize "On"
 
+project "Benchmark"
+	location "benchmark"
+	kind "ConsoleApp"
+	language "C++"
+	staticruntime "off"
+	debugdir "sandbox"
+
+	targetdir ("bin/" .. outputdir .. "/%{prj.name}")
+	objdir ("build/" .. outputdir .. "/%{prj.name}")
+
+	files
+	{
+		"%{prj.name}/include/**.h",
+		"%{prj.name}/src/**.cpp",
+	}
+
+	includedirs
+	{
+		"%{prj.name}/include",
+		"ephyra/enginecode/",
+		"ephyra/enginecode/include/Core",
+		"ephyra/enginecode/include/",
+		"ephyra/precompiled/",
+		"vendor/assimp/include",
+		"vendor/glfw/include",
+		"vendor/Glad/include",
+		"vendor/glm/",
+		"vendor/spdlog/include",
+		"vendor/freetype2/include",
+		"vendor/json/single_include/nlohmann",
+		"vendor/enTT"
+	}
+
+	links
+	{
+		"Ephyra"
+	}
+
+	filter "system:windows"
+		cppdialect "C++17"
+		systemversion "latest"
+
+		defines
+		{
+			"NG_PLATFORM_WINDOWS"
+		}
+
+	filter "configurations:Debug"
+		defines "NG_DEBUG"
+		runtime "Debug"
+		symbols "On"
+
+	filter "configurations:Release"
+		defines "NG_RELEASE"
+		runtime "Release"
+		optimize "On"
+
+project "BenchmarkCPU"
+	location "benchmark/cpu"
+	kind "ConsoleApp"
+	language "C++"
+	staticruntime "off"
+	debugdir "sandbox"
+
+	targetdir ("bin/" .. outputdir .. "/%{prj.name}")
+	objdir ("build/" .. outputdir .. "/%{prj.name}")
+
+	files
+	{
+		"benchmark/cpu/include/**.h",
+		"benchmark/cpu/src/**.cpp",
+	}
+
+	includedirs
+	{
+		"benchmark/cpu/include",
+		"ephyra/enginecode/",
+		"ephyra/enginecode/include/Core",
+		"ephyra/enginecode/include/",
+		"ephyra/precompiled/",
+		"vendor/assimp/include",
+		"vendor/glfw/include",
+		"vendor/Glad/include",
+		"vendor/glm/",
+		"vendor/spdlog/include",
+		"vendor/freetype2/include",
+		"vendor/json/single_include/nlohmann",
+		"vendor/enTT"
+	}
+
+	links
+	{
+		"Ephyra"
+	}
+
+	filter "system:windows"
+		cppdialect "C++17"
+		systemversion "latest"
+
+		defines
+		{
+			"NG_PLATFORM_WINDOWS"
+		}
+
+	filter "configurations:Debug"
+		defines "NG_DEBUG"
+		runtime "Debug"
+		symbols "On"
+
+	filter "configurations:Release"
+		defines "NG_RELEASE"
+		runtime "Release"
+		optimize "On"
+
+project "RenderReplay"
+	location "benchmark/replay"
+	kind "ConsoleApp"
+	language "C++"
+	staticruntime "off"
+	debugdir "sandbox"
+
+	targetdir ("bin/" .. outputdir .. "/%{prj.name}")
+	objdir ("build/" .. outputdir .. "/%{prj.name}")
+
+	files
+	{
+		"benchmark/replay/src/**.cpp",
+	}
+
+	includedirs
+	{
+		"ephyra/enginecode/",
+		"ephyra/enginecode/include/Core",
+		"ephyra/enginecode/include/",
+		"ephyra/precompiled/",
+		"vendor/assimp/include",
+		"vendor/glfw/include",
+		"vendor/Glad/include",
+		"vendor/glm/",
+		"vendor/spdlog/include",
+		"vendor/freetype2/include",
+		"vendor/json/single_include/nlohmann",
+		"vendor/enTT"
+	}
+
+	links
+	{
+		"Ephyra"
+	}
+
+	filter "system:windows"
+		cppdialect "C++17"
+		systemversion "latest"
+
+		defines
+		{
+			"NG_PLATFORM_WINDOWS"
+		}
+
+	filter "configurations:Debug"
+		defines "NG_DEBUG"
+		runtime "Debug"
+		symbols "On"
+
+	filter "configurations:Release"
+		defines "NG_RELEASE"
+		runtime "Release"
+		optimize "On"
+
 group "Vendor"
 
 	include "vendor/glfw"
@@ -7,13 +7,15 @@ layout(location = 1) in vec3 a_vertexNormal;
 layout(location = 2) in vec2 a_texCoord;
 layout(location = 3) in vec4 a_boneIndices;
 layout(location = 4) in vec4 a_boneWeights;
-layout(location = 5) in mat4 a_model;
-layout(location = 9) in vec4 a_tint; // MATERIAL m_tint
-layout(location = 10) in int a_albedo;
-layout(location = 11) in int a_metallic;
-layout(location = 12) in int a_roughness;
-layout(location = 13) in int a_ao;
-layout(location = 14) in int a_normal;
+layout(location = 5) in vec4 a_instance0; // Affine row 0, or rigid rotation quaternion
+layout(location = 6) in vec4 a_instance1; // Affine row 1, or rigid position
+layout(location = 7) in vec4 a_instance2; // Affine row 2, or rigid uniform scale in x
+layout(location = 8) in vec4 a_tint; // MATERIAL m_tint, (time offset, rate) for vertex animation crowds
+layout(location = 9) in int a_albedo;
+layout(location = 10) in int a_metallic;
+layout(location = 11) in int a_roughness;
+layout(location = 12) in int a_ao;
+layout(location = 13) in int a_normal;
 
 out vec3 worldPos;
 out vec3 norm;
@@ -34,7 +36,11 @@ layout (std140) uniform b_camera
 	mat4 u_view;
 };
 
+// Depth prepass computes the same static path position, shading then tests for equal depth
+invariant gl_Position;
+
 uniform int ImmediateMode;
+uniform int InstanceEncoding; // 0 = 3x4 affine rows, 1 = rigid quaternion, position and uniform scale
 
 uniform int AlbedoTex;
 uniform int MetallicTex;
@@ -46,8 +52,68 @@ uniform vec4 TintCol;
 
 uniform mat4 boneMatrices[100];
 
+uniform int VertexAnimation;
+uniform sampler2D VATPositions;
+uniform sampler2D VATNormals;
+uniform int VATBaseVertex;
+uniform int VATVertexCount;
+uniform int VATFrameCount;
+uniform int VATWidth;
+uniform float VATFramesPerSecond;
+uniform float VATTime;
+
+vec4 fetchVAT(sampler2D tex, int frame, int vertex)
+{
+    int texel = frame * VATVertexCount + vertex;
+    return texelFetch(tex, ivec2(texel % VATWidth, texel / VATWidth), 0);
+}
+
+mat4 decodeInstance()
+{
+    if (InstanceEncoding == 1)
+    {
+        vec4 q = a_instance0;
+        float s = a_instance2.x;
+        vec3 x = vec3(1.0 - 2.0 * (q.y * q.y + q.z * q.z), 2.0 * (q.x * q.y + q.w * q.z), 2.0 * (q.x * q.z - q.w * q.y));
+        vec3 y = vec3(2.0 * (q.x * q.y - q.w * q.z), 1.0 - 2.0 * (q.x * q.x + q.z * q.z), 2.0 * (q.y * q.z + q.w * q.x));
+        vec3 z = vec3(2.0 * (q.x * q.z + q.w * q.y), 2.0 * (q.y * q.z - q.w * q.x), 1.0 - 2.0 * (q.x * q.x + q.y * q.y));
+        return mat4(vec4(x * s, 0.0), vec4(y * s, 0.0), vec4(z * s, 0.0), vec4(a_instance1.xyz, 1.0));
+    }
+
+    // Rows go in as columns, transposing restores the matrix and its implicit (0,0,0,1) bottom row
+    return transpose(mat4(a_instance0, a_instance1, a_instance2, vec4(0.0, 0.0, 0.0, 1.0)));
+}
+
 void main()
 {
+    if (VertexAnimation == 1)
+    {
+        Albedo = AlbedoTex;
+        Metallic = MetallicTex;
+        Roughness = RoughnessTex;
+        Ao = AOTex;
+        Normal = NormalTex;
+        model = decodeInstance();
+        tints = TintCol;
+
+        // Per instance playback, blended between the two nearest baked frames
+        float frame = mod((VATTime * a_tint.y + a_tint.x) * VATFramesPerSecond, float(VATFrameCount));
+        int frame0 = int(floor(frame));
+        int frame1 = (frame0 + 1) % VATFrameCount;
+        float blend = fract(frame);
+        int vertex = gl_VertexID - VATBaseVertex;
+
+        vec3 position = mix(fetchVAT(VATPositions, frame0, vertex).xyz, fetchVAT(VATPositions, frame1, vertex).xyz, blend);
+        vec3 normal = mix(fetchVAT(VATNormals, frame0, vertex).xyz, fetchVAT(VATNormals, frame1, vertex).xyz, blend);
+
+        worldPos = vec3(model * vec4(position, 1.0));
+        norm = normalize(mat3(transpose(inverse(model))) * normal);
+        texCoords = vec2(a_texCoord.x, a_texCoord.y);
+
+        gl_Position = u_projection * u_view * vec4(worldPos, 1.0);
+        return;
+    }
+
     if (ImmediateMode == 1)
     {
 	    Albedo = AlbedoTex;
@@ -58,6 +124,17 @@ void main()
         model = ModelMat;
         tints = vec4(1.0f); //TintCol;
     }
+    else if (ImmediateMode == 2)
+    {
+        // Retained slots, the material is uniform per draw and only the transform and tint are per instance
+        Albedo = AlbedoTex;
+        Metallic = MetallicTex;
+        Roughness = RoughnessTex;
+        Ao = AOTex;
+        Normal = NormalTex;
+        model = decodeInstance();
+        tints = a_tint;
+    }
     else
     {
 	    Albedo = a_albedo;
@@ -65,7 +142,7 @@ void main()
 	    Roughness = a_roughness;
 	    Ao = a_ao;
         Normal = a_normal;
-        model = a_model;
+        model = decodeInstance();
         tints = a_tint;
     }
 
@@ -128,6 +205,8 @@ out mat4 Model;
 
 out mat3 TBNMat;
 
+invariant gl_Position;
+
 void main()
 {
     for(int i = 0; i < 3; i++)
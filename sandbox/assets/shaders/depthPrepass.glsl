@@ -0,0 +1,23 @@
+#region Vertex
+#version 440 core
+
+layout(location = 0) in vec3 a_vertexPosition;
+layout(location = 1) in vec4 a_instance0; // Affine row 0
+layout(location = 2) in vec4 a_instance1; // Affine row 1
+layout(location = 3) in vec4 a_instance2; // Affine row 2
+
+layout (std140) uniform b_camera
+{
+	mat4 u_projection;
+	mat4 u_view;
+};
+
+// Must match the PBR static path bit for bit, shading runs with an equal depth test
+invariant gl_Position;
+
+void main()
+{
+    mat4 model = transpose(mat4(a_instance0, a_instance1, a_instance2, vec4(0.0, 0.0, 0.0, 1.0)));
+    mat4 MVP = u_projection * u_view * model;
+    gl_Position = MVP * vec4(a_vertexPosition, 1.0);
+}
@@ -0,0 +1,37 @@
+#region Compute
+#version 440 core
+
+layout (local_size_x = 16, local_size_y = 16) in;
+
+layout (r32f, binding = 0) uniform writeonly image2D dstLevel;
+layout (r32f, binding = 1) uniform readonly image2D srcLevel;
+
+uniform sampler2D depthTex;
+uniform int sourceIsDepth;
+
+void main()
+{
+    ivec2 dst = ivec2(gl_GlobalInvocationID.xy);
+    ivec2 dstSize = imageSize(dstLevel);
+    if (dst.x >= dstSize.x || dst.y >= dstSize.y) return;
+
+    if (sourceIsDepth == 1)
+    {
+        imageStore(dstLevel, dst, vec4(texelFetch(depthTex, dst, 0).r));
+        return;
+    }
+
+    // Odd sized sources fold their last row and column into the last texel so no depth is dropped
+    ivec2 srcSize = imageSize(srcLevel);
+    ivec2 first = dst * 2;
+    ivec2 last = min(first + 1, srcSize - 1);
+    if (dst.x == dstSize.x - 1) last.x = srcSize.x - 1;
+    if (dst.y == dstSize.y - 1) last.y = srcSize.y - 1;
+
+    float farthest = 0.0;
+    for (int y = first.y; y <= last.y; y++)
+        for (int x = first.x; x <= last.x; x++)
+            farthest = max(farthest, imageLoad(srcLevel, ivec2(x, y)).r);
+
+    imageStore(dstLevel, dst, vec4(farthest));
+}
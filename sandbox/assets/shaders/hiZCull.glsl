@@ -0,0 +1,81 @@
+#region Compute
+#version 440 core
+
+layout (local_size_x = 64) in;
+
+// Minimum and maximum corner per box
+layout (std430, binding = 0) readonly buffer Bounds
+{
+    vec4 bounds[];
+};
+
+layout (std430, binding = 1) writeonly buffer Visibility
+{
+    uint visible[];
+};
+
+uniform sampler2D hiZ;
+uniform mat4 viewProjection; // Camera the pyramid was rendered with
+uniform int boundsCount;
+uniform int levelCount;
+
+void main()
+{
+    uint id = gl_GlobalInvocationID.x;
+    if (id >= uint(boundsCount)) return;
+
+    vec3 boxMin = bounds[id * 2].xyz;
+    vec3 boxMax = bounds[id * 2 + 1].xyz;
+    if (any(greaterThan(boxMin, boxMax)))
+    {
+        visible[id] = 1u;
+        return;
+    }
+
+    vec2 rectMin = vec2(1.0);
+    vec2 rectMax = vec2(0.0);
+    float nearest = 1.0;
+    for (int i = 0; i < 8; i++)
+    {
+        vec3 corner = vec3((i & 1) != 0 ? boxMax.x : boxMin.x, (i & 2) != 0 ? boxMax.y : boxMin.y, (i & 4) != 0 ? boxMax.z : boxMin.z);
+        vec4 clip = viewProjection * vec4(corner, 1.0);
+
+        // Crossing the near plane, no depth to compare against
+        if (clip.w <= 0.0)
+        {
+            visible[id] = 1u;
+            return;
+        }
+
+        vec3 ndc = clip.xyz / clip.w;
+        rectMin = min(rectMin, ndc.xy * 0.5 + 0.5);
+        rectMax = max(rectMax, ndc.xy * 0.5 + 0.5);
+        nearest = min(nearest, ndc.z * 0.5 + 0.5);
+    }
+
+    // Off screen last frame, the pyramid knows nothing about it
+    if (any(lessThan(rectMax, vec2(0.0))) || any(greaterThan(rectMin, vec2(1.0))))
+    {
+        visible[id] = 1u;
+        return;
+    }
+    rectMin = clamp(rectMin, 0.0, 1.0);
+    rectMax = clamp(rectMax, 0.0, 1.0);
+
+    // Level where the rectangle covers at most two texels a side
+    vec2 size = (rectMax - rectMin) * vec2(textureSize(hiZ, 0));
+    int level = clamp(int(ceil(log2(max(max(size.x, size.y), 1.0)))), 0, levelCount - 1);
+
+    // Pixels map 2:1 down the pyramid and the odd last row and column fold into the last texel, as the reduction does
+    ivec2 baseSize = textureSize(hiZ, 0);
+    ivec2 levelSize = textureSize(hiZ, level);
+    ivec2 first = min(clamp(ivec2(rectMin * vec2(baseSize)), ivec2(0), baseSize - 1) >> level, levelSize - 1);
+    ivec2 last = min(clamp(ivec2(rectMax * vec2(baseSize)), ivec2(0), baseSize - 1) >> level, levelSize - 1);
+
+    float farthest = 0.0;
+    for (int y = first.y; y <= last.y; y++)
+        for (int x = first.x; x <= last.x; x++)
+            farthest = max(farthest, texelFetch(hiZ, ivec2(x, y), level).r);
+
+    visible[id] = nearest <= farthest ? 1u : 0u;
+}
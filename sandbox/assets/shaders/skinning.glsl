@@ -0,0 +1,67 @@
+#region Compute
+#version 440 core
+
+layout (local_size_x = 64) in;
+
+// Renderer3DVertex, 16 floats: position(3) normal(3) uv(2) boneIndices(4) boneWeights(4)
+layout (std430, binding = 0) buffer Vertices
+{
+    float vertexData[];
+};
+
+// Position only copy of the arena read by the depth prepass, 3 floats per vertex
+layout (std430, binding = 1) buffer Positions
+{
+    float positionData[];
+};
+
+uniform mat4 boneMatrices[100];
+uniform int sourceFirstVertex;
+uniform int skinnedFirstVertex;
+uniform int vertexCount;
+
+const uint stride = 16;
+
+void main()
+{
+    uint id = gl_GlobalInvocationID.x;
+    if (id >= uint(vertexCount)) return;
+
+    uint src = (uint(sourceFirstVertex) + id) * stride;
+    uint dst = (uint(skinnedFirstVertex) + id) * stride;
+
+    vec3 position = vec3(vertexData[src + 0], vertexData[src + 1], vertexData[src + 2]);
+    vec3 normal = vec3(vertexData[src + 3], vertexData[src + 4], vertexData[src + 5]);
+    vec4 boneIndices = vec4(vertexData[src + 8], vertexData[src + 9], vertexData[src + 10], vertexData[src + 11]);
+    vec4 boneWeights = vec4(vertexData[src + 12], vertexData[src + 13], vertexData[src + 14], vertexData[src + 15]);
+
+    mat4 boneTransform = boneMatrices[int(boneIndices[0])] * boneWeights[0];
+    boneTransform += boneMatrices[int(boneIndices[1])] * boneWeights[1];
+    boneTransform += boneMatrices[int(boneIndices[2])] * boneWeights[2];
+    boneTransform += boneMatrices[int(boneIndices[3])] * boneWeights[3];
+
+    // Unweighted vertices are left in bind pose, matching the PBR vertex shader
+    if (boneTransform != mat4(0.f))
+    {
+        position = vec3(boneTransform * vec4(position, 1.0));
+        normal = normalize(mat3(boneTransform) * normal);
+    }
+
+    vertexData[dst + 0] = position.x;
+    vertexData[dst + 1] = position.y;
+    vertexData[dst + 2] = position.z;
+    vertexData[dst + 3] = normal.x;
+    vertexData[dst + 4] = normal.y;
+    vertexData[dst + 5] = normal.z;
+    vertexData[dst + 6] = vertexData[src + 6];
+    vertexData[dst + 7] = vertexData[src + 7];
+
+    uint dstPosition = (uint(skinnedFirstVertex) + id) * 3;
+    positionData[dstPosition + 0] = position.x;
+    positionData[dstPosition + 1] = position.y;
+    positionData[dstPosition + 2] = position.z;
+
+    // Zero weights mark the output as static for every later pass
+    for (uint i = 8; i < stride; i++)
+        vertexData[dst + i] = 0.0;
+}
@@ -0,0 +1,179 @@
+#pragma once
+#include "Core/Resources/Management/ResourceManager.h"
+#include "Core/Resources/Management/SceneManager.h"
+#include "Core/Rendering/API/Global/RenderStats.h"
+
+#include <json.hpp>
+#include <algorithm>
+#include <filesystem>
+#include <fstream>
+#include <numeric>
+
+// Runs the sandbox unattended in place of the editor GUI. Loads a saved scene, plays a recorded input path or else the
+// timeline at a fixed step for a number of frames, then writes frame time percentiles, hitches and the load time and closes.
+//
+// Sandbox --benchmark MechScene.eph [--input-path saves/input.path] [--frames N] [--warmup N] [--dt seconds]
+//         [--hitch-factor F] [--pipelined] [--out benchmark.json] [--headless]
+class BenchmarkLayer : public Engine::Layer {
+private:
+    std::shared_ptr<Engine::ResourceManager> gResources;
+    std::string m_scene; // Scene under saves/
+    std::string m_outPath = "benchmark.json"; // Report written when done
+    uint32_t m_warmupFrames = 60; // Frames run before measuring
+    uint32_t m_measuredFrames = 600; // Frames measured
+    float m_delta = 0.f; // Seconds every frame steps by
+    float m_hitchFactor = 2.f; // Frames longer than this many times the median are hitches
+    float m_maxTime = 250.f; // Timeline length, played on a loop when there is no input path
+    float m_loadTime = 0.f; // Seconds the scene took to load
+    float m_firstFrameTime = 0.f; // Seconds of the first frame, which builds batches, slots and skinned copies
+    uint32_t m_frame = 0; // Frames updated so far
+    std::vector<float> m_frameTimes; // Milliseconds of each measured frame
+    uint64_t m_drawCalls = 0; // Draw calls over the measured frames
+    uint64_t m_bytesUploaded = 0; // Bytes uploaded over the measured frames
+    bool m_failed = false; // Set when the scene or path could not be read, the report says why
+
+    void finish(const std::string& error = ""); // Write the report and close the application
+
+public:
+    BenchmarkLayer(const std::string& name = "BenchmarkLayer")
+        : Engine::Layer(name) { gResources = Engine::ResourceManager::getInstance(); }
+
+    void OnAttach() override;
+    void OnFixedUpdate(float step) override;
+    void OnUpdate(float timestep) override;
+};
+
+void BenchmarkLayer::OnAttach()
+{
+    auto& app = Engine::Application::getInstance();
+    m_scene = Engine::Application::getArgument("--benchmark");
+    m_outPath = Engine::Application::getArgument("--out", m_outPath);
+    m_warmupFrames = std::stoul(Engine::Application::getArgument("--warmup", std::to_string(m_warmupFrames)));
+    m_hitchFactor = std::stof(Engine::Application::getArgument("--hitch-factor", std::to_string(m_hitchFactor)));
+
+    // loadScene reads from saves/, a path given from the sandbox directory is accepted as well
+    if (m_scene.rfind("saves/", 0) == 0)
+        m_scene = m_scene.substr(6);
+    if (m_scene.empty() || !std::filesystem::exists("saves/" + m_scene))
+        return finish("scene saves/" + m_scene + " not found, run from the sandbox directory");
+
+    // Ticks are the length the path was recorded at, and each frame is one tick unless --dt says otherwise
+    std::string inputPath = Engine::Application::getArgument("--input-path");
+    uint32_t pathFrames = 0;
+    if (!inputPath.empty())
+    {
+        if (!gResources->inputPath.load(inputPath) || !gResources->inputPath.startPlayback())
+            return finish("input path " + inputPath + " could not be read");
+        app.getFixedTimestep().setTickRate(1.f / gResources->inputPath.getStep());
+    }
+    m_delta = std::stof(Engine::Application::getArgument("--dt", std::to_string(app.getFixedTimestep().getStep())));
+    if (!inputPath.empty())
+        pathFrames = static_cast<uint32_t>(gResources->inputPath.getTickCount() * gResources->inputPath.getStep() / m_delta);
+
+    // Measures the whole path by default, past its end the camera holds still and the timeline keeps playing
+    if (Engine::Application::hasArgument("--frames"))
+        m_measuredFrames = std::stoul(Engine::Application::getArgument("--frames"));
+    else if (pathFrames > 0)
+        m_measuredFrames = pathFrames > m_warmupFrames ? pathFrames - m_warmupFrames : pathFrames;
+    m_measuredFrames = std::max(1u, m_measuredFrames);
+
+    app.setFixedDelta(m_delta);
+    app.setPipelined(Engine::Application::hasArgument("--pipelined"));
+    app.getFramePacer().setTargetRate(0.f);
+    gResources->isGuiActive = true;
+    gResources->eIntroMessage = false;
+    gResources->currentTimeKey = 0.f;
+
+    Engine::ChronoTimer loadTimer;
+    loadTimer.start();
+    Engine::SceneManager::getInstance()->loadScene(gResources->m_registry, m_scene);
+    m_loadTime = loadTimer.getElapsedTime();
+    m_frameTimes.reserve(m_measuredFrames);
+
+    Engine::Log::info("Benchmark: {0} loaded in {1:.1f} ms, {2} warmup and {3} measured frames at {4:.4f} s", m_scene, m_loadTime * 1000.f, m_warmupFrames, m_measuredFrames, m_delta);
+}
+
+void BenchmarkLayer::OnFixedUpdate(float step)
+{
+    // Stands in for the editor's play button, an input path sets the time itself
+    if (m_failed || gResources->inputPath.isPlaying())
+        return;
+
+    gResources->currentTimeKey += step;
+    if (gResources->currentTimeKey > m_maxTime)
+        gResources->currentTimeKey = 0.f;
+}
+
+void BenchmarkLayer::OnUpdate(float timestep)
+{
+    if (m_failed)
+        return;
+
+    // The application times each whole loop iteration, so this frame reads the one before it
+    if (m_frame > 0)
+    {
+        uint32_t previous = m_frame - 1;
+        float frameTime = Engine::Application::getInstance().getPipelineStats().frame;
+        if (previous == 0)
+            m_firstFrameTime = frameTime;
+        if (previous >= m_warmupFrames)
+        {
+            auto& stats = Engine::RenderStats::getLastFrame();
+            m_frameTimes.push_back(frameTime * 1000.f);
+            m_drawCalls += stats.drawCalls;
+            m_bytesUploaded += stats.bytesUploaded;
+        }
+    }
+    m_frame++;
+
+    if (m_frameTimes.size() == m_measuredFrames)
+        finish();
+}
+
+void BenchmarkLayer::finish(const std::string& error)
+{
+    nlohmann::json report;
+    report["scene"] = m_scene;
+    report["input_path"] = Engine::Application::getArgument("--input-path");
+    report["renderer"] = reinterpret_cast<const char*>(glGetString(GL_RENDERER));
+    report["pipelined"] = Engine::Application::getInstance().isPipelined();
+
+    if (!error.empty())
+    {
+        m_failed = true;
+        report["error"] = error;
+        Engine::Log::error("Benchmark: {0}", error);
+    }
+    else
+    {
+        std::vector<float> sorted = m_frameTimes;
+        std::sort(sorted.begin(), sorted.end());
+        auto percentile = [&](uint32_t p) { return sorted[std::min<size_t>(sorted.size() - 1, sorted.size() * p / 100)]; };
+        float median = percentile(50);
+        uint32_t hitches = static_cast<uint32_t>(std::count_if(sorted.begin(), sorted.end(), [&](float time) { return time > median * m_hitchFactor; }));
+        uint32_t overBudget = static_cast<uint32_t>(std::count_if(sorted.begin(), sorted.end(), [&](float time) { return time > m_delta * 1000.f; }));
+
+        report["dt"] = m_delta;
+        report["warmup_frames"] = m_warmupFrames;
+        report["measured_frames"] = m_frameTimes.size();
+        report["load_ms"] = m_loadTime * 1000.f;
+        report["first_frame_ms"] = m_firstFrameTime * 1000.f;
+        report["frame_ms"]["mean"] = std::accumulate(sorted.begin(), sorted.end(), 0.0) / sorted.size();
+        report["frame_ms"]["p50"] = median;
+        report["frame_ms"]["p95"] = percentile(95);
+        report["frame_ms"]["p99"] = percentile(99);
+        report["frame_ms"]["max"] = sorted.back();
+        report["hitch_factor"] = m_hitchFactor;
+        report["hitches"] = hitches;
+        report["over_budget"] = overBudget;
+        report["draw_calls_per_frame"] = static_cast<double>(m_drawCalls) / m_frameTimes.size();
+        report["kb_uploaded_per_frame"] = m_bytesUploaded / 1024.0 / m_frameTimes.size();
+        report["frame_times_ms"] = m_frameTimes;
+
+        Engine::Log::info("Benchmark: p50 {0:.2f} ms, p95 {1:.2f} ms, p99 {2:.2f} ms, {3} hitches, loaded in {4:.1f} ms", median, percentile(95), percentile(99), hitches, m_loadTime * 1000.f);
+    }
+
+    std::ofstream out(m_outPath);
+    out << report.dump(2) << std::endl;
+    Engine::Application::getInstance().close(error.empty() ? 0 : 1);
+}
@@ -3,11 +3,34 @@
 #include "Core/Systems/Events/InputPoller.h"
 #include "Core/Resources/Components/Components.h"
 #include "Core/Resources/Utility/AssimpLoader.h"
+#include "Core/Rendering/Renderer/RenderPacket.h"
+#include "Core/Systems/Utility/JobSystem.h"
 
 class EngineLayer : public Engine::Layer {
 private:
 
     std::shared_ptr<Engine::ResourceManager> gResources;
+    uint32_t m_frame = 0; // Frame counter used to stagger animation LOD updates
+    std::vector<uint32_t> m_visible; // Entities returned by the last frustum query
+    std::vector<Engine::AABB> m_occludeeBounds; // World bounds of the frustum survivors, tested for occlusion
+    std::vector<uint8_t> m_occludeeVisible; // Occlusion result per frustum survivor
+    std::vector<uint32_t> m_shown; // Retained entities shown last frame, rechecked in case they left the view
+    std::vector<uint32_t> m_nextShown; // Retained entities shown this frame
+    bool m_culling = false; // Whether the last frame was culled
+    bool m_retainedSynced[2] = { false, false }; // Culling and static batching state the retained visibility was last fully synced with
+    glm::mat4 m_cameraTicks[2] = { glm::mat4(1.f), glm::mat4(1.f) }; // Camera world transform at the previous and the latest tick
+    float m_timeKeyTick = 0.f; // Animation time at the start of the latest tick
+    float m_timeKey = 0.f; // Animation time interpolated between ticks, what the frame is posed and drawn at
+    Engine::RenderPacketBuffer m_packets; // Extracted frames, the back is filled by OnSimulate while the front is drawn by OnRender
+    std::vector<entt::entity> m_unmerge; // Static entities that changed, taken out of their batches at the next sync
+    std::vector<entt::entity> m_pendingSkinned; // Entities waiting for a GPU skinned copy, created at the next sync
+
+    void cullOccluded(const glm::mat4& viewProjection); // Remove entities hidden behind occluders from m_visible
+    void cullHiZ(); // Remove entities hidden behind last frame's depth from m_visible
+    void rebuildStaticBatches(); // Merge every static entity's meshes into batches by material and cell
+    bool showRetained(entt::entity entity, Engine::RetainedComponent& retained); // Set each retained slot's visibility, true if the entity is shown
+    void syncRetained(); // Create or patch the slots of changed entities and follow the culling result
+    void extract(Engine::RenderPacket& packet); // Copy everything OnRender draws out of the registry
 
 public:
     EngineLayer(const std::string& name = "EngineLayer")
@@ -19,8 +42,12 @@ public:
         if (!gResources->m_window) gResources->m_window = window;
         if (!gResources->m_poller) gResources->m_poller = poller;
     };
+    void OnFixedUpdate(float step) override;
     void OnUpdate(float timestep) override;
     void OnRender() override;
+    bool isPipelined() override { return true; }
+    void OnSimulate(float timestep) override;
+    void OnSync() override;
     bool OnKeyPress(Engine::KeyPressedEvent& e) override;
     bool OnMousePressed(Engine::MouseButtonPressedEvent& e) override;
     bool OnMouseMovedEvent(Engine::MouseMovedEvent& e) override;
@@ -31,6 +58,26 @@ void EngineLayer::OnAttach()
     // Init 3D Renderer
     Engine::Renderer3D::init(262144, 262144, 262144);
 
+    // Keep the transform hierarchy in step with deleted entities
+    gResources->m_registry.on_destroy<Engine::HierarchyComponent>().connect<&Engine::onHierarchyDestroyed>();
+    gResources->m_registry.on_destroy<Engine::SpatialComponent>().connect<&Engine::onSpatialDestroyed>();
+    gResources->m_registry.on_destroy<Engine::StaticComponent>().connect<&Engine::onStaticDestroyed>();
+    gResources->m_registry.on_destroy<Engine::SkinnedMeshComponent>().connect<&Engine::onSkinnedMeshDestroyed>();
+    gResources->m_registry.on_destroy<Engine::CrowdComponent>().connect<&Engine::onCrowdDestroyed>();
+
+    // Render proxies are resolved once per mesh renderer, the frame loops iterate them through a group
+    gResources->m_registry.on_construct<Engine::MeshRendererComponent>().connect<&Engine::onMeshRendererChanged>();
+    gResources->m_registry.on_update<Engine::MeshRendererComponent>().connect<&Engine::onMeshRendererChanged>();
+    gResources->m_registry.group<Engine::RenderProxyComponent>(entt::get<Engine::TransformComponent, Engine::StateComponent>);
+
+    // Retained instance slots follow the registry, only entities that changed are patched
+    gResources->m_registry.on_construct<Engine::MeshRendererComponent>().connect<&Engine::onRetainedChanged>();
+    gResources->m_registry.on_update<Engine::MeshRendererComponent>().connect<&Engine::onRetainedChanged>();
+    gResources->m_registry.on_update<Engine::TransformComponent>().connect<&Engine::onRetainedChanged>();
+    gResources->m_registry.on_update<Engine::StateComponent>().connect<&Engine::onRetainedChanged>();
+    gResources->m_registry.on_destroy<Engine::MeshRendererComponent>().connect<&Engine::onMeshRendererDestroyed>();
+    gResources->m_registry.on_destroy<Engine::RetainedComponent>().connect<&Engine::onRetainedDestroyed>();
+
     // Init Shader
     std::shared_ptr<Engine::Shader> PBRShader;
     PBRShader.reset(Engine::Shader::create("./assets/shaders/PBRShader.glsl"));
@@ -56,6 +103,7 @@ void EngineLayer::OnAttach()
     gResources->m_view3D = gResources->activeCamera->getViewMatrix();
     gResources->m_projection3D = gResources->activeCamera->getProjectionMatrix();
     gResources->m_viewPos3D = gResources->activeCamera->getPosition();
+    m_cameraTicks[0] = m_cameraTicks[1] = glm::inverse(gResources->m_view3D);
 
     // Set Scene Wide Uniforms
     gResources->sWideUniforms3D["u_projection"] = std::pair<Engine::ShaderDataType, void*>(Engine::ShaderDataType::Mat4, static_cast<void*>(glm::value_ptr(gResources->m_projection3D)));
@@ -68,49 +116,304 @@ void EngineLayer::OnDetach() {
     // Cleanup code here
 }
 
+void EngineLayer::OnFixedUpdate(float step) {
+    EPHYRA_PROFILE_FUNCTION();
+    // The camera moves in whole ticks so its speed and damping do not depend on the frame rate, frames blend between the last two ticks
+    m_cameraTicks[0] = m_cameraTicks[1];
+
+    // A recorded path is taken from or written over the input before the camera reads it
+    bool cameraActive = !gResources->isGuiActive;
+    gResources->inputPath.tick(*gResources->m_poller, cameraActive, gResources->currentTimeKey);
+    gResources->isGuiActive = !cameraActive;
+
+    if (!gResources->isGuiActive)
+        gResources->activeCamera->update(step);
+    m_cameraTicks[1] = glm::inverse(gResources->activeCamera->getViewMatrix());
+
+    // Layers later in the stack advance the clip during this tick
+    m_timeKeyTick = gResources->currentTimeKey;
+}
+
 void EngineLayer::OnUpdate(float timestep) {
-    // Update logic for each frame
+    // Update logic for each frame, the same stages the application overlaps when pipelining
+    OnSimulate(timestep);
+    OnSync();
+    OnRender();
+}
+
+void EngineLayer::OnSimulate(float timestep) {
+    EPHYRA_PROFILE_FUNCTION();
+    // Nothing here touches the GL context, work that does is left for OnSync
+    float alpha = Engine::Application::getInstance().getFixedTimestep().getAlpha();
+
+    // A jump of more than a tick is a scrub or a loop, it is shown straight away rather than blended through
+    float timeStep = gResources->currentTimeKey - m_timeKeyTick;
+    bool jumped = std::abs(timeStep) > Engine::Application::getInstance().getFixedTimestep().getStep() * 1.01f;
+    m_timeKey = jumped ? gResources->currentTimeKey : m_timeKeyTick + timeStep * alpha;
+
+        // Update Transform Hierarchy, only subtrees changed since the last frame are recomputed
+    auto& hierarchy = gResources->transformHierarchy;
+    hierarchy.update();
+    for (auto node : hierarchy.getUpdated())
+    {
+        auto entity = entt::entity(hierarchy.getUserData(node));
+        if (gResources->m_registry.valid(entity) && gResources->m_registry.all_of<Engine::TransformComponent>(entity))
+            gResources->m_registry.patch<Engine::TransformComponent>(entity, [&](auto& transform) { transform.Transform = hierarchy.getWorld(node); });
+    }
+
+        // Update Static Batches, anything moved, hidden or no longer static since it was merged is drawn on its own from now and taken out of its batch at the sync
+    auto staticView = gResources->m_registry.view<Engine::StaticComponent, Engine::TransformComponent, Engine::StateComponent>();
+    for (auto entity : staticView)
+    {
+        auto& merged = staticView.get<Engine::StaticComponent>(entity);
+        if (!merged.Merged)
+            continue;
+        if (merged.Static && staticView.get<Engine::StateComponent>(entity).State && staticView.get<Engine::TransformComponent>(entity).Transform == merged.MergedTransform)
+            continue;
+
+        merged.Merged = false;
+        m_unmerge.push_back(entity);
+    }
 
         // Update Animation
-    auto& view = gResources->m_registry.view<Engine::TransformComponent, Engine::MeshRendererComponent, Engine::StateComponent, Engine::TagComponent>();
+    auto proxies = gResources->m_registry.group<Engine::RenderProxyComponent>(entt::get<Engine::TransformComponent, Engine::StateComponent>);
 
-    for (auto& entity : view)
+    auto& lodSettings = gResources->animationLOD;
+    auto& lodStats = gResources->animationLODStats;
+    lodStats.reset();
+
+    glm::mat4 viewProjection = gResources->m_projection3D * gResources->m_view3D;
+    Engine::ChronoTimer evaluationTimer;
+    uint32_t animatedCount = 0;
+
+    for (auto entity : proxies)
     {
-        auto tag = view.get<Engine::TagComponent>(entity).Tag;
-        auto& trans = view.get<Engine::TransformComponent>(entity).Transform;
-        if (!(sceneMapping.find(tag) == sceneMapping.end()))
-            if (sceneMapping[tag]->HasAnimations() == 1)
-                Engine::Loader::updateBoneTransforms(gResources->currentTimeKey, sceneMapping[tag]->mRootNode, glm::mat4(1.f), tag);
+        auto& proxy = proxies.get<Engine::RenderProxyComponent>(entity);
+        if (!proxy.Animated)
+            continue;
+
+        auto& trans = proxies.get<Engine::TransformComponent>(entity).Transform;
+        animatedCount++;
+
+        // Distant and off screen characters are evaluated every Nth frame, offset per entity so the work spreads evenly
+        auto& lod = gResources->m_registry.get_or_emplace<Engine::AnimationLODComponent>(entity, static_cast<uint32_t>(entity));
+        float screenSize = 1.f;
+        Engine::AABB localBounds = proxy.getBounds(m_timeKey);
+
+        lod.Level = lodSettings.enabled ? Engine::AnimationLOD::selectLevel(lodSettings, viewProjection, trans, screenSize, &localBounds) : 0;
+        uint32_t interval = lodSettings.enabled ? Engine::AnimationLOD::updateInterval(lodSettings, lod.Level) : 1;
+        lodStats.levelCounts[lod.Level]++;
+
+        if (lod.CurrentPose.empty() || (m_frame + lod.Phase) % interval == 0)
+        {
+            bool reduced = lodSettings.enabled && screenSize < lodSettings.minorJointScreenSize;
+
+            evaluationTimer.start();
+            Engine::Loader::updateBoneTransforms(m_timeKey, proxy.Scene->mRootNode, glm::mat4(1.f), proxy.LoaderID, reduced ? &Engine::Loader::getMinorJoints(proxy.LoaderID) : nullptr);
+
+            // Pose vectors keep their capacity between evaluations so this does not allocate after the first
+            std::swap(lod.PreviousPose, lod.CurrentPose);
+            lod.PreviousTime = lod.CurrentTime;
+            lod.CurrentTime = m_timeKey;
+            lod.CurrentPose.resize(proxy.Skeleton.size());
+            for (int i = 0; i < proxy.Skeleton.size(); i++)
+            {
+                lod.CurrentPose[i].clear();
+                if (proxy.Skeleton[i])
+                    for (auto& bone : *proxy.Skeleton[i])
+                        lod.CurrentPose[i].push_back(bone.finalTransformation);
+            }
+            if (lod.PreviousPose.size() != lod.CurrentPose.size())
+            {
+                lod.PreviousPose = lod.CurrentPose;
+                lod.PreviousTime = lod.CurrentTime;
+            }
+
+            // Dropping or restoring the minor joints changes the pose at the same time key
+            if (reduced != lod.Reduced)
+                lod.PoseVersion++;
+            lod.Reduced = reduced;
+
+            float elapsed = evaluationTimer.getElapsedTime();
+            lodStats.evaluationTime += elapsed;
+            lodStats.evaluated++;
+            if (reduced)
+                lodStats.reducedJoints++;
+            else
+                lodStats.fullEvaluationTime = lodStats.fullEvaluationTime == 0.f ? elapsed : glm::mix(lodStats.fullEvaluationTime, elapsed, 0.05f);
+
+            lod.FramesSinceUpdate = 0;
+        }
+        else
+        {
+            lod.FramesSinceUpdate++;
+            lodStats.skipped++;
+        }
+
+        // Blend from the previous evaluation to the latest across the interval so the reduced rate reads as smooth motion.
+        // Each palette matrix is blended as translation, rotation and scale, a linear mix would shrink joints turning far between evaluations
+        float blend = std::min(1.f, (lod.FramesSinceUpdate + 1) / static_cast<float>(interval));
+        lod.Pose.resize(lod.CurrentPose.size());
+        for (int i = 0; i < lod.CurrentPose.size(); i++)
+        {
+            lod.Pose[i] = lod.CurrentPose[i];
+            if (blend < 1.f && lod.PreviousPose[i].size() == lod.CurrentPose[i].size())
+                for (int j = 0; j < lod.Pose[i].size(); j++)
+                    lod.Pose[i][j] = Engine::FixedTimestep::interpolate(lod.PreviousPose[i][j], lod.CurrentPose[i][j], blend);
+        }
+
+        // The pose only changes with the evaluated times and the blend between them, so a character holding still keeps its skinned copy
+        bool blending = blend < 1.f && lod.PreviousTime != lod.CurrentTime;
+        glm::vec3 poseKey(lod.CurrentTime, blending ? lod.PreviousTime : lod.CurrentTime, blending ? blend : 1.f);
+        if (poseKey != lod.PoseKey)
+        {
+            lod.PoseKey = poseKey;
+            lod.PoseVersion++;
+        }
+    }
+
+    lodStats.savedTime = std::max(0.f, animatedCount * lodStats.fullEvaluationTime - lodStats.evaluationTime);
+    m_frame++;
+
+        // Update Spatial Index, a leaf only moves in the tree once its bounds leave the fattened box
+    for (auto entity : proxies)
+    {
+        Engine::AABB localBounds = proxies.get<Engine::RenderProxyComponent>(entity).getBounds(m_timeKey);
+        if (!localBounds.isValid())
+            continue;
+
+        Engine::AABB worldBounds = localBounds.transformed(proxies.get<Engine::TransformComponent>(entity).Transform);
+        auto* spatial = gResources->m_registry.try_get<Engine::SpatialComponent>(entity);
+        if (!spatial)
+            gResources->m_registry.emplace<Engine::SpatialComponent>(entity, entity, worldBounds);
+        else
+            gResources->spatialIndex.move(spatial->Proxy, worldBounds, worldBounds.getCenter() - gResources->spatialIndex.getBounds(spatial->Proxy).getCenter());
     }
     
 
-        // Update ViewPoint
-    gResources->m_view3D = gResources->activeCamera->getViewMatrix();
+        // Update ViewPoint, between the camera of the last two ticks
+    glm::mat4 camera = Engine::FixedTimestep::interpolate(m_cameraTicks[0], m_cameraTicks[1], alpha);
+    gResources->m_view3D = glm::inverse(camera);
 
         // Update Projection
     gResources->m_projection3D = gResources->activeCamera->getProjectionMatrix();
 
         // Update Camera Position
-    gResources->m_viewPos3D = gResources->activeCamera->getPosition();
+    gResources->m_viewPos3D = glm::vec3(camera[3]);
+
+        // Extract The Frame
+    extract(m_packets.getBack());
+}
 
-        // Call Render
-    this->OnRender();
+void EngineLayer::OnSync() {
+    EPHYRA_PROFILE_FUNCTION();
+    // Runs on the main thread while nothing is simulating or rendering, so GL and the registry are both safe to touch
 
-    if (!gResources->isGuiActive)
-        gResources->activeCamera->update(timestep);
-    
+        // Take Changed Static Entities Out Of Their Batches
+    for (auto entity : m_unmerge)
+    {
+        gResources->staticBatcher.unmerge(entt::to_integral(entity));
+        gResources->retainedChanged.push_back(entity);
+    }
+    m_unmerge.clear();
+
+    if (gResources->staticBatchesDirty)
+    {
+        rebuildStaticBatches();
+        gResources->staticBatchesDirty = false;
+    }
+
+        // Update Retained Instances
+    syncRetained();
+
+        // Reserve Skinned Copies Requested By Extraction, drawn from the next extracted frame
+    for (auto entity : m_pendingSkinned)
+    {
+        if (gResources->m_registry.valid(entity) && gResources->m_registry.all_of<Engine::MeshRendererComponent>(entity) && !gResources->m_registry.all_of<Engine::SkinnedMeshComponent>(entity))
+            gResources->m_registry.emplace<Engine::SkinnedMeshComponent>(entity, gResources->m_registry.get<Engine::MeshRendererComponent>(entity));
+    }
+    m_pendingSkinned.clear();
+
+    m_packets.swap();
 }
 
-void EngineLayer::OnRender(){
+void EngineLayer::syncRetained() {
+    EPHYRA_PROFILE_FUNCTION();
+    // Slots are created or patched only for entities queued by the registry signals
+    auto& changed = gResources->retainedChanged;
+    for (auto entity : changed)
+    {
+        if (!gResources->m_registry.valid(entity) || !gResources->m_registry.all_of<Engine::MeshRendererComponent, Engine::RenderProxyComponent, Engine::TransformComponent>(entity))
+            continue;
 
-    //Call Render Commands
-    Engine::RendererCommon::actionCommand(gResources->setClearColourCommand);
-    Engine::RendererCommon::actionCommand(gResources->clearCommand);
-    Engine::RendererCommon::actionCommand(gResources->glDisableBlend);
-    Engine::RendererCommon::actionCommand(gResources->glEnableDepthTest);
+        // Animated models are posed per entity every frame and stay on the submit path
+        auto& mesh = gResources->m_registry.get<Engine::MeshRendererComponent>(entity);
+        if (gResources->m_registry.get<Engine::RenderProxyComponent>(entity).Animated)
+            continue;
+
+        auto& trans = gResources->m_registry.get<Engine::TransformComponent>(entity).Transform;
+        auto* retained = gResources->m_registry.try_get<Engine::RetainedComponent>(entity);
+        if (retained && !retained->matches(mesh))
+        {
+            gResources->m_registry.remove<Engine::RetainedComponent>(entity);
+            retained = nullptr;
+        }
+
+        if (!retained)
+            retained = &gResources->m_registry.emplace<Engine::RetainedComponent>(entity, mesh, trans);
+        else
+        {
+            for (int i = 0; i < retained->Slots.size(); i++)
+            {
+                Engine::Renderer3D::setRetainedTransform(retained->Slots[i], trans);
+                Engine::Renderer3D::setRetainedMaterial(retained->Slots[i], mesh.Material[i]);
+            }
+        }
 
-    Engine::RendererCommon::lightPos.clear();
-    Engine::RendererCommon::lightColour.clear();
+        if (showRetained(entity, *retained) && m_culling)
+            m_shown.push_back(entt::to_integral(entity));
+    }
+    changed.clear();
+
+    // Slots are only touched for entities entering or leaving the view, everything is rechecked when culling or batching is toggled
+    if (m_retainedSynced[0] != m_culling || m_retainedSynced[1] != gResources->eStaticBatching)
+    {
+        m_shown.clear();
+        auto retainedView = gResources->m_registry.view<Engine::RetainedComponent>();
+        for (auto entity : retainedView)
+            if (showRetained(entity, retainedView.get<Engine::RetainedComponent>(entity)))
+                m_shown.push_back(entt::to_integral(entity));
+        m_retainedSynced[0] = m_culling;
+        m_retainedSynced[1] = gResources->eStaticBatching;
+    }
+    else if (m_culling)
+    {
+        m_nextShown.clear();
+        for (auto* list : { &m_visible, &m_shown })
+        {
+            for (auto id : *list)
+            {
+                auto entity = entt::entity(id);
+                if (!gResources->m_registry.valid(entity))
+                    continue;
+                auto* retained = gResources->m_registry.try_get<Engine::RetainedComponent>(entity);
+                if (retained && showRetained(entity, *retained))
+                    m_nextShown.push_back(id);
+            }
+        }
+        std::sort(m_nextShown.begin(), m_nextShown.end());
+        m_nextShown.erase(std::unique(m_nextShown.begin(), m_nextShown.end()), m_nextShown.end());
+        std::swap(m_shown, m_nextShown);
+    }
+}
+
+void EngineLayer::extract(Engine::RenderPacket& packet) {
+    EPHYRA_PROFILE_FUNCTION();
+    packet.clear();
+    packet.view = gResources->m_view3D;
+    packet.projection = gResources->m_projection3D;
+    packet.viewPos = gResources->m_viewPos3D;
+    packet.time = m_timeKey;
 
     auto& view1 = gResources->m_registry.view<Engine::EmmissiveComponent>();
 
@@ -123,7 +426,7 @@ void EngineLayer::OnRender(){
 
         if (gResources->m_registry.all_of<Engine::TransformComponent>(entity))
         {
-            Position += gResources->m_registry.get<Engine::TransformComponent>(entity).Translation;
+            Position += glm::vec3(gResources->m_registry.get<Engine::TransformComponent>(entity).Transform[3]);
         }
 
         if (gResources->m_registry.all_of<Engine::StateComponent>(entity))
@@ -133,11 +436,145 @@ void EngineLayer::OnRender(){
 
         if (vis)
         {
-            Engine::RendererCommon::lightPos.push_back(Position);
-            Engine::RendererCommon::lightColour.push_back(gResources->m_registry.get<Engine::EmmissiveComponent>(entity).Color);
+            packet.lightPositions.push_back(Position);
+            packet.lightColours.push_back(gResources->m_registry.get<Engine::EmmissiveComponent>(entity).Color);
         }
     }
 
+    // Only entities passing the frustum and occlusion tests are extracted, ones not yet in the spatial index are always drawn
+    bool culling = gResources->eFrustumCulling || gResources->eOcclusionCulling || gResources->eHiZCulling;
+    if (culling)
+    {
+        glm::mat4 viewProjection = gResources->m_projection3D * gResources->m_view3D;
+
+        m_visible.clear();
+        if (gResources->eFrustumCulling)
+            gResources->spatialIndex.queryFrustum(Engine::Frustum(viewProjection), m_visible);
+        else
+            for (auto entity : gResources->m_registry.view<Engine::SpatialComponent>())
+                m_visible.push_back(entt::to_integral(entity));
+
+        if (gResources->eOcclusionCulling)
+            cullOccluded(viewProjection);
+
+        // The pyramid lives on the GPU, off the main thread the packet is tested by OnRender instead
+        if (gResources->eHiZCulling)
+        {
+            if (Engine::JobSystem::isMainThread())
+                cullHiZ();
+            else
+                packet.hiZ = true;
+        }
+
+        for (auto id : m_visible)
+        {
+            auto entity = entt::entity(id);
+            if (gResources->m_registry.valid(entity) && gResources->m_registry.all_of<Engine::SpatialComponent>(entity))
+                gResources->m_registry.get<Engine::SpatialComponent>(entity).VisibleFrame = m_frame;
+        }
+    }
+    m_culling = culling;
+
+    // Extraction walks the packed proxy group, handles and skeletons were resolved when each mesh renderer was added
+    bool retainedPath = gResources->eRetainedInstances;
+    auto proxies = gResources->m_registry.group<Engine::RenderProxyComponent>(entt::get<Engine::TransformComponent, Engine::StateComponent>);
+
+    for (auto entity : proxies)
+    {
+        auto& proxy = proxies.get<Engine::RenderProxyComponent>(entity);
+        if (!proxies.get<Engine::StateComponent>(entity).State)
+            continue;
+
+        // Drawn from their persistent slots, entities without slots yet get them at the sync before this packet is drawn
+        auto* retained = retainedPath && !proxy.Animated ? gResources->m_registry.try_get<Engine::RetainedComponent>(entity) : nullptr;
+        if (retainedPath && !proxy.Animated && (!retained || !retained->Slots.empty()))
+            continue;
+
+        auto* spatial = gResources->m_registry.try_get<Engine::SpatialComponent>(entity);
+        if (culling && spatial && spatial->VisibleFrame != m_frame)
+            continue;
+
+        uint32_t bounds = Engine::RenderPacketItem::noBounds;
+        if (packet.hiZ && spatial)
+        {
+            bounds = static_cast<uint32_t>(packet.bounds.size());
+            packet.bounds.push_back(gResources->spatialIndex.getBounds(spatial->Proxy));
+            packet.boundsKeys.push_back(entt::to_integral(entity));
+        }
+
+        auto& trans = proxies.get<Engine::TransformComponent>(entity).Transform;
+        auto* lod = gResources->m_registry.try_get<Engine::AnimationLODComponent>(entity);
+        auto* merged = gResources->eStaticBatching ? gResources->m_registry.try_get<Engine::StaticComponent>(entity) : nullptr;
+
+        // Skin once into the entity's copy, every pass after this draws it as a static mesh
+        Engine::SkinnedMeshComponent* skinned = nullptr;
+        if (gResources->eGPUSkinning && proxy.Animated)
+        {
+            skinned = gResources->m_registry.try_get<Engine::SkinnedMeshComponent>(entity);
+            if (!skinned)
+                m_pendingSkinned.push_back(entity);
+        }
+
+        for (int i = 0; i < proxy.Geometry.size(); i++)
+        {
+            // Meshes merged into a static batch are drawn with the batch
+            if (!proxy.Animated && merged && merged->Merged && gResources->staticBatcher.isMerged(entt::to_integral(entity), i))
+                continue;
+
+            Engine::RenderPacketItem item;
+            item.geometry = proxy.Geometry[i];
+            item.material = proxy.Material[i];
+            item.model = trans;
+            item.bounds = bounds;
+            if (skinned && i < skinned->Geometry.size() && skinned->Geometry[i])
+                item.skinned = skinned->Geometry[i];
+
+            // The pose is copied so the next frame can be posed while this one is drawn, the interpolated LOD pose first and the shared skeleton as a fallback.
+            // A skinned copy gets it too, only the renderer knows whether the copy was skinned in the pose already
+            if (proxy.Skeleton[i])
+            {
+                item.firstBone = static_cast<uint32_t>(packet.bones.size());
+                if (lod && i < lod->Pose.size() && !lod->Pose[i].empty())
+                {
+                    packet.bones.insert(packet.bones.end(), lod->Pose[i].begin(), lod->Pose[i].begin() + std::min<size_t>(lod->Pose[i].size(), 100));
+                    item.pose = lod->PoseVersion;
+                }
+                else
+                    for (int j = 0; j < proxy.Skeleton[i]->size() && j < 100; j++)
+                        packet.bones.push_back((*proxy.Skeleton[i])[j].finalTransformation);
+                item.boneCount = static_cast<uint32_t>(packet.bones.size()) - item.firstBone;
+            }
+            packet.items.push_back(item);
+        }
+    }
+
+    // Crowds play back baked clips on the GPU, one draw per mesh however many instances
+    auto& view3 = gResources->m_registry.view<Engine::CrowdComponent>();
+
+    for (auto& entity : view3)
+    {
+        auto& crowd = view3.get<Engine::CrowdComponent>(entity);
+        for (int i = 0; i < crowd.Animation.size(); i++)
+        {
+            packet.crowds.push_back({ crowd.Animation[i], crowd.Crowd, crowd.Material[i] });
+        }
+    }
+}
+
+void EngineLayer::OnRender(){
+    EPHYRA_PROFILE_FUNCTION();
+    // Draws only from the front packet and the renderer's own state, the registry may be mid simulation
+    auto& packet = m_packets.getFront();
+
+    //Call Render Commands
+    Engine::RendererCommon::actionCommand(gResources->setClearColourCommand);
+    Engine::RendererCommon::actionCommand(gResources->clearCommand);
+    Engine::RendererCommon::actionCommand(gResources->glDisableBlend);
+    Engine::RendererCommon::actionCommand(gResources->glEnableDepthTest);
+
+    Engine::RendererCommon::lightPos = packet.lightPositions;
+    Engine::RendererCommon::lightColour = packet.lightColours;
+
     while (Engine::RendererCommon::lightPos.size() < 64)
     {
         Engine::RendererCommon::lightPos.push_back({0.f, 0.f, 0.f});
@@ -148,53 +585,183 @@ void EngineLayer::OnRender(){
         Engine::RendererCommon::lightColour.push_back({ 0.f, 0.f, 0.f });
     }
    
-    Engine::Renderer3D::begin(gResources->sWideUniforms3D);
+    Engine::Renderer3D::setDepthPrepass(gResources->eDepthPrepass);
+    Engine::Renderer3D::setHiZ(gResources->eHiZCulling);
+    Engine::Renderer3D::setMeshletCulling(gResources->eMeshletCulling, gResources->eMeshletConeCulling);
+    Engine::Renderer3D::begin(packet.uniforms);
 
-    auto& view2 = gResources->m_registry.view<Engine::TransformComponent, Engine::MeshRendererComponent, Engine::StateComponent, Engine::TagComponent>();
+    // Extracted off the main thread, the depth pyramid test that extraction could not run happens here
+    bool hiZ = packet.hiZ && Engine::Renderer3D::testHiZ(packet.bounds, packet.boundsKeys, packet.boundsVisible);
 
-    for (auto& entity : view2)
+    if (gResources->eRetainedInstances)
+        Engine::Renderer3D::drawRetained();
+
+    for (auto& item : packet.items)
     {
-        auto& filepath = view2.get<Engine::MeshRendererComponent>(entity).LoaderPath;
-        for (int i = 0; i < gResources->IDToMeshNames[gResources->FPToIDs[filepath][0]].size(); i++)
-        {
-            auto& tag = gResources->FPToIDs[filepath][0];
+        if (hiZ && item.bounds != Engine::RenderPacketItem::noBounds && !packet.boundsVisible[item.bounds])
+            continue;
 
-            if (boneInfoList.find(gResources->IDToMeshNames[tag][i]) != boneInfoList.end())              //sceneMapping[tag]->mMeshes[0]->mName.data) != boneInfoList.end())
-            {
-                auto bone = boneInfoList[gResources->IDToMeshNames[tag][i]]; // sceneMapping[tag]->mMeshes[0]->mName.data];
-                for (int i = 0; i < bone.size() && i < 100; i++)
-                {
-                    auto& boneMatrix = boneManager.getBoneMatrices()[i];
-                    boneMatrix = bone[i].finalTransformation;
-                }
-            }
-            else
-            {
-                for (int i = 0; i < 100; i++)
-                {
-                    auto& boneMatrix = boneManager.getBoneMatrices()[i];
-                    boneMatrix = glm::mat4(0.0f);
-                }
-            }
+        if (item.skinned)
+        {
+            if (item.boneCount > 0)
+                Engine::Renderer3D::skin(*item.geometry, *item.skinned, &packet.bones[item.firstBone], item.boneCount, item.pose);
+            Engine::Renderer3D::submit(*item.skinned, item.material, item.model);
+            continue;
         }
 
-        auto& mesh = view2.get<Engine::MeshRendererComponent>(entity);
-        auto& trans = view2.get<Engine::TransformComponent>(entity);
-        auto& vis = view2.get<Engine::StateComponent>(entity).State;
-        if (vis)
+        // Only meshes with bones read the palette in the vertex shader, it is left untouched for the rest
+        if (item.boneCount > 0)
+            std::copy_n(&packet.bones[item.firstBone], item.boneCount, boneManager.getBoneMatrices());
+        Engine::Renderer3D::submit(*item.geometry, item.material, item.model);
+    }
+
+    // Static batches are already in world space, culled as a whole by the bounds of their cell, they only change at the sync
+    if (gResources->eStaticBatching)
+    {
+        Engine::Frustum frustum(packet.projection * packet.view);
+        for (auto& batch : gResources->staticBatcher.getBatches())
         {
-            for (int i = 0; i < mesh.Geometry.size(); i++)
-            {
-                Engine::Renderer3D::submit(*mesh.Geometry[i], mesh.Material[i], trans);
-            }
+            if (batch.liveMembers == 0)
+                continue;
+            if (gResources->eFrustumCulling && !frustum.intersects(batch.bounds))
+                continue;
+            Engine::Renderer3D::submit(batch.geometry, batch.material, glm::mat4(1.f));
         }
     }
 
+    for (auto& crowd : packet.crowds)
+        Engine::Renderer3D::submitCrowd(*crowd.animation, crowd.crowd, crowd.material, packet.time);
+
     bool enabledEffects[16] = { gResources->eDOF, gResources->eVolumetric, gResources->eBloom, gResources->eToneMapping, gResources->eVignette,1,1,1,1,1,1,1,1,1,1,1 };
 
     Engine::Renderer3D::end(enabledEffects);
 }
 
+void EngineLayer::cullOccluded(const glm::mat4& viewProjection)
+{
+    auto& culler = gResources->occlusionCuller;
+    culler.begin(viewProjection);
+
+    auto occluders = gResources->m_registry.view<Engine::OccluderComponent, Engine::TransformComponent, Engine::RenderProxyComponent>();
+    for (auto entity : occluders)
+    {
+        if (!occluders.get<Engine::OccluderComponent>(entity).Occluder)
+            continue;
+        if (gResources->m_registry.all_of<Engine::StateComponent>(entity) && !gResources->m_registry.get<Engine::StateComponent>(entity).State)
+            continue;
+
+        auto& mesh = occluders.get<Engine::RenderProxyComponent>(entity).Occluder;
+        if (!mesh)
+            continue;
+
+        culler.addOccluder(*mesh, occluders.get<Engine::TransformComponent>(entity).Transform);
+    }
+
+    if (culler.getStats().occluders == 0)
+        return;
+
+    culler.rasterize();
+
+    m_occludeeBounds.clear();
+    for (auto id : m_visible)
+    {
+        auto entity = entt::entity(id);
+        auto* spatial = gResources->m_registry.try_get<Engine::SpatialComponent>(entity);
+        m_occludeeBounds.push_back(spatial ? gResources->spatialIndex.getBounds(spatial->Proxy) : Engine::AABB());
+    }
+
+    culler.testVisibility(m_occludeeBounds, m_occludeeVisible);
+
+    uint32_t kept = 0;
+    for (uint32_t i = 0; i < m_visible.size(); i++)
+        if (m_occludeeVisible[i])
+            m_visible[kept++] = m_visible[i];
+    m_visible.resize(kept);
+}
+
+void EngineLayer::cullHiZ()
+{
+    m_occludeeBounds.clear();
+    for (auto id : m_visible)
+    {
+        auto entity = entt::entity(id);
+        auto* spatial = gResources->m_registry.try_get<Engine::SpatialComponent>(entity);
+        m_occludeeBounds.push_back(spatial ? gResources->spatialIndex.getBounds(spatial->Proxy) : Engine::AABB());
+    }
+
+    // Results come from last frame's boxes against the depth before that, something uncovered appears up to two frames late
+    if (!Engine::Renderer3D::testHiZ(m_occludeeBounds, m_visible, m_occludeeVisible))
+        return;
+
+    uint32_t kept = 0;
+    for (uint32_t i = 0; i < m_visible.size(); i++)
+        if (m_occludeeVisible[i])
+            m_visible[kept++] = m_visible[i];
+    m_visible.resize(kept);
+}
+
+void EngineLayer::rebuildStaticBatches()
+{
+    auto& batcher = gResources->staticBatcher;
+    batcher.clear();
+
+    auto view = gResources->m_registry.view<Engine::StaticComponent, Engine::TransformComponent, Engine::MeshRendererComponent>();
+    for (auto entity : view)
+    {
+        auto& merged = view.get<Engine::StaticComponent>(entity);
+        merged.Merged = false;
+        if (!merged.Static)
+            continue;
+        if (gResources->m_registry.all_of<Engine::StateComponent>(entity) && !gResources->m_registry.get<Engine::StateComponent>(entity).State)
+            continue;
+
+        // Animated models are posed every frame, merging them would freeze their bind pose
+        auto* proxy = gResources->m_registry.try_get<Engine::RenderProxyComponent>(entity);
+        if (proxy && proxy->Animated)
+            continue;
+
+        auto& mesh = view.get<Engine::MeshRendererComponent>(entity);
+        auto& trans = view.get<Engine::TransformComponent>(entity).Transform;
+        for (int i = 0; i < mesh.Geometry.size(); i++)
+        {
+            if (mesh.Geometry[i] && i < mesh.Material.size())
+                batcher.add(*mesh.Geometry[i], mesh.Material[i], trans, entt::to_integral(entity), i);
+        }
+        merged.MergedTransform = trans;
+    }
+
+    batcher.build();
+
+    for (auto entity : view)
+    {
+        auto& merged = view.get<Engine::StaticComponent>(entity);
+        auto& mesh = view.get<Engine::MeshRendererComponent>(entity);
+        for (int i = 0; i < mesh.Geometry.size() && !merged.Merged; i++)
+            merged.Merged = batcher.isMerged(entt::to_integral(entity), i);
+        gResources->retainedChanged.push_back(entity);
+    }
+}
+
+bool EngineLayer::showRetained(entt::entity entity, Engine::RetainedComponent& retained)
+{
+    auto* state = gResources->m_registry.try_get<Engine::StateComponent>(entity);
+    auto* spatial = gResources->m_registry.try_get<Engine::SpatialComponent>(entity);
+    auto* merged = gResources->eStaticBatching ? gResources->m_registry.try_get<Engine::StaticComponent>(entity) : nullptr;
+
+    // Entities not yet in the spatial index are always drawn, as on the submit path
+    bool shown = (!state || state->State) && (!m_culling || !spatial || spatial->VisibleFrame == m_frame);
+    for (int i = 0; i < retained.Slots.size(); i++)
+    {
+        bool visible = shown && !(merged && merged->Merged && gResources->staticBatcher.isMerged(entt::to_integral(entity), i));
+        if (visible == (retained.Visible[i] != 0))
+            continue;
+
+        Engine::Renderer3D::setRetainedVisible(retained.Slots[i], visible);
+        retained.Visible[i] = visible ? 1 : 0;
+    }
+    return shown;
+}
+
 bool EngineLayer::OnKeyPress(Engine::KeyPressedEvent& e) {
     e.handle(true);
     int keycode = e.getKeyCode();
@@ -4,7 +4,11 @@
 
 #include "Core/Resources/Management/ResourceManager.h"
 #include "Core/Rendering/API/Global/RendererCommon.h"
+#include "Core/Rendering/API/Global/RenderStats.h"
+#include "Core/Rendering/Renderer/GPUTimer.h"
+#include "Core/Rendering/Renderer/RenderCapture.h"
 #include "Core/Resources/Management/SceneManager.h"
+#include "Core/Resources/Utility/TransformKernels.h"
 #include "Core/Systems/Events/InputPoller.h"
 
 #include <External/IMGui/imgui.h>
@@ -64,6 +68,7 @@ public:
     void OnAttach() override;
     void OnDetach() override;
     void bindHandlers(std::shared_ptr<Engine::Window> window, std::shared_ptr<Engine::InputPoller> poller) override {};
+    void OnFixedUpdate(float step) override;
     void OnUpdate(float timestep) override;
     void OnRender() override;
     bool OnKeyPress(Engine::KeyPressedEvent& e) override;
@@ -94,6 +99,19 @@ void ImGuiLayer::OnDetach() {
     ImGui::DestroyContext();
 }
 
+void ImGuiLayer::OnFixedUpdate(float step) {
+    // The clip advances in whole ticks, the engine layer poses frames between them
+    if (isPlaying)
+    {
+        gResources->currentTimeKey += step;
+    }
+    if (gResources->currentTimeKey > maxTime)
+    {
+        gResources->currentTimeKey = 0;
+        isPlaying = false;
+    }
+}
+
 void ImGuiLayer::OnUpdate(float timestep) {
 
     SCR_WIDTH = ViewportSize.x;
@@ -116,16 +134,6 @@ void ImGuiLayer::OnUpdate(float timestep) {
     if (gResources->isGuiActive) glfwSetInputMode((GLFWwindow*)gResources->m_window->getNativeWindow(), GLFW_CURSOR, GLFW_CURSOR_NORMAL);
     else glfwSetInputMode((GLFWwindow*)gResources->m_window->getNativeWindow(), GLFW_CURSOR, GLFW_CURSOR_DISABLED);
 
-    if (isPlaying)
-    {
-        gResources->currentTimeKey += timestep;
-    }
-    if (gResources->currentTimeKey > maxTime)
-    {
-        gResources->currentTimeKey = 0;
-        isPlaying = false;
-    }
-
     this->OnRender();
 }
 
@@ -227,6 +235,9 @@ void ImGuiLayer::OnRender() {
             }
             ImGui::Separator();
             auto tagView = gResources->m_registry.view<Engine::TagComponent>();
+            entt::entity crowdSource = entt::null; // Spawned once the view is no longer being iterated
+            static int crowdCount = 100;
+            static float crowdSpacing = 2.f;
             for (auto asset : tagView)
             {
                 auto& tag = tagView.get<Engine::TagComponent>(asset);
@@ -240,16 +251,62 @@ void ImGuiLayer::OnRender() {
                         ImGui::TextColored(SubTitleColor, "Transformation");
                         auto localView = gResources->m_registry.view<Engine::TransformComponent>();
                         auto& transformation = localView.get<Engine::TransformComponent>(asset);
-                        ImGui::DragFloat3("Translation: ", &transformation.Translation.x, 0.05f);
-                        ImGui::DragFloat3("Rotation: ", &transformation.Euler.x, 0.05f);
-                        ImGui::DragFloat3("Scale: ", &transformation.Scale.x, 0.05f);
+                        bool edited = ImGui::DragFloat3("Translation: ", &transformation.Translation.x, 0.05f);
+                        edited |= ImGui::DragFloat3("Rotation: ", &transformation.Euler.x, 0.05f);
+                        edited |= ImGui::DragFloat3("Scale: ", &transformation.Scale.x, 0.05f);
 
                         glm::mat4 T = glm::translate(glm::mat4(1.0), transformation.Translation);
                         glm::mat4 R = glm::mat4_cast(glm::quat(transformation.Euler));
                         transformation.Rotation = R;
                         glm::mat4 S = glm::scale(glm::mat4(1.0), transformation.Scale);
 
-                        transformation.Transform = T * R * S;
+                        // Parented entities get their world matrix from the hierarchy update, only an edit marks their subtree dirty
+                        if (gResources->m_registry.all_of<Engine::HierarchyComponent>(asset))
+                        {
+                            if (edited)
+                                gResources->transformHierarchy.setLocal(gResources->m_registry.get<Engine::HierarchyComponent>(asset).Node, transformation.Translation, transformation.Rotation, transformation.Scale);
+                        }
+                        else
+                        {
+                            transformation.Transform = T * R * S;
+                            if (edited)
+                                gResources->m_registry.patch<Engine::TransformComponent>(asset);
+                        }
+
+                        auto* hierarchy = gResources->m_registry.try_get<Engine::HierarchyComponent>(asset);
+                        std::string parentTag = "None";
+                        if (hierarchy && hierarchy->Parent != entt::null && gResources->m_registry.all_of<Engine::TagComponent>(hierarchy->Parent))
+                            parentTag = gResources->m_registry.get<Engine::TagComponent>(hierarchy->Parent).Tag;
+
+                        if (ImGui::BeginCombo("Parent: ", parentTag.c_str()))
+                        {
+                            if (ImGui::Selectable("None", parentTag == "None") && hierarchy)
+                            {
+                                gResources->transformHierarchy.setParent(hierarchy->Node, Engine::TransformHierarchy::invalid);
+                                hierarchy->Parent = entt::null;
+                            }
+
+                            for (auto other : tagView)
+                            {
+                                if (other == asset || !gResources->m_registry.all_of<Engine::TransformComponent>(other)) continue;
+                                auto& otherTag = tagView.get<Engine::TagComponent>(other).Tag;
+                                if (ImGui::Selectable(otherTag.c_str(), otherTag == parentTag))
+                                {
+                                    if (!gResources->m_registry.all_of<Engine::HierarchyComponent>(other))
+                                        gResources->m_registry.emplace<Engine::HierarchyComponent>(other, other, entt::entity(entt::null));
+
+                                    if (!hierarchy)
+                                        gResources->m_registry.emplace<Engine::HierarchyComponent>(asset, asset, other);
+                                    else
+                                    {
+                                        gResources->transformHierarchy.setParent(hierarchy->Node, gResources->m_registry.get<Engine::HierarchyComponent>(other).Node);
+                                        if (gResources->transformHierarchy.getParent(hierarchy->Node) == gResources->m_registry.get<Engine::HierarchyComponent>(other).Node)
+                                            hierarchy->Parent = other;
+                                    }
+                                }
+                            }
+                            ImGui::EndCombo();
+                        }
                     }
                     if (gResources->m_registry.all_of<Engine::EmmissiveComponent>(asset))
                     {
@@ -260,7 +317,36 @@ void ImGuiLayer::OnRender() {
                         ImGui::DragFloat3("Color: ", &transformation.Color.x, 0.05f);
                     }
                     if (gResources->m_registry.all_of<Engine::StateComponent>(asset))
-                        ImGui::Checkbox("Visible: ", &gResources->m_registry.get<Engine::StateComponent>(asset).State);
+                        if (ImGui::Checkbox("Visible: ", &gResources->m_registry.get<Engine::StateComponent>(asset).State))
+                            gResources->m_registry.patch<Engine::StateComponent>(asset);
+                    if (gResources->m_registry.all_of<Engine::MeshRendererComponent>(asset))
+                    {
+                        bool occluder = gResources->m_registry.all_of<Engine::OccluderComponent>(asset) && gResources->m_registry.get<Engine::OccluderComponent>(asset).Occluder;
+                        if (ImGui::Checkbox("Occluder: ", &occluder))
+                            gResources->m_registry.emplace_or_replace<Engine::OccluderComponent>(asset, occluder);
+
+                        // Cleared at once, set entities are merged at the next rebuild
+                        bool isStatic = gResources->m_registry.all_of<Engine::StaticComponent>(asset) && gResources->m_registry.get<Engine::StaticComponent>(asset).Static;
+                        if (ImGui::Checkbox("Static: ", &isStatic))
+                        {
+                            if (gResources->m_registry.all_of<Engine::StaticComponent>(asset))
+                                gResources->m_registry.get<Engine::StaticComponent>(asset).Static = isStatic;
+                            else
+                                gResources->m_registry.emplace<Engine::StaticComponent>(asset, isStatic);
+                        }
+
+                        // Animated models can be instanced as a crowd playing the clip baked into vertex animation textures
+                        auto* proxy = gResources->m_registry.try_get<Engine::RenderProxyComponent>(asset);
+                        if (proxy && proxy->Animated && gResources->m_registry.all_of<Engine::TransformComponent>(asset))
+                        {
+                            ImGui::TextColored(SubTitleColor, "Crowd");
+                            ImGui::InputInt("Instances: ", &crowdCount);
+                            ImGui::DragFloat("Spacing: ", &crowdSpacing, 0.05f, 0.1f, 100.f);
+                            crowdCount = std::max(1, crowdCount);
+                            if (ImGui::Button("Spawn Crowd", ImVec2(ImGui::GetContentRegionAvail().x, 20.f)))
+                                crowdSource = asset;
+                        }
+                    }
                     ImGui::Separator();
                     if (ImGui::Button("Delete Asset", ImVec2(ImGui::GetContentRegionAvail().x, 20.f)))
                     {
@@ -268,6 +354,22 @@ void ImGuiLayer::OnRender() {
                     }
                 }
             }
+
+            // The crowd takes the source's local transform, its instances are placed from it when spawned and when loaded
+            if (crowdSource != entt::null)
+            {
+                std::string sourceTag = gResources->m_registry.get<Engine::TagComponent>(crowdSource).Tag;
+                std::string loaderPath = gResources->m_registry.get<Engine::MeshRendererComponent>(crowdSource).LoaderPath;
+                auto transform = gResources->m_registry.get<Engine::TransformComponent>(crowdSource);
+
+                auto crowd = gResources->m_registry.create();
+                gResources->m_registry.emplace<Engine::TagComponent>(crowd, sourceTag + " Crowd " + std::to_string(entt::to_integral(crowd)), Engine::TagType::Render3D);
+                gResources->m_registry.emplace<Engine::StateComponent>(crowd, true);
+                auto& origin = gResources->m_registry.emplace<Engine::TransformComponent>(crowd, transform.Translation, transform.Euler, transform.Scale);
+                auto& added = gResources->m_registry.emplace<Engine::CrowdComponent>(crowd, loaderPath, sourceTag, origin.Transform, (uint32_t)crowdCount, crowdSpacing);
+                if (added.Crowd.instanceCount == 0)
+                    gResources->m_registry.destroy(crowd);
+            }
         }
         ImGui::End();
     }
@@ -304,6 +406,30 @@ void ImGuiLayer::OnRender() {
             ImVec2 imageRenderSize = ImVec2(scaledWidth, scaledHeight);
 
             ImGui::Image((void*)(intptr_t)Engine::RendererCommon::colorFBOTexture->getID(), imageRenderSize, ImVec2(0, 1), ImVec2(1, 0));
+
+            // Clicking the viewport selects the nearest object whose bounds are under the cursor
+            if (ImGui::IsItemClicked(ImGuiMouseButton_Left))
+            {
+                ImVec2 imageMin = ImGui::GetItemRectMin();
+                ImVec2 mouse = ImGui::GetMousePos();
+                glm::vec2 ndc = glm::vec2((mouse.x - imageMin.x) / imageRenderSize.x, (mouse.y - imageMin.y) / imageRenderSize.y) * 2.f - 1.f;
+                ndc.y = -ndc.y;
+
+                glm::mat4 inverseViewProjection = glm::inverse(gResources->m_projection3D * gResources->m_view3D);
+                glm::vec4 nearPoint = inverseViewProjection * glm::vec4(ndc, -1.f, 1.f);
+                glm::vec4 farPoint = inverseViewProjection * glm::vec4(ndc, 1.f, 1.f);
+                glm::vec3 origin = glm::vec3(nearPoint) / nearPoint.w;
+                glm::vec3 ray = glm::vec3(farPoint) / farPoint.w - origin;
+
+                uint32_t hit;
+                float distance;
+                if (gResources->spatialIndex.raycast(origin, glm::normalize(ray), glm::length(ray), hit, distance))
+                {
+                    auto entity = entt::entity(hit);
+                    if (gResources->m_registry.valid(entity) && gResources->m_registry.all_of<Engine::TagComponent>(entity))
+                        gResources->selectedObject = gResources->m_registry.get<Engine::TagComponent>(entity).Tag;
+                }
+            }
         }
         ImGui::End();
     }
@@ -542,6 +668,33 @@ void ImGuiLayer::OnRender() {
         }
         ImGui::End();
     }
+    if (gResources->eRenderStats)
+    {
+        if (ImGui::Begin("Render Stats", &gResources->eRenderStats))
+        {
+            auto& frame = Engine::RenderStats::getLastFrame();
+            ImGui::Text("Draw Calls %u (%u draws, %u instances), Dispatches %u", frame.drawCalls, frame.drawCommands, frame.instances, frame.dispatches);
+            ImGui::Text("Batch Flushes %u (%u forced by full texture units)", frame.batchFlushes, frame.forcedFlushes);
+            ImGui::Text("Program Binds %u, Texture Binds %u", frame.programBinds, frame.textureBinds);
+            ImGui::Text("Uploads %u, %.1f KB", frame.bufferUploads, frame.bytesUploaded / 1024.0);
+
+            // Oldest frame first so the graphs scroll left
+            uint32_t frames = Engine::RenderStats::getHistoryCount();
+            std::vector<float> values(frames);
+            auto plot = [&](const char* label, const std::function<float(const Engine::RenderFrameStats&)>& counter) {
+                for (uint32_t i = 0; i < frames; i++)
+                    values[i] = counter(Engine::RenderStats::getHistory(frames - 1 - i));
+                ImGui::PlotLines(label, values.data(), (int)frames, 0, nullptr, 0.f, FLT_MAX, ImVec2(0.f, 50.f));
+            };
+            plot("Draw Calls", [](const Engine::RenderFrameStats& stats) { return (float)stats.drawCalls; });
+            plot("Instances", [](const Engine::RenderFrameStats& stats) { return (float)stats.instances; });
+            plot("Batch Flushes", [](const Engine::RenderFrameStats& stats) { return (float)stats.batchFlushes; });
+            plot("Program Binds", [](const Engine::RenderFrameStats& stats) { return (float)stats.programBinds; });
+            plot("Texture Binds", [](const Engine::RenderFrameStats& stats) { return (float)stats.textureBinds; });
+            plot("Uploaded KB", [](const Engine::RenderFrameStats& stats) { return stats.bytesUploaded / 1024.f; });
+        }
+        ImGui::End();
+    }
 
     if (ImGui::BeginMainMenuBar())
     {
@@ -654,6 +807,31 @@ void ImGuiLayer::OnRender() {
             ImGui::Checkbox("Bloom:          ", &gResources->eBloom);
             ImGui::Checkbox("Tone Mapping:   ", &gResources->eToneMapping);
             ImGui::Checkbox("Vignette:       ", &gResources->eVignette);
+            ImGui::Separator();
+            ImGui::Checkbox("GPU Skinning:   ", &gResources->eGPUSkinning);
+            ImGui::Checkbox("Animation LOD:  ", &gResources->animationLOD.enabled);
+            ImGui::Checkbox("Frustum Culling:", &gResources->eFrustumCulling);
+            ImGui::Checkbox("Occlusion Culling:", &gResources->eOcclusionCulling);
+            ImGui::Checkbox("Hi-Z Culling:   ", &gResources->eHiZCulling);
+            ImGui::Checkbox("Depth Prepass:  ", &gResources->eDepthPrepass);
+            ImGui::Checkbox("Meshlet Culling:", &gResources->eMeshletCulling);
+            ImGui::Checkbox("Meshlet Cones:  ", &gResources->eMeshletConeCulling);
+            ImGui::Checkbox("Static Batching:", &gResources->eStaticBatching);
+            ImGui::Checkbox("Retained Draws: ", &gResources->eRetainedInstances);
+            bool pipelined = Engine::Application::getInstance().isPipelined();
+            if (ImGui::Checkbox("Pipelined:      ", &pipelined))
+                Engine::Application::getInstance().setPipelined(pipelined);
+            bool gpuTiming = Engine::GPUTimer::isEnabled();
+            if (ImGui::Checkbox("GPU Timing:     ", &gpuTiming))
+                Engine::GPUTimer::setEnabled(gpuTiming);
+            auto& fixedTimestep = Engine::Application::getInstance().getFixedTimestep();
+            float tickRate = fixedTimestep.getTickRate();
+            if (ImGui::SliderFloat("Tick Rate", &tickRate, 10.f, 240.f, "%.0f Hz"))
+                fixedTimestep.setTickRate(tickRate);
+            auto& framePacer = Engine::Application::getInstance().getFramePacer();
+            float frameLimit = framePacer.getTargetRate();
+            if (ImGui::SliderFloat("Frame Limit", &frameLimit, 0.f, 360.f, frameLimit > 0.f ? "%.0f FPS" : "Off"))
+                framePacer.setTargetRate(frameLimit);
             ImGui::EndMenu();
         }
         if (ImGui::BeginMenu("Window"))
@@ -663,11 +841,114 @@ void ImGuiLayer::OnRender() {
             ImGui::Checkbox("Assets", &gResources->eAssets);
             ImGui::Checkbox("Keyframe Timeline", &gResources->eKeyframe);
             ImGui::Checkbox("Tutorial Information", &gResources->eHints);
+            ImGui::Checkbox("Render Stats", &gResources->eRenderStats);
             ImGui::EndMenu();
         }
+#ifdef EPHYRA_PROFILING
+        // Checked every frame rather than in the menu, which is closed while the capture runs
+        static std::vector<Engine::ProfileZoneTotal> zoneTotals;
+        static bool profileExported = true;
+        if (!profileExported && Engine::Profiler::isCaptureReady())
+        {
+            Engine::Profiler::exportChromeTrace("profile.json");
+            Engine::Profiler::getZoneTotals(zoneTotals);
+            profileExported = true;
+        }
+#endif
         if (ImGui::BeginMenu("Help"))
         {
             ImGui::Text("FPS %.3f ms/frame (%.1f FPS)", ms, ImGui::GetIO().Framerate);
+            auto& pipelineStats = Engine::Application::getInstance().getPipelineStats();
+            auto& ticks = Engine::Application::getInstance().getFixedTimestep();
+            auto& pacerStats = Engine::Application::getInstance().getFramePacer().getStats();
+            ImGui::Text("Ticks %u at %.0f Hz, %u dropped, blend %.2f", ticks.getTicks(), ticks.getTickRate(), ticks.getDroppedTicks(), ticks.getAlpha());
+            ImGui::Text("Frame Pacing: slept %.3f ms, spun %.3f ms, late %.3f ms", pacerStats.sleepTime * 1000.f, pacerStats.spinTime * 1000.f, pacerStats.lateTime * 1000.f);
+            ImGui::Text("Frame %.3f ms: simulation %.3f ms, render %.3f ms, other %.3f ms%s", pipelineStats.frame * 1000.f, pipelineStats.simulation * 1000.f, pipelineStats.render * 1000.f, pipelineStats.other * 1000.f, Engine::Application::getInstance().isPipelined() ? ", overlapped" : "");
+            if (Engine::GPUTimer::isEnabled())
+            {
+                auto& gpuStats = Engine::GPUTimer::getStats();
+                ImGui::Text("GPU %.3f ms, read %u frames late, %u dropped, %u queries", gpuStats.frameTime * 1000.f, gpuStats.latency, gpuStats.dropped, gpuStats.queries);
+                for (auto& result : Engine::GPUTimer::getResults())
+                {
+                    if (result.depth == 0) continue;
+                    ImGui::Text("%*s%s: %.3f ms", (int)(result.depth - 1) * 2, "", result.name, result.time * 1000.f);
+                }
+            }
+            ImGui::Separator();
+            auto& lodStats = gResources->animationLODStats;
+            ImGui::Text("Animation LOD 0/1/2/3/Off: %u/%u/%u/%u/%u", lodStats.levelCounts[0], lodStats.levelCounts[1], lodStats.levelCounts[2], lodStats.levelCounts[3], lodStats.levelCounts[4]);
+            ImGui::Text("Poses Evaluated %u, Interpolated %u, Reduced Joints %u", lodStats.evaluated, lodStats.skipped, lodStats.reducedJoints);
+            ImGui::Text("Animation CPU %.3f ms, Saved %.3f ms", lodStats.evaluationTime * 1000.f, lodStats.savedTime * 1000.f);
+            ImGui::Separator();
+            ImGui::Text("Transform Kernel: %s", Engine::TransformKernels::getPathName(Engine::TransformKernels::getPath()));
+            ImGui::Separator();
+            auto& occlusionStats = gResources->occlusionCuller.getStats();
+            ImGui::Text("Occlusion: %u occluders, %u triangles, %u/%u culled", occlusionStats.occluders, occlusionStats.triangles, occlusionStats.culled, occlusionStats.tested);
+            ImGui::Text("Occlusion CPU: raster %.3f ms, test %.3f ms", occlusionStats.rasterTime * 1000.f, occlusionStats.testTime * 1000.f);
+            uint64_t invocationsOff = Engine::Renderer3D::getFragmentInvocations(false);
+            uint64_t invocationsOn = Engine::Renderer3D::getFragmentInvocations(true);
+            ImGui::Text("Fragment Invocations: %llu without prepass, %llu with", (unsigned long long)invocationsOff, (unsigned long long)invocationsOn);
+            if (invocationsOff > 0 && invocationsOn > 0)
+                ImGui::Text("Depth Prepass Shading Saved: %.1f%%", 100.0 * (1.0 - (double)invocationsOn / (double)invocationsOff));
+            auto& meshletStats = Engine::Renderer3D::getMeshletStats();
+            ImGui::Text("Meshlets: %u tested, %u outside, %u back facing, %u commands", meshletStats.tested, meshletStats.frustumCulled, meshletStats.coneCulled, meshletStats.commands);
+            ImGui::Text("Meshlet Triangles: %llu drawn, %llu culled", (unsigned long long)meshletStats.trianglesDrawn, (unsigned long long)meshletStats.trianglesCulled);
+            auto& staticStats = gResources->staticBatcher.getStats();
+            ImGui::Text("Static Batches: %u from %u meshes, %u merged, %u unmerged, %u failed", staticStats.batches, staticStats.sources, staticStats.merged, staticStats.unmerged, staticStats.failed);
+            if (ImGui::MenuItem("Rebuild Static Batches", nullptr, false))
+                gResources->staticBatchesDirty = true;
+            auto& retainedStats = Engine::Renderer3D::getRetainedStats();
+            ImGui::Text("Retained: %u/%u visible, %u draws, %u rebuilds", retainedStats.visible, retainedStats.instances, retainedStats.draws, retainedStats.rebuilds);
+            ImGui::Text("Retained Uploads: %u instances, %u commands", retainedStats.patchedInstances, retainedStats.patchedCommands);
+            ImGui::Separator();
+            ImGui::Text("Job System: %u workers", Engine::JobSystem::getWorkerCount());
+            ImGui::Text("Spatial Index: %u objects, height %u", gResources->spatialIndex.getProxyCount(), gResources->spatialIndex.getHeight());
+            ImGui::Separator();
+            if (ImGui::MenuItem("Capture Render Frames (60)", nullptr, false, !Engine::RenderCapture::isCapturing()))
+                Engine::RenderCapture::begin("capture.erc", 60);
+            auto& captureStats = Engine::RenderCapture::getStats();
+            if (captureStats.frames != 0)
+                ImGui::Text("Render Capture: %u frames, %u calls, %u meshes, %u materials, %.1f MB in capture.erc%s", captureStats.frames, captureStats.calls, captureStats.geometries, captureStats.materials,
+                    captureStats.bytes / (1024.f * 1024.f), Engine::RenderCapture::isCapturing() ? " (recording)" : "");
+            auto& inputPath = gResources->inputPath;
+            if (ImGui::MenuItem(inputPath.isRecording() ? "Stop Recording Input Path" : "Record Input Path", nullptr, false, !inputPath.isPlaying()))
+            {
+                if (inputPath.isRecording())
+                {
+                    inputPath.stop();
+                    inputPath.save("saves/input.path");
+                }
+                else
+                    inputPath.startRecording(Engine::Application::getInstance().getFixedTimestep().getStep());
+            }
+            if (ImGui::MenuItem("Play Input Path", nullptr, false, !inputPath.isRecording() && !inputPath.isPlaying()))
+                if (inputPath.load("saves/input.path"))
+                    inputPath.startPlayback();
+            if (inputPath.getTickCount() != 0)
+                ImGui::Text("Input Path: %u ticks in saves/input.path%s", inputPath.isPlaying() ? inputPath.getPosition() : inputPath.getTickCount(), inputPath.isRecording() ? " (recording)" : inputPath.isPlaying() ? " played" : "");
+            ImGui::Separator();
+#ifdef EPHYRA_PROFILING
+            static float profilerOverhead = 0.f;
+            if (ImGui::MenuItem("Capture Profile (120 frames)", nullptr, false, !Engine::Profiler::isCapturing()))
+            {
+                Engine::Profiler::beginCapture(120);
+                profileExported = false;
+            }
+            if (ImGui::MenuItem("Measure Profiler Overhead", nullptr, false, !Engine::Profiler::isCapturing()))
+                profilerOverhead = Engine::Profiler::measureOverhead();
+            if (profilerOverhead > 0.f)
+                ImGui::Text("Profiler Overhead: %.1f ns per zone", profilerOverhead);
+            if (!zoneTotals.empty())
+            {
+                auto& profileStats = Engine::Profiler::getStats();
+                ImGui::Text("Profile: %u frames, %u zones on %u threads, %u dropped, written to profile.json", profileStats.frames, profileStats.events, profileStats.threads, profileStats.dropped);
+                float frames = (float)std::max(profileStats.frames, 1u);
+                for (size_t i = 0; i < std::min<size_t>(zoneTotals.size(), 10); i++)
+                    ImGui::Text("%s: %.3f ms per frame, %.1f calls", zoneTotals[i].name.c_str(), zoneTotals[i].time * 1000.f / frames, zoneTotals[i].count / frames);
+            }
+#else
+            ImGui::Text("Profiler: compiled out, define EPHYRA_PROFILE to enable it in release");
+#endif
             ImGui::EndMenu();
         }
 
@@ -1,6 +1,7 @@
 /** \file engineApp.cpp
 */
 #include "Core/engineApp.h"
+#include "Layers/BenchmarkLayer.h"
 #include "Layers/EngineLayer.h"
 #include "Layers/ImGuiLayer.h"
 
@@ -8,7 +9,12 @@
 engineApp::engineApp()
 {
 	m_layerStack->Push(std::make_shared<EngineLayer>(EngineLayer("EngineLayer")));
-	m_layerStack->Push(std::make_shared<ImGuiLayer>(ImGuiLayer("ImGuiLayer")));
+
+	// Benchmark runs drive the engine layer without the editor
+	if (Engine::Application::hasArgument("--benchmark"))
+		m_layerStack->Push(std::make_shared<BenchmarkLayer>(BenchmarkLayer("BenchmarkLayer")));
+	else
+		m_layerStack->Push(std::make_shared<ImGuiLayer>(ImGuiLayer("ImGuiLayer")));
 }
 
 engineApp::~engineApp()